@@ -0,0 +1,97 @@
+// Eight color variants of a material with albedo, normal, occlusion and height outputs, written as PFM files.
+// SeparateBakes evaluates and saves every output of every variant on its own, BatchBake runs BakeBatch with the
+// argument as variants per pass. The height field and everything derived from it only depend on the seed, so the batch
+// evaluates them once. Items/s is variants per second.
+
+#include "Bench.hpp"
+
+#include "Engine/Batch.hpp"
+#include "Engine/ImageIO.hpp"
+#include "Engine/ThreadPool.hpp"
+
+#include <filesystem>
+
+namespace Texturia::Bench {
+
+namespace {
+
+const EvaluationSettings s_Settings = { 256, 256, 64, 0 };
+constexpr uint32_t s_VariantCount = 8;
+
+struct Material {
+  NodesTree Tree;
+  std::vector<Frameio::UUID> Outputs;
+  BatchParameter Color;
+  std::vector<BatchVariant> Variants;
+
+  Material()
+  {
+    Node height = CreateNode("Fractal Noise");
+    Node color = CreateNode("Constant");
+    Node albedo = CreateNode("Multiply");
+    Node normal = CreateNode("Height To Normal");
+    Node occlusion = CreateNode("Ambient Occlusion");
+    for (const Node* node : { &height, &color, &albedo, &normal, &occlusion }) Tree.AddNode(*node);
+    Tree.AddLink({ height.UUID, albedo.UUID, 0 });
+    Tree.AddLink({ color.UUID, albedo.UUID, 1 });
+    Tree.AddLink({ height.UUID, normal.UUID, 0 });
+    Tree.AddLink({ height.UUID, occlusion.UUID, 0 });
+    for (const Node* node : { &albedo, &normal, &occlusion, &height }) {
+      Node output = CreateNode("Output");
+      Tree.AddNode(output);
+      Tree.AddLink({ node->UUID, output.UUID, 0 });
+      Outputs.push_back(output.UUID);
+    }
+
+    Color = { color.UUID, 0 };
+    for (uint32_t i = 0; i < s_VariantCount; i++) {
+      Variants.push_back({ SocketValue::Color(i / (float)s_VariantCount, 0.5f, 0.25f) });
+    }
+  }
+};
+
+std::string GetPath(uint32_t variant, uint32_t output)
+{
+  const std::string name = "texturia-bench-batch-" + std::to_string(variant) + "-" + std::to_string(output) + ".pfm";
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void SeparateBakes(State& state)
+{
+  Material material;
+  ThreadPool pool;
+  ImageIO io;
+  while (state.KeepRunning()) {
+    for (uint32_t variant = 0; variant < s_VariantCount; variant++) {
+      const NodeHandle color = material.Tree.FindNode(material.Color.Node);
+      material.Tree.SetSocketValue(color, 0, material.Variants[variant][0]);
+      for (uint32_t output = 0; output < material.Outputs.size(); output++) {
+        const EvaluationPlan plan = EvaluationPlan::Build(material.Tree, material.Outputs[output]);
+        io.Save(std::make_shared<const Image>(Evaluate(plan, s_Settings, pool)), GetPath(variant, output));
+      }
+    }
+    io.Wait();
+  }
+  state.SetItemsProcessed(state.GetIterations() * s_VariantCount);
+}
+
+void BatchBake(State& state)
+{
+  Material material;
+  ThreadPool pool;
+  ImageIO io;
+  BatchSettings settings = { s_Settings, (uint32_t)state.GetArgument() };
+  std::string error;
+  while (state.KeepRunning()) {
+    BakeBatch(material.Tree, material.Outputs, { &material.Color, 1 }, material.Variants, settings, pool, io, GetPath,
+              error);
+  }
+  state.SetItemsProcessed(state.GetIterations() * s_VariantCount);
+}
+
+} // namespace
+
+TX_BENCHMARK(SeparateBakes);
+TX_BENCHMARK(BatchBake, { 1, 4, 8 });
+
+} // namespace Texturia::Bench
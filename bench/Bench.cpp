@@ -0,0 +1,228 @@
+// texturia-bench [filter] [--json <file>] [--baseline <file>] [--threshold <percent>] [--min-time <seconds>]
+//   Runs every registered benchmark, or the ones whose name contains filter.
+//   --json writes the results to file, to keep track of them across versions.
+//   --baseline compares the results against a file written by --json before. Benchmarks that got more than threshold
+//   percent (10 by default) slower count as regressions, which make the exit code 1.
+
+#include "Bench.hpp"
+
+#include "Engine/Json.hpp"
+#include "Engine/Simd.hpp"
+#include "Engine/ThreadPool.hpp"
+
+#include <charconv>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+
+namespace Texturia::Bench {
+
+namespace {
+
+struct Benchmark {
+  std::string Name;
+  BenchmarkFunction Function;
+  int64_t Argument;
+};
+
+struct Result {
+  std::string Name;
+  uint64_t Iterations = 0;
+  double Nanoseconds = 0.0;
+  double ItemsPerSecond = 0.0;
+  std::string Label;
+  bool Skipped = false;
+};
+
+std::vector<Benchmark>& GetBenchmarks()
+{
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+Result Run(const Benchmark& benchmark, double minSeconds)
+{
+  uint64_t iterations = 1;
+  std::unique_ptr<State> state;
+  while (true) {
+    state = std::make_unique<State>(iterations, benchmark.Argument);
+    benchmark.Function(*state);
+    if (state->IsSkipped()) return { benchmark.Name, 0, 0.0, 0.0, state->GetLabel(), true };
+    if (state->GetSeconds() >= minSeconds || iterations >= 1'000'000'000) break;
+
+    // Aim a bit above the minimum time so that usually only one more run is needed
+    double scale = state->GetSeconds() > 0.0 ? minSeconds * 1.4 / state->GetSeconds() : 100.0;
+    iterations = std::max(iterations + 1, (uint64_t)(iterations * std::min(scale, 100.0)));
+  }
+
+  Result result = { benchmark.Name, iterations, state->GetSeconds() * 1e9 / (double)iterations };
+  result.Label = state->GetLabel();
+  if (state->GetItemsProcessed() > 0) result.ItemsPerSecond = (double)state->GetItemsProcessed() / state->GetSeconds();
+  return result;
+}
+
+std::string FormatNumber(double value)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+  return buffer;
+}
+
+std::string WriteResults(const std::vector<Result>& results)
+{
+  char date[32];
+  const std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+  std::string out = "{\n  \"format\": \"texturia-bench\",\n  \"version\": 1,\n  \"context\": {\n    \"date\": ";
+  WriteJsonString(out, date);
+  out += ",\n    \"threads\": " + std::to_string(ThreadPool::GetHardwareThreadCount()) + ",\n    \"simd\": ";
+  WriteJsonString(out, GetSimdLevelName(GetSimdLevel()));
+  out += "\n  },\n  \"benchmarks\": [";
+  bool first = true;
+  for (const Result& result : results) {
+    if (result.Skipped) continue;
+    out += first ? "\n    { \"name\": " : ",\n    { \"name\": ";
+    first = false;
+    WriteJsonString(out, result.Name);
+    out += ", \"iterations\": " + std::to_string(result.Iterations);
+    out += ", \"ns_per_iteration\": " + FormatNumber(result.Nanoseconds);
+    out += ", \"items_per_second\": " + FormatNumber(result.ItemsPerSecond);
+    out += ", \"label\": ";
+    WriteJsonString(out, result.Label);
+    out += " }";
+  }
+  out += "\n  ]\n}\n";
+  return out;
+}
+
+// Nanoseconds per iteration by benchmark name, returns false and sets error if the file is not a result file
+bool ReadBaseline(const std::string& path, std::unordered_map<std::string, double>& baseline, std::string& error)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    error = "Could not open " + path;
+    return false;
+  }
+  std::stringstream text;
+  text << file.rdbuf();
+
+  JsonValue root;
+  if (!ParseJson(text.str(), root, error)) return false;
+  const JsonValue* format = root.Find("format");
+  const JsonValue* benchmarks = root.Find("benchmarks");
+  if (!format || format->String != "texturia-bench" || !benchmarks || benchmarks->Kind != JsonKind::Array) {
+    error = path + " does not hold texturia-bench results";
+    return false;
+  }
+  for (const JsonValue& benchmark : benchmarks->Array) {
+    const JsonValue* name = benchmark.Find("name");
+    const JsonValue* nanoseconds = benchmark.Find("ns_per_iteration");
+    if (!name || !nanoseconds || nanoseconds->Kind != JsonKind::Number) continue;
+    double value = 0.0;
+    const std::string& digits = nanoseconds->String;
+    if (std::from_chars(digits.data(), digits.data() + digits.size(), value).ec == std::errc()) {
+      baseline[name->String] = value;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+Registration::Registration(const char* name, BenchmarkFunction function, std::vector<int64_t> arguments)
+{
+  for (int64_t argument : arguments) {
+    std::string fullName = name;
+    if (arguments.size() > 1 || argument != 0) fullName.append("/").append(std::to_string(argument));
+    GetBenchmarks().push_back({ fullName, function, argument });
+  }
+}
+
+void RegisterBenchmark(std::string fullName, BenchmarkFunction function, int64_t argument)
+{
+  GetBenchmarks().push_back({ std::move(fullName), function, argument });
+}
+
+} // namespace Texturia::Bench
+
+int main(int argc, char** argv)
+{
+  using namespace Texturia;
+  using namespace Texturia::Bench;
+
+  std::string filter, jsonPath, baselinePath;
+  double minSeconds = 0.2, threshold = 10.0;
+  for (int i = 1; i < argc; i++) {
+    const std::string argument = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if (argument == "--json" && hasValue) jsonPath = argv[++i];
+    else if (argument == "--baseline" && hasValue) baselinePath = argv[++i];
+    else if (argument == "--threshold" && hasValue) threshold = std::atof(argv[++i]);
+    else if (argument == "--min-time" && hasValue) minSeconds = std::atof(argv[++i]);
+    else if (argument.starts_with("--")) {
+      std::fprintf(stderr, "Unknown option %s\n", argument.c_str());
+      return 2;
+    } else filter = argument;
+  }
+
+  std::unordered_map<std::string, double> baseline;
+  if (!baselinePath.empty()) {
+    std::string error;
+    if (!ReadBaseline(baselinePath, baseline, error)) {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 2;
+    }
+  }
+
+  std::printf("%-48s %12s %16s %16s", "Benchmark", "Iterations", "Time/iteration", "Items/s");
+  if (!baselinePath.empty()) std::printf(" %10s", "Change");
+  std::printf("\n");
+
+  std::vector<Result> results;
+  uint32_t regressions = 0;
+  for (const Benchmark& benchmark : GetBenchmarks()) {
+    if (!filter.empty() && benchmark.Name.find(filter) == std::string::npos) continue;
+
+    const Result& result = results.emplace_back(Run(benchmark, minSeconds));
+    if (result.Skipped) {
+      std::printf("%-48s skipped: %s\n", result.Name.c_str(), result.Label.c_str());
+      continue;
+    }
+
+    std::printf("%-48s %12llu %13.0f ns", result.Name.c_str(), (unsigned long long)result.Iterations,
+                result.Nanoseconds);
+    if (result.ItemsPerSecond > 0.0) std::printf(" %16.4g", result.ItemsPerSecond);
+    else std::printf(" %16s", "");
+    if (!baselinePath.empty()) {
+      // Positive is slower
+      auto previous = baseline.find(result.Name);
+      if (previous == baseline.end() || previous->second <= 0.0) {
+        std::printf(" %10s", "new");
+      } else {
+        const double change = (result.Nanoseconds / previous->second - 1.0) * 100.0;
+        std::printf(" %+9.1f%%", change);
+        if (change > threshold) regressions++;
+      }
+    }
+    if (!result.Label.empty()) std::printf("  %s", result.Label.c_str());
+    std::printf("\n");
+  }
+
+  if (!jsonPath.empty()) {
+    std::ofstream file(jsonPath, std::ios::binary | std::ios::trunc);
+    file << WriteResults(results);
+    if (!file) {
+      std::fprintf(stderr, "Failed to write %s\n", jsonPath.c_str());
+      return 2;
+    }
+  }
+  if (regressions > 0) {
+    std::printf("%u benchmarks are more than %.0f%% slower than the baseline\n", regressions, threshold);
+    return 1;
+  }
+  return 0;
+}
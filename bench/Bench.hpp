@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Texturia::Bench {
+
+// Passed to every benchmark function, which runs its measured code in a while (state.KeepRunning()) loop. The runner
+// calls the function with growing iteration counts until one run takes long enough to be measured reliably.
+class State {
+public:
+  State(uint64_t iterations, int64_t argument) : m_Iterations(iterations), m_Argument(argument) {}
+
+  inline bool KeepRunning()
+  {
+    if (m_Skipped) return false;
+    if (m_Done == 0) m_Start = std::chrono::steady_clock::now();
+    if (m_Done++ < m_Iterations) return true;
+
+    ResumeTiming();
+    PauseTiming();
+    return false;
+  }
+
+  // Excludes setup inside of the loop from the measured time
+  inline void PauseTiming()
+  {
+    m_Elapsed += std::chrono::steady_clock::now() - m_Start;
+    m_Paused = true;
+  }
+  inline void ResumeTiming()
+  {
+    if (m_Paused) m_Start = std::chrono::steady_clock::now();
+    m_Paused = false;
+  }
+
+  inline uint64_t GetIterations() const { return m_Iterations; }
+  inline int64_t GetArgument() const { return m_Argument; }
+  inline double GetSeconds() const { return std::chrono::duration<double>(m_Elapsed).count(); }
+
+  // Reported as throughput, per second
+  inline void SetItemsProcessed(uint64_t items) { m_Items = items; }
+  inline uint64_t GetItemsProcessed() const { return m_Items; }
+
+  // Printed next to the results
+  inline void SetLabel(std::string label) { m_Label = std::move(label); }
+  inline const std::string& GetLabel() const { return m_Label; }
+
+  // Reports the benchmark as not runnable on this machine, call it before KeepRunning
+  inline void Skip(std::string reason)
+  {
+    m_Skipped = true;
+    m_Label = std::move(reason);
+  }
+  inline bool IsSkipped() const { return m_Skipped; }
+
+private:
+  uint64_t m_Iterations, m_Done = 0;
+  int64_t m_Argument;
+  uint64_t m_Items = 0;
+  bool m_Paused = false, m_Skipped = false;
+  std::string m_Label;
+  std::chrono::steady_clock::time_point m_Start;
+  std::chrono::steady_clock::duration m_Elapsed = {};
+};
+
+using BenchmarkFunction = void (*)(State& state);
+
+struct Registration {
+  Registration(const char* name, BenchmarkFunction function, std::vector<int64_t> arguments = { 0 });
+};
+
+// Registers a single benchmark under fullName, for benchmarks that are generated in loops
+void RegisterBenchmark(std::string fullName, BenchmarkFunction function, int64_t argument);
+
+// Keeps the compiler from optimizing away results that are otherwise unused
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace Texturia::Bench
+
+#define TX_BENCHMARK_CONCAT_(a, b) a##b
+#define TX_BENCHMARK_CONCAT(a, b) TX_BENCHMARK_CONCAT_(a, b)
+// TX_BENCHMARK(Function) or TX_BENCHMARK(Function, { arguments... }), every argument is run separately
+#define TX_BENCHMARK(function, ...)                                                                                    \
+  static const Texturia::Bench::Registration TX_BENCHMARK_CONCAT(s_Benchmark, __LINE__)(                               \
+      #function, function __VA_OPT__(, ) __VA_ARGS__)
@@ -0,0 +1,188 @@
+#include "Corpus.hpp"
+
+#include "Engine/Kernels.hpp"
+#include "Hash.hpp"
+
+#include <map>
+#include <memory>
+#include <random>
+
+namespace Texturia::Bench {
+
+namespace {
+
+// Nodes per layer of the Dag shape, and how many layers back a node reads from
+constexpr uint32_t s_LayerWidth = 32, s_LayerReach = 4;
+
+class CorpusBuilder {
+public:
+  CorpusBuilder(CorpusShape shape, uint32_t count)
+      : m_Shape((uint64_t)shape + 1), m_Random(HashCombine(m_Shape, count))
+  {
+  }
+
+  // Sockets get UUIDs derived from the node, the ones CreateNode hands out are random
+  uint32_t Add(const char* type)
+  {
+    const uint32_t index = (uint32_t)m_Corpus.Nodes.size();
+    const Frameio::UUID uuid(HashCombine(m_Shape, index + 1));
+    Node node = CreateNode(type, std::string(type) + " " + std::to_string(index), uuid);
+    for (size_t i = 0; i < node.GetSockets().size(); i++) {
+      NodeSocket& socket = node.GetSockets()[i];
+      socket.UUID = Frameio::UUID(HashCombine(uuid, i + 1));
+      if (socket.Label == "Seed") socket.Value = (int32_t)(m_Random() % 1000);
+    }
+    m_Corpus.Nodes.push_back(std::move(node));
+    return index;
+  }
+
+  void Link(uint32_t from, uint32_t to, uint32_t socket)
+  {
+    m_Corpus.Links.push_back({ m_Corpus.Nodes[from].UUID, m_Corpus.Nodes[to].UUID, socket });
+  }
+
+  void SetValue(uint32_t node, uint32_t socket, const SocketValue& value)
+  {
+    m_Corpus.Nodes[node].GetSockets()[socket].Value = value;
+  }
+
+  // The distributions of <random> differ between standard libraries, the engine itself is fully specified
+  inline float NextFloat() { return (float)(m_Random() >> 40) * 0x1p-24f; }
+  inline uint32_t NextIndex(uint32_t first, uint32_t end) { return first + (uint32_t)(m_Random() % (end - first)); }
+
+  inline uint32_t GetCount() const { return (uint32_t)m_Corpus.Nodes.size(); }
+
+  Corpus Finish(uint32_t last)
+  {
+    const uint32_t output = Add("Output");
+    Link(last, output, 0);
+    m_Corpus.Output = m_Corpus.Nodes[output].UUID;
+    return std::move(m_Corpus);
+  }
+
+private:
+  uint64_t m_Shape;
+  std::mt19937_64 m_Random;
+  Corpus m_Corpus;
+};
+
+// Balanced tree of Add nodes over nodes, which takes one node less than there are nodes. Returns the root.
+uint32_t AddSum(CorpusBuilder& builder, std::vector<uint32_t> nodes)
+{
+  while (nodes.size() > 1) {
+    std::vector<uint32_t> next;
+    for (size_t i = 0; i + 1 < nodes.size(); i += 2) {
+      const uint32_t node = builder.Add("Add");
+      builder.Link(nodes[i], node, 0);
+      builder.Link(nodes[i + 1], node, 1);
+      next.push_back(node);
+    }
+    if (nodes.size() % 2 == 1) next.push_back(nodes.back());
+    nodes = std::move(next);
+  }
+  return nodes.front();
+}
+
+Corpus BuildChain(CorpusBuilder& builder, uint32_t count)
+{
+  static const char* const chainTypes[] = { "Multiply", "Add", "Mix", "Invert" };
+  const uint32_t noise = builder.Add("Gradient Noise");
+  uint32_t previous = noise;
+  for (uint32_t i = 0; builder.GetCount() < count - 1; i++) {
+    const uint32_t node = builder.Add(chainTypes[i % 4]);
+    builder.Link(previous, node, 0);
+    if (i % 4 == 0) builder.SetValue(node, 1, SocketValue::Color(builder.NextFloat(), builder.NextFloat(), 1.0f));
+    if (i % 4 == 1) builder.SetValue(node, 1, builder.NextFloat() * 0.1f);
+    if (i % 4 == 2) builder.Link(noise, node, 1);
+    previous = node;
+  }
+  return builder.Finish(previous);
+}
+
+Corpus BuildFan(CorpusBuilder& builder, uint32_t count)
+{
+  const uint32_t source = builder.Add("Value Noise");
+  // Fan out and reduce take one node less than twice the width
+  std::vector<uint32_t> layer;
+  for (uint32_t i = 0; i < (count - 1) / 2; i++) {
+    const uint32_t node = builder.Add("Multiply");
+    builder.Link(source, node, 0);
+    builder.SetValue(node, 1, SocketValue::Color(builder.NextFloat(), builder.NextFloat(), builder.NextFloat()));
+    layer.push_back(node);
+  }
+  // Even counts are one node short
+  uint32_t last = AddSum(builder, std::move(layer));
+  while (builder.GetCount() < count - 1) {
+    const uint32_t node = builder.Add("Invert");
+    builder.Link(last, node, 0);
+    last = node;
+  }
+  return builder.Finish(last);
+}
+
+Corpus BuildDag(CorpusBuilder& builder, uint32_t count)
+{
+  static const char* const sourceTypes[] = { "Gradient Noise", "Checker", "Constant", "Gradient", "Value Noise" };
+  static const char* const innerTypes[] = { "Mix", "Add", "Multiply", "Invert" };
+  // The last layer is summed up, so that every node is upstream of the output
+  const uint32_t summed = count >= 3 * s_LayerWidth ? s_LayerWidth : 1;
+  const uint32_t layered = count - summed;
+  while (builder.GetCount() < std::min(s_LayerWidth, layered)) {
+    builder.Add(sourceTypes[builder.GetCount() % std::size(sourceTypes)]);
+  }
+  while (builder.GetCount() < layered) {
+    const uint32_t layer = builder.GetCount() / s_LayerWidth;
+    const uint32_t first = layer > s_LayerReach ? (layer - s_LayerReach) * s_LayerWidth : 0;
+    const uint32_t end = layer * s_LayerWidth;
+    const char* type = innerTypes[builder.NextIndex(0, (uint32_t)std::size(innerTypes))];
+    const uint32_t node = builder.Add(type);
+    // The first input continues the column of the node, the others read random nodes of the layers before
+    builder.Link(node - s_LayerWidth, node, 0);
+    for (uint32_t socket = 1; socket < FindKernel(type)->Inputs.size(); socket++) {
+      builder.Link(builder.NextIndex(first, end), node, socket);
+    }
+  }
+  std::vector<uint32_t> last;
+  for (uint32_t node = layered - summed; node < layered; node++) last.push_back(node);
+  return builder.Finish(AddSum(builder, std::move(last)));
+}
+
+} // namespace
+
+const char* GetCorpusShapeName(CorpusShape shape)
+{
+  switch (shape) {
+    case CorpusShape::Chain: return "Chain";
+    case CorpusShape::Fan: return "Fan";
+    case CorpusShape::Dag: return "Dag";
+  }
+  return "Unknown";
+}
+
+void Corpus::AddNodes(NodesTree& tree) const
+{
+  for (const Node& node : Nodes) tree.AddNode(node);
+}
+
+void Corpus::AddLinks(NodesTree& tree) const
+{
+  for (const NodeLink& link : Links) tree.AddLink(link);
+}
+
+const Corpus& GetCorpus(CorpusShape shape, uint32_t count)
+{
+  FR_ASSERT(count >= 3, "Corpora need room for a source, a node and the output!");
+  static std::map<std::pair<CorpusShape, uint32_t>, std::unique_ptr<Corpus>> s_Corpora;
+  std::unique_ptr<Corpus>& corpus = s_Corpora[{ shape, count }];
+  if (corpus) return *corpus;
+
+  CorpusBuilder builder(shape, count);
+  switch (shape) {
+    case CorpusShape::Chain: corpus = std::make_unique<Corpus>(BuildChain(builder, count)); break;
+    case CorpusShape::Fan: corpus = std::make_unique<Corpus>(BuildFan(builder, count)); break;
+    case CorpusShape::Dag: corpus = std::make_unique<Corpus>(BuildDag(builder, count)); break;
+  }
+  return *corpus;
+}
+
+} // namespace Texturia::Bench
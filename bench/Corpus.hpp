@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Nodes.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Texturia::Bench {
+
+// Synthetic node graphs the benchmarks run on. They are generated from fixed seeds, UUIDs included, so every run and
+// every version of texturia-bench measures exactly the same graphs.
+enum class CorpusShape {
+  // Noise followed by a single line of point-wise nodes
+  Chain,
+  // One source read by half of the nodes, summed up again by a balanced tree of Add nodes
+  Fan,
+  // Layers of 32 nodes, every node reads the node below it in the layer before and random nodes of the four layers
+  // before it
+  Dag
+};
+
+const char* GetCorpusShapeName(CorpusShape shape);
+
+struct Corpus {
+  // In the order they are generated in, links only go from earlier to later nodes
+  std::vector<Node> Nodes;
+  std::vector<NodeLink> Links;
+  // Last node, every other node is upstream of it
+  Frameio::UUID Output = 0;
+
+  void AddNodes(NodesTree& tree) const;
+  void AddLinks(NodesTree& tree) const;
+};
+
+// Exactly count nodes of shape, count has to be at least 3. Generated on first use and kept until the process exits.
+const Corpus& GetCorpus(CorpusShape shape, uint32_t count);
+
+} // namespace Texturia::Bench
@@ -0,0 +1,172 @@
+// Editing, traversing, serializing and baking the synthetic graphs of Corpus.hpp. Names are
+// <Operation>/<Shape>/<Node count>, the same graphs are generated on every run so the results can be compared across
+// versions with --baseline.
+
+#include "Bench.hpp"
+#include "Corpus.hpp"
+
+#include "Engine/Evaluator.hpp"
+#include "Engine/ImagePool.hpp"
+#include "Engine/ThreadPool.hpp"
+#include "Hash.hpp"
+
+#include <cstdio>
+
+namespace Texturia::Bench {
+
+namespace {
+
+constexpr CorpusShape s_Shapes[] = { CorpusShape::Chain, CorpusShape::Fan, CorpusShape::Dag };
+constexpr uint32_t s_NodeCounts[] = { 10'000, 100'000 };
+
+using CorpusFunction = void (*)(State& state, const Corpus& corpus);
+
+template <CorpusFunction Function, CorpusShape Shape>
+void RunOnCorpus(State& state)
+{
+  Function(state, GetCorpus(Shape, (uint32_t)state.GetArgument()));
+}
+
+template <CorpusFunction Function>
+void RegisterForCorpora(const char* name)
+{
+  const BenchmarkFunction functions[] = { RunOnCorpus<Function, CorpusShape::Chain>,
+                                          RunOnCorpus<Function, CorpusShape::Fan>,
+                                          RunOnCorpus<Function, CorpusShape::Dag> };
+  for (CorpusShape shape : s_Shapes) {
+    for (uint32_t count : s_NodeCounts) {
+      std::string fullName = std::string(name) + "/" + GetCorpusShapeName(shape) + "/" + std::to_string(count);
+      RegisterBenchmark(std::move(fullName), functions[(size_t)shape], count);
+    }
+  }
+}
+
+NodesTree LoadCorpus(const Corpus& corpus)
+{
+  NodesTree tree;
+  corpus.AddNodes(tree);
+  corpus.AddLinks(tree);
+  return tree;
+}
+
+void CorpusAddNode(State& state, const Corpus& corpus)
+{
+  while (state.KeepRunning()) {
+    NodesTree tree;
+    corpus.AddNodes(tree);
+    DoNotOptimize(tree);
+  }
+  state.SetItemsProcessed(state.GetIterations() * corpus.Nodes.size());
+}
+
+// Every link runs the cycle check
+void CorpusAddLink(State& state, const Corpus& corpus)
+{
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    NodesTree tree;
+    corpus.AddNodes(tree);
+    state.ResumeTiming();
+
+    corpus.AddLinks(tree);
+    DoNotOptimize(tree);
+  }
+  state.SetItemsProcessed(state.GetIterations() * corpus.Links.size());
+}
+
+// In a fixed random order, which moves nodes around in the columns and removes links from both of their ends
+void CorpusDeleteNode(State& state, const Corpus& corpus)
+{
+  std::vector<Frameio::UUID> order;
+  for (const Node& node : corpus.Nodes) order.push_back(node.UUID);
+  for (size_t i = order.size() - 1; i > 0; i--) std::swap(order[i], order[HashMix(i) % (i + 1)]);
+
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    NodesTree tree = LoadCorpus(corpus);
+    state.ResumeTiming();
+
+    for (const Frameio::UUID& uuid : order) tree.DeleteNode(uuid);
+    DoNotOptimize(tree);
+  }
+  state.SetItemsProcessed(state.GetIterations() * corpus.Nodes.size());
+}
+
+void CorpusTopologicalOrder(State& state, const Corpus& corpus)
+{
+  const NodesTree tree = LoadCorpus(corpus);
+  while (state.KeepRunning()) DoNotOptimize(tree.GetTopologicalOrder());
+  state.SetItemsProcessed(state.GetIterations() * tree.GetNodeCount());
+}
+
+// Depth first walk upstream from the output, content hashes are up to date after the first iteration
+void CorpusBuildPlan(State& state, const Corpus& corpus)
+{
+  const NodesTree tree = LoadCorpus(corpus);
+  size_t steps = 0;
+  while (state.KeepRunning()) {
+    EvaluationPlan plan = EvaluationPlan::Build(tree, corpus.Output);
+    steps = plan.GetSteps().size();
+    DoNotOptimize(plan);
+  }
+  state.SetItemsProcessed(state.GetIterations() * steps);
+  state.SetLabel(std::to_string(steps) + " steps");
+}
+
+void CorpusToString(State& state, const Corpus& corpus)
+{
+  const NodesTree tree = LoadCorpus(corpus);
+  size_t bytes = 0;
+  while (state.KeepRunning()) {
+    std::string text = tree.ToString();
+    bytes = text.size();
+    DoNotOptimize(text);
+  }
+  state.SetItemsProcessed(state.GetIterations() * tree.GetNodeCount());
+
+  char label[64];
+  std::snprintf(label, sizeof(label), "%.1f MiB", bytes / 1048576.0);
+  state.SetLabel(label);
+}
+
+// Full bake of a Dag corpus like texturia-bake writes a TIFF, chunk by chunk within a memory budget, without the disk.
+// Graphs of 10k nodes and more would take minutes per bake, so this one is small enough to run at 4K. The argument is
+// the resolution.
+void Bake(State& state)
+{
+  const Corpus& corpus = GetCorpus(CorpusShape::Dag, 128);
+  const NodesTree tree = LoadCorpus(corpus);
+  const EvaluationPlan plan = EvaluationPlan::Build(tree, corpus.Output);
+  EvaluationSettings settings = { (uint32_t)state.GetArgument(), (uint32_t)state.GetArgument(), 64, 0 };
+  settings.MemoryBudget = 256ull << 20;
+  ThreadPool pool;
+  ImagePool images;
+
+  while (state.KeepRunning()) {
+    float sum = 0.0f;
+    EvaluateStreaming(plan, settings, pool, images, settings.TileSize, [&](const Image& chunk) {
+      sum += *chunk.GetPointer(0, chunk.GetRegion().X, chunk.GetRegion().Y);
+      return true;
+    });
+    DoNotOptimize(sum);
+  }
+  // Output pixels
+  state.SetItemsProcessed(state.GetIterations() * settings.Width * settings.Height);
+  state.SetLabel(std::to_string(plan.GetSteps().size()) + " steps");
+}
+
+[[maybe_unused]] const bool s_Registered = [] {
+  RegisterForCorpora<CorpusAddNode>("AddNode");
+  RegisterForCorpora<CorpusAddLink>("AddLink");
+  RegisterForCorpora<CorpusDeleteNode>("DeleteNode");
+  RegisterForCorpora<CorpusTopologicalOrder>("TopologicalOrder");
+  RegisterForCorpora<CorpusBuildPlan>("BuildPlan");
+  RegisterForCorpora<CorpusToString>("ToString");
+  return true;
+}();
+
+} // namespace
+
+TX_BENCHMARK(Bake, { 1024, 4096 });
+
+} // namespace Texturia::Bench
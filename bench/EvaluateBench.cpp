@@ -0,0 +1,167 @@
+// Full evaluation of a material against re-evaluating it through a ResultCache after a leaf parameter changed, and
+// evaluation with point-wise chains fused into one pass against every node in its own pass.
+
+#include "Bench.hpp"
+
+#include "Engine/Evaluator.hpp"
+#include "Engine/ResultCache.hpp"
+#include "Engine/ThreadPool.hpp"
+
+#include <cstdio>
+
+namespace Texturia::Bench {
+
+namespace {
+
+const EvaluationSettings s_Settings = { 256, 256, 64, 0 };
+
+// Binary tree of Mix, Multiply and Add nodes over noise, checker and constant leaves, roughly count nodes in total.
+// Returns the UUID of the output node, the first leaf is a Gradient Noise node.
+Frameio::UUID BuildMaterial(NodesTree& tree, int64_t count, Frameio::UUID& leaf)
+{
+  static const char* const leafTypes[] = { "Gradient Noise", "Checker", "Constant" };
+  static const char* const combineTypes[] = { "Mix", "Multiply", "Add" };
+
+  std::vector<Frameio::UUID> layer;
+  for (int64_t i = 0; i < count / 2; i++) {
+    Node node = CreateNode(leafTypes[i % 3]);
+    if (i % 3 == 0) node.GetSockets()[1].Value = (int32_t)i;
+    tree.AddNode(node);
+    layer.push_back(node.UUID);
+  }
+  leaf = layer.front();
+
+  for (uint32_t round = 0; layer.size() > 1; round++) {
+    std::vector<Frameio::UUID> next;
+    for (size_t i = 0; i + 1 < layer.size(); i += 2) {
+      Node node = CreateNode(combineTypes[(round + i) % 3]);
+      tree.AddNode(node);
+      tree.AddLink({ layer[i], node.UUID, 0 });
+      tree.AddLink({ layer[i + 1], node.UUID, 1 });
+      next.push_back(node.UUID);
+    }
+    if (layer.size() % 2 == 1) next.push_back(layer.back());
+    layer = std::move(next);
+  }
+
+  Node output = CreateNode("Output");
+  tree.AddNode(output);
+  tree.AddLink({ layer.front(), output.UUID, 0 });
+  return output.UUID;
+}
+
+void FullEvaluate(State& state)
+{
+  NodesTree tree;
+  Frameio::UUID leaf;
+  const Frameio::UUID output = BuildMaterial(tree, state.GetArgument(), leaf);
+  ThreadPool pool;
+
+  int32_t seed = 0;
+  while (state.KeepRunning()) {
+    tree.SetSocketValue(tree.FindNode(leaf), 1, ++seed);
+    EvaluationPlan plan = EvaluationPlan::Build(tree, output);
+    DoNotOptimize(Evaluate(plan, s_Settings, pool));
+  }
+  state.SetItemsProcessed(state.GetIterations());
+}
+
+void IncrementalEvaluate(State& state)
+{
+  NodesTree tree;
+  Frameio::UUID leaf;
+  const Frameio::UUID output = BuildMaterial(tree, state.GetArgument(), leaf);
+  ThreadPool pool;
+  ResultCache cache;
+  Evaluate(EvaluationPlan::Build(tree, output), s_Settings, pool, cache);
+  cache.ResetCounters();
+
+  // Every iteration uses a new seed, so the leaf and everything downstream of it is a miss
+  int32_t seed = 0;
+  while (state.KeepRunning()) {
+    tree.SetSocketValue(tree.FindNode(leaf), 1, ++seed);
+    EvaluationPlan plan = EvaluationPlan::Build(tree, output);
+    DoNotOptimize(Evaluate(plan, s_Settings, pool, cache));
+  }
+  state.SetItemsProcessed(state.GetIterations());
+
+  const CacheStatistics statistics = cache.GetStatistics();
+  char label[128];
+  std::snprintf(label, sizeof(label), "hits %llu, misses %llu, evicted %llu MiB",
+                (unsigned long long)statistics.Hits, (unsigned long long)statistics.Misses,
+                (unsigned long long)(statistics.EvictedBytes >> 20));
+  state.SetLabel(label);
+}
+
+// Two noise layers blended through a chain of count point-wise nodes, the shape of most material graphs
+Frameio::UUID BuildChain(NodesTree& tree, int64_t count)
+{
+  Node noise = CreateNode("Gradient Noise");
+  Node worley = CreateNode("Worley Noise");
+  tree.AddNode(noise);
+  tree.AddNode(worley);
+
+  static const char* const chainTypes[] = { "Multiply", "Add", "Mix", "Invert" };
+  Frameio::UUID previous = noise.UUID;
+  for (int64_t i = 0; i < count; i++) {
+    Node node = CreateNode(chainTypes[i % 4]);
+    if (node.Type == "Multiply") node.GetSockets()[1].Value = SocketValue::Color(0.9f, 0.8f, 0.7f);
+    if (node.Type == "Add") node.GetSockets()[1].Value = 0.05f;
+    tree.AddNode(node);
+    tree.AddLink({ previous, node.UUID, 0 });
+    if (node.Type == "Mix") tree.AddLink({ worley.UUID, node.UUID, 2 });
+    previous = node.UUID;
+  }
+
+  Node output = CreateNode("Output");
+  tree.AddNode(output);
+  tree.AddLink({ previous, output.UUID, 0 });
+  return output.UUID;
+}
+
+void RunChain(State& state, bool fuse, Profiler* profiler = nullptr)
+{
+  NodesTree tree;
+  const Frameio::UUID output = BuildChain(tree, state.GetArgument());
+  const EvaluationPlan plan = EvaluationPlan::Build(tree, output);
+  ThreadPool pool;
+  EvaluationSettings settings = { 1024, 1024, 64, 0 };
+  settings.Fuse = fuse;
+  settings.Profile = profiler;
+
+  while (state.KeepRunning()) DoNotOptimize(Evaluate(plan, settings, pool));
+  // Pixels of the whole chain
+  state.SetItemsProcessed(state.GetIterations() * settings.Width * settings.Height * plan.GetSteps().size());
+}
+
+// Items/s is node pixels per second, 1024x1024
+void FusedChain(State& state)
+{
+  RunChain(state, true);
+}
+
+void UnfusedChain(State& state)
+{
+  RunChain(state, false);
+}
+
+// Fused, with every kernel call timed. Compare against FusedChain for the cost of recording.
+void ProfiledChain(State& state)
+{
+  Profiler profiler;
+  RunChain(state, true, &profiler);
+
+  char label[64];
+  std::snprintf(label, sizeof(label), "%zu nodes profiled", profiler.GetNodeProfiles().size());
+  state.SetLabel(label);
+}
+
+} // namespace
+
+TX_BENCHMARK(FusedChain, { 8, 32 });
+TX_BENCHMARK(UnfusedChain, { 8, 32 });
+TX_BENCHMARK(ProfiledChain, { 8, 32 });
+TX_BENCHMARK(FullEvaluate, { 300 });
+TX_BENCHMARK(IncrementalEvaluate, { 300 });
+
+} // namespace Texturia::Bench
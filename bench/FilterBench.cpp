@@ -0,0 +1,113 @@
+// Convolutions of a 1024x1024 image in 64x64 tiles like a bake with the default settings, halos included. The
+// argument is the radius in pixels. Items/s is pixels per second. The "Forced" benchmarks run a kernel with a strategy
+// ChooseStrategy would not pick, to check its choices: compare FilterDense with FilterDenseForcedDirect and
+// FilterDenseForcedFourier, or FilterBox with FilterBoxForcedSeparable.
+
+#include "Bench.hpp"
+
+#include "Engine/Filters/Filters.hpp"
+
+#include <cmath>
+#include <optional>
+
+namespace Texturia::Bench {
+
+namespace {
+
+constexpr int32_t s_Size = 1024, s_TileSize = 64;
+
+const Image& GetSource()
+{
+  static const Image s_Source = [] {
+    Image image(s_Size, s_Size);
+    for (int32_t y = 0; y < s_Size; y++) {
+      for (int32_t x = 0; x < s_Size; x++) {
+        const float value = 0.5f + 0.25f * std::sin(x * 0.05f) + 0.25f * std::cos(y * 0.07f + x * 0.01f);
+        image.SetPixel(x, y, { value, 1.0f - value, value * value, 1.0f });
+      }
+    }
+    return image;
+  }();
+  return s_Source;
+}
+
+// Cone weights like the Ambient Occlusion node, a kernel that is not separable
+Filters::FilterKernel CreateCone(int32_t radius)
+{
+  const int32_t taps = 2 * radius + 1;
+  std::vector<float> weights((size_t)taps * taps);
+  for (int32_t y = -radius; y <= radius; y++) {
+    for (int32_t x = -radius; x <= radius; x++) {
+      weights[(y + radius) * taps + x + radius] = std::max(0.0f, 1.0f - std::sqrt((float)(x * x + y * y)) / radius);
+    }
+  }
+  return Filters::FilterKernel::Dense(radius, std::move(weights));
+}
+
+void RunFilter(State& state, const Filters::FilterKernel& kernel, std::optional<Filters::Strategy> strategy = {})
+{
+  const KernelInput input = { &GetSource(), Pixel() };
+  Image output(s_Size, s_Size), block;
+  const Filters::Strategy chosen = strategy ? *strategy : Filters::ChooseStrategy(kernel);
+  const int32_t halo = Filters::GetHalo(kernel.Radius, chosen);
+  state.SetLabel(Filters::GetStrategyName(chosen));
+
+  while (state.KeepRunning()) {
+    for (int32_t y = 0; y < s_Size; y += s_TileSize) {
+      for (int32_t x = 0; x < s_Size; x += s_TileSize) {
+        const Rect region = { x, y, s_TileSize, s_TileSize };
+        Filters::LoadBlock(input, region.Expand(halo), Image::Channels, block);
+        Filters::Convolve(kernel, block, Image::Channels, region, output, chosen);
+      }
+    }
+    DoNotOptimize(output);
+  }
+  state.SetItemsProcessed(state.GetIterations() * s_Size * s_Size);
+}
+
+void FilterGaussian(State& state)
+{
+  RunFilter(state, Filters::FilterKernel::Gaussian((int32_t)state.GetArgument()));
+}
+
+void FilterGaussianForcedDirect(State& state)
+{
+  RunFilter(state, Filters::FilterKernel::Gaussian((int32_t)state.GetArgument()), Filters::Strategy::Direct);
+}
+
+void FilterBox(State& state)
+{
+  RunFilter(state, Filters::FilterKernel::Box((int32_t)state.GetArgument()));
+}
+
+void FilterBoxForcedSeparable(State& state)
+{
+  RunFilter(state, Filters::FilterKernel::Box((int32_t)state.GetArgument()), Filters::Strategy::Separable);
+}
+
+void FilterDense(State& state)
+{
+  RunFilter(state, CreateCone((int32_t)state.GetArgument()));
+}
+
+void FilterDenseForcedDirect(State& state)
+{
+  RunFilter(state, CreateCone((int32_t)state.GetArgument()), Filters::Strategy::Direct);
+}
+
+void FilterDenseForcedFourier(State& state)
+{
+  RunFilter(state, CreateCone((int32_t)state.GetArgument()), Filters::Strategy::Fourier);
+}
+
+} // namespace
+
+TX_BENCHMARK(FilterGaussian, { 4, 16, 64 });
+TX_BENCHMARK(FilterGaussianForcedDirect, { 4, 16 });
+TX_BENCHMARK(FilterBox, { 4, 16, 64 });
+TX_BENCHMARK(FilterBoxForcedSeparable, { 4, 16, 64 });
+TX_BENCHMARK(FilterDense, { 2, 4, 8, 16, 32 });
+TX_BENCHMARK(FilterDenseForcedDirect, { 2, 4, 8, 16 });
+TX_BENCHMARK(FilterDenseForcedFourier, { 2, 4, 8, 16, 32 });
+
+} // namespace Texturia::Bench
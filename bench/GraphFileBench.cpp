@@ -0,0 +1,102 @@
+// Loading a 50k node graph from a .txg file, the mapping on its own and into a NodesTree, against the JSON form of the
+// same graph. Items/s is nodes per second.
+
+#include "Bench.hpp"
+
+#include "AllocationCounter.hpp"
+#include "Engine/GraphFile.hpp"
+#include "Engine/GraphJson.hpp"
+#include "Engine/NodeRegistry.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <unordered_set>
+
+namespace Texturia::Bench {
+
+namespace {
+
+const std::vector<int64_t> s_NodeCounts = { 50'000 };
+
+// Random DAG of kernel nodes, every linkable input is driven by an earlier node with probability 1/2
+void BuildGraph(NodesTree& tree, int64_t count)
+{
+  const std::vector<const NodeKernel*> kernels = GetNodeRegistry().GetKernels();
+  std::mt19937 random(7);
+  std::vector<NodeHandle> handles;
+  for (int64_t i = 0; i < count; i++) {
+    const NodeKernel& kernel = *kernels[random() % kernels.size()];
+    handles.push_back(tree.AddNode(CreateNode(kernel.Type, "Node " + std::to_string(i), Frameio::UUID(i + 1))));
+    for (uint32_t socket = 0; i > 0 && socket < kernel.Inputs.size(); socket++) {
+      if (random() % 2 == 0) tree.AddLink(handles[random() % i], { handles.back(), socket });
+    }
+  }
+}
+
+// Written once per run and node count, then reused by every benchmark
+std::string GetGraphPath(int64_t count, const char* extension)
+{
+  static std::unordered_set<std::string> s_Written;
+  const std::filesystem::path path =
+    std::filesystem::temp_directory_path() / ("texturia-bench-" + std::to_string(count) + extension);
+  if (s_Written.insert(path.string()).second) {
+    NodesTree tree("Bench");
+    BuildGraph(tree, count);
+    if (std::string(extension) == ".txg") {
+      WriteGraphFile(tree, path.string());
+    } else {
+      std::ofstream(path) << ExportGraphJson(tree);
+    }
+  }
+  return path.string();
+}
+
+// Maps the file and reads every node record in place
+void GraphFileOpen(State& state)
+{
+  const std::string path = GetGraphPath(state.GetArgument(), ".txg");
+  GraphFile file;
+  uint64_t sockets = 0;
+  while (state.KeepRunning()) {
+    NoAllocationScope scope("GraphFile::Open");
+    if (!file.Open(path)) return state.Skip(file.GetError());
+    for (const GraphFormat::NodeRecord& node : file.GetNodes()) sockets += file.GetParameters(node).size();
+    DoNotOptimize(sockets);
+  }
+  state.SetItemsProcessed(state.GetIterations() * file.GetNodes().size());
+}
+TX_BENCHMARK(GraphFileOpen, s_NodeCounts);
+
+void GraphFileLoad(State& state)
+{
+  const std::string path = GetGraphPath(state.GetArgument(), ".txg");
+  NodesTree tree;
+  while (state.KeepRunning()) {
+    GraphFile file(path);
+    if (!file.Load(tree)) return state.Skip(file.GetError());
+    DoNotOptimize(tree);
+  }
+  state.SetItemsProcessed(state.GetIterations() * tree.GetNodeCount());
+}
+TX_BENCHMARK(GraphFileLoad, s_NodeCounts);
+
+void GraphJsonImport(State& state)
+{
+  std::ostringstream json;
+  json << std::ifstream(GetGraphPath(state.GetArgument(), ".json")).rdbuf();
+  const std::string text = json.str();
+  NodesTree tree;
+  std::string error;
+  while (state.KeepRunning()) {
+    if (!ImportGraphJson(text, tree, error)) return state.Skip(error);
+    DoNotOptimize(tree);
+  }
+  state.SetItemsProcessed(state.GetIterations() * tree.GetNodeCount());
+}
+TX_BENCHMARK(GraphJsonImport, s_NodeCounts);
+
+} // namespace
+
+} // namespace Texturia::Bench
@@ -0,0 +1,117 @@
+// A material made of the argument many uses of a "scratches" subgraph, as nodes of one group and as copies of its
+// nodes. The uses only have four distinct parameters and the dirt layer of the subgraph does not read any, so the
+// grouped plan evaluates the dirt once and the rest four times. GroupedBuild only builds the plan. Items/s is uses
+// per second.
+
+#include "Bench.hpp"
+
+#include "Engine/Evaluator.hpp"
+#include "Engine/ThreadPool.hpp"
+
+namespace Texturia::Bench {
+
+namespace {
+
+const EvaluationSettings s_Settings = { 256, 256, 64, 0 };
+
+struct Material {
+  NodesTree Tree;
+  Frameio::UUID Output;
+
+  Material(int64_t uses, bool grouped)
+  {
+    NodesTree body;
+    Node dirt = CreateNode("Fractal Noise");
+    Node blur = CreateNode("Blur");
+    Node scratches = CreateNode("Worley Noise");
+    Node invert = CreateNode("Invert");
+    Node mix = CreateNode("Mix");
+    for (const Node* node : { &dirt, &blur, &scratches, &invert, &mix }) body.AddNode(*node);
+    body.AddLink({ dirt.UUID, blur.UUID, 0 });
+    body.AddLink({ scratches.UUID, invert.UUID, 0 });
+    body.AddLink({ blur.UUID, mix.UUID, 0 });
+    body.AddLink({ invert.UUID, mix.UUID, 1 });
+    std::string error;
+    std::vector<GroupParameter> parameters = { { "Scale", 8.0f, { { scratches.UUID, 0 } } },
+                                                { "Wear", 0.5f, { { mix.UUID, 2 } } } };
+    const Frameio::Ref<const NodeGroup> group = NodeGroup::Create("Scratches", body, mix.UUID, parameters, error);
+    FR_ASSERT(group, error);
+    Tree.SetGroup(group);
+
+    Node output = CreateNode("Output");
+    Tree.AddNode(output);
+    Output = output.UUID;
+    Frameio::UUID previous = Output;
+    for (int64_t i = 0; i < uses; i++) {
+      const SocketValue scale = 4.0f + 4.0f * (float)(i % 2), wear = 0.25f + 0.5f * (float)(i / 2 % 2);
+      Frameio::UUID use;
+      if (grouped) {
+        Node node = group->CreateNode();
+        node.GetSockets()[0].Value = scale;
+        node.GetSockets()[1].Value = wear;
+        Tree.AddNode(node);
+        use = node.UUID;
+      } else {
+        // Fresh UUIDs for the copies of the body, links follow them
+        std::unordered_map<Frameio::UUID, Frameio::UUID> copies;
+        for (uint32_t node = 0; node < body.GetNodeCount(); node++) {
+          Node copy = body.GetNode(body.GetHandle(node));
+          copies[copy.UUID] = Frameio::UUID();
+          copy.UUID = copies[copy.UUID];
+          if (copy.Type == "Worley Noise") copy.GetSockets()[0].Value = scale;
+          if (copy.Type == "Mix") copy.GetSockets()[2].Value = wear;
+          Tree.AddNode(copy);
+        }
+        for (uint32_t link = 0; link < body.GetLinkCount(); link++) {
+          const LinkHandle handle = body.GetLinkHandle(link);
+          const SocketHandle target = body.GetLinkTarget(handle);
+          Tree.AddLink({ copies[body.GetUUID(body.GetLinkSource(handle))], copies[body.GetUUID(target.Node)],
+                         target.Socket });
+        }
+        use = copies[mix.UUID];
+      }
+
+      // Chain of Add nodes into the output
+      Node add = CreateNode("Add");
+      Tree.AddNode(add);
+      Tree.AddLink({ add.UUID, previous, 0 });
+      Tree.AddLink({ use, add.UUID, 1 });
+      previous = add.UUID;
+    }
+  }
+};
+
+void GroupedBuild(State& state)
+{
+  Material material(state.GetArgument(), true);
+  while (state.KeepRunning()) DoNotOptimize(EvaluationPlan::Build(material.Tree, material.Output));
+  state.SetItemsProcessed(state.GetIterations() * state.GetArgument());
+}
+
+void BakeUses(State& state, bool grouped)
+{
+  Material material(state.GetArgument(), grouped);
+  ThreadPool pool;
+  const EvaluationPlan plan = EvaluationPlan::Build(material.Tree, material.Output);
+  state.SetLabel(std::to_string(plan.GetSteps().size()) + " steps");
+  while (state.KeepRunning()) DoNotOptimize(Evaluate(plan, s_Settings, pool));
+  state.SetItemsProcessed(state.GetIterations() * state.GetArgument());
+}
+
+void GroupedBake(State& state)
+{
+  BakeUses(state, true);
+}
+
+void CopiedBake(State& state)
+{
+  BakeUses(state, false);
+}
+
+} // namespace
+
+TX_BENCHMARK(GroupedBuild, { 16, 256 });
+TX_BENCHMARK(GroupedBake, { 4, 16, 64 });
+TX_BENCHMARK(CopiedBake, { 4, 16, 64 });
+
+} // namespace Texturia::Bench
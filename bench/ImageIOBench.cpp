@@ -0,0 +1,99 @@
+// Reading and writing 1024x1024 images. ImageDecode and ImageEncode take the format as argument (0 PNG, 1 TGA, 2 EXR,
+// 3 PFM) and work on memory only. ImageSaveMaps writes the eight maps of a material through ImageIO, the argument is
+// the number of threads: on enough cores 8 threads take about as long as one map. ImageLoadCached loads a file whose
+// contents ImageIO already decoded, which only maps and hashes it. Items/s is pixels per second.
+
+#include "Bench.hpp"
+
+#include "Engine/ImageIO.hpp"
+#include "Engine/ImageReader.hpp"
+#include "Engine/ImageWriter.hpp"
+
+#include <cmath>
+#include <filesystem>
+
+namespace Texturia::Bench {
+
+namespace {
+
+constexpr int32_t s_Size = 1024;
+constexpr uint32_t s_MapCount = 8;
+const char* const s_Extensions[] = { ".png", ".tga", ".exr", ".pfm" };
+
+Frameio::Ref<const Image> GetSource()
+{
+  static const Frameio::Ref<const Image> s_Source = [] {
+    Frameio::Ref<Image> image = std::make_shared<Image>(s_Size, s_Size);
+    for (int32_t y = 0; y < s_Size; y++) {
+      for (int32_t x = 0; x < s_Size; x++) {
+        const float value = 0.5f + 0.25f * std::sin(x * 0.05f) + 0.25f * std::cos(y * 0.07f + x * 0.01f);
+        image->SetPixel(x, y, { value, 1.0f - value, value * value, 1.0f });
+      }
+    }
+    return image;
+  }();
+  return s_Source;
+}
+
+void ImageEncode(State& state)
+{
+  const Frameio::Ref<const Image> source = GetSource();
+  std::vector<uint8_t> bytes;
+  while (state.KeepRunning()) {
+    bytes.clear();
+    EncodeImage(*source, s_Extensions[state.GetArgument()], bytes);
+    DoNotOptimize(bytes);
+  }
+  state.SetItemsProcessed(state.GetIterations() * s_Size * s_Size);
+  state.SetLabel(s_Extensions[state.GetArgument()]);
+}
+
+void ImageDecode(State& state)
+{
+  std::vector<uint8_t> bytes;
+  EncodeImage(*GetSource(), s_Extensions[state.GetArgument()], bytes);
+  Image image;
+  std::string error;
+  while (state.KeepRunning()) {
+    DecodeImage(std::as_bytes(std::span(bytes)), image, error);
+    DoNotOptimize(image);
+  }
+  state.SetItemsProcessed(state.GetIterations() * s_Size * s_Size);
+  state.SetLabel(s_Extensions[state.GetArgument()]);
+}
+
+void ImageSaveMaps(State& state)
+{
+  const std::filesystem::path directory = std::filesystem::temp_directory_path();
+  ImageIO io((uint32_t)state.GetArgument());
+  while (state.KeepRunning()) {
+    for (uint32_t i = 0; i < s_MapCount; i++) {
+      io.Save(GetSource(), (directory / ("texturia-bench-map-" + std::to_string(i) + ".png")).string());
+    }
+    io.Wait();
+  }
+  state.SetItemsProcessed(state.GetIterations() * s_MapCount * s_Size * s_Size);
+}
+
+void ImageLoadCached(State& state)
+{
+  const std::string path = (std::filesystem::temp_directory_path() / "texturia-bench-cached.png").string();
+  WriteImage(*GetSource(), path);
+  ImageIO io(1);
+  io.Load(path)->Wait();
+  while (state.KeepRunning()) {
+    const Frameio::Ref<ImageTask> load = io.Load(path);
+    load->Wait();
+    DoNotOptimize(load->GetImage());
+  }
+  state.SetItemsProcessed(state.GetIterations() * s_Size * s_Size);
+}
+
+} // namespace
+
+TX_BENCHMARK(ImageEncode, { 0, 1, 2, 3 });
+TX_BENCHMARK(ImageDecode, { 0, 1, 2, 3 });
+TX_BENCHMARK(ImageSaveMaps, { 1, 2, 4, 8 });
+TX_BENCHMARK(ImageLoadCached);
+
+} // namespace Texturia::Bench
@@ -0,0 +1,65 @@
+// Throughput of every registered kernel on its own, run tile by tile over a 1024x1024 image with every float and color
+// socket linked to an image and the other sockets at their defaults. Items/s is pixels per second.
+
+#include "Bench.hpp"
+
+#include "Engine/NodeRegistry.hpp"
+
+#include <cstdio>
+
+namespace Texturia::Bench {
+
+namespace {
+
+constexpr uint32_t s_KernelSize = 1024, s_KernelTileSize = 64;
+
+void KernelThroughput(State& state)
+{
+  const NodeKernel& kernel = *GetNodeRegistry().GetKernels()[state.GetArgument()];
+
+  Image source(s_KernelSize, s_KernelSize);
+  for (int32_t y = 0; y < (int32_t)s_KernelSize; y++) {
+    for (int32_t x = 0; x < (int32_t)s_KernelSize; x++) {
+      source.SetPixel(x, y, { x / (float)s_KernelSize, y / (float)s_KernelSize, 0.5f, 1.0f });
+    }
+  }
+  std::vector<KernelInput> inputs;
+  for (const SocketSchema& socket : kernel.Inputs) {
+    const bool linked = socket.Default.Type == SocketType::Float || socket.Default.Type == SocketType::Color;
+    inputs.push_back({ linked ? &source : nullptr, ToPixel(socket.Default) });
+  }
+
+  Image output(s_KernelSize, s_KernelSize);
+  while (state.KeepRunning()) {
+    for (uint32_t y = 0; y < s_KernelSize; y += s_KernelTileSize) {
+      for (uint32_t x = 0; x < s_KernelSize; x += s_KernelTileSize) {
+        const Rect tile = { (int32_t)x, (int32_t)y, (int32_t)s_KernelTileSize, (int32_t)s_KernelTileSize };
+        kernel.Run({ tile, s_KernelSize, s_KernelSize, inputs, &output });
+      }
+    }
+    DoNotOptimize(output);
+  }
+  state.SetItemsProcessed(state.GetIterations() * s_KernelSize * s_KernelSize);
+
+  char label[64];
+  const double seconds = state.GetSeconds() / state.GetIterations();
+  std::snprintf(label, sizeof(label), "%.1f Mpix/s", s_KernelSize * s_KernelSize / seconds * 1e-6);
+  state.SetLabel(label);
+}
+
+// One benchmark per kernel, named Kernel/<Type> without the spaces
+[[maybe_unused]] const bool s_Registered = [] {
+  const std::vector<const NodeKernel*> kernels = GetNodeRegistry().GetKernels();
+  for (size_t i = 0; i < kernels.size(); i++) {
+    std::string name = "Kernel/";
+    for (const char* c = kernels[i]->Type; *c; c++) {
+      if (*c != ' ') name += *c;
+    }
+    RegisterBenchmark(std::move(name), KernelThroughput, (int64_t)i);
+  }
+  return true;
+}();
+
+} // namespace
+
+} // namespace Texturia::Bench
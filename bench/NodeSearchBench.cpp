@@ -0,0 +1,87 @@
+// Searches of the add node popup in registries of synthetic node types, the argument is the number of types. Typing
+// runs one search per prefix of a query like the popup does on every keystroke, items are keystrokes.
+
+#include "Bench.hpp"
+
+#include "Engine/NodeRegistry.hpp"
+
+#include <cstdio>
+#include <map>
+#include <random>
+
+namespace Texturia::Bench {
+
+namespace {
+
+// Names like "Blurred Cell Noise 17", half of them kernels and half presets of the kernels before them
+const NodeRegistry& GetSyntheticRegistry(int64_t count)
+{
+  static constexpr const char* s_Adjectives[] = { "Blurred", "Ridged", "Warped", "Tiled", "Sharp", "Soft", "Radial",
+                                                  "Layered", "Inverted", "Directional", "Curved", "Fractal" };
+  static constexpr const char* s_Nouns[] = { "Noise", "Gradient", "Checker", "Cells", "Bricks", "Scratches", "Waves",
+                                             "Mask", "Blend", "Levels", "Normal", "Curvature", "Edges", "Dirt" };
+  static constexpr const char* s_Categories[] = { "Generators", "Math", "Noise", "Filters", "Patterns" };
+  static std::map<int64_t, std::unique_ptr<NodeRegistry>> s_Registries;
+  // NodeKernel::Type does not own its name
+  static std::deque<std::string> s_Names;
+
+  std::unique_ptr<NodeRegistry>& registry = s_Registries[count];
+  if (registry) return *registry;
+  registry = std::make_unique<NodeRegistry>();
+
+  std::mt19937 random(7);
+  const NodeKernel& base = *GetNodeRegistry().FindKernel("Fractal Noise");
+  std::vector<std::string> kernels;
+  for (int64_t i = 0; i < count; i++) {
+    std::string name = std::string(s_Adjectives[random() % std::size(s_Adjectives)]) + " " +
+                       s_Nouns[random() % std::size(s_Nouns)] + " " + std::to_string(i);
+    const std::string category = s_Categories[random() % std::size(s_Categories)];
+    if (i % 2 == 0) {
+      NodeKernel kernel = base;
+      kernel.Type = s_Names.emplace_back(std::move(name)).c_str();
+      kernels.push_back(kernel.Type);
+      registry->AddKernel(std::move(kernel), category);
+    } else {
+      registry->AddPreset(name, kernels[random() % kernels.size()], { { "Octaves", 3 } }, category);
+    }
+  }
+  return *registry;
+}
+
+void RunKeystrokes(State& state, std::string_view query)
+{
+  const NodeRegistry& registry = GetSyntheticRegistry(state.GetArgument());
+  size_t results = 0;
+  while (state.KeepRunning()) {
+    for (size_t length = 1; length <= query.size(); length++) {
+      const std::vector<const NodeType*> types = registry.Search(query.substr(0, length));
+      results += types.size();
+      DoNotOptimize(types);
+    }
+  }
+  state.SetItemsProcessed(state.GetIterations() * query.size());
+
+  char label[64];
+  std::snprintf(label, sizeof(label), "%.1f results per keystroke",
+                (double)results / (state.GetIterations() * query.size()));
+  state.SetLabel(label);
+}
+
+// Most prefixes are substrings of many names
+void NodeSearchTyping(State& state)
+{
+  RunKeystrokes(state, "warped noise");
+}
+
+// The characters are in order but not adjacent, so every search ends in the scattered scan over all types
+void NodeSearchFuzzy(State& state)
+{
+  RunKeystrokes(state, "wrpdnse");
+}
+
+} // namespace
+
+TX_BENCHMARK(NodeSearchTyping, { 1'000, 10'000 });
+TX_BENCHMARK(NodeSearchFuzzy, { 1'000, 10'000 });
+
+} // namespace Texturia::Bench
@@ -0,0 +1,350 @@
+// Compares the dense NodesTree storage against the std::unordered_map<UUID, Node> it replaced.
+
+#include "Bench.hpp"
+
+#include "AllocationCounter.hpp"
+#include "Nodes.hpp"
+#include "UndoHistory.hpp"
+
+#include <frameio/ImGui/Nodes.hpp>
+#include <frameio/frameio.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace Texturia::Bench {
+
+namespace {
+
+using NodesMap = std::unordered_map<Frameio::UUID, Node>;
+
+const std::vector<int64_t> s_NodeCounts = { 1'000, 10'000 };
+
+std::vector<Node> CreateNodes(int64_t count)
+{
+  std::vector<Node> nodes;
+  nodes.reserve(count);
+  for (int64_t i = 0; i < count; i++) nodes.push_back(Node("Node " + std::to_string(i), Frameio::UUID(i + 1)));
+  return nodes;
+}
+
+float SumSocket(const SocketValue& value)
+{
+  return value.Type == SocketType::Float ? value.AsFloat() : 1.0f;
+}
+
+void NodesTreeInsert(State& state)
+{
+  const std::vector<Node> nodes = CreateNodes(state.GetArgument());
+  while (state.KeepRunning()) {
+    NodesTree tree;
+    for (const Node& node : nodes) tree.AddNode(node);
+    DoNotOptimize(tree);
+  }
+  state.SetItemsProcessed(state.GetIterations() * nodes.size());
+}
+TX_BENCHMARK(NodesTreeInsert, s_NodeCounts);
+
+void NodesMapInsert(State& state)
+{
+  const std::vector<Node> nodes = CreateNodes(state.GetArgument());
+  while (state.KeepRunning()) {
+    NodesMap map;
+    for (const Node& node : nodes) map.insert({ node.UUID, node });
+    DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.GetIterations() * nodes.size());
+}
+TX_BENCHMARK(NodesMapInsert, s_NodeCounts);
+
+void NodesTreeDelete(State& state)
+{
+  const std::vector<Node> nodes = CreateNodes(state.GetArgument());
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    NodesTree tree;
+    for (const Node& node : nodes) tree.AddNode(node);
+    state.ResumeTiming();
+
+    for (const Node& node : nodes) tree.DeleteNode(node.UUID);
+    DoNotOptimize(tree);
+  }
+  state.SetItemsProcessed(state.GetIterations() * nodes.size());
+}
+TX_BENCHMARK(NodesTreeDelete, s_NodeCounts);
+
+void NodesMapDelete(State& state)
+{
+  const std::vector<Node> nodes = CreateNodes(state.GetArgument());
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    NodesMap map;
+    for (const Node& node : nodes) map.insert({ node.UUID, node });
+    state.ResumeTiming();
+
+    for (const Node& node : nodes) map.erase(node.UUID);
+    DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(state.GetIterations() * nodes.size());
+}
+TX_BENCHMARK(NodesMapDelete, s_NodeCounts);
+
+// Touches the UUID and every socket value of every node, like evaluation and UI passes do
+void NodesTreeIterate(State& state)
+{
+  NodesTree tree;
+  for (const Node& node : CreateNodes(state.GetArgument())) tree.AddNode(node);
+
+  while (state.KeepRunning()) {
+    float sum = 0.0f;
+    uint64_t uuids = 0;
+    for (uint32_t i = 0; i < tree.GetNodeCount(); i++) {
+      NodeHandle handle = tree.GetHandle(i);
+      uuids ^= tree.GetUUID(handle);
+      std::span<const SocketType> types = tree.GetSocketTypes(handle);
+      std::span<const SocketData> data = tree.GetSocketData(handle);
+      for (size_t socket = 0; socket < types.size(); socket++) sum += SumSocket({ types[socket], data[socket] });
+    }
+    DoNotOptimize(sum);
+    DoNotOptimize(uuids);
+  }
+  state.SetItemsProcessed(state.GetIterations() * tree.GetNodeCount());
+}
+TX_BENCHMARK(NodesTreeIterate, s_NodeCounts);
+
+void NodesMapIterate(State& state)
+{
+  NodesMap map;
+  for (const Node& node : CreateNodes(state.GetArgument())) map.insert({ node.UUID, node });
+
+  while (state.KeepRunning()) {
+    float sum = 0.0f;
+    uint64_t uuids = 0;
+    for (const auto& [uuid, node] : map) {
+      uuids ^= uuid;
+      for (const NodeSocket& socket : node.GetSockets()) sum += SumSocket(socket.Value);
+    }
+    DoNotOptimize(sum);
+    DoNotOptimize(uuids);
+  }
+  state.SetItemsProcessed(state.GetIterations() * map.size());
+}
+TX_BENCHMARK(NodesMapIterate, s_NodeCounts);
+
+// Random DAG with two links into every node but the first, from nodes created earlier. Links are added in random order,
+// so the cycle check has to walk real downstream subgraphs.
+std::vector<NodeLink> CreateLinks(const std::vector<Node>& nodes)
+{
+  std::mt19937 random(42);
+  std::vector<NodeLink> links;
+  for (size_t i = 1; i < nodes.size(); i++) {
+    for (uint32_t socket = 0; socket < 2; socket++) {
+      links.push_back({ nodes[random() % i].UUID, nodes[i].UUID, socket });
+    }
+  }
+  std::shuffle(links.begin(), links.end(), random);
+  return links;
+}
+
+void NodesTreeLink(State& state)
+{
+  const std::vector<Node> nodes = CreateNodes(state.GetArgument());
+  const std::vector<NodeLink> links = CreateLinks(nodes);
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    NodesTree tree;
+    for (const Node& node : nodes) tree.AddNode(node);
+    state.ResumeTiming();
+
+    for (const NodeLink& link : links) tree.AddLink(link);
+    DoNotOptimize(tree);
+  }
+  state.SetItemsProcessed(state.GetIterations() * links.size());
+}
+TX_BENCHMARK(NodesTreeLink, s_NodeCounts);
+
+void NodesTreeUnlink(State& state)
+{
+  const std::vector<Node> nodes = CreateNodes(state.GetArgument());
+  const std::vector<NodeLink> links = CreateLinks(nodes);
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    NodesTree tree;
+    for (const Node& node : nodes) tree.AddNode(node);
+    std::vector<LinkHandle> handles;
+    for (const NodeLink& link : links) handles.push_back(tree.AddLink(link));
+    state.ResumeTiming();
+
+    for (LinkHandle handle : handles) tree.RemoveLink(handle);
+    DoNotOptimize(tree);
+  }
+  state.SetItemsProcessed(state.GetIterations() * links.size());
+}
+TX_BENCHMARK(NodesTreeUnlink, s_NodeCounts);
+
+// Every downstream neighbour of every node, what dirty propagation and the editor walk
+void NodesTreeDownstream(State& state)
+{
+  const std::vector<Node> nodes = CreateNodes(state.GetArgument());
+  NodesTree tree;
+  for (const Node& node : nodes) tree.AddNode(node);
+  for (const NodeLink& link : CreateLinks(nodes)) tree.AddLink(link);
+
+  while (state.KeepRunning()) {
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < tree.GetNodeCount(); i++) {
+      for (LinkHandle link : tree.GetOutgoingLinks(tree.GetHandle(i))) sum += tree.GetLinkTarget(link).Socket;
+    }
+    DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.GetIterations() * tree.GetLinkCount());
+}
+TX_BENCHMARK(NodesTreeDownstream, s_NodeCounts);
+
+// Places the nodes on a square grid with some space between them, returns the size of the grid
+float LayOutNodes(NodesTree& tree)
+{
+  constexpr float spacing = 240.0f;
+  const uint32_t columns = (uint32_t)std::ceil(std::sqrt((double)tree.GetNodeCount()));
+  for (uint32_t i = 0; i < tree.GetNodeCount(); i++) {
+    tree.SetEditorPosition(tree.GetHandle(i), (i % columns) * spacing, (i / columns) * spacing);
+  }
+  return columns * spacing;
+}
+
+// Areas the size of a 1080p editor window at random places of the layout, items are queries
+void NodesTreeCull(State& state)
+{
+  NodesTree tree;
+  for (const Node& node : CreateNodes(state.GetArgument())) tree.AddNode(node);
+  const float size = LayOutNodes(tree);
+
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> position(-1920.0f, size);
+  std::vector<NodeHandle> visible;
+  size_t found = 0;
+  while (state.KeepRunning()) {
+    visible.clear();
+    tree.FindEditorNodes({ position(random), position(random), 1920.0f, 1080.0f }, visible);
+    found += visible.size();
+    DoNotOptimize(visible);
+  }
+  state.SetItemsProcessed(state.GetIterations());
+
+  char label[64];
+  std::snprintf(label, sizeof(label), "%.1f visible nodes per query", (double)found / state.GetIterations());
+  state.SetLabel(label);
+}
+TX_BENCHMARK(NodesTreeCull, { 5'000, 50'000 });
+
+// What culling costs without the grid
+void NodesTreeCullScan(State& state)
+{
+  NodesTree tree;
+  for (const Node& node : CreateNodes(state.GetArgument())) tree.AddNode(node);
+  const float size = LayOutNodes(tree);
+
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> position(-1920.0f, size);
+  std::vector<NodeHandle> visible;
+  while (state.KeepRunning()) {
+    visible.clear();
+    const EditorRect area = { position(random), position(random), 1920.0f, 1080.0f };
+    for (uint32_t i = 0; i < tree.GetNodeCount(); i++) {
+      const NodeHandle node = tree.GetHandle(i);
+      if (tree.GetEditorRect(node).Overlaps(area)) visible.push_back(node);
+    }
+    DoNotOptimize(visible);
+  }
+  state.SetItemsProcessed(state.GetIterations());
+}
+TX_BENCHMARK(NodesTreeCullScan, { 5'000, 50'000 });
+
+// One frame of the nodes editor in a 1080p window without a display, and a check that the UI path does not allocate
+// in steady state. Only the visible nodes are drawn, so the time barely depends on the size of the tree.
+void NodesTreeImGuiRender(State& state)
+{
+  NodesTree tree;
+  for (const Node& node : CreateNodes(state.GetArgument())) tree.AddNode(node);
+  LayOutNodes(tree);
+
+  ImGuiContext* context = ImGui::CreateContext();
+  ImNodesContext* nodesContext = ImNodes::CreateContext();
+  ImGuiIO& io = ImGui::GetIO();
+  io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+  io.DeltaTime = 1.0f / 60.0f;
+  unsigned char* fontPixels;
+  int fontWidth, fontHeight;
+  io.Fonts->GetTexDataAsRGBA32(&fontPixels, &fontWidth, &fontHeight);
+
+  EditorFrame editorFrame;
+  auto frame = [&]() {
+    ImGui::NewFrame();
+    ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+    ImGui::SetNextWindowSize(io.DisplaySize);
+    ImGui::Begin("Nodes Editor");
+    ImNodes::BeginNodeEditor();
+    tree.OnImGuiRender(editorFrame);
+    ImNodes::EndNodeEditor();
+    tree.UpdateEditorLayout(editorFrame);
+    ImGui::End();
+    ImGui::Render();
+  };
+
+  // The first frames grow the ImGui and ImNodes pools
+  for (int i = 0; i < 3; i++) frame();
+
+  while (state.KeepRunning()) {
+    NoAllocationScope scope("NodesTree::OnImGuiRender");
+    frame();
+  }
+  state.SetItemsProcessed(state.GetIterations());
+
+  char label[64];
+  std::snprintf(label, sizeof(label), "%zu detailed, %zu proxies", editorFrame.Detailed.size(),
+                editorFrame.Proxies.size());
+  state.SetLabel(label);
+
+  ImNodes::DestroyContext(nodesContext);
+  ImGui::DestroyContext(context);
+}
+TX_BENCHMARK(NodesTreeImGuiRender, { 5'000, 50'000 });
+
+// Every edit in the app changes a socket value, commits a version for undo and hands a snapshot to the evaluator. The
+// label has the memory both allocate, the version only keeps what the edit wrote to.
+void NodesTreeUndo(State& state)
+{
+  const std::vector<Node> nodes = CreateNodes(state.GetArgument());
+  NodesTree tree;
+  for (const Node& node : nodes) tree.AddNode(node);
+  for (const NodeLink& link : CreateLinks(nodes)) tree.AddLink(link);
+  UndoHistory history(1'000);
+  history.Commit(tree);
+  Frameio::Ref<const NodesTree> snapshot = tree.Snapshot();
+
+  std::mt19937 random(7);
+  uint64_t versionBytes = 0, snapshotBytes = 0;
+  while (state.KeepRunning()) {
+    const uint64_t start = AllocationCounter::GetBytes();
+    tree.SetSocketValue(tree.GetHandle(random() % tree.GetNodeCount()), 2, (float)random());
+    history.Commit(tree);
+    const uint64_t committed = AllocationCounter::GetBytes();
+    snapshot = tree.Snapshot();
+    versionBytes += committed - start;
+    snapshotBytes += AllocationCounter::GetBytes() - committed;
+  }
+  DoNotOptimize(snapshot);
+  state.SetItemsProcessed(state.GetIterations());
+
+  char label[96];
+  std::snprintf(label, sizeof(label), "%.1f KiB per version, %.1f KiB per snapshot",
+                versionBytes / 1024.0 / state.GetIterations(), snapshotBytes / 1024.0 / state.GetIterations());
+  state.SetLabel(label);
+}
+TX_BENCHMARK(NodesTreeUndo, { 20'000 });
+
+} // namespace
+
+} // namespace Texturia::Bench
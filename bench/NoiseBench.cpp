@@ -0,0 +1,78 @@
+// Noise throughput per basis and instruction set. Items/s is pixels per second, one 256x256 block per iteration, the
+// argument is the SimdLevel. Run with the filter "Noise" to compare the code paths side by side.
+
+#include "Bench.hpp"
+
+#include "Engine/Image.hpp"
+#include "Engine/Noise/Noise.hpp"
+
+namespace Texturia::Bench {
+
+namespace {
+
+constexpr int32_t s_Size = 256;
+
+const std::vector<int64_t> s_SimdLevels = { (int64_t)SimdLevel::Generic, (int64_t)SimdLevel::SSE42,
+                                            (int64_t)SimdLevel::AVX2, (int64_t)SimdLevel::AVX512 };
+
+void RunNoise(State& state, const Noise::Settings& settings)
+{
+  const SimdLevel level = (SimdLevel)state.GetArgument();
+  if (!IsSimdLevelSupported(level)) return state.Skip(std::string(GetSimdLevelName(level)) + " is not supported");
+  state.SetLabel(GetSimdLevelName(level));
+
+  Image image(s_Size, s_Size);
+  const float step = 8.0f / s_Size;
+  while (state.KeepRunning()) {
+    for (int32_t y = 0; y < s_Size; y++) {
+      Noise::GenerateRow(settings, 0, step, (y + 0.5f) * step, image.GetPointer(0, 0, y), s_Size, level);
+    }
+    DoNotOptimize(image);
+  }
+  state.SetItemsProcessed(state.GetIterations() * s_Size * s_Size);
+}
+
+Noise::Settings CreateSettings(Noise::Basis basis, int32_t octaves = 1)
+{
+  Noise::Settings settings;
+  settings.Basis = basis;
+  settings.Seed = 1337;
+  settings.Octaves = octaves;
+  return settings;
+}
+
+void GradientNoise(State& state)
+{
+  RunNoise(state, CreateSettings(Noise::Basis::Gradient));
+}
+
+void ValueNoise(State& state)
+{
+  RunNoise(state, CreateSettings(Noise::Basis::Value));
+}
+
+void SimplexNoise(State& state)
+{
+  RunNoise(state, CreateSettings(Noise::Basis::Simplex));
+}
+
+void WorleyNoise(State& state)
+{
+  RunNoise(state, CreateSettings(Noise::Basis::Worley));
+}
+
+// Five octaves of gradient noise, what the Fractal Noise node does by default
+void FractalNoise(State& state)
+{
+  RunNoise(state, CreateSettings(Noise::Basis::Gradient, 5));
+}
+
+} // namespace
+
+TX_BENCHMARK(GradientNoise, s_SimdLevels);
+TX_BENCHMARK(ValueNoise, s_SimdLevels);
+TX_BENCHMARK(SimplexNoise, s_SimdLevels);
+TX_BENCHMARK(WorleyNoise, s_SimdLevels);
+TX_BENCHMARK(FractalNoise, s_SimdLevels);
+
+} // namespace Texturia::Bench
@@ -0,0 +1,88 @@
+// Viewport previews without a window: the time from an edit to the first coarse level on screen while the previous
+// request is still refining at full resolution, and a full refinement from 1/8 to full resolution. The argument is
+// the preview resolution.
+
+#include "Bench.hpp"
+
+#include "Engine/Preview.hpp"
+
+#include <cstdio>
+#include <thread>
+
+namespace Texturia::Bench {
+
+namespace {
+
+// Fractal noise tinted by a Worley pattern, returns the UUID of the output node
+Frameio::UUID BuildPreviewGraph(NodesTree& tree, Frameio::UUID& fractal)
+{
+  Node noise = CreateNode("Fractal Noise");
+  Node worley = CreateNode("Worley Noise");
+  Node mix = CreateNode("Mix");
+  Node output = CreateNode("Output");
+  for (const Node* node : { &noise, &worley, &mix, &output }) tree.AddNode(*node);
+  tree.AddLink({ noise.UUID, mix.UUID, 0 });
+  tree.AddLink({ worley.UUID, mix.UUID, 1 });
+  tree.AddLink({ mix.UUID, output.UUID, 0 });
+  fractal = noise.UUID;
+  return output.UUID;
+}
+
+// Polls like a viewport running at 1000 frames per second would
+const PreviewLevel& WaitForLevel(PreviewRenderer& preview, uint64_t generation)
+{
+  while (true) {
+    const PreviewLevel* level = preview.Poll();
+    if (level && level->Generation == generation) return *level;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+// Every iteration changes the seed, which cancels the refinement of the iteration before. The plan is built from a
+// snapshot on the threads of the renderer, like the viewport does.
+void PreviewEdit(State& state)
+{
+  NodesTree tree;
+  Frameio::UUID fractal;
+  const Frameio::UUID output = BuildPreviewGraph(tree, fractal);
+  const uint32_t size = (uint32_t)state.GetArgument();
+  PreviewRenderer preview;
+
+  int32_t seed = 0;
+  double latency = 0.0;
+  while (state.KeepRunning()) {
+    tree.SetSocketValue(tree.FindNode(fractal), 1, ++seed);
+    latency += WaitForLevel(preview, preview.Request(tree.Snapshot(), output, size, size)).Latency;
+  }
+  preview.Cancel();
+  state.SetItemsProcessed(state.GetIterations());
+
+  char label[64];
+  std::snprintf(label, sizeof(label), "%.1f ms from edit to first level", latency * 1000.0 / state.GetIterations());
+  state.SetLabel(label);
+}
+
+void PreviewRefine(State& state)
+{
+  NodesTree tree;
+  Frameio::UUID fractal;
+  const Frameio::UUID output = BuildPreviewGraph(tree, fractal);
+  const uint32_t size = (uint32_t)state.GetArgument();
+  const EvaluationPlan plan = EvaluationPlan::Build(tree, output);
+  PreviewRenderer preview;
+
+  while (state.KeepRunning()) {
+    preview.Request(plan, size, size);
+    preview.Wait();
+    DoNotOptimize(preview.Poll());
+  }
+  // Pixels of the full resolution level
+  state.SetItemsProcessed(state.GetIterations() * size * size);
+}
+
+} // namespace
+
+TX_BENCHMARK(PreviewEdit, { 2048, 8192 });
+TX_BENCHMARK(PreviewRefine, { 2048 });
+
+} // namespace Texturia::Bench
@@ -0,0 +1,93 @@
+#include "AllocationCounter.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <cstdlib>
+#include <new>
+
+namespace Texturia {
+
+namespace {
+
+thread_local uint64_t s_AllocationCount = 0;
+thread_local uint64_t s_AllocationBytes = 0;
+
+} // namespace
+
+uint64_t AllocationCounter::GetCount()
+{
+  return s_AllocationCount;
+}
+
+uint64_t AllocationCounter::GetBytes()
+{
+  return s_AllocationBytes;
+}
+
+bool AllocationCounter::IsEnabled()
+{
+#ifdef TX_TRACK_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+NoAllocationScope::~NoAllocationScope()
+{
+  FR_ASSERT(GetAllocations() == 0,
+            std::string(m_Name) + " allocated " + std::to_string(GetAllocations()) + " times but must not allocate!");
+}
+
+} // namespace Texturia
+
+#ifdef TX_TRACK_ALLOCATIONS
+
+// The array and nothrow versions of new and delete forward to these by default
+void* operator new(std::size_t size)
+{
+  Texturia::s_AllocationCount++;
+  Texturia::s_AllocationBytes += size;
+  if (void* pointer = std::malloc(size ? size : 1)) return pointer;
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  Texturia::s_AllocationCount++;
+  Texturia::s_AllocationBytes += size;
+  std::size_t align = (std::size_t)alignment;
+#ifdef TX_PLATFORM_WINDOWS
+  if (void* pointer = _aligned_malloc(size ? size : 1, align)) return pointer;
+#else
+  // aligned_alloc wants the size to be a non zero multiple of the alignment
+  if (void* pointer = std::aligned_alloc(align, (size / align + 1) * align)) return pointer;
+#endif
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+#ifdef TX_PLATFORM_WINDOWS
+  _aligned_free(pointer);
+#else
+  std::free(pointer);
+#endif
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+  operator delete(pointer, alignment);
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include <cstdint>
+
+namespace Texturia {
+
+// Counts the heap allocations made by the calling thread. Counting only happens in targets compiled with
+// TX_TRACK_ALLOCATIONS, which replace the global operator new in AllocationCounter.cpp, elsewhere the count stays 0.
+class AllocationCounter {
+public:
+  static uint64_t GetCount();
+  static uint64_t GetBytes();
+  static bool IsEnabled();
+};
+
+// Test hook: asserts that the thread does not allocate between construction and destruction
+class NoAllocationScope {
+public:
+  NoAllocationScope(const char* name) : m_Name(name), m_Start(AllocationCounter::GetCount()) {}
+  ~NoAllocationScope();
+
+  inline uint64_t GetAllocations() const { return AllocationCounter::GetCount() - m_Start; }
+
+private:
+  const char* m_Name;
+  uint64_t m_Start;
+};
+
+} // namespace Texturia
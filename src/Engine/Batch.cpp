@@ -0,0 +1,198 @@
+#include "Engine/Batch.hpp"
+
+#include "Engine/Compiler.hpp"
+#include "Engine/ImageIO.hpp"
+#include "Engine/ImagePool.hpp"
+#include "Engine/Scheduler.hpp"
+
+namespace Texturia {
+
+std::vector<BatchVariant> ExpandParameterMatrix(std::span<const std::vector<SocketValue>> values)
+{
+  std::vector<BatchVariant> variants = { {} };
+  for (const std::vector<SocketValue>& parameter : values) {
+    std::vector<BatchVariant> expanded;
+    expanded.reserve(variants.size() * parameter.size());
+    for (const BatchVariant& variant : variants) {
+      for (const SocketValue& value : parameter) {
+        expanded.push_back(variant);
+        expanded.back().push_back(value);
+      }
+    }
+    variants = std::move(expanded);
+  }
+  return variants;
+}
+
+bool BakeBatch(const NodesTree& tree, std::span<const Frameio::UUID> outputs,
+               std::span<const BatchParameter> parameters, std::span<const BatchVariant> variants,
+               const BatchSettings& settings, ThreadPool& pool, ImageIO& io,
+               const BatchPathFunction& path, std::string& error, BatchStatistics* statistics)
+{
+  const EvaluationSettings& evaluation = settings.Evaluation;
+  BatchStatistics stats;
+  stats.Variants = (uint32_t)variants.size();
+
+  // The parameters are set on a copy, whose content hashes then tell which steps the variants share
+  NodesTree working(tree);
+  std::vector<NodeHandle> handles;
+  for (const BatchParameter& parameter : parameters) {
+    const NodeHandle handle = working.FindNode(parameter.Node);
+    if (handle.IsNull() || parameter.Socket >= working.GetSocketCount(handle)) {
+      error = "Parameter " + std::to_string(parameter.Node) + "." + std::to_string(parameter.Socket) +
+              " is not part of " + tree.GetLabel() + "!";
+      return false;
+    }
+    handles.push_back(handle);
+  }
+
+  std::vector<EvaluationPlan> plans;
+  plans.reserve(variants.size() * outputs.size());
+  {
+    ProfileScope scope(evaluation.GetProfiler(), "Build plans", "plan");
+    for (const BatchVariant& variant : variants) {
+      if (variant.size() != parameters.size()) {
+        error = "Variant " + std::to_string(&variant - variants.data()) + " has " + std::to_string(variant.size()) +
+                " values for " + std::to_string(parameters.size()) + " parameters!";
+        return false;
+      }
+      for (size_t i = 0; i < parameters.size(); i++) {
+        const SocketType type = working.GetSocketValue(handles[i], parameters[i].Socket).Type;
+        if (variant[i].Type != type) {
+          error = "Socket { " + working.GetSocketLabel(handles[i], parameters[i].Socket) + " } of node { " +
+                  working.GetLabel(handles[i]) + " } is a " + GetSocketTypeName(type) + ", not a " +
+                  GetSocketTypeName(variant[i].Type) + "!";
+          return false;
+        }
+        working.SetSocketValue(handles[i], parameters[i].Socket, variant[i]);
+      }
+      for (const Frameio::UUID& output : outputs) {
+        plans.push_back(EvaluationPlan::Build(working, output));
+        if (!plans.back().IsValid()) {
+          error = plans.back().GetError();
+          return false;
+        }
+        stats.PlannedSteps += plans.back().GetSteps().size();
+      }
+    }
+  }
+
+  // Every pass merges the plans of its variants, steps are shared across passes by content hash
+  const size_t variantsPerPass = settings.VariantsPerPass ? settings.VariantsPerPass
+                                                         : std::max<size_t>(1, variants.size());
+  const size_t plansPerPass = variantsPerPass * outputs.size();
+  std::vector<EvaluationPlan> passes;
+  std::vector<std::vector<uint32_t>> passOutputs;
+  for (size_t first = 0; first < plans.size(); first += plansPerPass) {
+    const size_t count = std::min(plansPerPass, plans.size() - first);
+    passes.push_back(EvaluationPlan::Merge(std::span(plans).subspan(first, count), passOutputs.emplace_back()));
+  }
+  plans.clear();
+  stats.Passes = (uint32_t)passes.size();
+
+  std::unordered_map<uint64_t, uint32_t> lastPasses;
+  for (uint32_t pass = 0; pass < passes.size(); pass++) {
+    for (const EvaluationStep& step : passes[pass].GetSteps()) lastPasses[step.Hash] = pass;
+  }
+
+  const Rect bounds = { 0, 0, (int32_t)evaluation.Width, (int32_t)evaluation.Height };
+  const uint32_t inFlight = std::max(1u, settings.PassesInFlight);
+  std::unordered_map<uint64_t, Frameio::Ref<const Image>> shared;
+  std::vector<std::vector<Frameio::Ref<ImageTask>>> saves(passes.size());
+  ImagePool images;
+  for (uint32_t pass = 0; pass < passes.size() && !evaluation.IsCancelled(); pass++) {
+    // Bounds the memory of finished outputs when encoding is slower than evaluating
+    if (pass >= inFlight) {
+      ProfileScope scope(evaluation.GetProfiler(), "Wait for saves", "io");
+      for (const Frameio::Ref<ImageTask>& save : saves[pass - inFlight]) save->Wait();
+    }
+
+    const EvaluationPlan& plan = passes[pass];
+    const std::vector<EvaluationStep>& steps = plan.GetSteps();
+    const size_t count = steps.size();
+    std::vector<bool> isOutput(count, false);
+    for (uint32_t step : passOutputs[pass]) isOutput[step] = true;
+
+    // Walk back from the outputs like Evaluate with a ResultCache, steps that already have an image are not evaluated
+    // and neither are their inputs unless another step reads them
+    std::vector<Frameio::Ref<const Image>> provided(count);
+    std::vector<Frameio::Ref<Image>> kept(count);
+    std::vector<bool> needed(isOutput);
+    for (size_t i = count; i-- > 0;) {
+      if (!needed[i]) continue;
+      if (auto it = shared.find(steps[i].Hash); it != shared.end()) {
+        provided[i] = it->second;
+        continue;
+      }
+      if (!isOutput[i]) {
+        provided[i] = steps[i].Provide(evaluation.Width, evaluation.Height);
+        if (provided[i] && provided[i]->GetRegion().Contains(bounds)) continue;
+        provided[i] = nullptr;
+      }
+
+      if (isOutput[i] || lastPasses[steps[i].Hash] > pass) {
+        kept[i] = std::make_shared<Image>(evaluation.Width, evaluation.Height);
+      }
+      stats.EvaluatedSteps++;
+      for (int32_t source : steps[i].InputSteps) {
+        if (source >= 0) needed[source] = true;
+      }
+    }
+
+    std::vector<StepResult> stepResults(count, StepResult::Provided);
+    std::vector<Image*> outputImages(count, nullptr);
+    std::vector<const Image*> results(count, nullptr);
+    for (size_t i = 0; i < count; i++) {
+      if (!needed[i] || provided[i]) {
+        results[i] = provided[i].get();
+        continue;
+      }
+      stepResults[i] = kept[i] ? StepResult::Kept : StepResult::Temporary;
+      outputImages[i] = kept[i].get();
+      results[i] = kept[i].get();
+    }
+
+    {
+      ProfileScope scope(evaluation.GetProfiler(), "Batch pass", "bake");
+      scope.SetPixels((uint64_t)bounds.Width * bounds.Height * passOutputs[pass].size());
+      const CompiledPlan compiled = CompiledPlan::Compile(plan, stepResults, evaluation.Width, evaluation.Height,
+                                                          evaluation.Fuse);
+      const uint32_t bandHeight = GetBandHeight(plan, compiled, evaluation);
+      for (uint32_t y = 0; y < evaluation.Height && !evaluation.IsCancelled(); y += bandHeight) {
+        const Rect band = Rect{ 0, (int32_t)y, bounds.Width, (int32_t)bandHeight }.Intersect(bounds);
+        TileScheduler scheduler(plan, compiled, evaluation, band, outputImages, results, images);
+        scheduler.Run(pool);
+      }
+    }
+    if (evaluation.IsCancelled()) break;
+
+    for (size_t i = 0; i < count; i++) {
+      if (kept[i] && lastPasses[steps[i].Hash] > pass) shared[steps[i].Hash] = kept[i];
+    }
+    for (auto it = shared.begin(); it != shared.end();) {
+      it = lastPasses[it->first] == pass ? shared.erase(it) : std::next(it);
+    }
+
+    for (size_t i = 0; i < passOutputs[pass].size(); i++) {
+      const uint32_t step = passOutputs[pass][i];
+      const uint32_t variant = (uint32_t)(pass * variantsPerPass + i / outputs.size());
+      Frameio::Ref<const Image> image = kept[step] ? kept[step] : provided[step];
+      saves[pass].push_back(io.Save(std::move(image), path(variant, (uint32_t)(i % outputs.size()))));
+    }
+  }
+
+  {
+    ProfileScope scope(evaluation.GetProfiler(), "Wait for saves", "io");
+    for (const std::vector<Frameio::Ref<ImageTask>>& tasks : saves) {
+      for (const Frameio::Ref<ImageTask>& save : tasks) {
+        save->Wait();
+        if (error.empty()) error = save->GetError();
+      }
+    }
+  }
+  if (statistics) *statistics = stats;
+  if (evaluation.IsCancelled()) error = "The batch was cancelled!";
+  return error.empty();
+}
+
+} // namespace Texturia
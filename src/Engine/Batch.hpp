@@ -0,0 +1,60 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Evaluator.hpp"
+#include "Nodes.hpp"
+
+#include <functional>
+#include <span>
+
+namespace Texturia {
+
+class ImageIO;
+class ThreadPool;
+
+// Socket whose value changes between the variants of a batch
+struct BatchParameter {
+  Frameio::UUID Node;
+  uint32_t Socket;
+};
+
+// Value of every parameter of a batch, in the order of the parameters
+using BatchVariant = std::vector<SocketValue>;
+
+// Every combination of the values of each parameter, the last parameter changes fastest
+std::vector<BatchVariant> ExpandParameterMatrix(std::span<const std::vector<SocketValue>> values);
+
+struct BatchSettings {
+  EvaluationSettings Evaluation;
+  // Variants whose outputs are evaluated together in one scheduler pass, 0 for all of them. Steps shared by several
+  // variants are evaluated once either way, larger passes give the workers more independent tiles but hold the outputs
+  // of more variants in memory.
+  uint32_t VariantsPerPass = 4;
+  // Passes whose outputs may still be encoding while the next pass is evaluated, at least one
+  uint32_t PassesInFlight = 2;
+};
+
+struct BatchStatistics {
+  uint32_t Variants = 0;
+  uint32_t Passes = 0;
+  // Steps of every output of every variant planned on their own, and the ones the batch actually evaluated
+  uint64_t PlannedSteps = 0;
+  uint64_t EvaluatedSteps = 0;
+};
+
+// Path of the file an output of a variant is written to, output indexes the outputs passed to BakeBatch
+using BatchPathFunction = std::function<std::string(uint32_t variant, uint32_t output)>;
+
+// Bakes every output node of tree once for every variant, with the parameters set to the values of the variant, and
+// writes the images with io. The plans of all outputs of a pass of variants are merged (see EvaluationPlan::Merge), so
+// every sub-DAG that does not depend on a parameter that differs is evaluated once and all outputs run in one scheduler
+// pass. Steps that later passes need as well are kept until their last pass. Encoding and writing the files of a pass
+// overlaps with the evaluation of the passes after it. Returns false with error set if a parameter does not exist or
+// has a different type than its values, a plan is invalid, the bake is cancelled or a file could not be written.
+bool BakeBatch(const NodesTree& tree, std::span<const Frameio::UUID> outputs,
+               std::span<const BatchParameter> parameters, std::span<const BatchVariant> variants,
+               const BatchSettings& settings, ThreadPool& pool, ImageIO& io,
+               const BatchPathFunction& path, std::string& error, BatchStatistics* statistics = nullptr);
+
+} // namespace Texturia
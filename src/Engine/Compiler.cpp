@@ -0,0 +1,103 @@
+#include "Engine/Compiler.hpp"
+
+#include <algorithm>
+
+namespace Texturia {
+
+CompiledPlan CompiledPlan::Compile(const EvaluationPlan& plan, std::span<const StepResult> results, uint32_t width,
+                                   uint32_t height, bool fuse)
+{
+  const std::vector<EvaluationStep>& steps = plan.GetSteps();
+  FR_ASSERT(results.size() == steps.size(), "Every step needs a result!");
+
+  CompiledPlan compiled;
+  compiled.m_StepPasses.assign(steps.size(), -1);
+  compiled.m_Materialized.assign(steps.size(), false);
+
+  std::vector<std::vector<uint32_t>> consumers(steps.size());
+  for (uint32_t i = 0; i < steps.size(); i++) {
+    for (int32_t source : steps[i].InputSteps) {
+      if (source >= 0 && (consumers[source].empty() || consumers[source].back() != i)) consumers[source].push_back(i);
+    }
+  }
+
+  // Consumers come after their sources, so walking backwards places every consumer before its sources
+  for (uint32_t i = (uint32_t)steps.size(); i-- > 0;) {
+    if (results[i] == StepResult::Provided) continue;
+
+    const int32_t radius = steps[i].GetRadius(width, height);
+    int32_t target = -1;
+    bool join = fuse && radius == 0 && !consumers[i].empty();
+    for (uint32_t consumer : consumers[i]) {
+      const int32_t pass = compiled.m_StepPasses[consumer];
+      if (pass < 0 || compiled.m_Passes[pass].Radius > 0 || (target >= 0 && target != pass)) join = false;
+      target = pass;
+    }
+
+    if (join) {
+      compiled.m_Passes[target].Steps.push_back({ i });
+      compiled.m_StepPasses[i] = target;
+      compiled.m_Materialized[i] = results[i] == StepResult::Kept;
+    } else {
+      compiled.m_Passes.push_back({ { { i } }, 0, radius });
+      compiled.m_StepPasses[i] = (int32_t)compiled.m_Passes.size() - 1;
+      compiled.m_Materialized[i] = true;
+    }
+  }
+
+  // Registers are handed out in step order and returned after the last step of the pass that reads them
+  std::vector<uint32_t> lastUse(steps.size(), 0);
+  std::vector<int32_t> registers(steps.size(), -1);
+  std::vector<int32_t> freeRegisters;
+  for (CompiledPass& pass : compiled.m_Passes) {
+    std::reverse(pass.Steps.begin(), pass.Steps.end());
+    for (uint32_t position = 0; position < pass.Steps.size(); position++) {
+      for (int32_t source : steps[pass.Steps[position].Step].InputSteps) {
+        if (source >= 0) lastUse[source] = position;
+      }
+    }
+
+    freeRegisters.clear();
+    for (uint32_t position = 0; position < pass.Steps.size(); position++) {
+      PassStep& step = pass.Steps[position];
+      // The output is assigned before the inputs are released, kernels may read an input after writing to the output
+      if (!compiled.m_Materialized[step.Step]) {
+        if (freeRegisters.empty()) {
+          step.Register = (int32_t)pass.RegisterCount++;
+        } else {
+          step.Register = freeRegisters.back();
+          freeRegisters.pop_back();
+        }
+        registers[step.Step] = step.Register;
+      }
+      for (int32_t source : steps[step.Step].InputSteps) {
+        // Steps with a register are only read inside of their own pass, a source read twice is released once
+        if (source >= 0 && registers[source] >= 0 && lastUse[source] == position) {
+          freeRegisters.push_back(registers[source]);
+          registers[source] = -1;
+        }
+      }
+    }
+  }
+  return compiled;
+}
+
+std::vector<Rect> CompiledPlan::GetStepRegions(const EvaluationPlan& plan, const Rect& region,
+                                               const Rect& bounds) const
+{
+  const std::vector<EvaluationStep>& steps = plan.GetSteps();
+  std::vector<Rect> regions(steps.size());
+  // Consumers come after their sources, so the region of a step is complete once the walk reaches it
+  for (uint32_t i = (uint32_t)steps.size(); i-- > 0;) {
+    if (m_StepPasses[i] < 0) continue;
+    if (regions[i].IsEmpty()) regions[i] = region.Intersect(bounds);
+
+    const Rect read = regions[i].Expand(steps[i].GetRadius(bounds.Width, bounds.Height)).Intersect(bounds);
+    for (int32_t source : steps[i].InputSteps) {
+      if (source >= 0 && m_StepPasses[source] >= 0) regions[source] = regions[source].Union(read);
+    }
+  }
+  return regions;
+}
+
+} // namespace Texturia
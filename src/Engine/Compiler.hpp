@@ -0,0 +1,64 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Evaluator.hpp"
+
+#include <span>
+
+namespace Texturia {
+
+// What the evaluation needs from a step of the plan
+enum class StepResult : uint8_t {
+  // Not evaluated, consumers read an image that already exists (e.g. from a ResultCache) or nobody reads it
+  Provided,
+  // Evaluated, but only its consumers need it
+  Temporary,
+  // Evaluated into a full size image that outlives the evaluation
+  Kept
+};
+
+struct PassStep {
+  uint32_t Step;
+  // Scratch image the step is evaluated into, -1 for steps that are written into their own full size image
+  int32_t Register = -1;
+};
+
+// Steps that are evaluated together, tile by tile. Every step of a pass with more than one step is point-wise, the
+// pass runs them block by block on scratch images small enough to stay in cache.
+struct CompiledPass {
+  // Topologically sorted, only the last step is read by other passes
+  std::vector<PassStep> Steps;
+  uint32_t RegisterCount = 0;
+  // Kernel radius of the steps, always 0 for passes with more than one step
+  int32_t Radius = 0;
+};
+
+// Groups the steps of a plan into passes. Point-wise steps join the pass of their consumers as long as all of them are
+// in the same point-wise pass, so maximal point-wise subgraphs fuse into one pass and only steps that are read by
+// several passes, by neighbourhood kernels or that are Kept get a full size image.
+class CompiledPlan {
+public:
+  // results has one entry per step of plan. Kernel radii are the ones of a bake of width x height. Without fuse every
+  // evaluated step becomes a pass of its own.
+  static CompiledPlan Compile(const EvaluationPlan& plan, std::span<const StepResult> results, uint32_t width,
+                              uint32_t height, bool fuse = true);
+
+  inline const std::vector<CompiledPass>& GetPasses() const { return m_Passes; }
+  // Pass that evaluates the step, -1 for Provided steps
+  inline int32_t GetPass(uint32_t step) const { return m_StepPasses[step]; }
+  // Whether the step is evaluated into its own full size image
+  inline bool IsMaterialized(uint32_t step) const { return m_Materialized[step]; }
+
+  // Part of the bake every evaluated step has to cover so that the steps nobody reads cover region: the union of what
+  // its consumers read, which is their region grown by their kernel radius. Everything is clipped to bounds, which is
+  // the whole bake.
+  std::vector<Rect> GetStepRegions(const EvaluationPlan& plan, const Rect& region, const Rect& bounds) const;
+
+private:
+  std::vector<CompiledPass> m_Passes;
+  std::vector<int32_t> m_StepPasses;
+  std::vector<bool> m_Materialized;
+};
+
+} // namespace Texturia
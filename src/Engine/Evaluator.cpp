@@ -0,0 +1,439 @@
+#include "Engine/Evaluator.hpp"
+
+#include "Engine/Compiler.hpp"
+#include "Engine/Groups.hpp"
+#include "Engine/ImagePool.hpp"
+#include "Engine/ResultCache.hpp"
+#include "Engine/Scheduler.hpp"
+#include "Hash.hpp"
+
+#include <numeric>
+
+namespace Texturia {
+
+EvaluationPlan EvaluationPlan::Build(const NodesTree& tree, const Frameio::UUID& output)
+{
+  EvaluationPlan plan;
+  NodeHandle outputHandle = tree.FindNode(output);
+  if (outputHandle.IsNull()) {
+    plan.m_Error = "Output node " + std::to_string(output) + " is not part of " + tree.GetLabel() + "!";
+    return plan;
+  }
+
+  // Iterative depth first search, so that long chains of nodes can not overflow the call stack. Everything below is
+  // indexed by the dense node index, which is stable while the tree is not modified.
+  enum class Mark : uint8_t { None, Visiting, Done };
+  struct Frame {
+    NodeHandle Current;
+    uint32_t NextSocket;
+  };
+  std::vector<Mark> marks(tree.GetNodeCount(), Mark::None);
+  std::vector<int32_t> stepIndices(tree.GetNodeCount(), -1);
+  std::vector<Frame> stack = { { outputHandle, 0 } };
+  std::vector<bool> keyedSteps;
+  std::unordered_map<uint64_t, uint32_t> shared;
+  marks[tree.GetIndex(outputHandle)] = Mark::Visiting;
+
+  while (!stack.empty()) {
+    Frame& frame = stack.back();
+    const uint32_t index = tree.GetIndex(frame.Current);
+
+    if (frame.NextSocket < tree.GetSocketCount(frame.Current)) {
+      NodeHandle from = tree.GetLinkedNode({ frame.Current, frame.NextSocket++ });
+      if (from.IsNull()) continue;
+
+      Mark& mark = marks[tree.GetIndex(from)];
+      if (mark == Mark::None) {
+        mark = Mark::Visiting;
+        stack.push_back({ from, 0 });
+      } else if (mark == Mark::Visiting) {
+        plan.m_Error = "Node { " + tree.GetLabel(frame.Current) + " } is part of a cycle!";
+        plan.m_Steps.clear();
+        return plan;
+      }
+      continue;
+    }
+
+    if (const NodeGroup* group = tree.FindGroup(tree.GetType(frame.Current))) {
+      const int32_t result =
+          plan.Instantiate(tree, frame.Current, *group, stepIndices, keyedSteps, shared, stack.size() == 1);
+      if (result < 0) {
+        plan.m_Steps.clear();
+        return plan;
+      }
+      marks[index] = Mark::Done;
+      stepIndices[index] = result;
+      stack.pop_back();
+      continue;
+    }
+
+    EvaluationStep step = {
+      tree.GetUUID(frame.Current), tree.GetContentHash(frame.Current), FindKernel(tree.GetType(frame.Current))
+    };
+    if (!step.Kernel) {
+      plan.m_Error = "Node { " + tree.GetLabel(frame.Current) + " } has the unknown type " +
+                     tree.GetType(frame.Current) + "!";
+      plan.m_Steps.clear();
+      return plan;
+    }
+
+    for (uint32_t i = 0; i < tree.GetSocketCount(frame.Current); i++) {
+      NodeHandle from = tree.GetLinkedNode({ frame.Current, i });
+      step.InputSteps.push_back(from.IsNull() ? -1 : stepIndices[tree.GetIndex(from)]);
+      step.Constants.push_back(ToPixel(tree.GetSocketValue(frame.Current, i)));
+    }
+
+    // Content hashes leave out UUIDs, so the steps keyed by their node and everything downstream of them add them
+    bool keyed = step.Kernel->KeyedByNode;
+    if (keyed) step.Hash = HashCombine(step.Hash, step.UUID);
+    for (int32_t input : step.InputSteps) keyed |= input >= 0 && keyedSteps[input];
+    for (int32_t input : step.InputSteps) {
+      if (keyed && input >= 0) step.Hash = HashCombine(step.Hash, plan.m_Steps[input].Hash);
+    }
+    keyedSteps.push_back(keyed);
+
+    marks[index] = Mark::Done;
+    stepIndices[index] = (int32_t)plan.m_Steps.size();
+    shared.try_emplace(step.Hash, (uint32_t)plan.m_Steps.size());
+    plan.m_Steps.push_back(std::move(step));
+    stack.pop_back();
+  }
+
+  return plan;
+}
+
+int32_t EvaluationPlan::Instantiate(const NodesTree& tree, NodeHandle node, const NodeGroup& group,
+                                    std::span<const int32_t> stepIndices, std::vector<bool>& keyedSteps,
+                                    std::unordered_map<uint64_t, uint32_t>& shared, bool isOutput)
+{
+  const std::vector<GroupParameter>& parameters = group.GetParameters();
+  const std::string name = "Node { " + tree.GetLabel(node) + " }";
+  bool matches = tree.GetSocketCount(node) == parameters.size();
+  for (uint32_t i = 0; matches && i < parameters.size(); i++) {
+    matches = tree.GetSocketValue(node, i).Type == parameters[i].Default.Type;
+  }
+  if (!matches) {
+    m_Error = name + " does not have the sockets of its group " + group.GetName() + "!";
+    return -1;
+  }
+  const Frameio::Ref<const CompiledGroup> compiled = CompileGroup(group);
+  if (!compiled->Body.IsValid()) {
+    m_Error = name + " is a node of a group that can not be evaluated: " + compiled->Body.GetError();
+    return -1;
+  }
+
+  // The step linked into each parameter or -1, and what it adds to the hashes of the steps reading it. Unlinked
+  // parameters add their value the way NodesTree::GetContentHash does.
+  std::vector<int32_t> sources(parameters.size());
+  std::vector<uint64_t> hashes(parameters.size());
+  for (uint32_t i = 0; i < parameters.size(); i++) {
+    const NodeHandle from = tree.GetLinkedNode({ node, i });
+    sources[i] = from.IsNull() ? -1 : stepIndices[tree.GetIndex(from)];
+    if (sources[i] >= 0) {
+      hashes[i] = m_Steps[sources[i]].Hash;
+      continue;
+    }
+    const SocketValue value = tree.GetSocketValue(node, i);
+    hashes[i] = HashCombine(HashCombine(0, (uint64_t)value.Type + 1),
+                            HashBytes((const unsigned char*)&value.Data, sizeof(SocketData)));
+  }
+
+  // Steps that do not vary keep the hash they have in the body, so every node of the group finds the same one
+  const std::vector<EvaluationStep>& body = compiled->Body.GetSteps();
+  const Frameio::UUID uuid = tree.GetUUID(node);
+  std::vector<int32_t> local(body.size(), -1);
+  for (uint32_t i = 0; i < body.size(); i++) {
+    if (!compiled->Needed[i]) continue;
+    const bool last = i + 1 == body.size();
+    EvaluationStep step = body[i];
+    step.UUID = last ? uuid : Frameio::UUID(HashCombine(uuid, body[i].UUID));
+    bool keyed = compiled->Keyed[i];
+    if (step.Kernel->KeyedByNode) step.Hash = HashCombine(step.Hash, step.UUID);
+
+    for (uint32_t socket = 0; socket < step.InputSteps.size(); socket++) {
+      const int32_t parameter = compiled->Parameters[i][socket];
+      if (parameter >= 0) {
+        step.InputSteps[socket] = sources[parameter];
+        step.Constants[socket] = ToPixel(tree.GetSocketValue(node, parameter));
+        step.Hash = HashCombine(step.Hash, hashes[parameter]);
+        keyed |= sources[parameter] >= 0 && keyedSteps[sources[parameter]];
+        continue;
+      }
+      const int32_t input = body[i].InputSteps[socket];
+      if (input < 0) continue;
+      step.InputSteps[socket] = local[input];
+      if (compiled->Varying[input]) step.Hash = HashCombine(step.Hash, m_Steps[local[input]].Hash);
+      keyed |= keyedSteps[local[input]];
+    }
+
+    // The output of the plan is always its last step
+    if (auto found = shared.find(step.Hash); found != shared.end() && !(isOutput && last)) {
+      local[i] = (int32_t)found->second;
+      continue;
+    }
+    local[i] = (int32_t)m_Steps.size();
+    shared.try_emplace(step.Hash, (uint32_t)m_Steps.size());
+    keyedSteps.push_back(keyed);
+    m_Steps.push_back(std::move(step));
+  }
+  return local.back();
+}
+
+EvaluationPlan EvaluationPlan::Merge(std::span<const EvaluationPlan> plans, std::vector<uint32_t>& outputs)
+{
+  // Every step comes after its inputs in its own plan, so it also comes after wherever they ended up in the merged one
+  EvaluationPlan merged;
+  std::unordered_map<uint64_t, uint32_t> indices;
+  std::vector<uint32_t> remap;
+  outputs.clear();
+  for (const EvaluationPlan& plan : plans) {
+    FR_ASSERT(plan.IsValid(), plan.GetError());
+    remap.resize(plan.m_Steps.size());
+    for (size_t i = 0; i < plan.m_Steps.size(); i++) {
+      auto [it, inserted] = indices.try_emplace(plan.m_Steps[i].Hash, (uint32_t)merged.m_Steps.size());
+      remap[i] = it->second;
+      if (!inserted) continue;
+
+      EvaluationStep& step = merged.m_Steps.emplace_back(plan.m_Steps[i]);
+      for (int32_t& input : step.InputSteps) {
+        if (input >= 0) input = (int32_t)remap[input];
+      }
+    }
+    outputs.push_back(remap.back());
+  }
+  return merged;
+}
+
+namespace {
+
+// Edge length streamed chunks start out with before the memory budget shrinks them, 16 MiB of output per chunk
+constexpr uint32_t s_ChunkSize = 1024;
+
+// Upper bound of the memory the Temporary images of a piece of the bake take, the scheduler may have every one of them
+// alive at once
+uint64_t GetTemporaryBytes(const EvaluationPlan& plan, const CompiledPlan& compiled, const Rect& piece,
+                           const Rect& bounds)
+{
+  const std::vector<Rect> regions = compiled.GetStepRegions(plan, piece, bounds);
+  uint64_t bytes = 0;
+  // The last step is the output, which is not a temporary
+  for (uint32_t i = 0; i + 1 < plan.GetSteps().size(); i++) {
+    if (compiled.GetPass(i) < 0 || !compiled.IsMaterialized(i)) continue;
+    bytes += Image::GetFloatCount(regions[i]) * sizeof(float);
+  }
+  return bytes;
+}
+
+// Whether every piece of width x height the bake splits into fits the memory budget, together with extra bytes. Pieces
+// in the middle need the largest halos.
+bool FitsBudget(const EvaluationPlan& plan, const CompiledPlan& compiled, const EvaluationSettings& settings,
+                uint32_t width, uint32_t height, uint64_t extra)
+{
+  const Rect bounds = { 0, 0, (int32_t)settings.Width, (int32_t)settings.Height };
+  for (uint32_t y = 0; y < settings.Height; y += height) {
+    for (uint32_t x = 0; x < settings.Width; x += width) {
+      const Rect piece = Rect{ (int32_t)x, (int32_t)y, (int32_t)width, (int32_t)height }.Intersect(bounds);
+      if (GetTemporaryBytes(plan, compiled, piece, bounds) + extra > settings.MemoryBudget) return false;
+    }
+  }
+  return true;
+}
+
+// CompiledPlan::Compile, timed by the profiler of settings
+CompiledPlan CompileForSettings(const EvaluationPlan& plan, std::span<const StepResult> results,
+                                const EvaluationSettings& settings)
+{
+  ProfileScope scope(settings.GetProfiler(), "Compile", "scheduler");
+  return CompiledPlan::Compile(plan, results, settings.Width, settings.Height, settings.Fuse);
+}
+
+// Steps whose kernel already has the image of the whole bake become Provided and their consumers read that image, no
+// copy is made. The last step always runs, its image is the one the evaluation returns or writes.
+std::vector<Frameio::Ref<const Image>> ProvideSteps(const EvaluationPlan& plan, const EvaluationSettings& settings,
+                                                     std::vector<StepResult>& results)
+{
+  const Rect bounds = { 0, 0, (int32_t)settings.Width, (int32_t)settings.Height };
+  std::vector<Frameio::Ref<const Image>> provided(results.size());
+  for (size_t i = 0; i + 1 < results.size(); i++) {
+    provided[i] = plan.GetSteps()[i].Provide(settings.Width, settings.Height);
+    if (provided[i] && provided[i]->GetRegion().Contains(bounds)) results[i] = StepResult::Provided;
+    else provided[i] = nullptr;
+  }
+  return provided;
+}
+
+// Rounds size up to a multiple of unit, at least one
+inline uint32_t RoundUp(uint32_t size, uint32_t unit)
+{
+  return std::max(1u, (size + unit - 1) / unit) * unit;
+}
+
+} // namespace
+
+uint32_t GetBandHeight(const EvaluationPlan& plan, const CompiledPlan& compiled, const EvaluationSettings& settings)
+{
+  if (settings.MemoryBudget == 0) return settings.Height;
+
+  // Halve the bands until every one of them fits
+  const uint32_t tile = settings.TileSize;
+  uint32_t height = RoundUp(settings.Height, tile);
+  while (height > tile && !FitsBudget(plan, compiled, settings, settings.Width, height, 0)) {
+    height = RoundUp(height / 2, tile);
+  }
+  return height;
+}
+
+uint32_t GetChunkSize(const EvaluationPlan& plan, const CompiledPlan& compiled, const EvaluationSettings& settings,
+                      uint32_t alignment)
+{
+  const uint32_t unit = std::lcm(settings.TileSize, alignment);
+  uint32_t size = RoundUp(std::min(s_ChunkSize, std::max(settings.Width, settings.Height)), unit);
+  if (settings.MemoryBudget == 0) return size;
+
+  // The output of a chunk comes from the pool as well
+  auto fits = [&](uint32_t size) {
+    const uint64_t output = Image::GetFloatCount({ 0, 0, (int32_t)size, (int32_t)size }) * sizeof(float);
+    return FitsBudget(plan, compiled, settings, size, size, output);
+  };
+  while (size > unit && !fits(size)) size = RoundUp(size / 2, unit);
+  return size;
+}
+
+Image Evaluate(const EvaluationPlan& plan, const EvaluationSettings& settings)
+{
+  ThreadPool pool(settings.ThreadCount);
+  return Evaluate(plan, settings, pool);
+}
+
+Image Evaluate(const EvaluationPlan& plan, const EvaluationSettings& settings, ThreadPool& pool)
+{
+  ImagePool images;
+  return Evaluate(plan, settings, pool, images);
+}
+
+Image Evaluate(const EvaluationPlan& plan, const EvaluationSettings& settings, ThreadPool& pool, ImagePool& images)
+{
+  FR_ASSERT(plan.IsValid(), plan.GetError());
+
+  const size_t count = plan.GetSteps().size();
+
+  // Only the output is needed afterwards, every other step only gets an image if the compiler could not fuse it
+  std::vector<StepResult> stepResults(count, StepResult::Temporary);
+  stepResults.back() = StepResult::Kept;
+  const std::vector<Frameio::Ref<const Image>> provided = ProvideSteps(plan, settings, stepResults);
+  const CompiledPlan compiled = CompileForSettings(plan, stepResults, settings);
+
+  Image output(settings.Width, settings.Height);
+  std::vector<Image*> outputs(count, nullptr);
+  outputs.back() = &output;
+  std::vector<const Image*> results(outputs.begin(), outputs.end());
+  for (size_t i = 0; i < count; i++) {
+    if (provided[i]) results[i] = provided[i].get();
+  }
+
+  const Rect bounds = { 0, 0, (int32_t)settings.Width, (int32_t)settings.Height };
+  const uint32_t bandHeight = GetBandHeight(plan, compiled, settings);
+  for (uint32_t y = 0; y < settings.Height; y += bandHeight) {
+    const Rect band = Rect{ 0, (int32_t)y, (int32_t)settings.Width, (int32_t)bandHeight }.Intersect(bounds);
+    if (settings.IsCancelled()) break;
+    ProfileScope scope(settings.GetProfiler(), "Band", "bake");
+    scope.SetPixels((uint64_t)band.Width * band.Height);
+    TileScheduler scheduler(plan, compiled, settings, band, outputs, results, images);
+    scheduler.Run(pool);
+  }
+  return output;
+}
+
+bool EvaluateStreaming(const EvaluationPlan& plan, const EvaluationSettings& settings, ThreadPool& pool,
+                       ImagePool& images, uint32_t alignment, const std::function<bool(const Image& chunk)>& write)
+{
+  FR_ASSERT(plan.IsValid(), plan.GetError());
+
+  const size_t count = plan.GetSteps().size();
+  std::vector<StepResult> stepResults(count, StepResult::Temporary);
+  stepResults.back() = StepResult::Kept;
+  const std::vector<Frameio::Ref<const Image>> provided = ProvideSteps(plan, settings, stepResults);
+  const CompiledPlan compiled = CompileForSettings(plan, stepResults, settings);
+
+  const Rect bounds = { 0, 0, (int32_t)settings.Width, (int32_t)settings.Height };
+  const int32_t size = (int32_t)GetChunkSize(plan, compiled, settings, alignment);
+  std::vector<Image*> outputs(count, nullptr);
+  std::vector<const Image*> results(count, nullptr);
+  for (size_t i = 0; i < count; i++) results[i] = provided[i].get();
+  for (int32_t y = 0; y < bounds.Height; y += size) {
+    for (int32_t x = 0; x < bounds.Width; x += size) {
+      const Rect chunk = Rect{ x, y, size, size }.Intersect(bounds);
+      ProfileScope scope(settings.GetProfiler(), "Chunk", "bake");
+      scope.SetPixels((uint64_t)chunk.Width * chunk.Height);
+      Image output = images.Acquire(chunk);
+      outputs.back() = &output;
+      results.back() = &output;
+      TileScheduler scheduler(plan, compiled, settings, chunk, outputs, results, images);
+      scheduler.Run(pool);
+
+      bool written = false;
+      if (!settings.IsCancelled()) {
+        ProfileScope writing(settings.GetProfiler(), "Write", "io");
+        written = write(output);
+      }
+      images.Recycle(std::move(output));
+      if (!written) return false;
+    }
+  }
+  return true;
+}
+
+Frameio::Ref<const Image> Evaluate(const EvaluationPlan& plan, const EvaluationSettings& settings, ThreadPool& pool,
+                                   ResultCache& cache)
+{
+  FR_ASSERT(plan.IsValid(), plan.GetError());
+  const std::vector<EvaluationStep>& steps = plan.GetSteps();
+  const size_t count = steps.size();
+
+  // The tile size does not change results, the resolution does
+  auto key = [&](const EvaluationStep& step) {
+    return HashCombine(HashCombine(step.Hash, settings.Width), settings.Height);
+  };
+
+  // Walk back from the output, the inputs of a cached step are not needed unless another step reads them as well
+  std::vector<Frameio::Ref<const Image>> cached(count);
+  std::vector<Frameio::Ref<Image>> computed(count);
+  std::vector<bool> needed(count, false);
+  needed.back() = true;
+  for (size_t i = count; i-- > 0;) {
+    if (!needed[i]) continue;
+    // Provided images are not added to the cache, the kernel has them anyway
+    if (i + 1 < count && (cached[i] = steps[i].Provide(settings.Width, settings.Height))) continue;
+    if ((cached[i] = cache.Find(key(steps[i])))) continue;
+
+    computed[i] = std::make_shared<Image>(settings.Width, settings.Height);
+    for (int32_t source : steps[i].InputSteps) {
+      if (source >= 0) needed[source] = true;
+    }
+  }
+  if (cached.back()) return cached.back();
+
+  // Every computed step is kept for the cache, the compiler still runs point-wise chains block by block
+  std::vector<StepResult> stepResults(count, StepResult::Provided);
+  std::vector<Image*> outputs(count, nullptr);
+  std::vector<const Image*> results(count, nullptr);
+  for (size_t i = 0; i < count; i++) {
+    if (computed[i]) stepResults[i] = StepResult::Kept;
+    outputs[i] = computed[i].get();
+    results[i] = computed[i] ? computed[i].get() : cached[i].get();
+  }
+  const CompiledPlan compiled = CompileForSettings(plan, stepResults, settings);
+
+  const Rect bounds = { 0, 0, (int32_t)settings.Width, (int32_t)settings.Height };
+  ImagePool images;
+  TileScheduler scheduler(plan, compiled, settings, bounds, outputs, results, images);
+  scheduler.Run(pool);
+  if (settings.IsCancelled()) return nullptr;
+
+  for (size_t i = 0; i < count; i++) {
+    if (computed[i]) cache.Insert(key(steps[i]), computed[i]);
+  }
+  return computed.back();
+}
+
+} // namespace Texturia
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Image.hpp"
+#include "Engine/Kernels.hpp"
+#include "Engine/Profiler.hpp"
+#include "Nodes.hpp"
+
+#include <atomic>
+#include <functional>
+#include <span>
+#include <unordered_map>
+
+namespace Texturia {
+
+struct EvaluationStep {
+  Frameio::UUID UUID;
+  // NodesTree::GetContentHash of the node, combined with the UUIDs of the nodes at or upstream of it whose kernel is
+  // KeyedByNode if there are any. Steps of groups start from the hash of their node in the body instead (see Build).
+  // Steps with equal hashes compute the same result.
+  uint64_t Hash;
+  const NodeKernel* Kernel;
+  // Index of the step producing each input socket, -1 when the socket is not linked
+  std::vector<int32_t> InputSteps;
+  // Value of each input socket, used when it is not linked
+  std::vector<Pixel> Constants;
+
+  // How far around a pixel the kernel reads its inputs in a bake of width x height
+  inline int32_t GetRadius(uint32_t width, uint32_t height) const
+  {
+    return Kernel->GetRadius ? Kernel->GetRadius(Constants, width, height) : Kernel->Radius;
+  }
+  // Image of the whole bake that consumers can read instead of evaluating the step (e.g. a decoded file of the same
+  // size), nullptr if the step has to run
+  inline Frameio::Ref<const Image> Provide(uint32_t width, uint32_t height) const
+  {
+    return Kernel->Provide ? Kernel->Provide(Constants, width, height) : nullptr;
+  }
+};
+
+// Nodes needed to compute one output node, topologically sorted so that every step comes after its inputs.
+// The output node is always the last step.
+class EvaluationPlan {
+public:
+  // Nodes of a group (see NodeGroup) become the steps of its compiled body, with the values of their sockets or the
+  // steps linked into them in place of the targets of the parameters. Steps of the body are only in the plan once for
+  // every distinct hash, so the parts of a body that do not read parameters and nodes of a group with the same inputs
+  // are evaluated once. Steps of the body get UUIDs derived from the node of the group, its output gets the UUID of the
+  // node itself.
+  static EvaluationPlan Build(const NodesTree& tree, const Frameio::UUID& output);
+  // One plan computing the outputs of every plan, steps with the same content hash are only in it once. outputs gets
+  // the index of the output step of each plan. The functions below only return the last step of a merged plan, the
+  // other outputs are Kept by the caller (see BakeBatch).
+  static EvaluationPlan Merge(std::span<const EvaluationPlan> plans, std::vector<uint32_t>& outputs);
+
+  inline bool IsValid() const { return m_Error.empty(); }
+  inline const std::string& GetError() const { return m_Error; }
+  inline const std::vector<EvaluationStep>& GetSteps() const { return m_Steps; }
+
+private:
+  // Appends the steps of the node of group. stepIndices maps the dense node indices of tree to steps, shared the
+  // hashes of the steps to the first step with it. Returns the step of the output of the body, or -1 and sets the
+  // error.
+  int32_t Instantiate(const NodesTree& tree, NodeHandle node, const NodeGroup& group,
+                      std::span<const int32_t> stepIndices, std::vector<bool>& keyedSteps,
+                      std::unordered_map<uint64_t, uint32_t>& shared, bool isOutput);
+
+  std::vector<EvaluationStep> m_Steps;
+  std::string m_Error;
+};
+
+// Lets another thread stop an evaluation early. The scheduler checks it before every tile, tiles that already run are
+// finished first.
+class CancellationToken {
+public:
+  inline void Cancel() { m_Cancelled.store(true, std::memory_order_relaxed); }
+  inline bool IsCancelled() const { return m_Cancelled.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<bool> m_Cancelled = false;
+};
+
+struct EvaluationSettings {
+  uint32_t Width = 1024, Height = 1024;
+  uint32_t TileSize = 64;
+  // Upper limit of worker threads, 0 uses every hardware thread
+  uint32_t ThreadCount = 0;
+  // Fuse chains of point-wise steps into one pass (see CompiledPlan), off gives every step its own image and pass
+  bool Fuse = true;
+  // Upper limit of the memory intermediate images may take in bytes, 0 is unlimited. Bakes that need more are
+  // evaluated in bands of tile rows, which recomputes the halos neighbourhood kernels read across band borders. A
+  // single row of tiles is the smallest band, even if it does not fit.
+  uint64_t MemoryBudget = 0;
+  // Optional, the results of a cancelled evaluation are undefined
+  const CancellationToken* Cancellation = nullptr;
+  // Optional, gets the time, pixels and memory of every node and the time of the scheduler while it is recording
+  Profiler* Profile = nullptr;
+
+  inline bool IsCancelled() const { return Cancellation && Cancellation->IsCancelled(); }
+  // Null unless Profile is set and recording
+  inline Profiler* GetProfiler() const { return Profile && Profile->IsRecording() ? Profile : nullptr; }
+};
+
+class CompiledPlan;
+class ImagePool;
+class ResultCache;
+class ThreadPool;
+
+// Evaluates every step of the plan tile by tile and returns the image of the output node
+Image Evaluate(const EvaluationPlan& plan, const EvaluationSettings& settings);
+// Same as above but reuses the workers of pool, settings.ThreadCount is ignored
+Image Evaluate(const EvaluationPlan& plan, const EvaluationSettings& settings, ThreadPool& pool);
+// Takes the intermediate images from images, whose statistics tell the memory the bake needed. Every intermediate
+// image goes back to images as soon as the last tile reading it is done.
+Image Evaluate(const EvaluationPlan& plan, const EvaluationSettings& settings, ThreadPool& pool, ImagePool& images);
+// Only evaluates the steps whose result is not in cache yet and that are needed for the output, every new result is
+// added to cache. After an edit that is just the edited node and the nodes downstream of it. Cancelled evaluations add
+// nothing to cache and return nullptr.
+Frameio::Ref<const Image> Evaluate(const EvaluationPlan& plan, const EvaluationSettings& settings, ThreadPool& pool,
+                                   ResultCache& cache);
+
+// Evaluates the bake chunk by chunk and never holds more than one chunk of the output, so the memory a bake needs does
+// not grow with its resolution. Chunks are squares of a multiple of alignment and settings.TileSize, each one only
+// evaluates the regions of the steps it reads, halos of neighbourhood kernels included. write gets the output of every
+// chunk in row major order, which goes back to images afterwards. Stops and returns false as soon as write does or the
+// evaluation is cancelled.
+bool EvaluateStreaming(const EvaluationPlan& plan, const EvaluationSettings& settings, ThreadPool& pool,
+                       ImagePool& images, uint32_t alignment, const std::function<bool(const Image& chunk)>& write);
+
+// Height of the bands the bake is split into to stay within settings.MemoryBudget, a multiple of the tile size
+uint32_t GetBandHeight(const EvaluationPlan& plan, const CompiledPlan& compiled, const EvaluationSettings& settings);
+// Edge length of the chunks EvaluateStreaming splits the bake into, shrunk until a chunk and its intermediate images
+// fit settings.MemoryBudget
+uint32_t GetChunkSize(const EvaluationPlan& plan, const CompiledPlan& compiled, const EvaluationSettings& settings,
+                      uint32_t alignment);
+
+} // namespace Texturia
@@ -0,0 +1,144 @@
+// Row loops of the filters, included once per instruction set by FiltersGeneric.cpp, FiltersSSE42.cpp,
+// FiltersAVX2.cpp and FiltersAVX512.cpp with TX_FILTER_TARGET set to the namespace to put them in. Like the noise
+// rows (see Engine/Noise/NoiseRow.inl) they only use plain arithmetic and no calls into the standard library.
+//
+// Every loop runs along a row of one channel, so the vectors are filled with neighbouring pixels and the weights or
+// twiddles are broadcast scalars. Vertical passes and the column transforms process whole rows at once instead of
+// walking down a column.
+
+#include "Engine/Filters/Filters.hpp"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+  #define TX_FILTER_SIMD_LOOP
+#else
+  #define TX_FILTER_SIMD_LOOP _Pragma("omp simd")
+#endif
+
+namespace Texturia::Filters::TX_FILTER_TARGET {
+
+namespace {
+
+void ConvolveRow(const float* in, const float* weights, int32_t taps, float* out, int32_t count, bool accumulate)
+{
+  // Four taps per sweep, so out is loaded and stored once for every four weights
+  int32_t t = 0;
+  for (; t + 4 <= taps; t += 4) {
+    const float w0 = weights[t], w1 = weights[t + 1], w2 = weights[t + 2], w3 = weights[t + 3];
+    const float* shifted = in + t;
+    if (t == 0 && !accumulate) {
+      TX_FILTER_SIMD_LOOP
+      for (int32_t i = 0; i < count; i++) {
+        out[i] = (shifted[i] * w0 + shifted[i + 1] * w1) + (shifted[i + 2] * w2 + shifted[i + 3] * w3);
+      }
+    } else {
+      TX_FILTER_SIMD_LOOP
+      for (int32_t i = 0; i < count; i++) {
+        out[i] += (shifted[i] * w0 + shifted[i + 1] * w1) + (shifted[i + 2] * w2 + shifted[i + 3] * w3);
+      }
+    }
+  }
+  for (; t < taps; t++) {
+    const float weight = weights[t];
+    const float* shifted = in + t;
+    if (t == 0 && !accumulate) {
+      TX_FILTER_SIMD_LOOP
+      for (int32_t i = 0; i < count; i++) out[i] = shifted[i] * weight;
+    } else {
+      TX_FILTER_SIMD_LOOP
+      for (int32_t i = 0; i < count; i++) out[i] += shifted[i] * weight;
+    }
+  }
+}
+
+void ConvolveColumns(const float* const* rows, const float* weights, int32_t taps, float* out, int32_t count)
+{
+  // Four rows per sweep, so out is loaded and stored once for every four weights
+  int32_t t = 0;
+  for (; t + 4 <= taps; t += 4) {
+    const float w0 = weights[t], w1 = weights[t + 1], w2 = weights[t + 2], w3 = weights[t + 3];
+    const float* row0 = rows[t];
+    const float* row1 = rows[t + 1];
+    const float* row2 = rows[t + 2];
+    const float* row3 = rows[t + 3];
+    if (t == 0) {
+      TX_FILTER_SIMD_LOOP
+      for (int32_t i = 0; i < count; i++) out[i] = (row0[i] * w0 + row1[i] * w1) + (row2[i] * w2 + row3[i] * w3);
+    } else {
+      TX_FILTER_SIMD_LOOP
+      for (int32_t i = 0; i < count; i++) out[i] += (row0[i] * w0 + row1[i] * w1) + (row2[i] * w2 + row3[i] * w3);
+    }
+  }
+  for (; t < taps; t++) {
+    const float weight = weights[t];
+    const float* row = rows[t];
+    if (t == 0) {
+      TX_FILTER_SIMD_LOOP
+      for (int32_t i = 0; i < count; i++) out[i] = row[i] * weight;
+    } else {
+      TX_FILTER_SIMD_LOOP
+      for (int32_t i = 0; i < count; i++) out[i] += row[i] * weight;
+    }
+  }
+}
+
+void SlideRows(int64_t* sums, const int64_t* entering, const int64_t* leaving, double scale, float* out,
+               int32_t count)
+{
+  if (leaving) {
+    TX_FILTER_SIMD_LOOP
+    for (int32_t i = 0; i < count; i++) sums[i] += entering[i] - leaving[i];
+  } else {
+    TX_FILTER_SIMD_LOOP
+    for (int32_t i = 0; i < count; i++) sums[i] += entering[i];
+  }
+  if (!out) return;
+  TX_FILTER_SIMD_LOOP
+  for (int32_t i = 0; i < count; i++) out[i] = (float)((double)sums[i] * scale);
+}
+
+void ButterflyForward(float* aRe, float* aIm, float* bRe, float* bIm, float wRe, float wIm, int32_t count)
+{
+  TX_FILTER_SIMD_LOOP
+  for (int32_t i = 0; i < count; i++) {
+    const float re = aRe[i] - bRe[i], im = aIm[i] - bIm[i];
+    aRe[i] += bRe[i];
+    aIm[i] += bIm[i];
+    bRe[i] = re * wRe - im * wIm;
+    bIm[i] = re * wIm + im * wRe;
+  }
+}
+
+void ButterflyInverse(float* aRe, float* aIm, float* bRe, float* bIm, float wRe, float wIm, int32_t count)
+{
+  TX_FILTER_SIMD_LOOP
+  for (int32_t i = 0; i < count; i++) {
+    const float re = bRe[i] * wRe - bIm[i] * wIm, im = bRe[i] * wIm + bIm[i] * wRe;
+    bRe[i] = aRe[i] - re;
+    bIm[i] = aIm[i] - im;
+    aRe[i] += re;
+    aIm[i] += im;
+  }
+}
+
+void MultiplySpectrum(float* re, float* im, const float* kernelRe, const float* kernelIm, int32_t count)
+{
+  TX_FILTER_SIMD_LOOP
+  for (int32_t i = 0; i < count; i++) {
+    const float r = re[i] * kernelRe[i] - im[i] * kernelIm[i];
+    im[i] = re[i] * kernelIm[i] + im[i] * kernelRe[i];
+    re[i] = r;
+  }
+}
+
+} // namespace
+
+const RowFunctions& GetRowFunctions()
+{
+  static constexpr RowFunctions s_Functions = { ConvolveRow,      ConvolveColumns,  SlideRows,
+                                                ButterflyForward, ButterflyInverse, MultiplySpectrum };
+  return s_Functions;
+}
+
+} // namespace Texturia::Filters::TX_FILTER_TARGET
+
+#undef TX_FILTER_SIMD_LOOP
@@ -0,0 +1,716 @@
+#include "Engine/Filters/Filters.hpp"
+
+#include "Hash.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <numbers>
+
+namespace Texturia::Filters {
+
+// Defined in FilterRow.inl, once per translation unit compiled for an instruction set
+namespace Generic {
+const RowFunctions& GetRowFunctions();
+}
+#ifdef TX_SIMD_X86
+namespace SSE42 {
+const RowFunctions& GetRowFunctions();
+}
+namespace AVX2 {
+const RowFunctions& GetRowFunctions();
+}
+namespace AVX512 {
+const RowFunctions& GetRowFunctions();
+}
+#endif
+
+const RowFunctions& GetRowFunctions(SimdLevel level)
+{
+  switch (level) {
+#ifdef TX_SIMD_X86
+    case SimdLevel::AVX512:
+      return AVX512::GetRowFunctions();
+    case SimdLevel::AVX2:
+      return AVX2::GetRowFunctions();
+    case SimdLevel::SSE42:
+      return SSE42::GetRowFunctions();
+#endif
+    default:
+      return Generic::GetRowFunctions();
+  }
+}
+
+namespace {
+
+constexpr uint32_t Channels = Image::Channels;
+// Largest radius of the nodes in pixels, which bounds the halo every tile reads
+constexpr int32_t MaxRadius = 256;
+// Output columns computed at once by the row strategies, so the ring of rows they keep stays in the cache for the
+// whole height of the region
+constexpr int32_t StripWidth = 256;
+// Cost of a butterfly with its share of the transposes and copies relative to a multiply-add of the direct sum,
+// measured with FilterBench. It includes the blocks that tiles transform for only part of their core, since the cores
+// rarely line up with the tiles: in 64x64 tiles the Fourier strategy overtakes the direct sum at a radius of about 16.
+constexpr double FourierCost = 80.0;
+// Fixed point of the running sums, 24 fractional bits with the inputs clamped to +-2^20. Sums of integers are exact,
+// so a pixel gets the same value whichever pixel the sums of its tile started at.
+constexpr float FixedOne = 16777216.0f, FixedLimit = 1048576.0f;
+static_assert((double)(2 * MaxRadius + 1) * (2 * MaxRadius + 1) * FixedLimit * FixedOne < 9.2e18,
+              "The column sums of the largest box must fit into 64 bits!");
+
+// NaN becomes -FixedLimit
+inline int64_t ToFixed(float value)
+{
+  return (int64_t)(std::max(-FixedLimit, std::min(value, FixedLimit)) * FixedOne);
+}
+
+uint64_t HashKernel(const FilterKernel& kernel)
+{
+  const uint64_t hash = HashCombine((uint64_t)kernel.Shape, (uint64_t)kernel.Radius);
+  const size_t size = kernel.Weights.size() * sizeof(float);
+  return HashCombine(hash, HashBytes((const unsigned char*)kernel.Weights.data(), size));
+}
+
+FilterKernel MakeSeparable(std::vector<float> horizontal, const std::vector<float>& vertical)
+{
+  FilterKernel kernel;
+  kernel.Radius = (int32_t)horizontal.size() / 2;
+  kernel.Shape = Shape::Separable;
+  kernel.Weights = std::move(horizontal);
+  kernel.Weights.insert(kernel.Weights.end(), vertical.begin(), vertical.end());
+  kernel.Hash = HashKernel(kernel);
+  return kernel;
+}
+
+// Horizontal and vertical weights of kernels that are separable, boxes included
+void GetSeparableWeights(const FilterKernel& kernel, std::vector<float>& weights)
+{
+  const int32_t taps = 2 * kernel.Radius + 1;
+  if (kernel.Shape == Shape::Box) weights.assign(2 * taps, 1.0f / taps);
+  else weights = kernel.Weights;
+}
+
+void GetDenseWeights(const FilterKernel& kernel, std::vector<float>& weights)
+{
+  if (kernel.Shape == Shape::Dense) {
+    weights = kernel.Weights;
+    return;
+  }
+  const int32_t taps = 2 * kernel.Radius + 1;
+  std::vector<float> separable;
+  GetSeparableWeights(kernel, separable);
+  weights.resize((size_t)taps * taps);
+  for (int32_t y = 0; y < taps; y++) {
+    for (int32_t x = 0; x < taps; x++) weights[y * taps + x] = separable[x] * separable[taps + y];
+  }
+}
+
+// Edge length of the square blocks the Fourier strategy transforms, blocks overlap by twice the radius. At four times
+// the radius at least half of every block is output.
+uint32_t GetFourierSize(int32_t radius)
+{
+  return std::max(32u, std::bit_ceil((uint32_t)(4 * radius + 1)));
+}
+
+// Edge length of the core of a block, the pixels it outputs. The cores tile the bake starting at its origin.
+int32_t GetFourierCore(int32_t radius)
+{
+  return (int32_t)GetFourierSize(radius) - 2 * radius;
+}
+
+struct Spectrum {
+  uint64_t Hash;
+  uint32_t Width, Height;
+  uint64_t LastUse;
+  std::vector<float> Re, Im;
+};
+
+// Buffers of the strategies, reused by every tile a thread convolves
+struct Scratch {
+  std::vector<float> Weights;
+  std::vector<float> Ring;
+  std::vector<const float*> Rows;
+  std::vector<int64_t> RowSums, Sums;
+  std::vector<float> Re, Im, TransposedRe, TransposedIm;
+  // exp(-2 pi i k / n) for k < n / 2, indexed by log2(n)
+  std::array<std::vector<float>, 32> TwiddleRe, TwiddleIm;
+  // Transformed kernels, a few of them for the nodes with different radii
+  std::vector<Spectrum> Spectra;
+  uint64_t Uses = 0;
+};
+thread_local Scratch s_Scratch;
+
+constexpr size_t MaxSpectra = 4;
+
+void ConvolveDirect(const FilterKernel& kernel, const Image& block, uint32_t channels, const Rect& region,
+                    Image& output, const RowFunctions& rows)
+{
+  const int32_t radius = kernel.Radius, taps = 2 * radius + 1;
+  std::vector<float>& weights = s_Scratch.Weights;
+  GetDenseWeights(kernel, weights);
+
+  for (int32_t x = region.X; x < region.Right(); x += StripWidth) {
+    const int32_t width = std::min(StripWidth, region.Right() - x);
+    for (uint32_t c = 0; c < channels; c++) {
+      for (int32_t y = region.Y; y < region.Bottom(); y++) {
+        float* out = output.GetPointer(c, x, y);
+        for (int32_t t = 0; t < taps; t++) {
+          rows.ConvolveRow(block.GetPointer(c, x - radius, y - radius + t), weights.data() + t * taps, taps, out, width,
+                           t > 0);
+        }
+      }
+    }
+  }
+}
+
+// Every block row is filtered horizontally once into a ring of the last 2r + 1 rows, which the vertical pass of the
+// output row in the middle of them reads
+void ConvolveSeparable(const FilterKernel& kernel, const Image& block, uint32_t channels, const Rect& region,
+                       Image& output, const RowFunctions& rows)
+{
+  const int32_t radius = kernel.Radius, taps = 2 * radius + 1, top = region.Y - radius;
+  std::vector<float>& weights = s_Scratch.Weights;
+  GetSeparableWeights(kernel, weights);
+  const float* horizontal = weights.data();
+  const float* vertical = horizontal + taps;
+  std::vector<const float*>& window = s_Scratch.Rows;
+  window.resize(taps);
+
+  for (int32_t x = region.X; x < region.Right(); x += StripWidth) {
+    const int32_t width = std::min(StripWidth, region.Right() - x);
+    std::vector<float>& ring = s_Scratch.Ring;
+    ring.resize((size_t)taps * width);
+    for (uint32_t c = 0; c < channels; c++) {
+      for (int32_t y = top; y < region.Bottom() + radius; y++) {
+        rows.ConvolveRow(block.GetPointer(c, x - radius, y), horizontal, taps,
+                         ring.data() + (size_t)((y - top) % taps) * width, width, false);
+        const int32_t outY = y - radius;
+        if (outY < region.Y) continue;
+        for (int32_t t = 0; t < taps; t++) window[t] = ring.data() + (size_t)((outY - region.Y + t) % taps) * width;
+        rows.ConvolveColumns(window.data(), vertical, taps, output.GetPointer(c, x, outY), width);
+      }
+    }
+  }
+}
+
+// Sliding sums along the rows into a ring of 2r + 2 rows, and down the columns over whole rows at once. The sums are
+// fixed point, see ToFixed, so neither the size of the region nor where it starts changes the result.
+void ConvolveRunningSum(const FilterKernel& kernel, const Image& block, uint32_t channels, const Rect& region,
+                        Image& output, const RowFunctions& rows)
+{
+  const int32_t radius = kernel.Radius, taps = 2 * radius + 1, top = region.Y - radius, slots = taps + 1;
+  const double scale = 1.0 / ((double)taps * taps * FixedOne);
+
+  for (int32_t x = region.X; x < region.Right(); x += StripWidth) {
+    const int32_t width = std::min(StripWidth, region.Right() - x);
+    std::vector<int64_t>& ring = s_Scratch.RowSums;
+    std::vector<int64_t>& sums = s_Scratch.Sums;
+    ring.resize((size_t)slots * width);
+    for (uint32_t c = 0; c < channels; c++) {
+      sums.assign(width, 0);
+      for (int32_t y = top; y < region.Bottom() + radius; y++) {
+        const float* in = block.GetPointer(c, x - radius, y);
+        int64_t* entering = ring.data() + (size_t)((y - top) % slots) * width;
+        int64_t sum = 0;
+        for (int32_t t = 0; t < taps; t++) sum += ToFixed(in[t]);
+        entering[0] = sum;
+        for (int32_t i = 1; i < width; i++) {
+          sum += ToFixed(in[i + taps - 1]) - ToFixed(in[i - 1]);
+          entering[i] = sum;
+        }
+
+        const int64_t* leaving = y - taps >= top ? ring.data() + (size_t)((y - taps - top) % slots) * width : nullptr;
+        // Rows above the region only fill up the sums
+        const int32_t outY = y - radius;
+        float* out = outY >= region.Y ? output.GetPointer(c, x, outY) : nullptr;
+        rows.SlideRows(sums.data(), entering, leaving, scale, out, width);
+      }
+    }
+  }
+}
+
+void GetTwiddles(uint32_t size, const float*& re, const float*& im)
+{
+  const uint32_t level = std::countr_zero(size);
+  std::vector<float>& twiddleRe = s_Scratch.TwiddleRe[level];
+  std::vector<float>& twiddleIm = s_Scratch.TwiddleIm[level];
+  if (twiddleRe.size() != size / 2) {
+    twiddleRe.resize(size / 2);
+    twiddleIm.resize(size / 2);
+    for (uint32_t k = 0; k < size / 2; k++) {
+      const double angle = -2.0 * std::numbers::pi * k / size;
+      twiddleRe[k] = (float)std::cos(angle);
+      twiddleIm[k] = (float)std::sin(angle);
+    }
+  }
+  re = twiddleRe.data();
+  im = twiddleIm.data();
+}
+
+// 1D transforms of length count along the columns of a count x width array, computed as butterflies between whole
+// rows. The forward transform takes natural order and leaves the frequencies in bit reversed order, the inverse one
+// takes them back from that order, so the two never need a reordering pass.
+void TransformColumns(float* re, float* im, uint32_t count, uint32_t width, bool forward, const RowFunctions& rows)
+{
+  const float* twiddleRe;
+  const float* twiddleIm;
+  GetTwiddles(count, twiddleRe, twiddleIm);
+  auto stage = [&](uint32_t size) {
+    const uint32_t half = size / 2, stride = count / size;
+    for (uint32_t start = 0; start < count; start += size) {
+      for (uint32_t k = 0; k < half; k++) {
+        const size_t a = (size_t)(start + k) * width, b = a + (size_t)half * width;
+        const float wRe = twiddleRe[k * stride], wIm = twiddleIm[k * stride];
+        if (forward) rows.ButterflyForward(re + a, im + a, re + b, im + b, wRe, wIm, width);
+        else rows.ButterflyInverse(re + a, im + a, re + b, im + b, wRe, -wIm, width);
+      }
+    }
+  };
+  if (forward) {
+    for (uint32_t size = count; size >= 2; size /= 2) stage(size);
+  } else {
+    for (uint32_t size = 2; size <= count; size *= 2) stage(size);
+  }
+}
+
+// Transposes a height x width array into a width x height one, in cache sized squares
+void Transpose(const float* source, uint32_t width, uint32_t height, float* destination)
+{
+  constexpr uint32_t Block = 16;
+  for (uint32_t y0 = 0; y0 < height; y0 += Block) {
+    for (uint32_t x0 = 0; x0 < width; x0 += Block) {
+      for (uint32_t y = y0; y < std::min(y0 + Block, height); y++) {
+        for (uint32_t x = x0; x < std::min(x0 + Block, width); x++) {
+          destination[(size_t)x * height + y] = source[(size_t)y * width + x];
+        }
+      }
+    }
+  }
+}
+
+// Transforms the height x width arrays in Re and Im into TransposedRe and TransposedIm, whose layout the spectra
+// of the kernels share
+void TransformForward(uint32_t width, uint32_t height, const RowFunctions& rows)
+{
+  Scratch& scratch = s_Scratch;
+  const size_t size = (size_t)width * height;
+  scratch.TransposedRe.resize(size);
+  scratch.TransposedIm.resize(size);
+  TransformColumns(scratch.Re.data(), scratch.Im.data(), height, width, true, rows);
+  Transpose(scratch.Re.data(), width, height, scratch.TransposedRe.data());
+  Transpose(scratch.Im.data(), width, height, scratch.TransposedIm.data());
+  TransformColumns(scratch.TransposedRe.data(), scratch.TransposedIm.data(), width, height, true, rows);
+}
+
+void TransformInverse(uint32_t width, uint32_t height, const RowFunctions& rows)
+{
+  Scratch& scratch = s_Scratch;
+  TransformColumns(scratch.TransposedRe.data(), scratch.TransposedIm.data(), width, height, false, rows);
+  Transpose(scratch.TransposedRe.data(), height, width, scratch.Re.data());
+  Transpose(scratch.TransposedIm.data(), height, width, scratch.Im.data());
+  TransformColumns(scratch.Re.data(), scratch.Im.data(), height, width, false, rows);
+}
+
+// The kernel is mirrored into the top left corner of a block, so the circular convolution with it is the sum of
+// the filter ending at every pixel. The scale of the inverse transform is folded into it.
+const Spectrum& GetSpectrum(const FilterKernel& kernel, uint32_t width, uint32_t height, const RowFunctions& rows)
+{
+  Scratch& scratch = s_Scratch;
+  scratch.Uses++;
+  for (Spectrum& spectrum : scratch.Spectra) {
+    if (spectrum.Hash == kernel.Hash && spectrum.Width == width && spectrum.Height == height) {
+      spectrum.LastUse = scratch.Uses;
+      return spectrum;
+    }
+  }
+
+  const int32_t taps = 2 * kernel.Radius + 1;
+  std::vector<float>& weights = scratch.Weights;
+  GetDenseWeights(kernel, weights);
+  const float scale = 1.0f / ((float)width * height);
+  scratch.Re.assign((size_t)width * height, 0.0f);
+  scratch.Im.assign((size_t)width * height, 0.0f);
+  for (int32_t y = 0; y < taps; y++) {
+    for (int32_t x = 0; x < taps; x++) {
+      scratch.Re[(size_t)y * width + x] = weights[(taps - 1 - y) * taps + (taps - 1 - x)] * scale;
+    }
+  }
+  TransformForward(width, height, rows);
+
+  if (scratch.Spectra.size() == MaxSpectra) {
+    scratch.Spectra.erase(std::min_element(scratch.Spectra.begin(), scratch.Spectra.end(),
+                                           [](const Spectrum& a, const Spectrum& b) { return a.LastUse < b.LastUse; }));
+  }
+  return scratch.Spectra.emplace_back(
+      Spectrum{ kernel.Hash, width, height, scratch.Uses, scratch.TransposedRe, scratch.TransposedIm });
+}
+
+// Overlap-save: the bake is cut into blocks whose size is a power of two, with cores at fixed positions (see
+// GetFourierCore). Every block the region touches is transformed whole even if only part of its core is output, so a
+// pixel always comes out of the same block with the same rounding, whichever tile it is part of. Two channels are
+// transformed at once as the real and imaginary part, which works because the kernel is real.
+void ConvolveFourier(const FilterKernel& kernel, const Image& block, uint32_t channels, const Rect& region,
+                     Image& output, const RowFunctions& rows)
+{
+  const int32_t radius = kernel.Radius, core = GetFourierCore(radius);
+  const uint32_t size = GetFourierSize(radius);
+  const size_t area = (size_t)size * size;
+  // Rounds down to a multiple of the core, also left of and above the origin
+  auto anchor = [core](int32_t start) { return (start >= 0 ? start : start - core + 1) / core * core; };
+  Scratch& scratch = s_Scratch;
+
+  for (int32_t y0 = anchor(region.Y); y0 < region.Bottom(); y0 += core) {
+    for (int32_t x0 = anchor(region.X); x0 < region.Right(); x0 += core) {
+      const Rect part = Rect{ x0, y0, core, core }.Intersect(region);
+      // Looked up for every block, a block of another kernel may have evicted it in between
+      const Spectrum& spectrum = GetSpectrum(kernel, size, size, rows);
+      for (uint32_t c = 0; c < channels; c += 2) {
+        scratch.Re.resize(area);
+        scratch.Im.resize(area);
+        for (uint32_t y = 0; y < size; y++) {
+          const int32_t blockY = y0 - radius + (int32_t)y;
+          std::copy_n(block.GetPointer(c, x0 - radius, blockY), size, scratch.Re.data() + (size_t)y * size);
+          if (c + 1 < channels) {
+            std::copy_n(block.GetPointer(c + 1, x0 - radius, blockY), size, scratch.Im.data() + (size_t)y * size);
+          } else {
+            std::fill_n(scratch.Im.data() + (size_t)y * size, size, 0.0f);
+          }
+        }
+
+        TransformForward(size, size, rows);
+        rows.MultiplySpectrum(scratch.TransposedRe.data(), scratch.TransposedIm.data(), spectrum.Re.data(),
+                              spectrum.Im.data(), (int32_t)area);
+        TransformInverse(size, size, rows);
+
+        for (int32_t y = 0; y < part.Height; y++) {
+          const size_t offset = (size_t)(part.Y - y0 + y + 2 * radius) * size + (part.X - x0) + 2 * radius;
+          std::copy_n(scratch.Re.data() + offset, part.Width, output.GetPointer(c, part.X, part.Y + y));
+          if (c + 1 < channels) {
+            std::copy_n(scratch.Im.data() + offset, part.Width, output.GetPointer(c + 1, part.X, part.Y + y));
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+FilterKernel FilterKernel::Gaussian(int32_t radius)
+{
+  const double sigma = std::max(radius / 3.0, 1e-3);
+  std::vector<float> weights(2 * radius + 1);
+  std::vector<double> exact(2 * radius + 1);
+  double sum = 0.0;
+  for (int32_t t = -radius; t <= radius; t++) sum += exact[t + radius] = std::exp(-t * t / (2.0 * sigma * sigma));
+  for (size_t t = 0; t < weights.size(); t++) weights[t] = (float)(exact[t] / sum);
+  return MakeSeparable(weights, weights);
+}
+
+FilterKernel FilterKernel::Box(int32_t radius)
+{
+  FilterKernel kernel;
+  kernel.Radius = radius;
+  kernel.Shape = Shape::Box;
+  kernel.Hash = HashKernel(kernel);
+  return kernel;
+}
+
+FilterKernel FilterKernel::SobelX()
+{
+  return MakeSeparable({ -1.0f, 0.0f, 1.0f }, { 1.0f, 2.0f, 1.0f });
+}
+
+FilterKernel FilterKernel::SobelY()
+{
+  return MakeSeparable({ 1.0f, 2.0f, 1.0f }, { -1.0f, 0.0f, 1.0f });
+}
+
+FilterKernel FilterKernel::Dense(int32_t radius, std::vector<float> weights)
+{
+  FR_ASSERT(weights.size() == (size_t)(2 * radius + 1) * (2 * radius + 1), "Dense kernels need (2r + 1)^2 weights!");
+  FilterKernel kernel;
+  kernel.Radius = radius;
+  kernel.Shape = Shape::Dense;
+  kernel.Weights = std::move(weights);
+  kernel.Hash = HashKernel(kernel);
+  return kernel;
+}
+
+const char* GetStrategyName(Strategy strategy)
+{
+  switch (strategy) {
+    case Strategy::Direct:
+      return "direct";
+    case Strategy::Separable:
+      return "separable";
+    case Strategy::RunningSum:
+      return "running sum";
+    case Strategy::Fourier:
+      return "fourier";
+  }
+  return "unknown";
+}
+
+Strategy ChooseStrategy(Shape shape, int32_t radius)
+{
+  if (shape == Shape::Box) return Strategy::RunningSum;
+  if (shape == Shape::Separable) return Strategy::Separable;
+
+  // Multiply-adds of the direct sum against butterflies of the forward and inverse transform of a block spread over
+  // its core, both per pixel and channel
+  const int32_t taps = 2 * radius + 1, core = GetFourierCore(radius);
+  const double size = GetFourierSize(radius);
+  // Two channels share a transform
+  const double fourier = size * size * std::log2(size * size) * FourierCost * 0.5 / ((double)core * core);
+  return fourier < (double)taps * taps ? Strategy::Fourier : Strategy::Direct;
+}
+
+int32_t GetHalo(int32_t radius, Strategy strategy)
+{
+  // The cores at the edges of a region start up to core - 1 pixels outside of it
+  return strategy == Strategy::Fourier ? radius + GetFourierCore(radius) - 1 : radius;
+}
+
+bool SupportsStrategy(const FilterKernel& kernel, Strategy strategy)
+{
+  switch (strategy) {
+    case Strategy::Direct:
+    case Strategy::Fourier:
+      return true;
+    case Strategy::Separable:
+      return kernel.Shape != Shape::Dense;
+    case Strategy::RunningSum:
+      return kernel.Shape == Shape::Box;
+  }
+  return false;
+}
+
+void LoadBlock(const KernelInput& input, const Rect& region, uint32_t channels, Image& block)
+{
+  block.Reset(region);
+  if (!input.Source) {
+    for (uint32_t c = 0; c < channels; c++) {
+      for (int32_t y = region.Y; y < region.Bottom(); y++) {
+        std::fill_n(block.GetPointer(c, region.X, y), region.Width, input.Constant[c]);
+      }
+    }
+    return;
+  }
+
+  const Rect& source = input.Source->GetRegion();
+  // Columns [begin, end) exist in the source, the ones left and right of them repeat its edge
+  const int32_t begin = std::clamp(source.X, region.X, region.Right());
+  const int32_t end = std::clamp(source.Right(), begin, region.Right());
+  for (uint32_t c = 0; c < channels; c++) {
+    for (int32_t y = region.Y; y < region.Bottom(); y++) {
+      const int32_t sourceY = std::clamp(y, source.Y, source.Bottom() - 1);
+      const float* in = input.Source->GetPointer(c, source.X, sourceY);
+      float* out = block.GetPointer(c, region.X, y);
+      std::fill_n(out, begin - region.X, in[0]);
+      std::copy(in + (begin - source.X), in + (end - source.X), out + (begin - region.X));
+      std::fill_n(out + (end - region.X), region.Right() - end, in[source.Width - 1]);
+    }
+  }
+}
+
+void Convolve(const FilterKernel& kernel, const Image& block, uint32_t channels, const Rect& region, Image& output)
+{
+  Convolve(kernel, block, channels, region, output, ChooseStrategy(kernel));
+}
+
+void Convolve(const FilterKernel& kernel, const Image& block, uint32_t channels, const Rect& region, Image& output,
+              Strategy strategy)
+{
+  FR_ASSERT(block.GetRegion().Contains(region.Expand(GetHalo(kernel.Radius, strategy))),
+            "Block does not cover the halo of the region!");
+  FR_ASSERT(SupportsStrategy(kernel, strategy), std::string("Kernel can not use the ") + GetStrategyName(strategy) +
+                                                    " strategy!");
+  const RowFunctions& rows = GetRowFunctions();
+  switch (strategy) {
+    case Strategy::Direct:
+      return ConvolveDirect(kernel, block, channels, region, output, rows);
+    case Strategy::Separable:
+      return ConvolveSeparable(kernel, block, channels, region, output, rows);
+    case Strategy::RunningSum:
+      return ConvolveRunningSum(kernel, block, channels, region, output, rows);
+    case Strategy::Fourier:
+      return ConvolveFourier(kernel, block, channels, region, output, rows);
+  }
+}
+
+int32_t ScaleRadius(float radius, uint32_t width)
+{
+  return std::clamp((int32_t)std::lround(radius * width / 1024.0f), 0, MaxRadius);
+}
+
+namespace {
+
+// Tile sized images of the node kernels, besides the blocks of their inputs
+thread_local Image s_Block, s_Filtered;
+
+// Luminance with Rec. 709 weights into channel 0 of the image
+void StoreLuminance(Image& image)
+{
+  const Rect& region = image.GetRegion();
+  for (int32_t y = region.Y; y < region.Bottom(); y++) {
+    float* r = image.GetPointer(0, region.X, y);
+    const float* g = image.GetPointer(1, region.X, y);
+    const float* b = image.GetPointer(2, region.X, y);
+    for (int32_t i = 0; i < region.Width; i++) r[i] = 0.2126f * r[i] + 0.7152f * g[i] + 0.0722f * b[i];
+  }
+}
+
+// Sobel derivatives of channel 0 of the block, d/dx into channel 0 of output and d/dy into channel 0 of s_Filtered
+void Differentiate(const Image& block, const Rect& tile, Image& output)
+{
+  static const FilterKernel s_SobelX = FilterKernel::SobelX(), s_SobelY = FilterKernel::SobelY();
+  s_Filtered.Reset(tile);
+  Convolve(s_SobelX, block, 1, tile, output);
+  Convolve(s_SobelY, block, 1, tile, s_Filtered);
+}
+
+void FillAlpha(const Rect& tile, Image& output)
+{
+  for (int32_t y = tile.Y; y < tile.Bottom(); y++) std::fill_n(output.GetPointer(3, tile.X, y), tile.Width, 1.0f);
+}
+
+} // namespace
+
+int32_t BlurRadius(std::span<const Pixel> constants, uint32_t width, uint32_t)
+{
+  return ScaleRadius(constants[1].R, width);
+}
+
+// Input, Radius, Mode (0 Gaussian, 1 box)
+void BlurKernel(const KernelContext& context)
+{
+  const Rect& tile = context.Tile;
+  const int32_t radius = ScaleRadius(context.Inputs[1].Constant.R, context.Width);
+  const FilterKernel kernel =
+    context.Inputs[2].Constant.R == 1.0f ? FilterKernel::Box(radius) : FilterKernel::Gaussian(radius);
+  LoadBlock(context.Inputs[0], tile.Expand(radius), Channels, s_Block);
+  Convolve(kernel, s_Block, Channels, tile, *context.Output);
+}
+
+int32_t SharpenRadius(std::span<const Pixel> constants, uint32_t width, uint32_t)
+{
+  return ScaleRadius(constants[2].R, width);
+}
+
+// Unsharp mask: Input, Amount, Radius. Alpha is passed through.
+void SharpenKernel(const KernelContext& context)
+{
+  const Rect& tile = context.Tile;
+  const float amount = context.Inputs[1].Constant.R;
+  const int32_t radius = ScaleRadius(context.Inputs[2].Constant.R, context.Width);
+  LoadBlock(context.Inputs[0], tile.Expand(radius), Channels, s_Block);
+  s_Filtered.Reset(tile);
+  Convolve(FilterKernel::Gaussian(radius), s_Block, 3, tile, s_Filtered);
+
+  for (uint32_t c = 0; c < Channels; c++) {
+    for (int32_t y = tile.Y; y < tile.Bottom(); y++) {
+      const float* in = s_Block.GetPointer(c, tile.X, y);
+      const float* blurred = s_Filtered.GetPointer(c, tile.X, y);
+      float* out = context.Output->GetPointer(c, tile.X, y);
+      if (c == 3) std::copy_n(in, tile.Width, out);
+      else for (int32_t i = 0; i < tile.Width; i++) out[i] = in[i] + amount * (in[i] - blurred[i]);
+    }
+  }
+}
+
+// Height, Strength. A strength of 1 tilts the normal by 45 degrees where the height changes by 1 over 1/64 of the
+// width of the bake. The normal map is encoded for OpenGL, with green pointing up.
+void HeightToNormalKernel(const KernelContext& context)
+{
+  const Rect& tile = context.Tile;
+  // Sobel derivatives are 8 times the slope per pixel
+  const float scale = context.Inputs[1].Constant.R * context.Width / 64.0f / 8.0f;
+  LoadBlock(context.Inputs[0], tile.Expand(1), 1, s_Block);
+  Image& output = *context.Output;
+  Differentiate(s_Block, tile, output);
+
+  for (int32_t y = tile.Y; y < tile.Bottom(); y++) {
+    const float* dy = s_Filtered.GetPointer(0, tile.X, y);
+    float* r = output.GetPointer(0, tile.X, y);
+    float* g = output.GetPointer(1, tile.X, y);
+    float* b = output.GetPointer(2, tile.X, y);
+    for (int32_t i = 0; i < tile.Width; i++) {
+      // Rows go down, so the height growing downwards tilts the normal up
+      const float x = -r[i] * scale, z = dy[i] * scale;
+      const float length = 1.0f / std::sqrt(x * x + z * z + 1.0f);
+      r[i] = x * length * 0.5f + 0.5f;
+      g[i] = z * length * 0.5f + 0.5f;
+      b[i] = length * 0.5f + 0.5f;
+    }
+  }
+  FillAlpha(tile, output);
+}
+
+int32_t AmbientOcclusionRadius(std::span<const Pixel> constants, uint32_t width, uint32_t)
+{
+  const int32_t radius = std::max(1, ScaleRadius(constants[1].R, width));
+  return GetHalo(radius, ChooseStrategy(Shape::Dense, radius));
+}
+
+// Height, Radius, Strength. Compares every pixel with the mean height around it, weighted by a cone so that close
+// neighbours occlude more. Large radii make this a dense kernel the Fourier strategy is there for.
+void AmbientOcclusionKernel(const KernelContext& context)
+{
+  const Rect& tile = context.Tile;
+  const int32_t radius = std::max(1, ScaleRadius(context.Inputs[1].Constant.R, context.Width));
+  const float strength = context.Inputs[2].Constant.R;
+
+  thread_local FilterKernel s_Cone;
+  if (s_Cone.Radius != radius) {
+    const int32_t taps = 2 * radius + 1;
+    std::vector<float> weights((size_t)taps * taps);
+    double sum = 0.0;
+    for (int32_t y = -radius; y <= radius; y++) {
+      for (int32_t x = -radius; x <= radius; x++) {
+        const double weight = std::max(0.0, 1.0 - std::sqrt((double)(x * x + y * y)) / (radius + 1));
+        weights[(y + radius) * taps + x + radius] = (float)weight;
+        sum += weight;
+      }
+    }
+    for (float& weight : weights) weight = (float)(weight / sum);
+    s_Cone = FilterKernel::Dense(radius, std::move(weights));
+  }
+
+  LoadBlock(context.Inputs[0], tile.Expand(GetHalo(radius, ChooseStrategy(Shape::Dense, radius))), 1, s_Block);
+  Image& output = *context.Output;
+  Convolve(s_Cone, s_Block, 1, tile, output);
+  for (int32_t y = tile.Y; y < tile.Bottom(); y++) {
+    const float* height = s_Block.GetPointer(0, tile.X, y);
+    float* r = output.GetPointer(0, tile.X, y);
+    for (int32_t i = 0; i < tile.Width; i++) r[i] = 1.0f - std::clamp(strength * (r[i] - height[i]), 0.0f, 1.0f);
+    std::copy_n(r, tile.Width, output.GetPointer(1, tile.X, y));
+    std::copy_n(r, tile.Width, output.GetPointer(2, tile.X, y));
+  }
+  FillAlpha(tile, output);
+}
+
+// Input, Strength. Magnitude of the gradient of the luminance, a hard step from 0 to 1 is an edge of strength 1.
+void EdgeDetectKernel(const KernelContext& context)
+{
+  const Rect& tile = context.Tile;
+  const float scale = context.Inputs[1].Constant.R / 4.0f;
+  LoadBlock(context.Inputs[0], tile.Expand(1), 3, s_Block);
+  StoreLuminance(s_Block);
+  Image& output = *context.Output;
+  Differentiate(s_Block, tile, output);
+
+  for (int32_t y = tile.Y; y < tile.Bottom(); y++) {
+    const float* dy = s_Filtered.GetPointer(0, tile.X, y);
+    float* r = output.GetPointer(0, tile.X, y);
+    for (int32_t i = 0; i < tile.Width; i++) r[i] = std::min(1.0f, std::sqrt(r[i] * r[i] + dy[i] * dy[i]) * scale);
+    std::copy_n(r, tile.Width, output.GetPointer(1, tile.X, y));
+    std::copy_n(r, tile.Width, output.GetPointer(2, tile.X, y));
+  }
+  FillAlpha(tile, output);
+}
+
+} // namespace Texturia::Filters
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Kernels.hpp"
+#include "Engine/Simd.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Texturia::Filters {
+
+enum class Shape : uint8_t {
+  // Any (2r + 1) x (2r + 1) weights
+  Dense,
+  // Product of a horizontal and a vertical row of weights
+  Separable,
+  // Same weight everywhere, summing up to 1
+  Box
+};
+
+// Weights of a convolution, out(x, y) = sum of Weight(dx, dy) * in(x + dx, y + dy) for dx, dy in [-r, r]
+struct FilterKernel {
+  int32_t Radius = 0;
+  Filters::Shape Shape = Shape::Dense;
+  // Separable kernels hold the 2r + 1 horizontal weights followed by the 2r + 1 vertical ones, dense kernels all
+  // (2r + 1)^2 weights row major, boxes none
+  std::vector<float> Weights;
+  // Identifies the weights, so transformed kernels can be cached
+  uint64_t Hash = 0;
+
+  // Normalized, with a sigma of a third of the radius
+  static FilterKernel Gaussian(int32_t radius);
+  static FilterKernel Box(int32_t radius);
+  // Horizontal and vertical 3 x 3 Sobel derivatives, a unit step from 0 to 1 responds with 4
+  static FilterKernel SobelX();
+  static FilterKernel SobelY();
+  static FilterKernel Dense(int32_t radius, std::vector<float> weights);
+};
+
+enum class Strategy : uint8_t {
+  // Every weight for every pixel
+  Direct,
+  // A horizontal pass into a ring of rows and a vertical pass over them
+  Separable,
+  // Sliding sums over rows and columns, the cost per pixel does not depend on the radius
+  RunningSum,
+  // Multiplication in the frequency domain of square blocks at fixed positions of the bake
+  Fourier
+};
+
+const char* GetStrategyName(Strategy strategy);
+// Cheapest strategy per pixel for a kernel of the shape and radius. Boxes and separable kernels never need the Fourier
+// transform, dense kernels use it once it beats the direct sum. The choice does not depend on the region, every
+// strategy gives each pixel the same value no matter which tile it is part of, so bakes with any tile size, thread
+// count or order of the tiles are identical.
+Strategy ChooseStrategy(Shape shape, int32_t radius);
+inline Strategy ChooseStrategy(const FilterKernel& kernel) { return ChooseStrategy(kernel.Shape, kernel.Radius); }
+// Pixels around a region that a strategy reads. The radius, except for the Fourier strategy: its blocks are anchored
+// to the bake rather than the region and reach up to a block past it.
+int32_t GetHalo(int32_t radius, Strategy strategy);
+// Whether strategy computes kernel at all, e.g. only boxes have running sums
+bool SupportsStrategy(const FilterKernel& kernel, Strategy strategy);
+
+// Copies region of the first channels of input into block, with clamp-to-edge addressing like Image::Sample. A
+// constant input fills the block with its value.
+void LoadBlock(const KernelInput& input, const Rect& region, uint32_t channels, Image& block);
+
+// Convolves the first channels of block with kernel and writes them to region of output. block has to cover
+// region.Expand(GetHalo(kernel.Radius, strategy)), which is what LoadBlock is for. Output channels past channels are
+// left alone.
+void Convolve(const FilterKernel& kernel, const Image& block, uint32_t channels, const Rect& region, Image& output);
+void Convolve(const FilterKernel& kernel, const Image& block, uint32_t channels, const Rect& region, Image& output,
+              Strategy strategy);
+
+// Loops of the strategies over one row of pixels, compiled once per instruction set like the noise rows
+struct RowFunctions {
+  // out[i] = sum of in[i + t] * weights[t] for t < taps, added to out if accumulate is set
+  void (*ConvolveRow)(const float* in, const float* weights, int32_t taps, float* out, int32_t count, bool accumulate);
+  // out[i] = sum of rows[t][i] * weights[t] for t < taps
+  void (*ConvolveColumns)(const float* const* rows, const float* weights, int32_t taps, float* out, int32_t count);
+  // sums[i] += entering[i] - leaving[i] and out[i] = sums[i] * scale, leaving may be nullptr. The sums are fixed
+  // point, so they are exact and do not depend on the row they started at.
+  void (*SlideRows)(int64_t* sums, const int64_t* entering, const int64_t* leaving, double scale, float* out,
+                    int32_t count);
+  // Radix 2 butterflies of count pairs (a, b) sharing the twiddle w, decimation in frequency for the forward
+  // transform: a' = a + b, b' = (a - b) * w
+  void (*ButterflyForward)(float* aRe, float* aIm, float* bRe, float* bIm, float wRe, float wIm, int32_t count);
+  // Decimation in time for the inverse transform: a' = a + b * w, b' = a - b * w
+  void (*ButterflyInverse)(float* aRe, float* aIm, float* bRe, float* bIm, float wRe, float wIm, int32_t count);
+  // (re, im) *= (kernelRe, kernelIm)
+  void (*MultiplySpectrum)(float* re, float* im, const float* kernelRe, const float* kernelIm, int32_t count);
+};
+
+// Runs the implementation compiled for level, which has to be supported by the CPU
+const RowFunctions& GetRowFunctions(SimdLevel level = GetSimdLevel());
+
+// Radius in pixels of a bake of the given width for a radius socket, which is measured in pixels of a 1024 wide bake
+// so that previews at lower resolutions look the same
+int32_t ScaleRadius(float radius, uint32_t width);
+
+// Node kernels, registered in Engine/Kernels.cpp
+void BlurKernel(const KernelContext& context);
+int32_t BlurRadius(std::span<const Pixel> constants, uint32_t width, uint32_t height);
+void SharpenKernel(const KernelContext& context);
+int32_t SharpenRadius(std::span<const Pixel> constants, uint32_t width, uint32_t height);
+void HeightToNormalKernel(const KernelContext& context);
+void AmbientOcclusionKernel(const KernelContext& context);
+int32_t AmbientOcclusionRadius(std::span<const Pixel> constants, uint32_t width, uint32_t height);
+void EdgeDetectKernel(const KernelContext& context);
+
+} // namespace Texturia::Filters
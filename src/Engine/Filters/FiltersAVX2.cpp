@@ -0,0 +1,3 @@
+// Compiled with -mavx2 -mfma, see CMakeLists.txt
+#define TX_FILTER_TARGET AVX2
+#include "Engine/Filters/FilterRow.inl"
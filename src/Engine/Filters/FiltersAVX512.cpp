@@ -0,0 +1,3 @@
+// Compiled with -mavx512f -mavx512dq, see CMakeLists.txt
+#define TX_FILTER_TARGET AVX512
+#include "Engine/Filters/FilterRow.inl"
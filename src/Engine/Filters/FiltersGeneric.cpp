@@ -0,0 +1,3 @@
+// Baseline of the target architecture, also the fallback when TX_SIMD_X86 is not defined
+#define TX_FILTER_TARGET Generic
+#include "Engine/Filters/FilterRow.inl"
@@ -0,0 +1,238 @@
+#include "Engine/GraphFile.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace Texturia {
+
+using namespace GraphFormat;
+
+namespace {
+
+template <typename Record>
+std::span<const Record> GetSection(std::span<const std::byte> file, const Section& section)
+{
+  return { (const Record*)(file.data() + section.Offset), (size_t)(section.Size / sizeof(Record)) };
+}
+
+} // namespace
+
+bool GraphFile::Open(const std::string& path)
+{
+  m_Header = nullptr;
+  m_Error.clear();
+  if (!m_File.Open(path)) return Fail("Could not open " + path);
+  if (!Validate()) {
+    m_File.Close();
+    return false;
+  }
+  return true;
+}
+
+bool GraphFile::Fail(std::string error)
+{
+  m_Header = nullptr;
+  m_Error = std::move(error);
+  return false;
+}
+
+// Only checks bounds, so the accessors never read outside of the mapping, the graph itself is checked by Load
+bool GraphFile::Validate()
+{
+  const std::span<const std::byte> file = m_File.GetData();
+  if (file.size() < sizeof(Header)) return Fail("File is too small to be a graph file");
+  const Header& header = *(const Header*)file.data();
+  if (std::memcmp(header.Magic, Magic, sizeof(Magic)) != 0) return Fail("Not a graph file");
+  if (header.Version != Version) {
+    return Fail("Unsupported graph file version " + std::to_string(header.Version) + ", expected " +
+                std::to_string(Version));
+  }
+  if (header.FileSize != file.size()) return Fail("Graph file is truncated");
+
+  auto checkSection = [&](const Section& section, uint64_t count, uint64_t recordSize, const char* name) {
+    if (section.Offset % SectionAlignment != 0 || section.Offset > file.size() ||
+        section.Size > file.size() - section.Offset || section.Size != count * recordSize) {
+      return Fail(std::string("Section ") + name + " is out of bounds");
+    }
+    return true;
+  };
+  if (!checkSection(header.Strings, header.StringCount, sizeof(StringRecord), "Strings") ||
+      !checkSection(header.StringData, header.StringData.Size, 1, "StringData") ||
+      !checkSection(header.Nodes, header.NodeCount, sizeof(NodeRecord), "Nodes") ||
+      !checkSection(header.Sockets, header.SocketCount, sizeof(SocketRecord), "Sockets") ||
+      !checkSection(header.Links, header.LinkCount, sizeof(LinkRecord), "Links") ||
+      !checkSection(header.Parameters, header.Parameters.Size, 1, "Parameters")) {
+    return false;
+  }
+
+  m_Strings = GetSection<StringRecord>(file, header.Strings);
+  m_StringData = GetSection<char>(file, header.StringData);
+  m_Nodes = GetSection<NodeRecord>(file, header.Nodes);
+  m_Sockets = GetSection<SocketRecord>(file, header.Sockets);
+  m_Links = GetSection<LinkRecord>(file, header.Links);
+  m_Parameters = GetSection<std::byte>(file, header.Parameters);
+
+  for (const StringRecord& string : m_Strings) {
+    if (string.Offset > m_StringData.size() || string.Size > m_StringData.size() - string.Offset) {
+      return Fail("String out of bounds");
+    }
+  }
+  if (header.Label >= header.StringCount) return Fail("Label out of bounds");
+  for (const NodeRecord& node : m_Nodes) {
+    if (node.Label >= header.StringCount || node.Type >= header.StringCount) return Fail("Node string out of bounds");
+    if ((uint64_t)node.FirstSocket + node.SocketCount > header.SocketCount) return Fail("Node sockets out of bounds");
+    if (node.Parameters % alignof(SocketData) != 0 ||
+        (uint64_t)node.Parameters + (uint64_t)node.SocketCount * sizeof(SocketData) > m_Parameters.size()) {
+      return Fail("Node parameters out of bounds");
+    }
+  }
+  for (const SocketRecord& socket : m_Sockets) {
+    if (socket.Label >= header.StringCount) return Fail("Socket label out of bounds");
+    if (socket.Type > SocketType::Image) return Fail("Unknown socket type " + std::to_string((int)socket.Type));
+  }
+  for (const LinkRecord& link : m_Links) {
+    if (link.From >= header.NodeCount || link.To >= header.NodeCount ||
+        link.ToSocket >= m_Nodes[link.To].SocketCount) {
+      return Fail("Link out of bounds");
+    }
+  }
+
+  m_Header = &header;
+  return true;
+}
+
+std::string_view GraphFile::GetString(uint32_t index) const
+{
+  const StringRecord& string = m_Strings[index];
+  return { m_StringData.data() + string.Offset, string.Size };
+}
+
+bool GraphFile::Load(NodesTree& tree)
+{
+  FR_ASSERT(IsValid(), "Graph file is not open!");
+  tree.Clear();
+  tree.SetLabel(std::string(GetLabel()));
+  tree.Reserve(m_Header->NodeCount, m_Header->SocketCount, m_Header->LinkCount);
+
+  std::vector<NodeHandle> handles;
+  handles.reserve(m_Nodes.size());
+  std::vector<NodeSocket> sockets;
+  for (const NodeRecord& record : m_Nodes) {
+    if (!tree.FindNode(record.UUID).IsNull()) {
+      tree.Clear();
+      return Fail("Duplicate node " + std::to_string(record.UUID));
+    }
+    std::span<const SocketRecord> socketRecords = GetSockets(record);
+    std::span<const SocketData> parameters = GetParameters(record);
+    sockets.clear();
+    for (uint32_t i = 0; i < record.SocketCount; i++) {
+      NodeSocket& socket = sockets.emplace_back(std::string(GetString(socketRecords[i].Label)),
+                                                SocketValue(socketRecords[i].Type, parameters[i]));
+      socket.UUID = socketRecords[i].UUID;
+    }
+    Node node(std::string(GetString(record.Label)), std::string(GetString(record.Type)), std::move(sockets),
+              record.UUID);
+    handles.push_back(tree.AddNode(node));
+    sockets = std::move(node.GetSockets());
+  }
+
+  for (const LinkRecord& link : m_Links) {
+    if (tree.AddLink(handles[link.From], { handles[link.To], link.ToSocket }).IsNull()) {
+      tree.Clear();
+      return Fail("Link from node " + std::to_string(link.From) + " to node " + std::to_string(link.To) +
+                  " closes a cycle");
+    }
+  }
+  return true;
+}
+
+bool WriteGraphFile(const NodesTree& tree, const std::string& path)
+{
+  if (!tree.GetGroups().empty()) return false;
+
+  // Upstream nodes first and links grouped by their source, so loading adds every link before the target has
+  // outgoing links and the cycle checks of AddLink stop right away
+  const std::vector<NodeHandle> order = tree.GetTopologicalOrder();
+  const uint32_t nodeCount = (uint32_t)order.size();
+  std::unordered_map<NodeHandle, uint32_t> fileIndices;
+  fileIndices.reserve(nodeCount);
+  for (uint32_t i = 0; i < nodeCount; i++) fileIndices[order[i]] = i;
+
+  std::vector<StringRecord> strings;
+  std::string stringData;
+  std::unordered_map<std::string_view, uint32_t> stringIndices;
+  // Views into the tree, which outlives the map
+  auto intern = [&](std::string_view string) {
+    auto [it, inserted] = stringIndices.try_emplace(string, (uint32_t)strings.size());
+    if (inserted) {
+      strings.push_back({ (uint32_t)stringData.size(), (uint32_t)string.size() });
+      stringData += string;
+    }
+    return it->second;
+  };
+
+  Header header = {};
+  std::memcpy(header.Magic, Magic, sizeof(Magic));
+  header.Version = Version;
+  header.Label = intern(tree.GetLabel());
+
+  std::vector<NodeRecord> nodes;
+  std::vector<SocketRecord> sockets;
+  std::vector<SocketData> parameters;
+  std::vector<LinkRecord> links;
+  nodes.reserve(nodeCount);
+  for (NodeHandle handle : order) {
+    const uint32_t socketCount = tree.GetSocketCount(handle);
+    nodes.push_back({ tree.GetUUID(handle), intern(tree.GetLabel(handle)), intern(tree.GetType(handle)),
+                      (uint32_t)sockets.size(), socketCount, (uint32_t)(parameters.size() * sizeof(SocketData)), 0 });
+    for (uint32_t socket = 0; socket < socketCount; socket++) {
+      sockets.push_back({ tree.GetSocketUUID(handle, socket), intern(tree.GetSocketLabel(handle, socket)),
+                          tree.GetSocketTypes(handle)[socket], {} });
+      parameters.push_back(tree.GetSocketData(handle)[socket]);
+    }
+    for (LinkHandle link : tree.GetOutgoingLinks(handle)) {
+      const SocketHandle target = tree.GetLinkTarget(link);
+      links.push_back({ fileIndices[handle], fileIndices[target.Node], target.Socket, 0 });
+    }
+  }
+  if (parameters.size() * sizeof(SocketData) > UINT32_MAX) return false;
+  header.StringCount = (uint32_t)strings.size();
+  header.NodeCount = nodeCount;
+  header.SocketCount = (uint32_t)sockets.size();
+  header.LinkCount = (uint32_t)links.size();
+
+  uint64_t offset = sizeof(Header);
+  auto place = [&](Section& section, uint64_t size) {
+    offset = (offset + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+    section = { offset, size };
+    offset += size;
+  };
+  place(header.Strings, strings.size() * sizeof(StringRecord));
+  place(header.StringData, stringData.size());
+  place(header.Nodes, nodes.size() * sizeof(NodeRecord));
+  place(header.Sockets, sockets.size() * sizeof(SocketRecord));
+  place(header.Links, links.size() * sizeof(LinkRecord));
+  place(header.Parameters, parameters.size() * sizeof(SocketData));
+  header.FileSize = offset;
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file) return false;
+  uint64_t written = sizeof(Header);
+  auto write = [&](const Section& section, const void* data) {
+    // Zero padding up to the section
+    static constexpr char s_Padding[SectionAlignment] = {};
+    file.write(s_Padding, (std::streamsize)(section.Offset - written));
+    file.write((const char*)data, (std::streamsize)section.Size);
+    written = section.Offset + section.Size;
+  };
+  file.write((const char*)&header, sizeof(header));
+  write(header.Strings, strings.data());
+  write(header.StringData, stringData.data());
+  write(header.Nodes, nodes.data());
+  write(header.Sockets, sockets.data());
+  write(header.Links, links.data());
+  write(header.Parameters, parameters.data());
+  return (bool)file;
+}
+
+} // namespace Texturia
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/MappedFile.hpp"
+#include "Nodes.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace Texturia {
+
+static_assert(std::endian::native == std::endian::little, "Graph files are little endian");
+
+// Binary layout of .txg graph files. Every section is an array of fixed size records that is read in place, records
+// refer to each other by index, strings by their index in the string table. Sections start at multiples of
+// SectionAlignment, so the records can be used straight from a memory mapping.
+namespace GraphFormat {
+
+constexpr char Magic[4] = { 'T', 'X', 'G', '\0' };
+// Bumped whenever a record changes, readers reject other versions
+constexpr uint32_t Version = 1;
+constexpr uint64_t SectionAlignment = 64;
+
+struct Section {
+  uint64_t Offset;
+  uint64_t Size;
+};
+
+struct Header {
+  char Magic[4];
+  uint32_t Version;
+  uint64_t FileSize;
+  // Label of the tree, index into the string table
+  uint32_t Label;
+  uint32_t StringCount;
+  uint32_t NodeCount;
+  uint32_t SocketCount;
+  uint32_t LinkCount;
+  uint32_t Reserved;
+  Section Strings;
+  Section StringData;
+  Section Nodes;
+  Section Sockets;
+  Section Links;
+  // SocketData payloads of the sockets, 16 byte aligned
+  Section Parameters;
+};
+
+// Characters [Offset, Offset + Size) of the string data, not null terminated
+struct StringRecord {
+  uint32_t Offset;
+  uint32_t Size;
+};
+
+struct NodeRecord {
+  uint64_t UUID;
+  uint32_t Label;
+  uint32_t Type;
+  // Sockets [FirstSocket, FirstSocket + SocketCount) of the socket section
+  uint32_t FirstSocket;
+  uint32_t SocketCount;
+  // Byte offset of the SocketCount payloads of the node in the parameter section
+  uint32_t Parameters;
+  uint32_t Reserved;
+};
+
+struct SocketRecord {
+  uint64_t UUID;
+  uint32_t Label;
+  SocketType Type;
+  uint8_t Reserved[3];
+};
+
+// Nodes are indices into the node section
+struct LinkRecord {
+  uint32_t From;
+  uint32_t To;
+  uint32_t ToSocket;
+  uint32_t Reserved;
+};
+
+static_assert(sizeof(Header) == 136 && sizeof(StringRecord) == 8 && sizeof(NodeRecord) == 32 &&
+              sizeof(SocketRecord) == 16 && sizeof(LinkRecord) == 16);
+
+} // namespace GraphFormat
+
+// Read only view of a .txg file. Opening maps the file and checks that every record is in bounds, nothing is parsed
+// or copied, so the accessors hand out pointers into the mapping which stay valid as long as the GraphFile.
+class GraphFile {
+public:
+  GraphFile() = default;
+  explicit GraphFile(const std::string& path) { Open(path); }
+
+  // Returns false and sets the error if the file can not be read or is not a valid graph file
+  bool Open(const std::string& path);
+
+  inline bool IsValid() const { return m_Header != nullptr; }
+  inline const std::string& GetError() const { return m_Error; }
+
+  std::string_view GetString(uint32_t index) const;
+  inline std::string_view GetLabel() const { return GetString(m_Header->Label); }
+
+  inline std::span<const GraphFormat::NodeRecord> GetNodes() const { return m_Nodes; }
+  inline std::span<const GraphFormat::SocketRecord> GetSockets(const GraphFormat::NodeRecord& node) const
+  {
+    return m_Sockets.subspan(node.FirstSocket, node.SocketCount);
+  }
+  inline std::span<const SocketData> GetParameters(const GraphFormat::NodeRecord& node) const
+  {
+    return { (const SocketData*)(m_Parameters.data() + node.Parameters), node.SocketCount };
+  }
+  inline std::span<const GraphFormat::LinkRecord> GetLinks() const { return m_Links; }
+
+  // Replaces the contents of tree with the graph. Fails if a link would close a cycle.
+  bool Load(NodesTree& tree);
+
+private:
+  bool Fail(std::string error);
+  bool Validate();
+
+  MappedFile m_File;
+  const GraphFormat::Header* m_Header = nullptr;
+  std::span<const GraphFormat::StringRecord> m_Strings;
+  std::span<const char> m_StringData;
+  std::span<const GraphFormat::NodeRecord> m_Nodes;
+  std::span<const GraphFormat::SocketRecord> m_Sockets;
+  std::span<const GraphFormat::LinkRecord> m_Links;
+  std::span<const std::byte> m_Parameters;
+  std::string m_Error;
+};
+
+// Writes the tree as a .txg file, nodes in the order of their dense indices. The format has no place for the
+// definitions of groups yet, so trees with groups fail and have to be written as JSON (see Engine/GraphJson.hpp).
+bool WriteGraphFile(const NodesTree& tree, const std::string& path);
+
+} // namespace Texturia
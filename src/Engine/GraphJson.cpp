@@ -0,0 +1,372 @@
+#include "Engine/GraphJson.hpp"
+
+#include "Engine/Json.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+namespace Texturia {
+
+namespace {
+
+constexpr std::string_view s_Format = "texturia-graph";
+constexpr int32_t s_Version = 1;
+
+// Number of components a value of the type is written with
+uint32_t GetComponentCount(SocketType type)
+{
+  switch (type) {
+    case SocketType::Vec2:
+      return 2;
+    case SocketType::Vec3:
+      return 3;
+    case SocketType::Vec4:
+    case SocketType::Color:
+    case SocketType::Image:
+      return 4;
+    default:
+      return 1;
+  }
+}
+
+// JSON has no infinities and NaNs, they are written as strings
+void WriteFloat(std::string& out, float value)
+{
+  if (std::isnan(value)) {
+    out += "\"nan\"";
+  } else if (std::isinf(value)) {
+    out += value > 0 ? "\"inf\"" : "\"-inf\"";
+  } else {
+    // Nine significant digits identify every float
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    out += buffer;
+  }
+}
+
+void WriteValue(std::string& out, const SocketValue& value)
+{
+  switch (value.Type) {
+    case SocketType::Bool:
+      out += value.Data.Ints[0] != 0 ? "true" : "false";
+      return;
+    case SocketType::Int:
+      out += std::to_string(value.Data.Ints[0]);
+      return;
+    case SocketType::Float:
+      return WriteFloat(out, value.Data.Floats[0]);
+    default:
+      break;
+  }
+  out += '[';
+  for (uint32_t i = 0; i < GetComponentCount(value.Type); i++) {
+    if (i > 0) out += ", ";
+    WriteFloat(out, value.Data.Floats[i]);
+  }
+  out += ']';
+}
+
+template <typename Number>
+bool ToNumber(const JsonValue& value, Number& number)
+{
+  if (value.Kind != JsonKind::Number) return false;
+  const char* end = value.String.data() + value.String.size();
+  auto result = std::from_chars(value.String.data(), end, number);
+  return result.ec == std::errc() && result.ptr == end;
+}
+
+bool ToFloat(const JsonValue& value, float& number)
+{
+  if (value.Kind == JsonKind::String) {
+    if (value.String == "nan") number = NAN;
+    else if (value.String == "inf") number = INFINITY;
+    else if (value.String == "-inf") number = -INFINITY;
+    else return false;
+    return true;
+  }
+  return ToNumber(value, number);
+}
+
+bool ToUUID(const JsonValue* value, uint64_t& uuid)
+{
+  if (!value || value->Kind != JsonKind::String) return false;
+  const char* end = value->String.data() + value->String.size();
+  auto result = std::from_chars(value->String.data(), end, uuid);
+  return result.ec == std::errc() && result.ptr == end;
+}
+
+bool ToString(const JsonValue* value, std::string& string)
+{
+  if (!value || value->Kind != JsonKind::String) return false;
+  string = value->String;
+  return true;
+}
+
+bool ToSocketType(const JsonValue* value, SocketType& type)
+{
+  if (!value || value->Kind != JsonKind::String) return false;
+  for (uint8_t i = 0; i <= (uint8_t)SocketType::Image; i++) {
+    if (value->String == GetSocketTypeName((SocketType)i)) {
+      type = (SocketType)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ToSocketValue(const JsonValue* json, SocketType type, SocketValue& value)
+{
+  if (!json) return false;
+  value = SocketValue(type, SocketData {});
+  switch (type) {
+    case SocketType::Bool:
+      value.Data.Ints[0] = json->Bool;
+      return json->Kind == JsonKind::Bool;
+    case SocketType::Int:
+      return ToNumber(*json, value.Data.Ints[0]);
+    case SocketType::Float:
+      return ToFloat(*json, value.Data.Floats[0]);
+    default:
+      break;
+  }
+  if (json->Kind != JsonKind::Array || json->Array.size() != GetComponentCount(type)) return false;
+  for (uint32_t i = 0; i < json->Array.size(); i++) {
+    if (!ToFloat(json->Array[i], value.Data.Floats[i])) return false;
+  }
+  return true;
+}
+
+bool ImportNode(const JsonValue& json, Node& node, std::string& error)
+{
+  auto fail = [&](std::string message) {
+    error = std::move(message);
+    return false;
+  };
+  uint64_t uuid;
+  if (!ToUUID(json.Find("uuid"), uuid)) return fail("Node without a valid \"uuid\"");
+  node.UUID = uuid;
+  const std::string name = "Node " + std::to_string(uuid);
+  if (!ToString(json.Find("label"), node.Label)) return fail(name + " has no \"label\"");
+  if (!ToString(json.Find("type"), node.Type)) return fail(name + " has no \"type\"");
+
+  const JsonValue* sockets = json.Find("sockets");
+  if (!sockets || sockets->Kind != JsonKind::Array) return fail(name + " has no \"sockets\"");
+  for (const JsonValue& socket : sockets->Array) {
+    const std::string socketName = name + " socket " + std::to_string(node.GetSockets().size());
+    uint64_t socketUUID;
+    std::string label;
+    SocketType type;
+    SocketValue value;
+    if (!ToUUID(socket.Find("uuid"), socketUUID)) return fail(socketName + " has no valid \"uuid\"");
+    if (!ToString(socket.Find("label"), label)) return fail(socketName + " has no \"label\"");
+    if (!ToSocketType(socket.Find("type"), type)) return fail(socketName + " has no valid \"type\"");
+    if (!ToSocketValue(socket.Find("value"), type, value)) {
+      return fail(socketName + " has no valid \"value\" for its type");
+    }
+    node.GetSockets().emplace_back(std::move(label), value).UUID = socketUUID;
+  }
+  return true;
+}
+
+// "nodes" and "links" of tree, every line starts with indent
+void WriteNodes(std::string& out, const NodesTree& tree, const std::string& indent)
+{
+  // Same order as .txg files, so exports of the same tree stay stable
+  const std::vector<NodeHandle> order = tree.GetTopologicalOrder();
+  out += indent + "\"nodes\": [";
+  for (size_t i = 0; i < order.size(); i++) {
+    const NodeHandle handle = order[i];
+    out += (i > 0 ? ",\n" : "\n") + indent + "  {\n" + indent + "    \"uuid\": \"";
+    out += std::to_string(tree.GetUUID(handle)) + "\", \"label\": ";
+    WriteJsonString(out, tree.GetLabel(handle));
+    out += ", \"type\": ";
+    WriteJsonString(out, tree.GetType(handle));
+    out += ",\n" + indent + "    \"sockets\": [";
+    for (uint32_t socket = 0; socket < tree.GetSocketCount(handle); socket++) {
+      out += (socket > 0 ? ",\n" : "\n") + indent + "      { \"uuid\": \"";
+      out += std::to_string(tree.GetSocketUUID(handle, socket)) + "\", \"label\": ";
+      WriteJsonString(out, tree.GetSocketLabel(handle, socket));
+      const SocketValue value = tree.GetSocketValue(handle, socket);
+      out += std::string(", \"type\": \"") + GetSocketTypeName(value.Type) + "\", \"value\": ";
+      WriteValue(out, value);
+      out += " }";
+    }
+    out += tree.GetSocketCount(handle) > 0 ? "\n" + indent + "    ]\n" + indent + "  }" : "]\n" + indent + "  }";
+  }
+  out += order.empty() ? "],\n" + indent + "\"links\": [" : "\n" + indent + "],\n" + indent + "\"links\": [";
+
+  bool first = true;
+  for (NodeHandle handle : order) {
+    for (LinkHandle link : tree.GetOutgoingLinks(handle)) {
+      const SocketHandle target = tree.GetLinkTarget(link);
+      out += (first ? "\n" : ",\n") + indent + "  { \"from\": \"";
+      out += std::to_string(tree.GetUUID(handle)) + "\", \"to\": \"" + std::to_string(tree.GetUUID(target.Node)) +
+             "\", \"socket\": " + std::to_string(target.Socket) + " }";
+      first = false;
+    }
+  }
+  out += first ? "]" : "\n" + indent + "]";
+}
+
+// Adds the "nodes" and "links" of json to tree
+bool ImportNodes(const JsonValue& json, NodesTree& tree, std::string& error)
+{
+  auto fail = [&](std::string message) {
+    error = std::move(message);
+    return false;
+  };
+  const JsonValue* nodes = json.Find("nodes");
+  const JsonValue* links = json.Find("links");
+  if (!nodes || nodes->Kind != JsonKind::Array) return fail("Graph has no \"nodes\"");
+  if (!links || links->Kind != JsonKind::Array) return fail("Graph has no \"links\"");
+
+  for (const JsonValue& nodeJson : nodes->Array) {
+    Node node("", "", {}, Frameio::UUID(0));
+    if (!ImportNode(nodeJson, node, error)) return false;
+    if (!tree.FindNode(node.UUID).IsNull()) return fail("Duplicate node " + std::to_string(node.UUID));
+    tree.AddNode(node);
+  }
+  for (const JsonValue& linkJson : links->Array) {
+    uint64_t from, to;
+    uint32_t socket;
+    const JsonValue* socketValue = linkJson.Find("socket");
+    if (!ToUUID(linkJson.Find("from"), from) || !ToUUID(linkJson.Find("to"), to) || !socketValue ||
+        !ToNumber(*socketValue, socket)) {
+      return fail("Link needs \"from\", \"to\" and \"socket\"");
+    }
+    const NodeHandle fromNode = tree.FindNode(from), toNode = tree.FindNode(to);
+    const std::string name = "Link from " + std::to_string(from) + " to " + std::to_string(to);
+    if (fromNode.IsNull() || toNode.IsNull()) return fail(name + " has an unknown endpoint");
+    if (socket >= tree.GetSocketCount(toNode)) return fail(name + " has an unknown socket");
+    if (tree.AddLink(fromNode, { toNode, socket }).IsNull()) return fail(name + " closes a cycle");
+  }
+  return true;
+}
+
+bool ImportGroup(const JsonValue& json, Frameio::Ref<const NodeGroup>& group, std::string& error)
+{
+  auto fail = [&](std::string message) {
+    error = std::move(message);
+    return false;
+  };
+  std::string name;
+  uint64_t output;
+  if (!ToString(json.Find("name"), name)) return fail("Group without a \"name\"");
+  if (!ToUUID(json.Find("output"), output)) return fail("Group " + name + " has no valid \"output\"");
+
+  const JsonValue* parametersJson = json.Find("parameters");
+  if (!parametersJson || parametersJson->Kind != JsonKind::Array) {
+    return fail("Group " + name + " has no \"parameters\"");
+  }
+  std::vector<GroupParameter> parameters;
+  for (const JsonValue& parameterJson : parametersJson->Array) {
+    const std::string parameterName = "Group " + name + " parameter " + std::to_string(parameters.size());
+    GroupParameter& parameter = parameters.emplace_back();
+    SocketType type;
+    if (!ToString(parameterJson.Find("label"), parameter.Label)) return fail(parameterName + " has no \"label\"");
+    if (!ToSocketType(parameterJson.Find("type"), type)) return fail(parameterName + " has no valid \"type\"");
+    if (!ToSocketValue(parameterJson.Find("value"), type, parameter.Default)) {
+      return fail(parameterName + " has no valid \"value\" for its type");
+    }
+    const JsonValue* targets = parameterJson.Find("targets");
+    if (!targets || targets->Kind != JsonKind::Array) return fail(parameterName + " has no \"targets\"");
+    for (const JsonValue& targetJson : targets->Array) {
+      uint64_t node;
+      GroupTarget& target = parameter.Targets.emplace_back();
+      const JsonValue* socket = targetJson.Find("socket");
+      if (!ToUUID(targetJson.Find("node"), node) || !socket || !ToNumber(*socket, target.Socket)) {
+        return fail(parameterName + " has a target without \"node\" and \"socket\"");
+      }
+      target.Node = node;
+    }
+  }
+
+  NodesTree body(name);
+  if (!ImportNodes(json, body, error)) return fail("Group " + name + ": " + error);
+  group = NodeGroup::Create(name, std::move(body), output, std::move(parameters), error);
+  return group != nullptr;
+}
+
+} // namespace
+
+std::string ExportGraphJson(const NodesTree& tree)
+{
+  std::string out = "{\n  \"format\": ";
+  WriteJsonString(out, s_Format);
+  out += ",\n  \"version\": " + std::to_string(s_Version) + ",\n  \"label\": ";
+  WriteJsonString(out, tree.GetLabel());
+  out += ",\n";
+  WriteNodes(out, tree, "  ");
+
+  // Left out of trees without groups, which older readers load as well
+  const std::vector<Frameio::Ref<const NodeGroup>> groups = tree.GetGroups();
+  if (!groups.empty()) {
+    out += ",\n  \"groups\": [";
+    for (size_t i = 0; i < groups.size(); i++) {
+      const NodeGroup& group = *groups[i];
+      out += i > 0 ? ",\n    {\n      \"name\": " : "\n    {\n      \"name\": ";
+      WriteJsonString(out, group.GetName());
+      out += ", \"output\": \"" + std::to_string(group.GetOutput()) + "\",\n      \"parameters\": [";
+      const std::vector<GroupParameter>& parameters = group.GetParameters();
+      for (size_t parameter = 0; parameter < parameters.size(); parameter++) {
+        out += parameter > 0 ? ",\n        { \"label\": " : "\n        { \"label\": ";
+        WriteJsonString(out, parameters[parameter].Label);
+        out += std::string(", \"type\": \"") + GetSocketTypeName(parameters[parameter].Default.Type) +
+               "\", \"value\": ";
+        WriteValue(out, parameters[parameter].Default);
+        out += ", \"targets\": [";
+        for (size_t target = 0; target < parameters[parameter].Targets.size(); target++) {
+          const GroupTarget& socket = parameters[parameter].Targets[target];
+          out += target > 0 ? ", { \"node\": \"" : " { \"node\": \"";
+          out += std::to_string(socket.Node) + "\", \"socket\": " + std::to_string(socket.Socket) + " }";
+        }
+        out += parameters[parameter].Targets.empty() ? "] }" : " ] }";
+      }
+      out += parameters.empty() ? "],\n" : "\n      ],\n";
+      WriteNodes(out, group.GetBody(), "      ");
+      out += "\n    }";
+    }
+    out += "\n  ]";
+  }
+  out += "\n}\n";
+  return out;
+}
+
+bool ImportGraphJson(std::string_view json, NodesTree& tree, std::string& error)
+{
+  auto fail = [&](std::string message) {
+    error = std::move(message);
+    return false;
+  };
+  JsonValue root;
+  if (std::string parseError; !ParseJson(json, root, parseError)) return fail(parseError);
+
+  const JsonValue* format = root.Find("format");
+  if (!format || format->String != s_Format) return fail("Not a texturia graph");
+  int32_t version = 0;
+  const JsonValue* versionValue = root.Find("version");
+  if (!versionValue || !ToNumber(*versionValue, version) || version != s_Version) {
+    return fail("Unsupported graph version, expected " + std::to_string(s_Version));
+  }
+  std::string label;
+  if (!ToString(root.Find("label"), label)) return fail("Graph has no \"label\"");
+
+  // Build into a scratch tree, so tree is left untouched on errors
+  NodesTree result(label);
+  if (const JsonValue* groups = root.Find("groups")) {
+    if (groups->Kind != JsonKind::Array) return fail("\"groups\" is not an array");
+    for (const JsonValue& groupJson : groups->Array) {
+      Frameio::Ref<const NodeGroup> group;
+      if (!ImportGroup(groupJson, group, error)) return false;
+      if (result.FindGroup(group->GetName())) return fail("Duplicate group " + group->GetName());
+      result.SetGroup(std::move(group));
+    }
+  }
+  if (!ImportNodes(root, result, error)) return false;
+
+  tree = std::move(result);
+  return true;
+}
+
+} // namespace Texturia
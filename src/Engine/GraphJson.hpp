@@ -0,0 +1,45 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Nodes.hpp"
+
+#include <string_view>
+
+namespace Texturia {
+
+// Text form of graph files, for diffs and reviews. Holds the same content as a .txg file, with one socket and one link
+// per line, UUIDs as strings and floats with enough digits to survive a round trip:
+//   {
+//     "format": "texturia-graph",
+//     "version": 1,
+//     "label": "Default Node Tree",
+//     "nodes": [
+//       {
+//         "uuid": "42", "label": "Noise", "type": "Gradient Noise",
+//         "sockets": [
+//           { "uuid": "43", "label": "Scale", "type": "Float", "value": 8 }
+//         ]
+//       }
+//     ],
+//     "links": [
+//       { "from": "42", "to": "44", "socket": 0 }
+//     ],
+//     "groups": [
+//       {
+//         "name": "Bricks", "output": "50",
+//         "parameters": [
+//           { "label": "Scale", "type": "Float", "value": 8, "targets": [ { "node": "51", "socket": 1 } ] }
+//         ],
+//         "nodes": [...],
+//         "links": [...]
+//       }
+//     ]
+//   }
+// Trees without groups leave out "groups".
+std::string ExportGraphJson(const NodesTree& tree);
+
+// Replaces the contents of tree. Returns false and sets error if the JSON is malformed or describes an invalid graph.
+bool ImportGraphJson(std::string_view json, NodesTree& tree, std::string& error);
+
+} // namespace Texturia
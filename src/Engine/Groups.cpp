@@ -0,0 +1,77 @@
+#include "Engine/Groups.hpp"
+
+#include <mutex>
+
+namespace Texturia {
+
+namespace {
+
+// Every edit of a group creates a new one, the cache starts over once it holds this many
+constexpr size_t s_CacheLimit = 256;
+
+std::mutex s_CacheMutex;
+std::unordered_map<uint64_t, Frameio::Ref<const CompiledGroup>> s_Cache;
+
+} // namespace
+
+Frameio::Ref<const CompiledGroup> CompileGroup(const NodeGroup& group)
+{
+  {
+    std::lock_guard lock(s_CacheMutex);
+    if (auto found = s_Cache.find(group.GetHash()); found != s_Cache.end()) return found->second;
+  }
+
+  auto compiled = std::make_shared<CompiledGroup>();
+  compiled->Body = EvaluationPlan::Build(group.GetBody(), group.GetOutput());
+  const std::vector<EvaluationStep>& steps = compiled->Body.GetSteps();
+  if (compiled->Body.IsValid()) {
+    // Bodies have no groups, so every step is a node of the body
+    std::unordered_map<Frameio::UUID, uint32_t> stepIndices;
+    for (uint32_t i = 0; i < steps.size(); i++) {
+      stepIndices.emplace(steps[i].UUID, i);
+      compiled->Parameters.emplace_back(steps[i].InputSteps.size(), -1);
+    }
+    const std::vector<GroupParameter>& parameters = group.GetParameters();
+    for (uint32_t parameter = 0; parameter < parameters.size(); parameter++) {
+      for (const GroupTarget& target : parameters[parameter].Targets) {
+        // Targets the output does not need are not part of the body
+        auto step = stepIndices.find(target.Node);
+        if (step != stepIndices.end()) compiled->Parameters[step->second][target.Socket] = (int32_t)parameter;
+      }
+    }
+
+    compiled->Varying.resize(steps.size());
+    compiled->Keyed.resize(steps.size());
+    for (uint32_t i = 0; i < steps.size(); i++) {
+      bool keyed = steps[i].Kernel->KeyedByNode, varying = false;
+      for (uint32_t socket = 0; socket < steps[i].InputSteps.size(); socket++) {
+        const int32_t input = steps[i].InputSteps[socket];
+        if (compiled->Parameters[i][socket] >= 0) {
+          varying = true;
+        } else if (input >= 0) {
+          keyed |= compiled->Keyed[input];
+          varying |= compiled->Varying[input];
+        }
+      }
+      compiled->Keyed[i] = keyed;
+      compiled->Varying[i] = varying || keyed;
+    }
+
+    // Steps come after their inputs, so walking back from the output reaches every consumer before its inputs
+    compiled->Needed.resize(steps.size(), false);
+    compiled->Needed.back() = true;
+    for (uint32_t i = (uint32_t)steps.size(); i-- > 0;) {
+      if (!compiled->Needed[i]) continue;
+      for (uint32_t socket = 0; socket < steps[i].InputSteps.size(); socket++) {
+        const int32_t input = steps[i].InputSteps[socket];
+        if (input >= 0 && compiled->Parameters[i][socket] < 0) compiled->Needed[input] = true;
+      }
+    }
+  }
+
+  std::lock_guard lock(s_CacheMutex);
+  if (s_Cache.size() >= s_CacheLimit) s_Cache.clear();
+  return s_Cache.try_emplace(group.GetHash(), std::move(compiled)).first->second;
+}
+
+} // namespace Texturia
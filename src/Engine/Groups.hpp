@@ -0,0 +1,30 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Evaluator.hpp"
+#include "Nodes.hpp"
+
+namespace Texturia {
+
+// The body of a group turned into steps, which EvaluationPlan::Build copies for every node of the group instead of
+// walking the body again
+struct CompiledGroup {
+  // Steps of the body that its output needs, invalid if the body can not be evaluated
+  EvaluationPlan Body;
+  // Per step and socket the parameter that replaces it, -1 for sockets that keep their value or link of the body
+  std::vector<std::vector<int32_t>> Parameters;
+  // Whether the step reads a parameter or is KeyedByNode, itself or through its inputs. The other steps compute the
+  // same for every node of the group, so all of them share one.
+  std::vector<bool> Varying;
+  // Whether the step is KeyedByNode, itself or through its inputs in the body
+  std::vector<bool> Keyed;
+  // Steps that only feed sockets replaced by parameters are left out of the nodes of the group
+  std::vector<bool> Needed;
+};
+
+// Compiles every group only once, later calls with a group of the same hash return the first result. Can be called
+// from any thread.
+Frameio::Ref<const CompiledGroup> CompileGroup(const NodeGroup& group);
+
+} // namespace Texturia
@@ -0,0 +1,58 @@
+#include "Engine/Image.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <cstring>
+
+namespace Texturia {
+
+Image::Image(const Rect& region)
+{
+  Reset(region);
+  std::memset(m_Data.get(), 0, GetSizeInBytes());
+}
+
+void Image::Reset(const Rect& region, size_t capacity)
+{
+  FR_ASSERT(!region.IsEmpty(), "Images must not be empty!");
+
+  const uint32_t floatsPerLine = Alignment / sizeof(float);
+  m_Region = region;
+  m_Stride = (region.Width + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+
+  const size_t count = GetFloatCount(region);
+  if (count > m_Capacity || !m_Data) {
+    m_Capacity = std::max(count, capacity);
+    m_Data.reset(new (std::align_val_t(Alignment)) float[m_Capacity]);
+  }
+}
+
+size_t Image::GetFloatCount(const Rect& region)
+{
+  const uint32_t floatsPerLine = Alignment / sizeof(float);
+  return (size_t)((region.Width + floatsPerLine - 1) / floatsPerLine * floatsPerLine) * region.Height * Channels;
+}
+
+Image Image::Clone() const
+{
+  if (IsEmpty()) return Image();
+
+  Image clone(m_Region);
+  std::memcpy(clone.m_Data.get(), m_Data.get(), GetSizeInBytes());
+  return clone;
+}
+
+std::vector<Rect> SplitIntoTiles(const Rect& bounds, uint32_t tileSize)
+{
+  FR_ASSERT(tileSize > 0, "Tile size must not be zero!");
+
+  std::vector<Rect> tiles;
+  for (int32_t y = bounds.Y; y < bounds.Bottom(); y += tileSize) {
+    for (int32_t x = bounds.X; x < bounds.Right(); x += tileSize) {
+      tiles.push_back(Rect{ x, y, (int32_t)tileSize, (int32_t)tileSize }.Intersect(bounds));
+    }
+  }
+  return tiles;
+}
+
+} // namespace Texturia
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+namespace Texturia {
+
+struct Pixel {
+  float R = 0.0f, G = 0.0f, B = 0.0f, A = 1.0f;
+
+  inline float& operator[](int channel) { return (&R)[channel]; }
+  inline float operator[](int channel) const { return (&R)[channel]; }
+};
+
+struct Rect {
+  int32_t X = 0, Y = 0;
+  int32_t Width = 0, Height = 0;
+
+  inline int32_t Right() const { return X + Width; }
+  inline int32_t Bottom() const { return Y + Height; }
+  inline bool IsEmpty() const { return Width <= 0 || Height <= 0; }
+  inline uint64_t Area() const { return IsEmpty() ? 0 : (uint64_t)Width * (uint64_t)Height; }
+
+  inline Rect Expand(int32_t radius) const
+  {
+    return { X - radius, Y - radius, Width + 2 * radius, Height + 2 * radius };
+  }
+
+  inline Rect Intersect(const Rect& other) const
+  {
+    int32_t x = std::max(X, other.X), y = std::max(Y, other.Y);
+    int32_t right = std::min(Right(), other.Right()), bottom = std::min(Bottom(), other.Bottom());
+    return { x, y, std::max(0, right - x), std::max(0, bottom - y) };
+  }
+
+  // Smallest rect containing both, empty rects are ignored
+  inline Rect Union(const Rect& other) const
+  {
+    if (IsEmpty()) return other;
+    if (other.IsEmpty()) return *this;
+    int32_t x = std::min(X, other.X), y = std::min(Y, other.Y);
+    return { x, y, std::max(Right(), other.Right()) - x, std::max(Bottom(), other.Bottom()) - y };
+  }
+
+  inline bool Contains(const Rect& other) const
+  {
+    return other.X >= X && other.Y >= Y && other.Right() <= Right() && other.Bottom() <= Bottom();
+  }
+
+  inline bool operator==(const Rect& other) const = default;
+};
+
+// Float RGBA image stored as four planes, one per channel. Every row starts on a 64 byte boundary, so SIMD loops over
+// a row of one channel use aligned loads and never straddle cache lines at the start.
+// Coordinates are absolute, (0, 0) is the top left pixel of the whole bake, an image may cover just a region of it.
+class Image {
+public:
+  static constexpr uint32_t Channels = 4;
+  static constexpr uint32_t Alignment = 64;
+
+  Image() = default;
+  Image(uint32_t width, uint32_t height) : Image(Rect{ 0, 0, (int32_t)width, (int32_t)height }) {}
+  explicit Image(const Rect& region);
+
+  Image(Image&&) = default;
+  Image& operator=(Image&&) = default;
+  // Images are large, copies have to be explicit
+  Image Clone() const;
+  // Moves the image to region and leaves its contents undefined. Only allocates if region needs more memory than the
+  // image had so far, for scratch images that are reused for every block of a tile. A new allocation holds at least
+  // capacity floats.
+  void Reset(const Rect& region, size_t capacity = 0);
+  // Floats the image can hold without reallocating
+  inline size_t GetCapacity() const { return m_Data ? m_Capacity : 0; }
+  // Floats a region needs
+  static size_t GetFloatCount(const Rect& region);
+
+  inline uint32_t GetWidth() const { return (uint32_t)m_Region.Width; }
+  inline uint32_t GetHeight() const { return (uint32_t)m_Region.Height; }
+  inline const Rect& GetRegion() const { return m_Region; }
+  inline bool IsEmpty() const { return !m_Data; }
+  // Distance between two rows in floats
+  inline uint32_t GetStride() const { return m_Stride; }
+  inline size_t GetSizeInBytes() const { return (size_t)m_Stride * m_Region.Height * Channels * sizeof(float); }
+
+  // Pointer to the pixel (x, y) of one channel, the following pixels of the row come right after it
+  inline float* GetPointer(uint32_t channel, int32_t x, int32_t y)
+  {
+    return m_Data.get() + ((size_t)channel * m_Region.Height + (y - m_Region.Y)) * m_Stride + (x - m_Region.X);
+  }
+  inline const float* GetPointer(uint32_t channel, int32_t x, int32_t y) const
+  {
+    return m_Data.get() + ((size_t)channel * m_Region.Height + (y - m_Region.Y)) * m_Stride + (x - m_Region.X);
+  }
+
+  inline Pixel GetPixel(int32_t x, int32_t y) const
+  {
+    return { *GetPointer(0, x, y), *GetPointer(1, x, y), *GetPointer(2, x, y), *GetPointer(3, x, y) };
+  }
+  inline void SetPixel(int32_t x, int32_t y, const Pixel& pixel)
+  {
+    for (uint32_t channel = 0; channel < Channels; channel++) *GetPointer(channel, x, y) = pixel[channel];
+  }
+
+  // Reads with clamp-to-edge addressing, so neighbourhood kernels never need bounds checks
+  inline Pixel Sample(int32_t x, int32_t y) const
+  {
+    x = std::clamp(x, m_Region.X, m_Region.Right() - 1);
+    y = std::clamp(y, m_Region.Y, m_Region.Bottom() - 1);
+    return GetPixel(x, y);
+  }
+
+private:
+  struct AlignedDelete {
+    void operator()(float* data) const { ::operator delete[](data, std::align_val_t(Alignment)); }
+  };
+
+  Rect m_Region;
+  uint32_t m_Stride = 0;
+  // Allocated floats, at least m_Stride * m_Region.Height * Channels
+  size_t m_Capacity = 0;
+  std::unique_ptr<float[], AlignedDelete> m_Data;
+};
+
+// Splits bounds into tiles of tileSize x tileSize (smaller at the right and bottom edges), in row major order.
+std::vector<Rect> SplitIntoTiles(const Rect& bounds, uint32_t tileSize);
+
+} // namespace Texturia
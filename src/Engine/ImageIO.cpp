@@ -0,0 +1,287 @@
+#include "Engine/ImageIO.hpp"
+
+#include "Engine/ImageReader.hpp"
+#include "Engine/ImageWriter.hpp"
+#include "Engine/MappedFile.hpp"
+#include "Hash.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace Texturia {
+
+namespace {
+
+// Four independent lanes over 8 byte words, so hashing keeps up with reading the file from the page cache
+uint64_t HashContents(std::span<const std::byte> data)
+{
+  uint64_t lanes[4] = { 1, 2, 3, 4 };
+  size_t offset = 0;
+  for (; offset + 32 <= data.size(); offset += 32) {
+    for (uint32_t lane = 0; lane < 4; lane++) {
+      uint64_t word;
+      std::memcpy(&word, data.data() + offset + lane * 8, 8);
+      lanes[lane] = HashMix(lanes[lane] ^ word);
+    }
+  }
+  uint64_t hash = HashBytes((const unsigned char*)data.data() + offset, data.size() - offset, data.size());
+  for (uint64_t lane : lanes) hash = HashCombine(hash, lane);
+  return hash;
+}
+
+std::mutex s_BitmapMutex;
+std::vector<Frameio::Ref<const DecodedImage>> s_Bitmaps;
+
+} // namespace
+
+uint64_t DecodedImage::GetSizeInBytes() const
+{
+  uint64_t size = 0;
+  for (const Frameio::Ref<const Image>& level : Levels) size += level->GetSizeInBytes();
+  return size;
+}
+
+void GenerateMipmaps(DecodedImage& image)
+{
+  FR_ASSERT(!image.Levels.empty(), "There is no image to generate mipmaps of!");
+  image.Levels.resize(1);
+  while (image.Levels.back()->GetWidth() > 1 || image.Levels.back()->GetHeight() > 1) {
+    const Image& source = *image.Levels.back();
+    const uint32_t width = (source.GetWidth() + 1) / 2, height = (source.GetHeight() + 1) / 2;
+    const uint32_t lastX = source.GetWidth() - 1, lastY = source.GetHeight() - 1;
+    Frameio::Ref<Image> level = std::make_shared<Image>(width, height);
+    for (uint32_t c = 0; c < Image::Channels; c++) {
+      for (uint32_t y = 0; y < height; y++) {
+        const float* top = source.GetPointer(c, 0, std::min(2 * y, lastY));
+        const float* bottom = source.GetPointer(c, 0, std::min(2 * y + 1, lastY));
+        float* out = level->GetPointer(c, 0, y);
+        for (uint32_t x = 0; x < width; x++) {
+          const uint32_t left = 2 * x, right = std::min(2 * x + 1, lastX);
+          out[x] = ((top[left] + top[right]) + (bottom[left] + bottom[right])) * 0.25f;
+        }
+      }
+    }
+    image.Levels.push_back(std::move(level));
+  }
+}
+
+bool ImageTask::IsDone() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Done;
+}
+
+void ImageTask::Wait() const
+{
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  m_Finished.wait(lock, [this] { return m_Done; });
+}
+
+Frameio::Ref<const DecodedImage> ImageTask::GetImage() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Image;
+}
+
+std::string ImageTask::GetError() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Error;
+}
+
+void ImageTask::Finish(Frameio::Ref<const DecodedImage> image, std::string error)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Image = std::move(image);
+  m_Error = std::move(error);
+  m_Done = true;
+  m_Finished.notify_all();
+}
+
+ImageIO::ImageIO(uint32_t threadCount, uint64_t budget) : m_Budget(budget), m_Pool(threadCount) {}
+
+ImageIO::~ImageIO()
+{
+  Wait();
+}
+
+Frameio::Ref<ImageTask> ImageIO::Load(const std::string& path, bool mipmaps)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  Frameio::Ref<ImageTask>& loading = m_Loading[path + (mipmaps ? "|mipmaps" : "")];
+  if (loading) return loading;
+
+  loading = std::make_shared<ImageTask>(path);
+  m_Pending++;
+  m_Pool.Submit({ RunLoad, new Job{ this, loading, nullptr, mipmaps }, 0 });
+  return loading;
+}
+
+Frameio::Ref<ImageTask> ImageIO::Save(Frameio::Ref<const Image> image, const std::string& path)
+{
+  FR_ASSERT(image, "There is no image to save!");
+  Frameio::Ref<ImageTask> task = std::make_shared<ImageTask>(path);
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Pending++;
+  m_Pool.Submit({ RunSave, new Job{ this, task, std::move(image), false }, 0 });
+  return task;
+}
+
+void ImageIO::Wait()
+{
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  m_Idle.wait(lock, [this] { return m_Pending == 0; });
+}
+
+void ImageIO::RunLoad(void* data, uint64_t)
+{
+  std::unique_ptr<Job> job((Job*)data);
+  ImageIO& owner = *job->Owner;
+  ImageTask& task = *job->Task;
+
+  MappedFile file;
+  if (!file.Open(task.GetPath())) {
+    owner.Finish(*job, nullptr, "Could not open " + task.GetPath());
+    return;
+  }
+
+  const uint64_t key = HashCombine(HashContents(file.GetData()), job->Mipmaps);
+  Frameio::Ref<const DecodedImage> cached = owner.FindCached(key);
+  if (cached) {
+    owner.Finish(*job, std::move(cached), "");
+    return;
+  }
+
+  Image image;
+  std::string error;
+  if (!DecodeImage(file.GetData(), image, error)) {
+    owner.Finish(*job, nullptr, task.GetPath() + ": " + error);
+    return;
+  }
+  file.Close();
+
+  Frameio::Ref<DecodedImage> decoded = std::make_shared<DecodedImage>();
+  decoded->Hash = key;
+  decoded->Levels.push_back(std::make_shared<const Image>(std::move(image)));
+  if (job->Mipmaps) GenerateMipmaps(*decoded);
+  owner.InsertCached(key, decoded);
+  owner.Finish(*job, std::move(decoded), "");
+}
+
+void ImageIO::RunSave(void* data, uint64_t)
+{
+  std::unique_ptr<Job> job((Job*)data);
+  ImageTask& task = *job->Task;
+  const std::string& path = task.GetPath();
+
+  bool written;
+  if (path.ends_with(".tif") || path.ends_with(".tiff")) {
+    written = WriteImage(*job->Source, path);
+  } else {
+    // Encoding takes most of the time and runs without holding the file open
+    std::vector<uint8_t> bytes;
+    const size_t dot = path.rfind('.');
+    written = dot != std::string::npos && EncodeImage(*job->Source, std::string_view(path).substr(dot), bytes);
+    if (written) {
+      std::ofstream file(path, std::ios::binary);
+      file.write((const char*)bytes.data(), bytes.size());
+      written = (bool)file;
+    }
+  }
+  job->Owner->Finish(*job, nullptr, written ? "" : "Could not write " + path);
+}
+
+void ImageIO::Finish(const Job& job, Frameio::Ref<const DecodedImage> image, std::string error)
+{
+  // Loads that start from here on read the file again instead of getting this task
+  if (!job.Source) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Loading.find(job.Task->GetPath() + (job.Mipmaps ? "|mipmaps" : ""));
+    if (it != m_Loading.end() && it->second == job.Task) m_Loading.erase(it);
+  }
+  job.Task->Finish(std::move(image), std::move(error));
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Pending--;
+  // Notified under the lock, so Wait can not return and destroy the condition variable before this is done
+  m_Idle.notify_all();
+}
+
+Frameio::Ref<const DecodedImage> ImageIO::FindCached(uint64_t key)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  auto it = m_Index.find(key);
+  if (it == m_Index.end()) {
+    m_Statistics.Misses++;
+    return nullptr;
+  }
+
+  m_Statistics.Hits++;
+  m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+  return it->second->Image;
+}
+
+void ImageIO::InsertCached(uint64_t key, Frameio::Ref<const DecodedImage> image)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  const uint64_t size = image->GetSizeInBytes();
+  // Two loads of the same contents may both miss, the image of the first one to finish stays
+  if (size > m_Budget || m_Index.contains(key)) return;
+
+  m_Entries.push_front({ key, std::move(image) });
+  m_Index[key] = m_Entries.begin();
+  m_Statistics.Entries++;
+  m_Statistics.ResidentBytes += size;
+  Evict(m_Budget);
+}
+
+void ImageIO::SetBudget(uint64_t budget)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Budget = budget;
+  Evict(budget);
+}
+
+CacheStatistics ImageIO::GetStatistics() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Statistics;
+}
+
+void ImageIO::ClearCache()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Entries.clear();
+  m_Index.clear();
+  m_Statistics.Entries = 0;
+  m_Statistics.ResidentBytes = 0;
+}
+
+void ImageIO::Evict(uint64_t budget)
+{
+  while (m_Statistics.ResidentBytes > budget) {
+    const Entry& entry = m_Entries.back();
+    const uint64_t size = entry.Image->GetSizeInBytes();
+    m_Statistics.ResidentBytes -= size;
+    m_Statistics.EvictedBytes += size;
+    m_Statistics.Evictions++;
+    m_Statistics.Entries--;
+    m_Index.erase(entry.Key);
+    m_Entries.pop_back();
+  }
+}
+
+uint32_t AddBitmap(Frameio::Ref<const DecodedImage> image)
+{
+  std::lock_guard<std::mutex> lock(s_BitmapMutex);
+  s_Bitmaps.push_back(std::move(image));
+  return (uint32_t)s_Bitmaps.size();
+}
+
+Frameio::Ref<const DecodedImage> FindBitmap(uint32_t id)
+{
+  std::lock_guard<std::mutex> lock(s_BitmapMutex);
+  return id >= 1 && id <= s_Bitmaps.size() ? s_Bitmaps[id - 1] : nullptr;
+}
+
+} // namespace Texturia
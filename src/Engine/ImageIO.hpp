@@ -0,0 +1,137 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Image.hpp"
+#include "Engine/ResultCache.hpp"
+#include "Engine/ThreadPool.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+
+namespace Texturia {
+
+// Image read from a file with its mip chain. Levels[0] is the image of the file, every further level halves the size
+// of the one before (rounded up) down to 1x1. Immutable once loaded, so the cache, node kernels and the viewport share
+// it without copies.
+struct DecodedImage {
+  std::vector<Frameio::Ref<const Image>> Levels;
+  // Hash of the file contents
+  uint64_t Hash = 0;
+
+  uint64_t GetSizeInBytes() const;
+  // Levels past the last one return the last one
+  inline const Image& GetLevel(size_t level) const { return *Levels[std::min(level, Levels.size() - 1)]; }
+};
+
+// Appends the mip chain of Levels[0], each level is the 2x2 box filter of the one before with the last row and column
+// repeated for odd sizes
+void GenerateMipmaps(DecodedImage& image);
+
+// Result of a load or save that runs on the workers of ImageIO
+class ImageTask {
+public:
+  explicit ImageTask(std::string path) : m_Path(std::move(path)) {}
+
+  bool IsDone() const;
+  void Wait() const;
+  // Loads only, nullptr until the task is done or if it failed
+  Frameio::Ref<const DecodedImage> GetImage() const;
+  // Empty unless the task failed
+  std::string GetError() const;
+  inline const std::string& GetPath() const { return m_Path; }
+
+private:
+  friend class ImageIO;
+  void Finish(Frameio::Ref<const DecodedImage> image, std::string error);
+
+  const std::string m_Path;
+  mutable std::mutex m_Mutex;
+  mutable std::condition_variable m_Finished;
+  bool m_Done = false;
+  Frameio::Ref<const DecodedImage> m_Image;
+  std::string m_Error;
+};
+
+// Reads and writes image files on a thread pool of its own, so neither the UI nor the bake threads wait for decoding,
+// encoding or the disk. Decoded images are cached by the hash of the file contents and evicted least recently used
+// first once they take up more than the memory budget: a file that is loaded again, under any path, is only read and
+// hashed, not decoded.
+class ImageIO {
+public:
+  static constexpr uint64_t DefaultBudget = 512ull << 20;
+
+  // threadCount 0 uses every hardware thread
+  explicit ImageIO(uint32_t threadCount = 0, uint64_t budget = DefaultBudget);
+  // Waits for every task that is still running
+  ~ImageIO();
+
+  ImageIO(const ImageIO&) = delete;
+  ImageIO& operator=(const ImageIO&) = delete;
+
+  // Decodes the file (see DecodeImage) and with mipmaps its mip chain. Loads of a path that is still being loaded
+  // share the task.
+  Frameio::Ref<ImageTask> Load(const std::string& path, bool mipmaps = true);
+  // Encodes the image in the format of the extension of path (see WriteImage) and writes it. The image is shared, not
+  // copied, and must not change until the task is done.
+  Frameio::Ref<ImageTask> Save(Frameio::Ref<const Image> image, const std::string& path);
+  // Blocks until every load and save submitted so far is done
+  void Wait();
+
+  inline uint32_t GetThreadCount() const { return m_Pool.GetThreadCount(); }
+
+  // Evicts right away when the new budget is smaller
+  void SetBudget(uint64_t budget);
+  CacheStatistics GetStatistics() const;
+  void ClearCache();
+
+private:
+  struct Job {
+    ImageIO* Owner;
+    Frameio::Ref<ImageTask> Task;
+    // Saves only
+    Frameio::Ref<const Image> Source;
+    bool Mipmaps;
+  };
+
+  static void RunLoad(void* job, uint64_t);
+  static void RunSave(void* job, uint64_t);
+  // Completes the task of the job. Called last by every job, the workers do not touch the ImageIO afterwards.
+  void Finish(const Job& job, Frameio::Ref<const DecodedImage> image, std::string error);
+
+  Frameio::Ref<const DecodedImage> FindCached(uint64_t key);
+  void InsertCached(uint64_t key, Frameio::Ref<const DecodedImage> image);
+  // Under m_Mutex
+  void Evict(uint64_t budget);
+
+  struct Entry {
+    uint64_t Key;
+    Frameio::Ref<const DecodedImage> Image;
+  };
+
+  mutable std::mutex m_Mutex;
+  std::condition_variable m_Idle;
+  uint32_t m_Pending = 0;
+  // Loads in flight by path and mipmaps flag
+  std::unordered_map<std::string, Frameio::Ref<ImageTask>> m_Loading;
+
+  uint64_t m_Budget;
+  // Most recently used first
+  std::list<Entry> m_Entries;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> m_Index;
+  CacheStatistics m_Statistics;
+
+  // Last, so its workers are joined before anything they use is destroyed
+  ThreadPool m_Pool;
+};
+
+// Decoded images that nodes read by id (see the Bitmap node). Ids start at 1 and are never reused, so the content hash
+// of a node that names an id always stands for the same image.
+uint32_t AddBitmap(Frameio::Ref<const DecodedImage> image);
+// nullptr for unknown ids
+Frameio::Ref<const DecodedImage> FindBitmap(uint32_t id);
+
+} // namespace Texturia
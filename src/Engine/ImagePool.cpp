@@ -0,0 +1,90 @@
+#include "Engine/ImagePool.hpp"
+
+#include <bit>
+
+namespace Texturia {
+
+Image ImagePool::Acquire(const Rect& region)
+{
+  const uint32_t sizeClass = GetSizeClass(Image::GetFloatCount(region));
+  const size_t bytes = GetClassSize(sizeClass) * sizeof(float);
+
+  Image image;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (sizeClass < m_Free.size() && !m_Free[sizeClass].empty()) {
+      image = std::move(m_Free[sizeClass].back());
+      m_Free[sizeClass].pop_back();
+      m_Statistics.Reuses++;
+    } else {
+      m_Statistics.Allocations++;
+      m_Statistics.ResidentBytes += bytes;
+      m_Statistics.PeakResidentBytes = std::max(m_Statistics.PeakResidentBytes, m_Statistics.ResidentBytes);
+    }
+    m_Statistics.InUseBytes += bytes;
+    m_Statistics.PeakInUseBytes = std::max(m_Statistics.PeakInUseBytes, m_Statistics.InUseBytes);
+  }
+
+  // Allocates outside of the lock, reused images already hold a whole class
+  image.Reset(region, GetClassSize(sizeClass));
+  return image;
+}
+
+void ImagePool::Recycle(Image&& image)
+{
+  if (image.GetCapacity() == 0) return;
+
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  // Largest class the image can hold, which is its own class for images from Acquire
+  uint32_t sizeClass = GetSizeClass(image.GetCapacity());
+  if (GetClassSize(sizeClass) > image.GetCapacity()) sizeClass--;
+  const size_t bytes = GetClassSize(sizeClass) * sizeof(float);
+  m_Statistics.InUseBytes -= std::min<uint64_t>(bytes, m_Statistics.InUseBytes);
+
+  if (m_Free.size() <= sizeClass) m_Free.resize(sizeClass + 1);
+  m_Free[sizeClass].push_back(std::move(image));
+}
+
+void ImagePool::Trim()
+{
+  std::vector<std::vector<Image>> free;
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (uint32_t sizeClass = 0; sizeClass < m_Free.size(); sizeClass++) {
+      m_Statistics.ResidentBytes -= m_Free[sizeClass].size() * GetClassSize(sizeClass) * sizeof(float);
+    }
+    free = std::move(m_Free);
+    m_Free.clear();
+  }
+  // Freed outside of the lock
+}
+
+ImagePoolStatistics ImagePool::GetStatistics() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Statistics;
+}
+
+void ImagePool::ResetPeaks()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Statistics.PeakResidentBytes = m_Statistics.ResidentBytes;
+  m_Statistics.PeakInUseBytes = m_Statistics.InUseBytes;
+}
+
+// Class 4 * e + k holds (4 + k) / 4 * 2^e floats
+uint32_t ImagePool::GetSizeClass(size_t floats)
+{
+  const uint32_t exponent = std::max(2, (int32_t)std::bit_width(floats) - 1);
+  for (uint32_t k = 0; k < 4; k++) {
+    if (GetClassSize(exponent * 4 + k) >= floats) return exponent * 4 + k;
+  }
+  return (exponent + 1) * 4;
+}
+
+size_t ImagePool::GetClassSize(uint32_t sizeClass)
+{
+  return ((size_t)(4 + sizeClass % 4) << (sizeClass / 4)) / 4;
+}
+
+} // namespace Texturia
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Image.hpp"
+
+#include <mutex>
+
+namespace Texturia {
+
+struct ImagePoolStatistics {
+  // Memory the pool allocated and did not free yet, whether it is handed out or waiting to be reused
+  uint64_t ResidentBytes = 0, PeakResidentBytes = 0;
+  // Memory of the images that are handed out right now
+  uint64_t InUseBytes = 0, PeakInUseBytes = 0;
+  uint64_t Allocations = 0, Reuses = 0;
+};
+
+// Recycles the memory of intermediate images, which all die long before the bake is done. Free images are kept in
+// size classes, four per power of two, and an image is only allocated when its class has no free image left. That
+// wastes at most a quarter of an image while regions of slightly different sizes still share memory.
+class ImagePool {
+public:
+  // The contents of the image are undefined
+  Image Acquire(const Rect& region);
+  // Takes back an image from Acquire
+  void Recycle(Image&& image);
+  // Frees every image that is not handed out
+  void Trim();
+
+  ImagePoolStatistics GetStatistics() const;
+  // Peaks start over from the current values, e.g. for the next bake
+  void ResetPeaks();
+
+private:
+  static uint32_t GetSizeClass(size_t floats);
+  static size_t GetClassSize(uint32_t sizeClass);
+
+  mutable std::mutex m_Mutex;
+  std::vector<std::vector<Image>> m_Free;
+  ImagePoolStatistics m_Statistics;
+};
+
+} // namespace Texturia
@@ -0,0 +1,892 @@
+#include "Engine/ImageReader.hpp"
+
+#include "Engine/MappedFile.hpp"
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstring>
+
+namespace Texturia {
+
+namespace {
+
+inline uint32_t ReadBigEndian32(const uint8_t* data)
+{
+  return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3];
+}
+
+inline uint16_t ReadLittleEndian16(const uint8_t* data)
+{
+  return (uint16_t)(data[0] | data[1] << 8);
+}
+
+inline uint32_t ReadLittleEndian32(const uint8_t* data)
+{
+  return (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+inline uint64_t ReadLittleEndian64(const uint8_t* data)
+{
+  return ReadLittleEndian32(data) | (uint64_t)ReadLittleEndian32(data + 4) << 32;
+}
+
+inline float HalfToFloat(uint16_t half)
+{
+  const uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+  uint32_t exponent = (half >> 10) & 0x1F, mantissa = half & 0x3FF;
+  uint32_t bits;
+  if (exponent == 0x1F) {
+    // Infinity and NaN
+    bits = sign | 0x7F800000 | mantissa << 13;
+  } else if (exponent != 0) {
+    bits = sign | (exponent + 112) << 23 | mantissa << 13;
+  } else if (mantissa == 0) {
+    bits = sign;
+  } else {
+    // Subnormal halves are normal floats
+    exponent = 113;
+    while (!(mantissa & 0x400)) {
+      mantissa <<= 1;
+      exponent--;
+    }
+    bits = sign | exponent << 23 | (mantissa & 0x3FF) << 13;
+  }
+  return std::bit_cast<float>(bits);
+}
+
+// Images are limited to what fits an Image and a 32 bit pixel count per plane
+bool CheckSize(uint64_t width, uint64_t height, std::string& error)
+{
+  if (width == 0 || height == 0 || width > (1u << 16) || height > (1u << 16) || width * height > (1ull << 30)) {
+    error = "Unsupported image size " + std::to_string(width) + "x" + std::to_string(height);
+    return false;
+  }
+  return true;
+}
+
+// Decoder of raw deflate streams (RFC 1951), for the zlib data of PNG and EXR files
+class Inflater {
+public:
+  Inflater(std::span<const uint8_t> input, std::vector<uint8_t>& output) : m_Input(input), m_Output(output) {}
+
+  bool Run(std::string& error)
+  {
+    bool final = false;
+    while (!final) {
+      final = GetBits(1);
+      const uint32_t type = GetBits(2);
+      bool valid = false;
+      if (type == 0) valid = CopyStored();
+      else if (type == 1) valid = InflateBlock(GetFixedTables().first, GetFixedTables().second);
+      else if (type == 2) valid = InflateDynamic();
+      if (!valid || m_Position > m_Input.size() + sizeof(m_Bits)) {
+        error = "Damaged deflate stream";
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  static constexpr uint32_t FastBits = 10;
+
+  // Canonical Huffman code. Codes up to FastBits long are looked up in one step, longer ones bit by bit.
+  struct Huffman {
+    // Symbol << 4 | length for every value of the next FastBits bits, 0 where the code is longer
+    std::array<uint16_t, 1 << FastBits> Fast;
+    std::array<uint16_t, 16> Counts;
+    std::array<uint16_t, 320> Symbols;
+
+    bool Build(const uint8_t* lengths, uint32_t count)
+    {
+      Counts.fill(0);
+      Fast.fill(0);
+      for (uint32_t i = 0; i < count; i++) Counts[lengths[i]]++;
+      Counts[0] = 0;
+      // More codes of a length than there is room for is an error, fewer are allowed (e.g. a single distance code)
+      int32_t left = 1;
+      for (uint32_t length = 1; length < 16; length++) {
+        left = left * 2 - Counts[length];
+        if (left < 0) return false;
+      }
+
+      std::array<uint16_t, 16> offsets, codes;
+      offsets[1] = 0;
+      for (uint32_t length = 1; length < 15; length++) offsets[length + 1] = offsets[length] + Counts[length];
+      uint32_t first = 0;
+      for (uint32_t length = 1; length < 16; length++) {
+        codes[length] = (uint16_t)first;
+        first = (first + Counts[length]) << 1;
+      }
+      for (uint32_t symbol = 0; symbol < count; symbol++) {
+        const uint32_t length = lengths[symbol];
+        if (length == 0) continue;
+        Symbols[offsets[length]++] = (uint16_t)symbol;
+        if (length > FastBits) continue;
+        // Deflate sends codes starting with their most significant bit
+        const uint32_t code = codes[length]++;
+        uint32_t reversed = 0;
+        for (uint32_t bit = 0; bit < length; bit++) reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+        for (uint32_t i = reversed; i < (1u << FastBits); i += 1u << length) {
+          Fast[i] = (uint16_t)(symbol << 4 | length);
+        }
+      }
+      return true;
+    }
+  };
+
+  static const std::pair<Huffman, Huffman>& GetFixedTables()
+  {
+    static const std::pair<Huffman, Huffman> s_Tables = [] {
+      std::pair<Huffman, Huffman> tables;
+      uint8_t lengths[288];
+      std::fill_n(lengths, 144, 8);
+      std::fill_n(lengths + 144, 112, 9);
+      std::fill_n(lengths + 256, 24, 7);
+      std::fill_n(lengths + 280, 8, 8);
+      tables.first.Build(lengths, 288);
+      std::fill_n(lengths, 30, 5);
+      tables.second.Build(lengths, 30);
+      return tables;
+    }();
+    return s_Tables;
+  }
+
+  // Past the end of the input the bits are zero, Run notices once more than the bit buffer was read that way
+  inline void Refill()
+  {
+    while (m_Count <= 56) {
+      const uint64_t byte = m_Position < m_Input.size() ? m_Input[m_Position] : 0;
+      m_Position++;
+      m_Bits |= byte << m_Count;
+      m_Count += 8;
+    }
+  }
+
+  inline uint32_t GetBits(uint32_t count)
+  {
+    if (count == 0) return 0;
+    Refill();
+    const uint32_t value = (uint32_t)(m_Bits & ((1ull << count) - 1));
+    m_Bits >>= count;
+    m_Count -= count;
+    return value;
+  }
+
+  // Returns -1 for codes the table does not have
+  inline int32_t Decode(const Huffman& huffman)
+  {
+    Refill();
+    const uint16_t entry = huffman.Fast[m_Bits & ((1u << FastBits) - 1)];
+    if (entry) {
+      m_Bits >>= entry & 15;
+      m_Count -= entry & 15;
+      return entry >> 4;
+    }
+    int32_t code = 0, first = 0, index = 0;
+    for (uint32_t length = 1; length < 16; length++) {
+      code |= GetBits(1);
+      const int32_t count = huffman.Counts[length];
+      if (code - first < count) return huffman.Symbols[index + code - first];
+      index += count;
+      first = (first + count) << 1;
+      code <<= 1;
+    }
+    return -1;
+  }
+
+  bool CopyStored()
+  {
+    // Whole bytes still in the bit buffer go back to the input
+    m_Bits >>= m_Count % 8;
+    m_Count -= m_Count % 8;
+    m_Position -= m_Count / 8;
+    m_Bits = 0;
+    m_Count = 0;
+    if (m_Position + 4 > m_Input.size()) return false;
+    const uint16_t size = ReadLittleEndian16(&m_Input[m_Position]);
+    const uint16_t check = ReadLittleEndian16(&m_Input[m_Position + 2]);
+    m_Position += 4;
+    if ((uint16_t)~size != check || m_Position + size > m_Input.size()) return false;
+    m_Output.insert(m_Output.end(), m_Input.begin() + m_Position, m_Input.begin() + m_Position + size);
+    m_Position += size;
+    return true;
+  }
+
+  bool InflateDynamic()
+  {
+    static constexpr uint8_t s_Order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    const uint32_t literals = GetBits(5) + 257, distances = GetBits(5) + 1, codeLengths = GetBits(4) + 4;
+    if (literals > 286 || distances > 30) return false;
+
+    uint8_t lengths[320] = {};
+    for (uint32_t i = 0; i < codeLengths; i++) lengths[s_Order[i]] = (uint8_t)GetBits(3);
+    Huffman& lengthCode = m_Tables[0];
+    if (!lengthCode.Build(lengths, 19)) return false;
+
+    std::memset(lengths, 0, sizeof(lengths));
+    for (uint32_t i = 0; i < literals + distances;) {
+      const int32_t symbol = Decode(lengthCode);
+      if (symbol < 0) return false;
+      if (symbol < 16) {
+        lengths[i++] = (uint8_t)symbol;
+        continue;
+      }
+      uint32_t repeat;
+      uint8_t value = 0;
+      if (symbol == 16) {
+        if (i == 0) return false;
+        value = lengths[i - 1];
+        repeat = 3 + GetBits(2);
+      } else if (symbol == 17) {
+        repeat = 3 + GetBits(3);
+      } else {
+        repeat = 11 + GetBits(7);
+      }
+      if (i + repeat > literals + distances) return false;
+      std::fill_n(lengths + i, repeat, value);
+      i += repeat;
+    }
+    if (lengths[256] == 0) return false;
+    if (!m_Tables[0].Build(lengths, literals) || !m_Tables[1].Build(lengths + literals, distances)) return false;
+    return InflateBlock(m_Tables[0], m_Tables[1]);
+  }
+
+  bool InflateBlock(const Huffman& literalCode, const Huffman& distanceCode)
+  {
+    static constexpr uint16_t s_LengthBase[29] = { 3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                                   31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static constexpr uint8_t s_LengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                   2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static constexpr uint16_t s_DistanceBase[30] = { 1,   2,   3,   4,   5,   7,    9,    13,   17,   25,
+                                                     33,  49,  65,  97,  129, 193,  257,  385,  513,  769,
+                                                     1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static constexpr uint8_t s_DistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                                     6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    while (true) {
+      const int32_t symbol = Decode(literalCode);
+      if (symbol < 0 || m_Position > m_Input.size() + sizeof(m_Bits)) return false;
+      if (symbol < 256) {
+        m_Output.push_back((uint8_t)symbol);
+        continue;
+      }
+      if (symbol == 256) return true;
+      if (symbol > 285) return false;
+
+      const uint32_t length = s_LengthBase[symbol - 257] + GetBits(s_LengthExtra[symbol - 257]);
+      const int32_t distanceSymbol = Decode(distanceCode);
+      if (distanceSymbol < 0 || distanceSymbol > 29) return false;
+      const uint32_t distance = s_DistanceBase[distanceSymbol] + GetBits(s_DistanceExtra[distanceSymbol]);
+      if (distance > m_Output.size()) return false;
+
+      // Matches may overlap the bytes they append, so they are copied byte by byte
+      size_t from = m_Output.size() - distance;
+      m_Output.resize(m_Output.size() + length);
+      uint8_t* out = m_Output.data();
+      for (size_t to = m_Output.size() - length; to < m_Output.size(); to++) out[to] = out[from++];
+    }
+  }
+
+  std::span<const uint8_t> m_Input;
+  std::vector<uint8_t>& m_Output;
+  size_t m_Position = 0;
+  uint64_t m_Bits = 0;
+  uint32_t m_Count = 0;
+  // Literal and distance codes of the current dynamic block
+  Huffman m_Tables[2];
+};
+
+// Appends the data of a zlib stream (RFC 1950) to output, the checksum is not verified
+bool InflateZlib(std::span<const uint8_t> input, std::vector<uint8_t>& output, std::string& error)
+{
+  if (input.size() < 2 || (input[0] & 0x0F) != 8 || (input[0] << 8 | input[1]) % 31 != 0 || (input[1] & 0x20)) {
+    error = "Unsupported zlib stream";
+    return false;
+  }
+  Inflater inflater(input.subspan(2), output);
+  return inflater.Run(error);
+}
+
+struct PngHeader {
+  uint32_t Width, Height;
+  uint8_t Depth, ColorType, Interlace;
+  uint32_t Channels;
+  // For color type 3, alpha from tRNS
+  std::vector<Pixel> Palette;
+  // Samples with this value are transparent, from tRNS for color types 0 and 2
+  bool HasKey = false;
+  uint16_t Key[3] = {};
+};
+
+// Decodes count unfiltered pixels of a row, every one of them dx pixels right of the one before
+void StorePngRow(const PngHeader& header, const uint8_t* row, uint32_t count, int32_t x, int32_t dx, int32_t y,
+                 Image& image)
+{
+  float* planes[Image::Channels];
+  for (uint32_t c = 0; c < Image::Channels; c++) planes[c] = image.GetPointer(c, x, y);
+
+  // The common case of 8 bit samples without a palette or key
+  if (header.Depth == 8 && header.ColorType != 3 && !header.HasKey) {
+    const uint32_t channels = header.Channels;
+    const bool gray = channels < 3, alpha = channels == 2 || channels == 4;
+    constexpr float scale = 1.0f / 255.0f;
+    for (uint32_t i = 0; i < count; i++) {
+      const uint8_t* sample = row + i * channels;
+      const size_t offset = (size_t)i * dx;
+      planes[0][offset] = sample[0] * scale;
+      planes[1][offset] = sample[gray ? 0 : 1] * scale;
+      planes[2][offset] = sample[gray ? 0 : 2] * scale;
+      planes[3][offset] = alpha ? sample[channels - 1] * scale : 1.0f;
+    }
+    return;
+  }
+
+  const uint32_t depth = header.Depth, maximum = (1u << depth) - 1;
+  auto sample = [&](uint32_t index) -> uint32_t {
+    if (depth == 16) return (uint32_t)row[index * 2] << 8 | row[index * 2 + 1];
+    if (depth == 8) return row[index];
+    const uint32_t bit = index * depth;
+    return (row[bit / 8] >> (8 - depth - bit % 8)) & maximum;
+  };
+  const float scale = 1.0f / maximum;
+  for (uint32_t i = 0; i < count; i++) {
+    const uint32_t first = i * header.Channels;
+    Pixel pixel;
+    switch (header.ColorType) {
+      case 0:
+      case 4: {
+        const uint32_t gray = sample(first);
+        pixel = { gray * scale, gray * scale, gray * scale, 1.0f };
+        if (header.ColorType == 4) pixel.A = sample(first + 1) * scale;
+        else if (header.HasKey && gray == header.Key[0]) pixel.A = 0.0f;
+        break;
+      }
+      case 2:
+      case 6: {
+        const uint32_t r = sample(first), g = sample(first + 1), b = sample(first + 2);
+        pixel = { r * scale, g * scale, b * scale, 1.0f };
+        if (header.ColorType == 6) pixel.A = sample(first + 3) * scale;
+        else if (header.HasKey && r == header.Key[0] && g == header.Key[1] && b == header.Key[2]) pixel.A = 0.0f;
+        break;
+      }
+      case 3: {
+        // Indices past the palette are black
+        const uint32_t index = sample(first);
+        pixel = index < header.Palette.size() ? header.Palette[index] : Pixel{ 0.0f, 0.0f, 0.0f, 1.0f };
+        break;
+      }
+    }
+    for (uint32_t c = 0; c < Image::Channels; c++) planes[c][(size_t)i * dx] = pixel[c];
+  }
+}
+
+inline uint8_t Paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+  const int32_t p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+  return pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+}
+
+// Reverses the filter of every row in place, previous is the unfiltered row above or zeros for the first one
+bool Unfilter(uint8_t* row, const uint8_t* previous, size_t size, uint32_t bytesPerPixel)
+{
+  const uint8_t filter = row[0];
+  uint8_t* data = row + 1;
+  switch (filter) {
+    case 0:
+      return true;
+    case 1:
+      for (size_t i = bytesPerPixel; i < size; i++) data[i] += data[i - bytesPerPixel];
+      return true;
+    case 2:
+      for (size_t i = 0; i < size; i++) data[i] += previous[i];
+      return true;
+    case 3:
+      for (size_t i = 0; i < bytesPerPixel && i < size; i++) data[i] += previous[i] / 2;
+      for (size_t i = bytesPerPixel; i < size; i++) data[i] += (uint8_t)((data[i - bytesPerPixel] + previous[i]) / 2);
+      return true;
+    case 4:
+      for (size_t i = 0; i < bytesPerPixel && i < size; i++) data[i] += previous[i];
+      for (size_t i = bytesPerPixel; i < size; i++) {
+        data[i] += Paeth(data[i - bytesPerPixel], previous[i], previous[i - bytesPerPixel]);
+      }
+      return true;
+  }
+  return false;
+}
+
+bool DecodePNG(std::span<const uint8_t> data, Image& image, std::string& error)
+{
+  PngHeader header = {};
+  std::vector<uint8_t> compressed;
+  bool ended = false;
+  for (size_t offset = 8; !ended;) {
+    if (offset + 12 > data.size()) {
+      error = "PNG file ends early";
+      return false;
+    }
+    const uint32_t size = ReadBigEndian32(&data[offset]);
+    const uint8_t* type = &data[offset + 4];
+    const uint8_t* chunk = &data[offset + 8];
+    if (size > data.size() - offset - 12) {
+      error = "PNG chunk is cut off";
+      return false;
+    }
+    offset += 12 + (size_t)size;
+
+    if (std::memcmp(type, "IHDR", 4) == 0 && size >= 13) {
+      header.Width = ReadBigEndian32(chunk);
+      header.Height = ReadBigEndian32(chunk + 4);
+      header.Depth = chunk[8];
+      header.ColorType = chunk[9];
+      header.Interlace = chunk[12];
+    } else if (std::memcmp(type, "PLTE", 4) == 0) {
+      for (uint32_t i = 0; i + 3 <= size; i += 3) {
+        header.Palette.push_back({ chunk[i] / 255.0f, chunk[i + 1] / 255.0f, chunk[i + 2] / 255.0f, 1.0f });
+      }
+    } else if (std::memcmp(type, "tRNS", 4) == 0) {
+      if (header.ColorType == 3) {
+        for (uint32_t i = 0; i < size && i < header.Palette.size(); i++) header.Palette[i].A = chunk[i] / 255.0f;
+      } else if (size >= 2) {
+        header.HasKey = true;
+        for (uint32_t i = 0; i < 3 && i * 2 + 1 < size; i++) {
+          header.Key[i] = (uint16_t)(chunk[i * 2] << 8 | chunk[i * 2 + 1]);
+        }
+      }
+    } else if (std::memcmp(type, "IDAT", 4) == 0) {
+      compressed.insert(compressed.end(), chunk, chunk + size);
+    } else if (std::memcmp(type, "IEND", 4) == 0) {
+      ended = true;
+    }
+  }
+
+  const uint8_t depth = header.Depth;
+  switch (header.ColorType) {
+    case 0:
+      header.Channels = 1;
+      break;
+    case 2:
+      header.Channels = 3;
+      break;
+    case 3:
+      header.Channels = 1;
+      break;
+    case 4:
+      header.Channels = 2;
+      break;
+    case 6:
+      header.Channels = 4;
+      break;
+  }
+  const bool validDepth = header.ColorType == 0 ? std::has_single_bit(depth) && depth <= 16
+                          : header.ColorType == 3 ? std::has_single_bit(depth) && depth <= 8
+                                                  : depth == 8 || depth == 16;
+  if (header.Channels == 0 || !validDepth || header.Interlace > 1) {
+    error = "Unsupported PNG color type " + std::to_string(header.ColorType) + " with " + std::to_string(depth) +
+            " bits";
+    return false;
+  }
+  if (!CheckSize(header.Width, header.Height, error)) return false;
+
+  // Adam7 passes as start and step in x and y, a single pass covers everything for images that are not interlaced
+  struct Pass {
+    uint32_t X, Y, StepX, StepY;
+  };
+  static constexpr Pass s_Adam7[] = { { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 },
+                                      { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } };
+  static constexpr Pass s_Whole[] = { { 0, 0, 1, 1 } };
+  const std::span<const Pass> passes = header.Interlace ? std::span<const Pass>(s_Adam7) : s_Whole;
+
+  const uint32_t bitsPerPixel = header.Channels * depth, bytesPerPixel = std::max(1u, bitsPerPixel / 8);
+  size_t expected = 0;
+  for (const Pass& pass : passes) {
+    const uint32_t width = (header.Width - pass.X + pass.StepX - 1) / pass.StepX;
+    const uint32_t height = (header.Height - pass.Y + pass.StepY - 1) / pass.StepY;
+    if (width && height) expected += (size_t)height * (1 + ((size_t)width * bitsPerPixel + 7) / 8);
+  }
+  std::vector<uint8_t> raw;
+  raw.reserve(expected);
+  if (!InflateZlib(compressed, raw, error)) return false;
+  if (raw.size() < expected) {
+    error = "PNG image data is too short";
+    return false;
+  }
+
+  image.Reset({ 0, 0, (int32_t)header.Width, (int32_t)header.Height });
+  const std::vector<uint8_t> zeros(((size_t)header.Width * bitsPerPixel + 7) / 8, 0);
+  uint8_t* row = raw.data();
+  for (const Pass& pass : passes) {
+    const uint32_t width = (header.Width - pass.X + pass.StepX - 1) / pass.StepX;
+    const uint32_t height = (header.Height - pass.Y + pass.StepY - 1) / pass.StepY;
+    if (width == 0 || height == 0) continue;
+    const size_t size = ((size_t)width * bitsPerPixel + 7) / 8;
+    const uint8_t* previous = zeros.data();
+    for (uint32_t y = 0; y < height; y++) {
+      if (!Unfilter(row, previous, size, bytesPerPixel)) {
+        error = "Unknown PNG filter " + std::to_string(row[0]);
+        return false;
+      }
+      StorePngRow(header, row + 1, width, pass.X, pass.StepX, pass.Y + y * pass.StepY, image);
+      previous = row + 1;
+      row += size + 1;
+    }
+  }
+  return true;
+}
+
+bool DecodeTGA(std::span<const uint8_t> data, Image& image, std::string& error)
+{
+  if (data.size() < 18) {
+    error = "Unknown image format";
+    return false;
+  }
+  const uint8_t idLength = data[0], mapType = data[1], type = data[2];
+  const uint16_t mapFirst = ReadLittleEndian16(&data[3]), mapLength = ReadLittleEndian16(&data[5]);
+  const uint8_t mapDepth = data[7];
+  const uint32_t width = ReadLittleEndian16(&data[12]), height = ReadLittleEndian16(&data[14]);
+  const uint8_t depth = data[16], descriptor = data[17];
+
+  // TGA files have no signature, so every field has to make sense before the data is taken for one
+  const bool mapped = type == 1 || type == 9, gray = type == 3 || type == 11, compressed = type >= 9;
+  const bool validType = mapped || gray || type == 2 || type == 10;
+  const bool validDepth = mapped ? depth == 8 : gray ? depth == 8 || depth == 16
+                                                     : depth == 15 || depth == 16 || depth == 24 || depth == 32;
+  const bool validMap = mapped ? mapType == 1 && (mapDepth == 15 || mapDepth == 16 || mapDepth == 24 || mapDepth == 32)
+                               : mapType <= 1;
+  if (!validType || !validDepth || !validMap || width == 0 || height == 0) {
+    error = "Unknown image format";
+    return false;
+  }
+  if (!CheckSize(width, height, error)) return false;
+
+  // Colors are stored as BGR(A), 15 and 16 bit ones as 5 bits per channel
+  auto decodeColor = [](const uint8_t* bytes, uint32_t depth) -> Pixel {
+    if (depth == 15 || depth == 16) {
+      const uint16_t value = ReadLittleEndian16(bytes);
+      return { ((value >> 10) & 31) / 31.0f, ((value >> 5) & 31) / 31.0f, (value & 31) / 31.0f, 1.0f };
+    }
+    return { bytes[2] / 255.0f, bytes[1] / 255.0f, bytes[0] / 255.0f, depth == 32 ? bytes[3] / 255.0f : 1.0f };
+  };
+
+  size_t offset = 18 + (size_t)idLength;
+  std::vector<Pixel> palette;
+  if (mapType == 1) {
+    const uint32_t entryBytes = (mapDepth + 7) / 8;
+    if (offset + (size_t)mapLength * entryBytes > data.size()) {
+      error = "TGA color map is cut off";
+      return false;
+    }
+    palette.resize(mapFirst + mapLength);
+    for (uint32_t i = 0; i < mapLength; i++) {
+      palette[mapFirst + i] = decodeColor(&data[offset + (size_t)i * entryBytes], mapDepth);
+    }
+    offset += (size_t)mapLength * entryBytes;
+  }
+
+  const uint32_t pixelBytes = (depth + 7) / 8;
+  auto decodePixel = [&](const uint8_t* bytes) -> Pixel {
+    if (mapped) return bytes[0] < palette.size() ? palette[bytes[0]] : Pixel{ 0.0f, 0.0f, 0.0f, 1.0f };
+    if (gray) {
+      const float value = bytes[0] / 255.0f;
+      return { value, value, value, depth == 16 ? bytes[1] / 255.0f : 1.0f };
+    }
+    return decodeColor(bytes, depth);
+  };
+
+  image.Reset({ 0, 0, (int32_t)width, (int32_t)height });
+  const bool topDown = descriptor & 0x20, rightToLeft = descriptor & 0x10;
+  const uint64_t count = (uint64_t)width * height;
+  // Run length packets may run across rows
+  uint64_t index = 0;
+  auto store = [&](const Pixel& pixel) {
+    const uint32_t x = (uint32_t)(index % width), y = (uint32_t)(index / width);
+    image.SetPixel(rightToLeft ? width - 1 - x : x, topDown ? y : height - 1 - y, pixel);
+    index++;
+  };
+  while (index < count) {
+    uint32_t run = 1;
+    bool repeat = false;
+    if (compressed) {
+      if (offset >= data.size()) break;
+      run = (data[offset] & 0x7F) + 1;
+      repeat = data[offset++] & 0x80;
+    }
+    run = (uint32_t)std::min<uint64_t>(run, count - index);
+    const size_t bytes = (size_t)(repeat ? 1 : run) * pixelBytes;
+    if (offset + bytes > data.size()) break;
+    if (repeat) {
+      const Pixel pixel = decodePixel(&data[offset]);
+      for (uint32_t i = 0; i < run; i++) store(pixel);
+    } else {
+      for (uint32_t i = 0; i < run; i++) store(decodePixel(&data[offset + (size_t)i * pixelBytes]));
+    }
+    offset += bytes;
+  }
+  if (index < count) {
+    error = "TGA image data is too short";
+    return false;
+  }
+  return true;
+}
+
+// Reverses the RLE compression of EXR files, which writes signed counts: negative ones for literal runs and
+// positive ones for a byte repeated count + 1 times
+bool DecompressExrRle(std::span<const uint8_t> input, std::vector<uint8_t>& output)
+{
+  for (size_t offset = 0; offset < input.size();) {
+    const int8_t count = (int8_t)input[offset++];
+    if (count < 0) {
+      if (offset + (size_t)-count > input.size()) return false;
+      output.insert(output.end(), input.begin() + offset, input.begin() + offset + -count);
+      offset += -count;
+    } else {
+      if (offset >= input.size()) return false;
+      output.insert(output.end(), (size_t)count + 1, input[offset++]);
+    }
+  }
+  return true;
+}
+
+// EXR compressors store differences of bytes and the even bytes of the data before the odd ones
+void ReverseExrPredictor(const std::vector<uint8_t>& input, std::vector<uint8_t>& output)
+{
+  std::vector<uint8_t> summed(input);
+  for (size_t i = 1; i < summed.size(); i++) summed[i] = (uint8_t)(summed[i - 1] + summed[i] - 128);
+  output.resize(summed.size());
+  const size_t half = (summed.size() + 1) / 2;
+  for (size_t i = 0; i < summed.size(); i++) output[i] = i % 2 == 0 ? summed[i / 2] : summed[half + i / 2];
+}
+
+bool DecodeEXR(std::span<const uint8_t> data, Image& image, std::string& error)
+{
+  const uint32_t version = ReadLittleEndian32(&data[4]);
+  if ((version & 0xFF) != 2 || (version & 0x1A00)) {
+    error = "Only single part scanline EXR files are supported";
+    return false;
+  }
+
+  struct Channel {
+    std::string Name;
+    // 0 uint, 1 half, 2 float
+    uint32_t Type;
+    // Plane of the image or -1 for channels that are skipped, Y fills R, G and B
+    int32_t Plane;
+  };
+  std::vector<Channel> channels;
+  uint8_t compression = 0;
+  int32_t window[4] = { 0, 0, -1, -1 };
+  bool luminance = false;
+
+  size_t offset = 8;
+  auto readString = [&](std::string& string) {
+    const auto end = std::find(data.begin() + offset, data.end(), (uint8_t)0);
+    if (end == data.end()) return false;
+    string.assign(data.begin() + offset, end);
+    offset = end - data.begin() + 1;
+    return true;
+  };
+  while (true) {
+    std::string name, type;
+    if (!readString(name)) break;
+    if (name.empty()) break;
+    if (!readString(type) || offset + 4 > data.size()) break;
+    const uint32_t size = ReadLittleEndian32(&data[offset]);
+    offset += 4;
+    if (size > data.size() - offset) break;
+    const uint8_t* value = &data[offset];
+
+    if (name == "channels" && type == "chlist") {
+      const size_t end = offset + size;
+      while (offset < end && data[offset] != 0) {
+        Channel channel;
+        if (!readString(channel.Name) || offset + 16 > end) break;
+        channel.Type = ReadLittleEndian32(&data[offset]);
+        const uint32_t samplingX = ReadLittleEndian32(&data[offset + 8]);
+        const uint32_t samplingY = ReadLittleEndian32(&data[offset + 12]);
+        offset += 16;
+        if (channel.Type > 2 || samplingX != 1 || samplingY != 1) {
+          error = "Unsupported EXR channel " + channel.Name;
+          return false;
+        }
+        // Layers are prefixes like "diffuse.R", only the last part picks the plane
+        const std::string_view suffix = std::string_view(channel.Name).substr(channel.Name.rfind('.') + 1);
+        channel.Plane = suffix == "R" ? 0 : suffix == "G" ? 1 : suffix == "B" ? 2 : suffix == "A" ? 3 : -1;
+        if (suffix == "Y") {
+          channel.Plane = 0;
+          luminance = true;
+        }
+        channels.push_back(std::move(channel));
+      }
+      offset = end;
+      continue;
+    }
+    if (name == "compression" && size >= 1) compression = value[0];
+    if (name == "dataWindow" && size >= 16) {
+      for (uint32_t i = 0; i < 4; i++) window[i] = (int32_t)ReadLittleEndian32(value + i * 4);
+    }
+    offset += size;
+  }
+
+  if (channels.empty() || offset > data.size()) {
+    error = "EXR header is damaged";
+    return false;
+  }
+  // NONE, RLE, ZIPS and ZIP
+  static constexpr uint32_t s_LinesPerBlock[] = { 1, 1, 1, 16 };
+  if (compression > 3) {
+    error = "Unsupported EXR compression " + std::to_string(compression);
+    return false;
+  }
+  const int64_t width = (int64_t)window[2] - window[0] + 1, height = (int64_t)window[3] - window[1] + 1;
+  if (width <= 0 || height <= 0 || !CheckSize(width, height, error)) return false;
+
+  size_t lineBytes = 0;
+  for (const Channel& channel : channels) lineBytes += (size_t)width * (channel.Type == 1 ? 2 : 4);
+  const uint32_t linesPerBlock = s_LinesPerBlock[compression];
+  const uint64_t blocks = ((uint64_t)height + linesPerBlock - 1) / linesPerBlock;
+  if (offset + blocks * 8 > data.size()) {
+    error = "EXR offset table is cut off";
+    return false;
+  }
+
+  image.Reset({ 0, 0, (int32_t)width, (int32_t)height });
+  for (uint32_t c = 0; c < Image::Channels; c++) {
+    for (int32_t y = 0; y < height; y++) std::fill_n(image.GetPointer(c, 0, y), width, c == 3 ? 1.0f : 0.0f);
+  }
+
+  std::vector<uint8_t> unpacked, block;
+  for (uint64_t i = 0; i < blocks; i++) {
+    const uint64_t chunk = ReadLittleEndian64(&data[offset + i * 8]);
+    if (chunk > data.size() - 8) {
+      error = "EXR block is cut off";
+      return false;
+    }
+    const int64_t firstLine = (int64_t)(int32_t)ReadLittleEndian32(&data[chunk]) - window[1];
+    const uint32_t size = ReadLittleEndian32(&data[chunk + 4]);
+    if (size > data.size() - chunk - 8 || firstLine < 0 || firstLine >= height) {
+      error = "EXR block is damaged";
+      return false;
+    }
+    const int32_t lines = (int32_t)std::min<int64_t>(linesPerBlock, height - firstLine);
+    const size_t expected = lineBytes * lines;
+    const std::span<const uint8_t> stored(&data[chunk + 8], size);
+
+    // Blocks that do not get smaller are stored uncompressed
+    const uint8_t* bytes = stored.data();
+    if (compression != 0 && size < expected) {
+      unpacked.clear();
+      const bool valid =
+        compression == 1 ? DecompressExrRle(stored, unpacked) : InflateZlib(stored, unpacked, error);
+      if (!valid || unpacked.size() != expected) {
+        error = "EXR block does not decompress";
+        return false;
+      }
+      ReverseExrPredictor(unpacked, block);
+      bytes = block.data();
+    } else if (size < expected) {
+      error = "EXR block is too short";
+      return false;
+    }
+
+    for (int32_t line = 0; line < lines; line++) {
+      for (const Channel& channel : channels) {
+        const uint32_t sampleBytes = channel.Type == 1 ? 2 : 4;
+        if (channel.Plane >= 0) {
+          float* out = image.GetPointer(channel.Plane, 0, (int32_t)firstLine + line);
+          if (channel.Type == 1) {
+            for (int64_t x = 0; x < width; x++) out[x] = HalfToFloat(ReadLittleEndian16(bytes + x * 2));
+          } else if (channel.Type == 2) {
+            for (int64_t x = 0; x < width; x++) out[x] = std::bit_cast<float>(ReadLittleEndian32(bytes + x * 4));
+          } else {
+            for (int64_t x = 0; x < width; x++) out[x] = (float)ReadLittleEndian32(bytes + x * 4);
+          }
+        }
+        bytes += width * sampleBytes;
+      }
+    }
+  }
+
+  if (luminance) {
+    for (int32_t y = 0; y < height; y++) {
+      std::copy_n(image.GetPointer(0, 0, y), width, image.GetPointer(1, 0, y));
+      std::copy_n(image.GetPointer(0, 0, y), width, image.GetPointer(2, 0, y));
+    }
+  }
+  return true;
+}
+
+// Portable float maps, rows are stored bottom to top
+bool DecodePFM(std::span<const uint8_t> data, Image& image, std::string& error)
+{
+  const bool color = data[1] == 'F';
+  // Three tokens after the magic, separated by one whitespace character each
+  size_t offset = 2;
+  std::string_view tokens[3];
+  for (std::string_view& token : tokens) {
+    while (offset < data.size() && std::isspace(data[offset])) offset++;
+    const size_t start = offset;
+    while (offset < data.size() && !std::isspace(data[offset])) offset++;
+    token = std::string_view((const char*)data.data() + start, offset - start);
+  }
+  offset++;
+
+  uint32_t width = 0, height = 0;
+  float scale = 0.0f;
+  std::from_chars(tokens[0].data(), tokens[0].data() + tokens[0].size(), width);
+  std::from_chars(tokens[1].data(), tokens[1].data() + tokens[1].size(), height);
+  std::from_chars(tokens[2].data(), tokens[2].data() + tokens[2].size(), scale);
+  if (!CheckSize(width, height, error)) return false;
+  const uint32_t channels = color ? 3 : 1;
+  if (scale > 0.0f || offset + (size_t)width * height * channels * sizeof(float) > data.size()) {
+    error = scale > 0.0f ? "Big endian PFM files are not supported" : "PFM image data is too short";
+    return false;
+  }
+
+  image.Reset({ 0, 0, (int32_t)width, (int32_t)height });
+  for (uint32_t y = 0; y < height; y++) {
+    const uint8_t* row = &data[offset + (size_t)(height - 1 - y) * width * channels * sizeof(float)];
+    for (uint32_t c = 0; c < Image::Channels; c++) {
+      float* out = image.GetPointer(c, 0, y);
+      if (c == 3) {
+        std::fill_n(out, width, 1.0f);
+        continue;
+      }
+      const uint32_t source = color ? c : 0;
+      for (uint32_t x = 0; x < width; x++) {
+        out[x] = std::bit_cast<float>(ReadLittleEndian32(row + (x * channels + source) * sizeof(float)));
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+bool DecodeImage(std::span<const std::byte> data, Image& image, std::string& error)
+{
+  const std::span<const uint8_t> bytes((const uint8_t*)data.data(), data.size());
+  static constexpr uint8_t s_PngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  static constexpr uint8_t s_ExrMagic[4] = { 0x76, 0x2F, 0x31, 0x01 };
+  if (bytes.size() >= 8 && std::memcmp(bytes.data(), s_PngSignature, 8) == 0) return DecodePNG(bytes, image, error);
+  if (bytes.size() >= 8 && std::memcmp(bytes.data(), s_ExrMagic, 4) == 0) return DecodeEXR(bytes, image, error);
+  if (bytes.size() >= 3 && bytes[0] == 'P' && (bytes[1] == 'F' || bytes[1] == 'f') && std::isspace(bytes[2])) {
+    return DecodePFM(bytes, image, error);
+  }
+  return DecodeTGA(bytes, image, error);
+}
+
+bool ReadImage(const std::string& path, Image& image, std::string& error)
+{
+  MappedFile file;
+  if (!file.Open(path)) {
+    error = "Could not open " + path;
+    return false;
+  }
+  if (!DecodeImage(file.GetData(), image, error)) {
+    error = path + ": " + error;
+    return false;
+  }
+  return true;
+}
+
+} // namespace Texturia
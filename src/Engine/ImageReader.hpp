@@ -0,0 +1,24 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Image.hpp"
+
+#include <cstddef>
+#include <span>
+
+namespace Texturia {
+
+// Decodes a file that is already in memory into image, which covers (0, 0) to the size of the file. The format is
+// picked from the contents:
+//   PNG  every color type and bit depth, interlaced or not. 8 and 16 bit values are mapped to [0, 1].
+//   TGA  true color, gray and color mapped, uncompressed or run length encoded
+//   EXR  single part scanline files, uncompressed, RLE, ZIPS or ZIP, with half, float or uint channels
+//   PFM  color and gray
+// Gray images fill R, G and B, images without alpha get 1. Returns false with a message in error if the data is not
+// one of the formats above or is damaged.
+bool DecodeImage(std::span<const std::byte> data, Image& image, std::string& error);
+// Maps the file at path and decodes it
+bool ReadImage(const std::string& path, Image& image, std::string& error);
+
+} // namespace Texturia
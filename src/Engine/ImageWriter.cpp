@@ -0,0 +1,265 @@
+#include "Engine/ImageWriter.hpp"
+
+#include "Engine/TiffWriter.hpp"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace Texturia {
+
+namespace {
+
+uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+  static const std::array<uint32_t, 256> table = [] {
+    std::array<uint32_t, 256> table;
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t value = i;
+      for (int bit = 0; bit < 8; bit++) value = value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+      table[i] = value;
+    }
+    return table;
+  }();
+
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+void AppendBigEndian(std::vector<uint8_t>& bytes, uint32_t value)
+{
+  for (int shift = 24; shift >= 0; shift -= 8) bytes.push_back((uint8_t)(value >> shift));
+}
+
+void AppendLittleEndian(std::vector<uint8_t>& bytes, uint32_t value, uint32_t size = 4)
+{
+  for (uint32_t i = 0; i < size; i++) bytes.push_back((uint8_t)(value >> (i * 8)));
+}
+
+void AppendChunk(std::vector<uint8_t>& bytes, const char* type, const std::vector<uint8_t>& data)
+{
+  const size_t start = bytes.size();
+  AppendBigEndian(bytes, (uint32_t)data.size());
+  bytes.insert(bytes.end(), type, type + 4);
+  bytes.insert(bytes.end(), data.begin(), data.end());
+  AppendBigEndian(bytes, Crc32(bytes.data() + start + 4, bytes.size() - start - 4));
+}
+
+// Rounds to nearest, NaN becomes 0
+inline uint8_t ToByte(float value)
+{
+  return (uint8_t)((value > 0.0f ? std::min(value, 1.0f) : 0.0f) * 255.0f + 0.5f);
+}
+
+// The image data is stored in uncompressed deflate blocks, which keeps the writer dependency free
+void EncodePNG(const Image& image, std::vector<uint8_t>& bytes)
+{
+  const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+  bytes.insert(bytes.end(), signature, signature + sizeof(signature));
+
+  std::vector<uint8_t> header;
+  AppendBigEndian(header, image.GetWidth());
+  AppendBigEndian(header, image.GetHeight());
+  header.insert(header.end(), { 8, 6, 0, 0, 0 }); // 8 bit depth, RGBA, deflate, no filter, no interlace
+  AppendChunk(bytes, "IHDR", header);
+
+  const size_t rowSize = (size_t)image.GetWidth() * 4;
+  std::vector<uint8_t> scanlines((size_t)image.GetHeight() * (rowSize + 1));
+  for (uint32_t y = 0; y < image.GetHeight(); y++) {
+    uint8_t* row = &scanlines[y * (rowSize + 1)];
+    row[0] = 0; // Filter type None
+    ConvertToRGBA8(image, y, row + 1);
+  }
+
+  std::vector<uint8_t> zlib = { 0x78, 0x01 };
+  zlib.reserve(scanlines.size() + scanlines.size() / 65535 * 5 + 16);
+  size_t offset = 0;
+  do {
+    uint16_t size = (uint16_t)std::min<size_t>(65535, scanlines.size() - offset);
+    zlib.push_back(offset + size == scanlines.size() ? 1 : 0); // Final block flag, block type stored
+    zlib.insert(zlib.end(), { (uint8_t)size, (uint8_t)(size >> 8), (uint8_t)~size, (uint8_t)(~size >> 8) });
+    zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + size);
+    offset += size;
+  } while (offset < scanlines.size());
+
+  // Adler-32, the sums can not overflow within 5552 bytes
+  uint32_t a = 1, b = 0;
+  for (size_t start = 0; start < scanlines.size(); start += 5552) {
+    const size_t end = std::min(scanlines.size(), start + 5552);
+    for (size_t i = start; i < end; i++) {
+      a += scanlines[i];
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  AppendBigEndian(zlib, (b << 16) | a);
+
+  AppendChunk(bytes, "IDAT", zlib);
+  AppendChunk(bytes, "IEND", {});
+}
+
+// Portable float map, rows are stored bottom to top
+void EncodePFM(const Image& image, std::vector<uint8_t>& bytes)
+{
+  const std::string header = "PF\n" + std::to_string(image.GetWidth()) + " " + std::to_string(image.GetHeight()) +
+                             "\n-1.0\n";
+  bytes.insert(bytes.end(), header.begin(), header.end());
+  std::vector<float> row(image.GetWidth() * 3);
+  for (uint32_t y = image.GetHeight(); y-- > 0;) {
+    for (uint32_t x = 0; x < image.GetWidth(); x++) {
+      const Pixel pixel = image.GetPixel(x, y);
+      row[x * 3 + 0] = pixel.R;
+      row[x * 3 + 1] = pixel.G;
+      row[x * 3 + 2] = pixel.B;
+    }
+    const uint8_t* data = (const uint8_t*)row.data();
+    bytes.insert(bytes.end(), data, data + row.size() * sizeof(float));
+  }
+}
+
+// 8 bit BGRA stored top to bottom, run length encoded per row
+void EncodeTGA(const Image& image, std::vector<uint8_t>& bytes)
+{
+  const uint32_t width = image.GetWidth();
+  uint8_t header[18] = {};
+  header[2] = 10; // Run length encoded true color
+  header[12] = (uint8_t)width;
+  header[13] = (uint8_t)(width >> 8);
+  header[14] = (uint8_t)image.GetHeight();
+  header[15] = (uint8_t)(image.GetHeight() >> 8);
+  header[16] = 32;
+  header[17] = 0x20 | 8; // Top left origin, 8 alpha bits
+  bytes.insert(bytes.end(), header, header + sizeof(header));
+
+  // Pixels as little endian words, so runs compare one value
+  std::vector<uint32_t> row(width);
+  bytes.reserve(bytes.size() + (size_t)width * image.GetHeight() * 4 + 1024);
+  for (uint32_t y = 0; y < image.GetHeight(); y++) {
+    ConvertToRGBA8(image, y, (uint8_t*)row.data());
+    auto append = [&](uint32_t rgba) {
+      bytes.insert(bytes.end(), { (uint8_t)(rgba >> 16), (uint8_t)(rgba >> 8), (uint8_t)rgba, (uint8_t)(rgba >> 24) });
+    };
+    for (uint32_t x = 0; x < width;) {
+      // A repeat packet for two or more equal pixels, otherwise a raw packet up to the next run
+      uint32_t run = 1;
+      while (x + run < width && run < 128 && row[x + run] == row[x]) run++;
+      if (run > 1) {
+        bytes.push_back((uint8_t)(0x80 | (run - 1)));
+        append(row[x]);
+        x += run;
+        continue;
+      }
+      uint32_t count = 1;
+      while (x + count < width && count < 128 && (x + count + 1 >= width || row[x + count] != row[x + count + 1])) {
+        count++;
+      }
+      bytes.push_back((uint8_t)(count - 1));
+      for (uint32_t i = 0; i < count; i++) append(row[x + i]);
+      x += count;
+    }
+  }
+  bytes.insert(bytes.end(), 26, 0);
+  const char footer[] = "TRUEVISION-XFILE.";
+  bytes.insert(bytes.end(), footer, footer + sizeof(footer));
+}
+
+// Single part scanline OpenEXR with uncompressed 32 bit float channels, one line per block
+void EncodeEXR(const Image& image, std::vector<uint8_t>& bytes)
+{
+  const uint32_t width = image.GetWidth(), height = image.GetHeight();
+  AppendLittleEndian(bytes, 20000630); // Magic number
+  AppendLittleEndian(bytes, 2);        // Version 2, scanline, short names
+  auto appendAttribute = [&](const char* name, const char* type, const std::vector<uint8_t>& value) {
+    bytes.insert(bytes.end(), name, name + std::strlen(name) + 1);
+    bytes.insert(bytes.end(), type, type + std::strlen(type) + 1);
+    AppendLittleEndian(bytes, (uint32_t)value.size());
+    bytes.insert(bytes.end(), value.begin(), value.end());
+  };
+
+  // Channels are sorted by name, which is also the order of the data in every line
+  std::vector<uint8_t> channels;
+  for (const char* name : { "A", "B", "G", "R" }) {
+    channels.insert(channels.end(), { (uint8_t)name[0], 0 });
+    AppendLittleEndian(channels, 2); // Float
+    AppendLittleEndian(channels, 0); // Not linear, reserved
+    AppendLittleEndian(channels, 1); // Sampling in x
+    AppendLittleEndian(channels, 1); // Sampling in y
+  }
+  channels.push_back(0);
+  std::vector<uint8_t> window, aspect, center, widthValue;
+  for (uint32_t value : { 0u, 0u, width - 1, height - 1 }) AppendLittleEndian(window, value);
+  AppendLittleEndian(aspect, std::bit_cast<uint32_t>(1.0f));
+  AppendLittleEndian(center, 0);
+  AppendLittleEndian(center, 0);
+  AppendLittleEndian(widthValue, std::bit_cast<uint32_t>(1.0f));
+
+  appendAttribute("channels", "chlist", channels);
+  appendAttribute("compression", "compression", { 0 });
+  appendAttribute("dataWindow", "box2i", window);
+  appendAttribute("displayWindow", "box2i", window);
+  appendAttribute("lineOrder", "lineOrder", { 0 });
+  appendAttribute("pixelAspectRatio", "float", aspect);
+  appendAttribute("screenWindowCenter", "v2f", center);
+  appendAttribute("screenWindowWidth", "float", widthValue);
+  bytes.push_back(0);
+
+  const size_t lineSize = (size_t)width * Image::Channels * sizeof(float);
+  const uint64_t first = bytes.size() + (uint64_t)height * 8;
+  for (uint32_t y = 0; y < height; y++) {
+    const uint64_t offset = first + (uint64_t)y * (lineSize + 8);
+    AppendLittleEndian(bytes, (uint32_t)offset);
+    AppendLittleEndian(bytes, (uint32_t)(offset >> 32));
+  }
+  bytes.reserve(bytes.size() + height * (lineSize + 8));
+  for (uint32_t y = 0; y < height; y++) {
+    AppendLittleEndian(bytes, y);
+    AppendLittleEndian(bytes, (uint32_t)lineSize);
+    for (uint32_t channel : { 3, 2, 1, 0 }) {
+      const uint8_t* data = (const uint8_t*)image.GetPointer(channel, 0, y);
+      bytes.insert(bytes.end(), data, data + width * sizeof(float));
+    }
+  }
+}
+
+} // namespace
+
+void ConvertToRGBA8(const Image& image, uint32_t row, uint8_t* pixels)
+{
+  const int32_t y = image.GetRegion().Y + (int32_t)row, x = image.GetRegion().X;
+  const float* planes[Image::Channels];
+  for (uint32_t c = 0; c < Image::Channels; c++) planes[c] = image.GetPointer(c, x, y);
+  for (uint32_t i = 0; i < image.GetWidth(); i++) {
+    for (uint32_t c = 0; c < Image::Channels; c++) pixels[i * 4 + c] = ToByte(planes[c][i]);
+  }
+}
+
+bool EncodeImage(const Image& image, std::string_view extension, std::vector<uint8_t>& bytes)
+{
+  if (extension == ".png") EncodePNG(image, bytes);
+  else if (extension == ".pfm") EncodePFM(image, bytes);
+  else if (extension == ".tga") EncodeTGA(image, bytes);
+  else if (extension == ".exr") EncodeEXR(image, bytes);
+  else return false;
+  return true;
+}
+
+bool WriteImage(const Image& image, const std::string& path)
+{
+  if (path.ends_with(".tif") || path.ends_with(".tiff")) {
+    TiffWriter writer(path, image.GetWidth(), image.GetHeight(), TiffWriter::GetTileSize(16));
+    return writer.Write(image) && writer.Close();
+  }
+
+  const size_t dot = path.rfind('.');
+  std::vector<uint8_t> bytes;
+  if (dot == std::string::npos || !EncodeImage(image, std::string_view(path).substr(dot), bytes)) return false;
+  std::ofstream file(path, std::ios::binary);
+  file.write((const char*)bytes.data(), bytes.size());
+  return (bool)file;
+}
+
+} // namespace Texturia
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Image.hpp"
+
+namespace Texturia {
+
+// Writes the image to path, the format is picked from the extension:
+//   .png  8 bit RGBA, values are clamped to [0, 1]
+//   .pfm  32 bit float RGB
+//   .tga  8 bit RGBA, run length encoded
+//   .exr  32 bit float RGBA, uncompressed scanlines
+//   .tif  32 bit float RGBA, tiled (see TiffWriter)
+bool WriteImage(const Image& image, const std::string& path);
+// Appends the file WriteImage would write for extension (".png", ".pfm", ".tga" or ".exr") to bytes, so encoding can
+// run apart from the file system. Returns false for other extensions.
+bool EncodeImage(const Image& image, std::string_view extension, std::vector<uint8_t>& bytes);
+// Converts one row of the image, counted from its top, to 8 bit RGBA clamped to [0, 1]
+void ConvertToRGBA8(const Image& image, uint32_t row, uint8_t* pixels);
+
+} // namespace Texturia
@@ -0,0 +1,222 @@
+#include "Engine/Json.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+
+namespace Texturia {
+
+namespace {
+
+// Recursive descent parser for all of JSON except surrogate pairs
+class JsonParser {
+public:
+  JsonParser(std::string_view text) : m_Text(text) {}
+
+  bool Parse(JsonValue& value)
+  {
+    if (!ParseValue(value, 0)) return false;
+    SkipWhitespace();
+    return m_Position == m_Text.size() || Fail("Unexpected characters after the document");
+  }
+
+  // Line of the error in the text
+  std::string GetError() const
+  {
+    const size_t line = std::count(m_Text.begin(), m_Text.begin() + std::min(m_Position, m_Text.size()), '\n') + 1;
+    return "Line " + std::to_string(line) + ": " + m_Error;
+  }
+
+private:
+  // Deeper documents are not written by texturia and would only exhaust the stack
+  static constexpr uint32_t s_MaxDepth = 64;
+
+  bool Fail(std::string error)
+  {
+    if (m_Error.empty()) m_Error = std::move(error);
+    return false;
+  }
+
+  void SkipWhitespace()
+  {
+    while (m_Position < m_Text.size() && std::isspace((unsigned char)m_Text[m_Position])) m_Position++;
+  }
+
+  bool Consume(char c)
+  {
+    SkipWhitespace();
+    if (m_Position < m_Text.size() && m_Text[m_Position] == c) {
+      m_Position++;
+      return true;
+    }
+    return false;
+  }
+
+  bool ConsumeWord(std::string_view word)
+  {
+    if (m_Text.substr(m_Position, word.size()) != word) return false;
+    m_Position += word.size();
+    return true;
+  }
+
+  bool ParseValue(JsonValue& value, uint32_t depth)
+  {
+    if (depth > s_MaxDepth) return Fail("Nested too deeply");
+    SkipWhitespace();
+    if (m_Position >= m_Text.size()) return Fail("Unexpected end of the document");
+
+    const char c = m_Text[m_Position];
+    if (c == '{') return ParseObject(value, depth);
+    if (c == '[') return ParseArray(value, depth);
+    if (c == '"') {
+      value.Kind = JsonKind::String;
+      return ParseString(value.String);
+    }
+    if (ConsumeWord("true") || ConsumeWord("false")) {
+      value.Kind = JsonKind::Bool;
+      value.Bool = c == 't';
+      return true;
+    }
+    if (ConsumeWord("null")) {
+      value.Kind = JsonKind::Null;
+      return true;
+    }
+    if (c == '-' || std::isdigit((unsigned char)c)) {
+      const size_t start = m_Position;
+      while (m_Position < m_Text.size() && std::strchr("+-.eE0123456789", m_Text[m_Position])) m_Position++;
+      value.Kind = JsonKind::Number;
+      value.String = m_Text.substr(start, m_Position - start);
+      return true;
+    }
+    return Fail(std::string("Unexpected character '") + c + "'");
+  }
+
+  bool ParseObject(JsonValue& value, uint32_t depth)
+  {
+    value.Kind = JsonKind::Object;
+    m_Position++;
+    if (Consume('}')) return true;
+    do {
+      SkipWhitespace();
+      auto& [key, member] = value.Object.emplace_back();
+      if (!ParseString(key)) return false;
+      if (!Consume(':')) return Fail("Expected ':' after \"" + key + "\"");
+      if (!ParseValue(member, depth + 1)) return false;
+    } while (Consume(','));
+    return Consume('}') || Fail("Expected ',' or '}'");
+  }
+
+  bool ParseArray(JsonValue& value, uint32_t depth)
+  {
+    value.Kind = JsonKind::Array;
+    m_Position++;
+    if (Consume(']')) return true;
+    do {
+      if (!ParseValue(value.Array.emplace_back(), depth + 1)) return false;
+    } while (Consume(','));
+    return Consume(']') || Fail("Expected ',' or ']'");
+  }
+
+  bool ParseString(std::string& string)
+  {
+    if (m_Position >= m_Text.size() || m_Text[m_Position] != '"') return Fail("Expected a string");
+    m_Position++;
+    while (m_Position < m_Text.size()) {
+      const char c = m_Text[m_Position++];
+      if (c == '"') return true;
+      if (c != '\\') {
+        string += c;
+        continue;
+      }
+      if (m_Position >= m_Text.size()) break;
+      switch (const char escaped = m_Text[m_Position++]) {
+        case 'b':
+          string += '\b';
+          break;
+        case 'f':
+          string += '\f';
+          break;
+        case 'n':
+          string += '\n';
+          break;
+        case 'r':
+          string += '\r';
+          break;
+        case 't':
+          string += '\t';
+          break;
+        case 'u': {
+          uint32_t code = 0;
+          const std::string_view digits = m_Text.substr(m_Position, 4);
+          if (digits.size() != 4 || std::from_chars(digits.data(), digits.data() + 4, code, 16).ptr != digits.end()) {
+            return Fail("Invalid unicode escape");
+          }
+          m_Position += 4;
+          // UTF-8 encoding of the code point
+          if (code < 0x80) {
+            string += (char)code;
+          } else if (code < 0x800) {
+            string += (char)(0xC0 | (code >> 6));
+            string += (char)(0x80 | (code & 0x3F));
+          } else {
+            string += (char)(0xE0 | (code >> 12));
+            string += (char)(0x80 | ((code >> 6) & 0x3F));
+            string += (char)(0x80 | (code & 0x3F));
+          }
+          break;
+        }
+        default:
+          string += escaped;
+      }
+    }
+    return Fail("Unterminated string");
+  }
+
+  std::string_view m_Text;
+  size_t m_Position = 0;
+  std::string m_Error;
+};
+
+} // namespace
+
+bool ParseJson(std::string_view text, JsonValue& value, std::string& error)
+{
+  JsonParser parser(text);
+  if (parser.Parse(value)) return true;
+  error = parser.GetError();
+  return false;
+}
+
+void WriteJsonString(std::string& out, std::string_view string)
+{
+  out += '"';
+  for (char c : string) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+          out += escaped;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+} // namespace Texturia
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace Texturia {
+
+// Minimal JSON document model shared by graph files and benchmark results
+enum class JsonKind { Null, Bool, Number, String, Array, Object };
+
+struct JsonValue {
+  JsonKind Kind = JsonKind::Null;
+  bool Bool = false;
+  // Numbers keep their text, so they can be converted to floats and ints without going through double
+  std::string String;
+  std::vector<JsonValue> Array;
+  std::vector<std::pair<std::string, JsonValue>> Object;
+
+  // First member called key of an object, nullptr if there is none
+  inline const JsonValue* Find(std::string_view key) const
+  {
+    for (const auto& [name, value] : Object) {
+      if (name == key) return &value;
+    }
+    return nullptr;
+  }
+};
+
+// Parses a whole document, returns false and sets error with the line of the problem if it is malformed
+bool ParseJson(std::string_view text, JsonValue& value, std::string& error);
+
+// Appends string in quotes, with everything JSON does not allow in a string escaped
+void WriteJsonString(std::string& out, std::string_view string);
+
+} // namespace Texturia
@@ -0,0 +1,252 @@
+#include "Engine/Kernels.hpp"
+
+#include "Engine/Filters/Filters.hpp"
+#include "Engine/ImageIO.hpp"
+#include "Engine/NodeRegistry.hpp"
+#include "Engine/Noise/Noise.hpp"
+
+#include <cmath>
+
+namespace Texturia {
+
+namespace {
+
+constexpr uint32_t Channels = Image::Channels;
+
+void ConstantKernel(const KernelContext& context)
+{
+  ForEachRow<1>(context, [](const OutputRow& row, const auto& color) {
+    for (uint32_t c = 0; c < Channels; c++) {
+      for (int32_t i = 0; i < row.Width; i++) row.Data[c][i] = color.Load(c, i);
+    }
+  });
+}
+
+void GradientKernel(const KernelContext& context)
+{
+  const bool vertical = context.Inputs[0].Constant.R != 0.0f;
+  const Rect& tile = context.Tile;
+  const float scaleX = 1.0f / context.Width, scaleY = 1.0f / context.Height;
+
+  for (int32_t y = tile.Y; y < tile.Bottom(); y++) {
+    float* row = context.Output->GetPointer(0, tile.X, y);
+    for (int32_t i = 0; i < tile.Width; i++) row[i] = vertical ? (y + 0.5f) * scaleY : (tile.X + i + 0.5f) * scaleX;
+    for (uint32_t c = 1; c < 3; c++) std::copy(row, row + tile.Width, context.Output->GetPointer(c, tile.X, y));
+    std::fill_n(context.Output->GetPointer(3, tile.X, y), tile.Width, 1.0f);
+  }
+}
+
+void CheckerKernel(const KernelContext& context)
+{
+  const float scale = std::max(1.0f, context.Inputs[0].Constant.R);
+  const float cellsX = scale / context.Width, cellsY = scale / context.Height;
+
+  ForEachRow<3>(context, [&](const OutputRow& row, const auto&, const auto& a, const auto& b) {
+    const int32_t cellY = (int32_t)std::floor((row.Y + 0.5f) * cellsY);
+    for (uint32_t c = 0; c < Channels; c++) {
+      for (int32_t i = 0; i < row.Width; i++) {
+        const int32_t cellX = (int32_t)std::floor((row.X + i + 0.5f) * cellsX);
+        row.Data[c][i] = (cellX + cellY) % 2 == 0 ? a.Load(c, i) : b.Load(c, i);
+      }
+    }
+  });
+}
+
+void MixKernel(const KernelContext& context)
+{
+  ForEachRow<3>(context, [](const OutputRow& row, const auto& a, const auto& b, const auto& factor) {
+    for (uint32_t c = 0; c < Channels; c++) {
+      for (int32_t i = 0; i < row.Width; i++) {
+        row.Data[c][i] = a.Load(c, i) + (b.Load(c, i) - a.Load(c, i)) * factor.Load(0, i);
+      }
+    }
+  });
+}
+
+void AddKernel(const KernelContext& context)
+{
+  ForEachRow<2>(context, [](const OutputRow& row, const auto& a, const auto& b) {
+    for (uint32_t c = 0; c < 3; c++) {
+      for (int32_t i = 0; i < row.Width; i++) row.Data[c][i] = a.Load(c, i) + b.Load(c, i);
+    }
+    for (int32_t i = 0; i < row.Width; i++) row.Data[3][i] = a.Load(3, i);
+  });
+}
+
+void MultiplyKernel(const KernelContext& context)
+{
+  ForEachRow<2>(context, [](const OutputRow& row, const auto& a, const auto& b) {
+    for (uint32_t c = 0; c < Channels; c++) {
+      for (int32_t i = 0; i < row.Width; i++) row.Data[c][i] = a.Load(c, i) * b.Load(c, i);
+    }
+  });
+}
+
+void InvertKernel(const KernelContext& context)
+{
+  ForEachRow<1>(context, [](const OutputRow& row, const auto& input) {
+    for (uint32_t c = 0; c < 3; c++) {
+      for (int32_t i = 0; i < row.Width; i++) row.Data[c][i] = 1.0f - input.Load(c, i);
+    }
+    for (int32_t i = 0; i < row.Width; i++) row.Data[3][i] = input.Load(3, i);
+  });
+}
+
+void OutputKernel(const KernelContext& context)
+{
+  ForEachRow<1>(context, [](const OutputRow& row, const auto& input) {
+    for (uint32_t c = 0; c < Channels; c++) {
+      for (int32_t i = 0; i < row.Width; i++) row.Data[c][i] = input.Load(c, i);
+    }
+  });
+}
+
+// Mip level of the bitmap a bake of width x height samples: the smallest one that is still at least as large
+size_t GetBitmapLevel(const DecodedImage& bitmap, uint32_t width, uint32_t height)
+{
+  size_t level = 0;
+  while (level + 1 < bitmap.Levels.size() && bitmap.Levels[level + 1]->GetWidth() >= width &&
+         bitmap.Levels[level + 1]->GetHeight() >= height) {
+    level++;
+  }
+  return level;
+}
+
+void BitmapKernel(const KernelContext& context)
+{
+  const Rect& tile = context.Tile;
+  const Frameio::Ref<const DecodedImage> bitmap = FindBitmap((uint32_t)context.Inputs[0].Constant.R);
+  if (!bitmap) {
+    for (uint32_t c = 0; c < Channels; c++) {
+      for (int32_t y = tile.Y; y < tile.Bottom(); y++) {
+        std::fill_n(context.Output->GetPointer(c, tile.X, y), tile.Width, 0.0f);
+      }
+    }
+    return;
+  }
+
+  // Bilinear with clamp to edge, pixel centers of the bake map onto pixel centers of the level
+  const Image& level = bitmap->GetLevel(GetBitmapLevel(*bitmap, context.Width, context.Height));
+  const int32_t lastX = (int32_t)level.GetWidth() - 1, lastY = (int32_t)level.GetHeight() - 1;
+  const float scaleX = (float)level.GetWidth() / context.Width, scaleY = (float)level.GetHeight() / context.Height;
+  for (int32_t y = tile.Y; y < tile.Bottom(); y++) {
+    const float sourceY = (y + 0.5f) * scaleY - 0.5f, floorY = std::floor(sourceY), fractionY = sourceY - floorY;
+    const int32_t y0 = std::clamp((int32_t)floorY, 0, lastY), y1 = std::clamp((int32_t)floorY + 1, 0, lastY);
+    for (uint32_t c = 0; c < Channels; c++) {
+      const float* top = level.GetPointer(c, 0, y0);
+      const float* bottom = level.GetPointer(c, 0, y1);
+      float* out = context.Output->GetPointer(c, tile.X, y);
+      for (int32_t i = 0; i < tile.Width; i++) {
+        const float sourceX = (tile.X + i + 0.5f) * scaleX - 0.5f, floorX = std::floor(sourceX);
+        const float fractionX = sourceX - floorX;
+        const int32_t x0 = std::clamp((int32_t)floorX, 0, lastX), x1 = std::clamp((int32_t)floorX + 1, 0, lastX);
+        const float upper = top[x0] + (top[x1] - top[x0]) * fractionX;
+        const float lower = bottom[x0] + (bottom[x1] - bottom[x0]) * fractionX;
+        out[i] = upper + (lower - upper) * fractionY;
+      }
+    }
+  }
+}
+
+// Bakes the size of a level read it without a copy
+Frameio::Ref<const Image> BitmapProvide(std::span<const Pixel> constants, uint32_t width, uint32_t height)
+{
+  const Frameio::Ref<const DecodedImage> bitmap = FindBitmap((uint32_t)constants[0].R);
+  if (!bitmap) return nullptr;
+  const Frameio::Ref<const Image>& level = bitmap->Levels[GetBitmapLevel(*bitmap, width, height)];
+  return level->GetWidth() == width && level->GetHeight() == height ? level : nullptr;
+}
+
+} // namespace
+
+void AddBuiltinNodeTypes(NodeRegistry& registry)
+{
+  // The order is part of what the benchmarks generate, new types go to the end of their category
+  registry.AddKernel({ "Constant", { { "Color", SocketValue::Color(0.5f, 0.5f, 0.5f) } }, ConstantKernel },
+                     "Generators");
+  registry.AddKernel({ "Gradient", { { "Vertical", false } }, GradientKernel }, "Generators");
+  registry.AddKernel({ "Checker",
+                       { { "Scale", 8 },
+                         { "Color A", SocketValue::Color(0.0f, 0.0f, 0.0f) },
+                         { "Color B", SocketValue::Color(1.0f, 1.0f, 1.0f) } },
+                       CheckerKernel },
+                     "Generators");
+  registry.AddKernel({ "Mix", { { "A", 0.0f }, { "B", 1.0f }, { "Factor", 0.5f } }, MixKernel }, "Math");
+  registry.AddKernel({ "Add", { { "A", 0.0f }, { "B", 0.0f } }, AddKernel }, "Math");
+  registry.AddKernel({ "Multiply", { { "A", 1.0f }, { "B", 1.0f } }, MultiplyKernel }, "Math");
+  registry.AddKernel({ "Invert", { { "Input", 0.0f } }, InvertKernel }, "Math");
+  registry.AddKernel({ "Gradient Noise", { { "Scale", 8.0f }, { "Seed", 0 } }, Noise::GradientNoiseKernel }, "Noise");
+  registry.AddKernel({ "Value Noise", { { "Scale", 8.0f }, { "Seed", 0 } }, Noise::ValueNoiseKernel }, "Noise");
+  registry.AddKernel({ "Simplex Noise", { { "Scale", 8.0f }, { "Seed", 0 } }, Noise::SimplexNoiseKernel }, "Noise");
+  registry.AddKernel(
+      { "Worley Noise", { { "Scale", 8.0f }, { "Seed", 0 }, { "Jitter", 1.0f } }, Noise::WorleyNoiseKernel }, "Noise");
+  registry.AddKernel({ "Fractal Noise",
+                       { { "Scale", 4.0f },
+                         { "Seed", 0 },
+                         // Gradient, Value, Simplex or Worley
+                         { "Basis", 0 },
+                         { "Octaves", 5 },
+                         { "Lacunarity", 2.0f },
+                         { "Gain", 0.5f },
+                         { "Ridged", false } },
+                       Noise::FractalNoiseKernel },
+                     "Noise");
+  // Keyed by its node, so two White Noise nodes with the same seed still differ
+  registry.AddKernel(
+      { "White Noise", { { "Seed", 0 }, { "Color", false } }, Noise::WhiteNoiseKernel, 0, nullptr, nullptr, true },
+      "Noise");
+  registry.AddKernel({ "Output", { { "Input", SocketValue::Color(0.0f, 0.0f, 0.0f) } }, OutputKernel }, "Output");
+  // Radii are in pixels of a 1024 wide bake, see Filters::ScaleRadius
+  registry.AddKernel({ "Blur",
+                       { { "Input", 0.0f },
+                         { "Radius", 4.0f },
+                         // Gaussian or Box
+                         { "Mode", 0 } },
+                       Filters::BlurKernel, 0, Filters::BlurRadius },
+                     "Filters");
+  registry.AddKernel({ "Sharpen",
+                       { { "Input", 0.0f }, { "Amount", 1.0f }, { "Radius", 2.0f } },
+                       Filters::SharpenKernel, 0, Filters::SharpenRadius },
+                     "Filters");
+  registry.AddKernel(
+      { "Height To Normal", { { "Height", 0.0f }, { "Strength", 1.0f } }, Filters::HeightToNormalKernel, 1 },
+      "Filters");
+  registry.AddKernel({ "Ambient Occlusion",
+                       { { "Height", 0.0f }, { "Radius", 16.0f }, { "Strength", 4.0f } },
+                       Filters::AmbientOcclusionKernel, 0, Filters::AmbientOcclusionRadius },
+                     "Filters");
+  registry.AddKernel({ "Edge Detect", { { "Input", 0.0f }, { "Strength", 1.0f } }, Filters::EdgeDetectKernel, 1 },
+                     "Filters");
+  // Id of a decoded image, see AddBitmap. Unknown ids are transparent black.
+  registry.AddKernel({ "Bitmap", { { "Asset", 0 } }, BitmapKernel, 0, nullptr, BitmapProvide }, "Inputs");
+
+  registry.AddPreset("Vertical Gradient", "Gradient", { { "Vertical", true } });
+  registry.AddPreset("Fine Checker", "Checker", { { "Scale", 32 } });
+  registry.AddPreset("Ridged Noise", "Fractal Noise", { { "Ridged", true }, { "Octaves", 6 } });
+  registry.AddPreset("Cells", "Fractal Noise", { { "Basis", 3 }, { "Octaves", 1 }, { "Scale", 8.0f } });
+  registry.AddPreset("Box Blur", "Blur", { { "Mode", 1 } });
+}
+
+Pixel ToPixel(const SocketValue& value)
+{
+  const float* data = value.Data.Floats;
+  switch (value.Type) {
+    case SocketType::Bool:
+    case SocketType::Int:
+    case SocketType::Float: {
+      float scalar = value.AsFloat();
+      return { scalar, scalar, scalar, 1.0f };
+    }
+    case SocketType::Vec2:
+      return { data[0], data[1], 0.0f, 1.0f };
+    case SocketType::Vec3:
+      return { data[0], data[1], data[2], 1.0f };
+    case SocketType::Vec4:
+    case SocketType::Color:
+    case SocketType::Image:
+      break;
+  }
+  return { data[0], data[1], data[2], data[3] };
+}
+
+} // namespace Texturia
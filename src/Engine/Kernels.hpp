@@ -0,0 +1,130 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Image.hpp"
+#include "Nodes.hpp"
+
+#include <span>
+#include <string_view>
+
+namespace Texturia {
+
+struct KernelInput {
+  // Result of the linked upstream node, nullptr when the socket is not linked
+  const Image* Source = nullptr;
+  // Value of the socket itself, used when it is not linked
+  Pixel Constant;
+
+  inline Pixel Sample(int32_t x, int32_t y) const { return Source ? Source->Sample(x, y) : Constant; }
+};
+
+struct KernelContext {
+  // Region of Output the kernel has to write, it must not write outside of it
+  Rect Tile;
+  // Resolution of the whole bake, used to compute normalized coordinates
+  uint32_t Width, Height;
+  std::span<const KernelInput> Inputs;
+  Image* Output;
+  // Hash of the UUID of the node, generators combine it with their seed into the key of their random numbers (see
+  // Engine/Random.hpp)
+  uint64_t NodeKey = 0;
+};
+
+using KernelFunction = void (*)(const KernelContext& context);
+// Radius of kernels that depends on the values of their sockets or the resolution of the bake
+using RadiusFunction = int32_t (*)(std::span<const Pixel> constants, uint32_t width, uint32_t height);
+// Image of a whole bake of width x height that a kernel already has, nullptr if the kernel has to run
+using ProvideFunction = Frameio::Ref<const Image> (*)(std::span<const Pixel> constants, uint32_t width,
+                                                      uint32_t height);
+
+struct SocketSchema {
+  const char* Label;
+  // Also defines the type of the socket
+  SocketValue Default;
+};
+
+struct NodeKernel {
+  const char* Type;
+  std::vector<SocketSchema> Inputs;
+  KernelFunction Run;
+  // How far around a pixel the kernel reads its inputs, 0 for point-wise kernels
+  int32_t Radius = 0;
+  // Replaces Radius if set, see EvaluationStep::GetRadius
+  RadiusFunction GetRadius = nullptr;
+  // Optional, lets consumers read an existing image instead of running the kernel, see EvaluationStep::Provide
+  ProvideFunction Provide = nullptr;
+  // Whether the result depends on KernelContext::NodeKey, which makes it part of EvaluationStep::Hash
+  bool KeyedByNode = false;
+};
+
+// Shorthands for GetNodeRegistry (see Engine/NodeRegistry.hpp), nullptr for unknown types and presets
+const NodeKernel* FindKernel(std::string_view type);
+
+// Creates a node with the sockets of the kernel or preset registered as type
+Node CreateNode(const std::string& type, const std::string& label = "", Frameio::UUID uuid = Frameio::UUID());
+
+// Scalars are broadcast to gray with full alpha, vectors fill up with 0 and full alpha
+Pixel ToPixel(const SocketValue& value);
+
+// Accessors for point-wise kernels. An input is either a constant or a row of an image, kernels are written as
+// templates over the accessor types and instantiated for every combination (see DispatchInputs), so a kernel never
+// reads a whole buffer for a constant socket and the compiler can vectorize the row loops over the planar channels.
+struct ConstantInput {
+  float Values[Image::Channels];
+
+  explicit ConstantInput(const Pixel& value) : Values{ value.R, value.G, value.B, value.A } {}
+  inline void BeginRow(int32_t, int32_t) {}
+  inline float Load(uint32_t channel, int32_t) const { return Values[channel]; }
+};
+
+struct ImageInput {
+  const Image* Source;
+  const float* Rows[Image::Channels];
+
+  explicit ImageInput(const Image& source) : Source(&source) {}
+  inline void BeginRow(int32_t x, int32_t y)
+  {
+    for (uint32_t channel = 0; channel < Image::Channels; channel++) Rows[channel] = Source->GetPointer(channel, x, y);
+  }
+  inline float Load(uint32_t channel, int32_t i) const { return Rows[channel][i]; }
+};
+
+template <size_t Index, size_t Count, typename Function, typename... Accessors>
+inline void DispatchInputs(const KernelContext& context, Function& function, Accessors... accessors)
+{
+  if constexpr (Index == Count) {
+    function(accessors...);
+  } else {
+    const KernelInput& input = context.Inputs[Index];
+    if (input.Source) DispatchInputs<Index + 1, Count>(context, function, accessors..., ImageInput(*input.Source));
+    else DispatchInputs<Index + 1, Count>(context, function, accessors..., ConstantInput(input.Constant));
+  }
+}
+
+// One row of a tile of the output, Data[channel][i] is the pixel (X + i, Y)
+struct OutputRow {
+  float* Data[Image::Channels];
+  int32_t X, Y, Width;
+};
+
+// Calls function(row, accessors...) once per row of the tile, with the first InputCount inputs resolved to
+// ConstantInput or ImageInput accessors that are positioned at the start of the row.
+template <size_t InputCount, typename Function>
+inline void ForEachRow(const KernelContext& context, Function function)
+{
+  auto rows = [&](auto... inputs) {
+    const Rect& tile = context.Tile;
+    OutputRow row = { {}, tile.X, tile.Y, tile.Width };
+    for (; row.Y < tile.Bottom(); row.Y++) {
+      for (uint32_t channel = 0; channel < Image::Channels; channel++) {
+        row.Data[channel] = context.Output->GetPointer(channel, tile.X, row.Y);
+      }
+      (inputs.BeginRow(tile.X, row.Y), ...);
+      function(row, inputs...);
+    }
+  };
+  DispatchInputs<0, InputCount>(context, rows);
+}
+
+} // namespace Texturia
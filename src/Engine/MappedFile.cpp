@@ -0,0 +1,108 @@
+#include "Engine/MappedFile.hpp"
+
+#include <utility>
+
+#ifdef TX_PLATFORM_WINDOWS
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace Texturia {
+
+MappedFile::~MappedFile()
+{
+  Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+  *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+  if (this == &other) return *this;
+  Close();
+  m_Data = std::exchange(other.m_Data, nullptr);
+  m_Size = std::exchange(other.m_Size, 0);
+  m_Open = std::exchange(other.m_Open, false);
+#ifdef TX_PLATFORM_WINDOWS
+  m_File = std::exchange(other.m_File, nullptr);
+  m_Mapping = std::exchange(other.m_Mapping, nullptr);
+#endif
+  return *this;
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+  Close();
+#ifdef TX_PLATFORM_WINDOWS
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+  m_File = file;
+  m_Open = true;
+  if (size.QuadPart == 0) return true;
+
+  m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  const void* view = m_Mapping ? MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!view) {
+    Close();
+    return false;
+  }
+  m_Data = (const std::byte*)view;
+  m_Size = (size_t)size.QuadPart;
+#else
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) return false;
+
+  struct stat status;
+  if (fstat(file, &status) != 0) {
+    close(file);
+    return false;
+  }
+  m_Open = true;
+  if (status.st_size > 0) {
+    // The mapping keeps its own reference to the file
+    void* view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED) {
+      close(file);
+      m_Open = false;
+      return false;
+    }
+    m_Data = (const std::byte*)view;
+    m_Size = (size_t)status.st_size;
+  }
+  close(file);
+#endif
+  return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef TX_PLATFORM_WINDOWS
+  if (m_Data) UnmapViewOfFile(m_Data);
+  if (m_Mapping) CloseHandle(m_Mapping);
+  if (m_File) CloseHandle(m_File);
+  m_Mapping = m_File = nullptr;
+#else
+  if (m_Data) munmap((void*)m_Data, m_Size);
+#endif
+  m_Data = nullptr;
+  m_Size = 0;
+  m_Open = false;
+}
+
+} // namespace Texturia
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include <cstddef>
+#include <span>
+
+namespace Texturia {
+
+// Read only view of a whole file through the page cache, nothing is read before it is touched
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Returns false if the file can not be opened, empty files map to an empty view
+  bool Open(const std::string& path);
+  void Close();
+
+  inline bool IsOpen() const { return m_Open; }
+  inline std::span<const std::byte> GetData() const { return { m_Data, m_Size }; }
+
+private:
+  const std::byte* m_Data = nullptr;
+  size_t m_Size = 0;
+  bool m_Open = false;
+#ifdef TX_PLATFORM_WINDOWS
+  void* m_File = nullptr;
+  void* m_Mapping = nullptr;
+#endif
+};
+
+} // namespace Texturia
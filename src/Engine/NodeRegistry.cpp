@@ -0,0 +1,242 @@
+#include "Engine/NodeRegistry.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <algorithm>
+
+namespace Texturia {
+
+namespace {
+
+// Lowered ASCII without leading, trailing and repeated spaces, names and queries are compared in this form
+std::string ToSearchKey(std::string_view text)
+{
+  std::string key;
+  key.reserve(text.size());
+  for (char c : text) {
+    if (c == ' ' || c == '\t') {
+      if (!key.empty() && key.back() != ' ') key += ' ';
+    } else {
+      key += (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    }
+  }
+  if (!key.empty() && key.back() == ' ') key.pop_back();
+  return key;
+}
+
+// Higher is better, 0 if query is not part of key. The best occurrence counts, e.g. the one at the start of a word.
+int32_t GetSubstringScore(const std::string& key, std::string_view query)
+{
+  if (key == query) return 4000;
+  int32_t best = 0;
+  for (size_t at = key.find(query); at != std::string::npos; at = key.find(query, at + 1)) {
+    int32_t score = 1000;
+    if (at == 0) score = 3000;
+    else if (key[at - 1] == ' ') score = 2000;
+    best = std::max(best, score - (int32_t)std::min<size_t>(at, 999));
+  }
+  return best;
+}
+
+// Characters of query in order but with gaps, e.g. "grno" in "gradient noise". Every skipped character costs a point,
+// every match at the start of a word gains some. 0 if key does not contain them in order.
+int32_t GetScatteredScore(const std::string& key, std::string_view query)
+{
+  int32_t score = 500;
+  size_t next = 0;
+  for (char c : query) {
+    const size_t at = key.find(c, next);
+    if (at == std::string::npos) return 0;
+    score -= (int32_t)(at - next);
+    if (at == 0 || key[at - 1] == ' ') score += 8;
+    next = at + 1;
+  }
+  return std::clamp(score, 1, 999);
+}
+
+} // namespace
+
+Node NodeType::Create(const std::string& label, Frameio::UUID uuid) const
+{
+  std::vector<NodeSocket> sockets;
+  for (const SocketSchema& input : Kernel->Inputs) sockets.push_back(NodeSocket(input.Label, input.Default));
+  for (const auto& [socket, value] : Values) sockets[socket].Value = value;
+  return Node(label.empty() ? Name : label, Kernel->Type, std::move(sockets), uuid);
+}
+
+const NodeType* NodeRegistry::AddKernel(NodeKernel kernel, std::string category)
+{
+  std::unique_lock lock(m_Mutex);
+  if (m_Names.contains(std::string_view(kernel.Type))) return nullptr;
+  const NodeKernel& stored = m_Kernels.emplace_back(std::move(kernel));
+  return Add({ stored.Type, std::move(category), &stored, {} });
+}
+
+const NodeType* NodeRegistry::AddPreset(std::string name, std::string_view baseType,
+                                        const std::vector<std::pair<std::string, SocketValue>>& values,
+                                        std::string category)
+{
+  std::unique_lock lock(m_Mutex);
+  auto base = m_Names.find(baseType);
+  if (m_Names.contains(std::string_view(name)) || base == m_Names.end()) return nullptr;
+
+  NodeType preset = { std::move(name), std::move(category), m_Types[base->second].Kernel, {} };
+  const std::vector<SocketSchema>& inputs = preset.Kernel->Inputs;
+  for (const auto& [label, value] : values) {
+    auto input = std::find_if(inputs.begin(), inputs.end(), [&](const SocketSchema& schema) {
+      return label == schema.Label;
+    });
+    if (input == inputs.end()) return nullptr;
+    preset.Values.push_back({ (uint32_t)(input - inputs.begin()), value });
+  }
+  return Add(std::move(preset));
+}
+
+const NodeType* NodeRegistry::Add(NodeType type)
+{
+  const uint32_t index = (uint32_t)m_Types.size();
+  const NodeType& stored = m_Types.emplace_back(std::move(type));
+  m_Names.emplace(stored.Name, index);
+
+  // Indices only grow, so the lists stay sorted. Pairs that repeat within the name are listed once.
+  const std::string& key = m_Keys.emplace_back(ToSearchKey(stored.Name));
+  for (size_t i = 0; i + 1 < key.size(); i++) {
+    std::vector<uint32_t>& types = m_Bigrams[GetBigram(key[i], key[i + 1])];
+    if (types.empty() || types.back() != index) types.push_back(index);
+  }
+  return &stored;
+}
+
+uint16_t NodeRegistry::GetBigram(char first, char second)
+{
+  return (uint16_t)((uint8_t)first << 8 | (uint8_t)second);
+}
+
+const NodeType* NodeRegistry::Find(std::string_view name) const
+{
+  std::shared_lock lock(m_Mutex);
+  auto found = m_Names.find(name);
+  return found == m_Names.end() ? nullptr : &m_Types[found->second];
+}
+
+const NodeKernel* NodeRegistry::FindKernel(std::string_view type) const
+{
+  const NodeType* nodeType = Find(type);
+  return nodeType && !nodeType->IsPreset() ? nodeType->Kernel : nullptr;
+}
+
+uint32_t NodeRegistry::GetTypeCount() const
+{
+  std::shared_lock lock(m_Mutex);
+  return (uint32_t)m_Types.size();
+}
+
+const NodeType& NodeRegistry::GetType(uint32_t index) const
+{
+  std::shared_lock lock(m_Mutex);
+  FR_ASSERT(index < m_Types.size(), "There is no node type " + std::to_string(index) + "!");
+  return m_Types[index];
+}
+
+std::vector<const NodeKernel*> NodeRegistry::GetKernels() const
+{
+  std::shared_lock lock(m_Mutex);
+  std::vector<const NodeKernel*> kernels;
+  for (const NodeKernel& kernel : m_Kernels) kernels.push_back(&kernel);
+  return kernels;
+}
+
+std::vector<const NodeType*> NodeRegistry::Search(std::string_view query, size_t limit) const
+{
+  const std::string key = ToSearchKey(query);
+  std::shared_lock lock(m_Mutex);
+  std::vector<const NodeType*> results;
+  if (key.empty()) {
+    for (size_t i = 0; i < std::min(limit, m_Types.size()); i++) results.push_back(&m_Types[i]);
+    return results;
+  }
+
+  struct Match {
+    int32_t Score;
+    uint32_t Type;
+  };
+  std::vector<Match> matches;
+  std::vector<bool> matched(m_Types.size(), false);
+  auto addSubstring = [&](uint32_t type) {
+    if (int32_t score = GetSubstringScore(m_Keys[type], key)) {
+      matches.push_back({ score, type });
+      matched[type] = true;
+    }
+  };
+
+  if (key.size() == 1) {
+    for (uint32_t type = 0; type < m_Types.size(); type++) addSubstring(type);
+  } else {
+    // A name that contains the query contains every pair of it, the shortest list bounds the candidates
+    std::vector<const std::vector<uint32_t>*> lists;
+    for (size_t i = 0; i + 1 < key.size(); i++) {
+      auto found = m_Bigrams.find(GetBigram(key[i], key[i + 1]));
+      if (found == m_Bigrams.end()) {
+        lists.clear();
+        break;
+      }
+      lists.push_back(&found->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+    for (size_t i = 0; !lists.empty() && i < lists[0]->size(); i++) {
+      const uint32_t type = (*lists[0])[i];
+      const bool inAll = std::all_of(lists.begin() + 1, lists.end(), [&](const std::vector<uint32_t>* list) {
+        return std::binary_search(list->begin(), list->end(), type);
+      });
+      if (inAll) addSubstring(type);
+    }
+  }
+
+  // Only typos and abbreviations get here, the scan stops being needed once the substrings fill the results
+  if (matches.size() < limit) {
+    for (uint32_t type = 0; type < m_Types.size(); type++) {
+      if (matched[type]) continue;
+      if (int32_t score = GetScatteredScore(m_Keys[type], key)) matches.push_back({ score, type });
+    }
+  }
+
+  // Shorter names first among equal scores, they are closer to the query
+  auto better = [&](const Match& a, const Match& b) {
+    if (a.Score != b.Score) return a.Score > b.Score;
+    if (m_Keys[a.Type].size() != m_Keys[b.Type].size()) return m_Keys[a.Type].size() < m_Keys[b.Type].size();
+    return a.Type < b.Type;
+  };
+  const size_t count = std::min(limit, matches.size());
+  std::partial_sort(matches.begin(), matches.begin() + count, matches.end(), better);
+  for (size_t i = 0; i < count; i++) results.push_back(&m_Types[matches[i].Type]);
+  return results;
+}
+
+NodeRegistry& GetNodeRegistry()
+{
+  static NodeRegistry s_Registry;
+  static const bool s_Builtins = (AddBuiltinNodeTypes(s_Registry), true);
+  (void)s_Builtins;
+  return s_Registry;
+}
+
+NodeRegistration::NodeRegistration(NodeKernel kernel, const char* category)
+{
+  const std::string type = kernel.Type;
+  const NodeType* added = GetNodeRegistry().AddKernel(std::move(kernel), category);
+  FR_ASSERT(added, "Node type " + type + " is registered twice!");
+}
+
+const NodeKernel* FindKernel(std::string_view type)
+{
+  return GetNodeRegistry().FindKernel(type);
+}
+
+Node CreateNode(const std::string& type, const std::string& label, Frameio::UUID uuid)
+{
+  const NodeType* nodeType = GetNodeRegistry().Find(type);
+  FR_ASSERT(nodeType, "There is no node type " + type + "!");
+  return nodeType->Create(label, uuid);
+}
+
+} // namespace Texturia
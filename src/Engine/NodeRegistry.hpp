@@ -0,0 +1,97 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Kernels.hpp"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace Texturia {
+
+// Something the add node popup offers: a kernel, or a preset that creates a node of a kernel with other socket values
+struct NodeType {
+  // Type of the kernel, or the name of the preset
+  std::string Name;
+  std::string Category;
+  const NodeKernel* Kernel = nullptr;
+  // Presets only, socket index and the value that replaces the default of the kernel
+  std::vector<std::pair<uint32_t, SocketValue>> Values;
+
+  inline bool IsPreset() const { return Name != Kernel->Type; }
+  // Nodes of presets are nodes of their kernel, only the socket values differ. An empty label uses the name.
+  Node Create(const std::string& label = "", Frameio::UUID uuid = Frameio::UUID()) const;
+};
+
+// Maps names to node types and kernels, and finds them by what is typed into the add node popup. Types are never
+// removed and their addresses never change, so pointers to them can be kept. Lookups may run on any thread while
+// another one adds types.
+class NodeRegistry {
+public:
+  // Search results past this many are not returned, the popup never shows more
+  static constexpr size_t DefaultSearchLimit = 64;
+
+  NodeRegistry() = default;
+  NodeRegistry(const NodeRegistry&) = delete;
+  NodeRegistry& operator=(const NodeRegistry&) = delete;
+
+  // Returns nullptr if the name is taken
+  const NodeType* AddKernel(NodeKernel kernel, std::string category);
+  // values maps socket labels of the base kernel to their new values. Returns nullptr if the name is taken, there is no
+  // kernel baseType or it has no socket with one of the labels.
+  const NodeType* AddPreset(std::string name, std::string_view baseType,
+                            const std::vector<std::pair<std::string, SocketValue>>& values,
+                            std::string category = "Presets");
+
+  const NodeType* Find(std::string_view name) const;
+  const NodeKernel* FindKernel(std::string_view type) const;
+
+  // Types are indexed in the order they were added
+  uint32_t GetTypeCount() const;
+  const NodeType& GetType(uint32_t index) const;
+  // Every kernel in the order it was added, presets are left out
+  std::vector<const NodeKernel*> GetKernels() const;
+
+  // Types whose name contains query or its characters in order, case insensitive. Whole names come first, then
+  // prefixes, then matches at the start of a word, then anywhere and last the scattered ones. An empty query lists
+  // every type in the order they were added.
+  std::vector<const NodeType*> Search(std::string_view query, size_t limit = DefaultSearchLimit) const;
+
+private:
+  struct StringHash {
+    using is_transparent = void;
+    inline size_t operator()(std::string_view string) const { return std::hash<std::string_view>()(string); }
+  };
+
+  // Under an exclusive lock
+  const NodeType* Add(NodeType type);
+  static uint16_t GetBigram(char first, char second);
+
+  mutable std::shared_mutex m_Mutex;
+  // Deques never move their elements
+  std::deque<NodeKernel> m_Kernels;
+  std::deque<NodeType> m_Types;
+  std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> m_Names;
+
+  // Search index: the lowered names and for every pair of adjacent characters the types whose name contains it, in
+  // ascending order. Substring queries only check the types that have all of their pairs.
+  std::vector<std::string> m_Keys;
+  std::unordered_map<uint16_t, std::vector<uint32_t>> m_Bigrams;
+};
+
+// Holds every built in kernel and preset from the first call on, in a fixed order. More types can be added at any
+// time, e.g. with NodeRegistration.
+NodeRegistry& GetNodeRegistry();
+// Defined in Engine/Kernels.cpp, called by GetNodeRegistry
+void AddBuiltinNodeTypes(NodeRegistry& registry);
+
+// Adds a kernel to GetNodeRegistry during static initialization, for node types that live outside of the engine:
+//   static const NodeRegistration s_Emboss({ "Emboss", { { "Input", 0.0f } }, EmbossKernel, 1 }, "Filters");
+struct NodeRegistration {
+  NodeRegistration(NodeKernel kernel, const char* category);
+};
+
+} // namespace Texturia
@@ -0,0 +1,125 @@
+#include "Engine/Noise/Noise.hpp"
+
+#include "Engine/Random.hpp"
+
+#include <algorithm>
+
+namespace Texturia::Noise {
+
+// Defined in NoiseRow.inl, once per translation unit compiled for an instruction set
+namespace Generic {
+void GenerateRow(const Settings& settings, int32_t x, float step, float y, float* output, int32_t count);
+}
+#ifdef TX_SIMD_X86
+namespace SSE42 {
+void GenerateRow(const Settings& settings, int32_t x, float step, float y, float* output, int32_t count);
+}
+namespace AVX2 {
+void GenerateRow(const Settings& settings, int32_t x, float step, float y, float* output, int32_t count);
+}
+namespace AVX512 {
+void GenerateRow(const Settings& settings, int32_t x, float step, float y, float* output, int32_t count);
+}
+#endif
+
+void GenerateRow(const Settings& settings, int32_t x, float step, float y, float* output, int32_t count,
+                 SimdLevel level)
+{
+  switch (level) {
+#ifdef TX_SIMD_X86
+    case SimdLevel::AVX512:
+      return AVX512::GenerateRow(settings, x, step, y, output, count);
+    case SimdLevel::AVX2:
+      return AVX2::GenerateRow(settings, x, step, y, output, count);
+    case SimdLevel::SSE42:
+      return SSE42::GenerateRow(settings, x, step, y, output, count);
+#endif
+    default:
+      return Generic::GenerateRow(settings, x, step, y, output, count);
+  }
+}
+
+namespace {
+
+// Noise parameters are read from the socket constants, linked inputs are ignored. Every kernel starts with a Scale
+// input, which is the number of lattice cells across the width of the bake.
+void NoiseKernel(const KernelContext& context, const Settings& settings)
+{
+  const Rect& tile = context.Tile;
+  const float scale = context.Inputs[0].Constant.R;
+  // Square cells, so y is scaled by the width as well
+  const float step = scale / context.Width;
+  const SimdLevel level = GetSimdLevel();
+
+  for (int32_t y = tile.Y; y < tile.Bottom(); y++) {
+    float* row = context.Output->GetPointer(0, tile.X, y);
+    GenerateRow(settings, tile.X, step, (y + 0.5f) * step, row, tile.Width, level);
+    for (uint32_t c = 1; c < 3; c++) std::copy(row, row + tile.Width, context.Output->GetPointer(c, tile.X, y));
+    std::fill_n(context.Output->GetPointer(3, tile.X, y), tile.Width, 1.0f);
+  }
+}
+
+Settings BasisSettings(const KernelContext& context, Basis basis)
+{
+  Settings settings;
+  settings.Basis = basis;
+  settings.Seed = (int32_t)context.Inputs[1].Constant.R;
+  return settings;
+}
+
+} // namespace
+
+void GradientNoiseKernel(const KernelContext& context)
+{
+  NoiseKernel(context, BasisSettings(context, Basis::Gradient));
+}
+
+void ValueNoiseKernel(const KernelContext& context)
+{
+  NoiseKernel(context, BasisSettings(context, Basis::Value));
+}
+
+void SimplexNoiseKernel(const KernelContext& context)
+{
+  NoiseKernel(context, BasisSettings(context, Basis::Simplex));
+}
+
+void WorleyNoiseKernel(const KernelContext& context)
+{
+  Settings settings = BasisSettings(context, Basis::Worley);
+  settings.Jitter = std::clamp(context.Inputs[2].Constant.R, 0.0f, 1.0f);
+  NoiseKernel(context, settings);
+}
+
+void FractalNoiseKernel(const KernelContext& context)
+{
+  Settings settings = BasisSettings(context, (Basis)std::clamp((int32_t)context.Inputs[2].Constant.R, 0, 3));
+  settings.Octaves = std::clamp((int32_t)context.Inputs[3].Constant.R, 1, 16);
+  settings.Lacunarity = context.Inputs[4].Constant.R;
+  settings.Gain = context.Inputs[5].Constant.R;
+  settings.Ridged = context.Inputs[6].Constant.R != 0.0f;
+  NoiseKernel(context, settings);
+}
+
+void WhiteNoiseKernel(const KernelContext& context)
+{
+  const PixelRandom random(GetRandomKey(context.NodeKey, (int32_t)context.Inputs[0].Constant.R));
+  const bool color = context.Inputs[1].Constant.R != 0.0f;
+  const Rect& tile = context.Tile;
+
+  for (int32_t y = tile.Y; y < tile.Bottom(); y++) {
+    float* rows[3];
+    for (uint32_t c = 0; c < 3; c++) rows[c] = context.Output->GetPointer(c, tile.X, y);
+    for (int32_t i = 0; i < tile.Width; i++) {
+      if (color) {
+        const std::array<uint32_t, 4> values = random.Generate(tile.X + i, y);
+        for (uint32_t c = 0; c < 3; c++) rows[c][i] = ToUnitFloat(values[c]);
+      } else {
+        rows[0][i] = rows[1][i] = rows[2][i] = ToUnitFloat(random.Hash(tile.X + i, y));
+      }
+    }
+    std::fill_n(context.Output->GetPointer(3, tile.X, y), tile.Width, 1.0f);
+  }
+}
+
+} // namespace Texturia::Noise
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Kernels.hpp"
+#include "Engine/Simd.hpp"
+
+#include <cstdint>
+
+namespace Texturia::Noise {
+
+enum class Basis : int32_t {
+  Gradient,
+  Value,
+  Simplex,
+  Worley
+};
+
+struct Settings {
+  Noise::Basis Basis = Noise::Basis::Gradient;
+  int32_t Seed = 0;
+  // Fractal sum, a single octave is the plain basis
+  int32_t Octaves = 1;
+  float Lacunarity = 2.0f;
+  float Gain = 0.5f;
+  bool Ridged = false;
+  // How far Worley feature points may move away from their cell corner, in [0, 1]
+  float Jitter = 1.0f;
+};
+
+// Writes count noise values in [0, 1] to output, sampled at ((x + i + 0.5) * step, y) in noise space where one unit is
+// one lattice cell and x is the first pixel column. Runs the implementation compiled for level, which has to be
+// supported by the CPU.
+void GenerateRow(
+    const Settings& settings, int32_t x, float step, float y, float* output, int32_t count, SimdLevel level);
+inline void GenerateRow(const Settings& settings, int32_t x, float step, float y, float* output, int32_t count)
+{
+  GenerateRow(settings, x, step, y, output, count, GetSimdLevel());
+}
+
+// Node kernels, registered in Engine/Kernels.cpp
+void GradientNoiseKernel(const KernelContext& context);
+void ValueNoiseKernel(const KernelContext& context);
+void SimplexNoiseKernel(const KernelContext& context);
+void WorleyNoiseKernel(const KernelContext& context);
+void FractalNoiseKernel(const KernelContext& context);
+// Independent random values per pixel, keyed by the node, its seed and the pixel (see PixelRandom)
+void WhiteNoiseKernel(const KernelContext& context);
+
+} // namespace Texturia::Noise
@@ -0,0 +1,3 @@
+// Compiled with -mavx512f -mavx512dq, see CMakeLists.txt
+#define TX_NOISE_TARGET AVX512
+#include "Engine/Noise/NoiseRow.inl"
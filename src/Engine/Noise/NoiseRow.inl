@@ -0,0 +1,221 @@
+// Noise implementation, included once per instruction set by NoiseGeneric.cpp, NoiseSSE42.cpp, NoiseAVX2.cpp and
+// NoiseAVX512.cpp with TX_NOISE_TARGET set to the namespace to put it in. Those files are compiled with the matching
+// -m flags, so the per pixel loops below turn into SSE, AVX2 or AVX-512 code processing 4, 8 or 16 pixels at once.
+//
+// Everything in here is branch free straight line arithmetic on floats and 32 bit integers, with lattice hashing
+// instead of permutation tables, so the compiler can vectorize the loops without gathers. Calls into the standard
+// library are avoided on purpose: an out of line copy compiled for AVX2 could otherwise be picked by the linker for
+// code running on older CPUs.
+
+#include "Engine/Noise/Noise.hpp"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+  #include <cmath>
+  #define TX_NOISE_SQRT(x) std::sqrt(x)
+  #define TX_NOISE_SIMD_LOOP
+#else
+  #define TX_NOISE_SQRT(x) __builtin_sqrtf(x)
+  #define TX_NOISE_SIMD_LOOP _Pragma("omp simd")
+#endif
+
+namespace Texturia::Noise::TX_NOISE_TARGET {
+
+constexpr uint32_t PrimeX = 501125321;
+constexpr uint32_t PrimeY = 1136930381;
+
+inline float Floor(float value)
+{
+  float truncated = (float)(int32_t)value;
+  return value < truncated ? truncated - 1.0f : truncated;
+}
+
+inline float Min(float a, float b)
+{
+  return a < b ? a : b;
+}
+
+inline float Clamp01(float value)
+{
+  return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+inline float Lerp(float a, float b, float t)
+{
+  return a + (b - a) * t;
+}
+
+// 6t^5 - 15t^4 + 10t^3, zero first and second derivative at the lattice points
+inline float Quintic(float t)
+{
+  return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+// Coordinates are premultiplied by PrimeX and PrimeY, so neighbouring cells only need an addition. All of this is
+// unsigned, the products are meant to wrap around.
+inline uint32_t Hash(int32_t seed, uint32_t xPrimed, uint32_t yPrimed)
+{
+  uint32_t hash = (uint32_t)seed ^ xPrimed ^ yPrimed;
+  hash *= 0x27D4EB2Du;
+  return hash ^ (hash >> 15);
+}
+
+// Maps the hash to [-1, 1]
+inline float HashToFloat(uint32_t hash)
+{
+  return (float)(int32_t)hash * (1.0f / 2147483648.0f);
+}
+
+// Dot product with one of eight gradients (±1, ±2), (±2, ±1), picked by the low bits of the hash
+inline float Gradient(uint32_t hash, float x, float y)
+{
+  float u = hash & 4 ? y : x;
+  float v = hash & 4 ? x : y;
+  return (hash & 1 ? -u : u) + (hash & 2 ? -2.0f * v : 2.0f * v);
+}
+
+inline float ValueBasis(float x, float y, int32_t seed)
+{
+  float x0f = Floor(x), y0f = Floor(y);
+  uint32_t x0 = (uint32_t)(int32_t)x0f * PrimeX, y0 = (uint32_t)(int32_t)y0f * PrimeY;
+  uint32_t x1 = x0 + PrimeX, y1 = y0 + PrimeY;
+  float tx = Quintic(x - x0f), ty = Quintic(y - y0f);
+
+  float top = Lerp(HashToFloat(Hash(seed, x0, y0)), HashToFloat(Hash(seed, x1, y0)), tx);
+  float bottom = Lerp(HashToFloat(Hash(seed, x0, y1)), HashToFloat(Hash(seed, x1, y1)), tx);
+  return Lerp(top, bottom, ty);
+}
+
+inline float GradientBasis(float x, float y, int32_t seed)
+{
+  float x0f = Floor(x), y0f = Floor(y);
+  uint32_t x0 = (uint32_t)(int32_t)x0f * PrimeX, y0 = (uint32_t)(int32_t)y0f * PrimeY;
+  uint32_t x1 = x0 + PrimeX, y1 = y0 + PrimeY;
+  float fx0 = x - x0f, fy0 = y - y0f;
+  float fx1 = fx0 - 1.0f, fy1 = fy0 - 1.0f;
+  float tx = Quintic(fx0), ty = Quintic(fy0);
+
+  float top = Lerp(Gradient(Hash(seed, x0, y0), fx0, fy0), Gradient(Hash(seed, x1, y0), fx1, fy0), tx);
+  float bottom = Lerp(Gradient(Hash(seed, x0, y1), fx0, fy1), Gradient(Hash(seed, x1, y1), fx1, fy1), tx);
+  // The gradients are not normalized, this brings the result back to about [-1, 1]
+  return Lerp(top, bottom, ty) * (1.0f / 1.6f);
+}
+
+inline float SimplexCorner(uint32_t hash, float x, float y)
+{
+  float t = 0.5f - x * x - y * y;
+  t = t < 0.0f ? 0.0f : t;
+  t *= t;
+  return t * t * Gradient(hash, x, y);
+}
+
+inline float SimplexBasis(float x, float y, int32_t seed)
+{
+  constexpr float F2 = 0.36602540378f; // (sqrt(3) - 1) / 2
+  constexpr float G2 = 0.21132486540f; // (3 - sqrt(3)) / 6
+
+  float skew = (x + y) * F2;
+  float i = Floor(x + skew), j = Floor(y + skew);
+  float unskew = (i + j) * G2;
+  float x0 = x - (i - unskew), y0 = y - (j - unskew);
+
+  // Lower or upper triangle of the skewed cell
+  bool lower = x0 > y0;
+  float i1 = lower ? 1.0f : 0.0f, j1 = lower ? 0.0f : 1.0f;
+  float x1 = x0 - i1 + G2, y1 = y0 - j1 + G2;
+  float x2 = x0 - 1.0f + 2.0f * G2, y2 = y0 - 1.0f + 2.0f * G2;
+
+  uint32_t ip = (uint32_t)(int32_t)i * PrimeX, jp = (uint32_t)(int32_t)j * PrimeY;
+  float n0 = SimplexCorner(Hash(seed, ip, jp), x0, y0);
+  float n1 = SimplexCorner(Hash(seed, ip + (lower ? PrimeX : 0u), jp + (lower ? 0u : PrimeY)), x1, y1);
+  float n2 = SimplexCorner(Hash(seed, ip + PrimeX, jp + PrimeY), x2, y2);
+  return (n0 + n1 + n2) * 18.0f;
+}
+
+// Distance to the closest feature point (F1), every cell holds one point jittered away from its corner
+inline float WorleyBasis(float x, float y, int32_t seed, float jitter)
+{
+  float xf = Floor(x), yf = Floor(y);
+  uint32_t xc = (uint32_t)(int32_t)xf * PrimeX, yc = (uint32_t)(int32_t)yf * PrimeY;
+  float fx = x - xf, fy = y - yf;
+
+  float closest = 8.0f;
+  for (int32_t dy = -1; dy <= 1; dy++) {
+    for (int32_t dx = -1; dx <= 1; dx++) {
+      uint32_t hash = Hash(seed, xc + (uint32_t)dx * PrimeX, yc + (uint32_t)dy * PrimeY);
+      float px = (float)dx + (float)(hash & 0xFFFF) * (jitter / 65535.0f) - fx;
+      float py = (float)dy + (float)(hash >> 16) * (jitter / 65535.0f) - fy;
+      closest = Min(closest, px * px + py * py);
+    }
+  }
+  // F1 is at most sqrt(2) for full jitter, map it to [-1, 1] like the other bases
+  return TX_NOISE_SQRT(closest) * 1.41421356f - 1.0f;
+}
+
+template <Basis B>
+inline float SampleBasis(float x, float y, int32_t seed, float jitter)
+{
+  if constexpr (B == Basis::Gradient) return GradientBasis(x, y, seed);
+  else if constexpr (B == Basis::Value) return ValueBasis(x, y, seed);
+  else if constexpr (B == Basis::Simplex) return SimplexBasis(x, y, seed);
+  else return WorleyBasis(x, y, seed, jitter);
+}
+
+// Octaves are the outer loop so that every pixel loop is straight line code, the fractal sum is accumulated in output
+template <Basis B, bool Ridged>
+inline void Row(const Settings& settings, int32_t x, float step, float y, float* output, int32_t count)
+{
+  const int32_t octaves = settings.Octaves < 1 ? 1 : settings.Octaves;
+  const float jitter = settings.Jitter;
+  float frequency = 1.0f, amplitude = 1.0f, amplitudeSum = 0.0f;
+
+  for (int32_t octave = 0; octave < octaves; octave++) {
+    const int32_t seed = (int32_t)((uint32_t)settings.Seed + (uint32_t)octave);
+    const float octaveStep = step * frequency, octaveY = y * frequency;
+
+    // Computed from the pixel column alone rather than accumulated from the start of the row, so a pixel gets the same
+    // value whichever tile or block it is evaluated in
+    TX_NOISE_SIMD_LOOP
+    for (int32_t i = 0; i < count; i++) {
+      float value = SampleBasis<B>(((float)(x + i) + 0.5f) * octaveStep, octaveY, seed, jitter);
+      if constexpr (Ridged) {
+        value = 1.0f - (value < 0.0f ? -value : value);
+        value *= value;
+      } else {
+        value = value * 0.5f + 0.5f;
+      }
+      // Selected rather than multiplied by 0, output may hold anything before the first octave, NaNs included
+      output[i] = (octave == 0 ? 0.0f : output[i]) + value * amplitude;
+    }
+
+    amplitudeSum += amplitude;
+    frequency *= settings.Lacunarity;
+    amplitude *= settings.Gain;
+  }
+
+  const float normalize = 1.0f / amplitudeSum;
+  TX_NOISE_SIMD_LOOP
+  for (int32_t i = 0; i < count; i++) output[i] = Clamp01(output[i] * normalize);
+}
+
+void GenerateRow(const Settings& settings, int32_t x, float step, float y, float* output, int32_t count)
+{
+  switch (settings.Basis) {
+    case Basis::Gradient:
+      return settings.Ridged ? Row<Basis::Gradient, true>(settings, x, step, y, output, count)
+                             : Row<Basis::Gradient, false>(settings, x, step, y, output, count);
+    case Basis::Value:
+      return settings.Ridged ? Row<Basis::Value, true>(settings, x, step, y, output, count)
+                             : Row<Basis::Value, false>(settings, x, step, y, output, count);
+    case Basis::Simplex:
+      return settings.Ridged ? Row<Basis::Simplex, true>(settings, x, step, y, output, count)
+                             : Row<Basis::Simplex, false>(settings, x, step, y, output, count);
+    case Basis::Worley:
+      return settings.Ridged ? Row<Basis::Worley, true>(settings, x, step, y, output, count)
+                             : Row<Basis::Worley, false>(settings, x, step, y, output, count);
+  }
+}
+
+} // namespace Texturia::Noise::TX_NOISE_TARGET
+
+#undef TX_NOISE_SQRT
+#undef TX_NOISE_SIMD_LOOP
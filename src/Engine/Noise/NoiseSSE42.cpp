@@ -0,0 +1,3 @@
+// Compiled with -msse4.2, see CMakeLists.txt
+#define TX_NOISE_TARGET SSE42
+#include "Engine/Noise/NoiseRow.inl"
@@ -0,0 +1,151 @@
+#include "Engine/Preview.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <cmath>
+#include <utility>
+
+namespace Texturia {
+
+PreviewRenderer::PreviewRenderer(uint32_t threadCount, uint32_t tileSize)
+    : m_TileSize(tileSize),
+      m_Pool(threadCount ? threadCount : std::max(1u, ThreadPool::GetHardwareThreadCount() - 1)),
+      m_Thread(&PreviewRenderer::Run, this)
+{
+}
+
+PreviewRenderer::~PreviewRenderer()
+{
+  {
+    std::lock_guard lock(m_Mutex);
+    m_Stop = true;
+    if (m_Running) m_Running->Cancel();
+  }
+  m_Changed.notify_all();
+  m_Thread.join();
+}
+
+uint64_t PreviewRenderer::Request(EvaluationPlan plan, uint32_t width, uint32_t height,
+                                  std::chrono::steady_clock::time_point editTime)
+{
+  FR_ASSERT(plan.IsValid(), plan.GetError());
+  return Submit({ std::move(plan), nullptr, 0, width, height, 0, editTime, nullptr });
+}
+
+uint64_t PreviewRenderer::Request(Frameio::Ref<const NodesTree> tree, const Frameio::UUID& output, uint32_t width,
+                                  uint32_t height, std::chrono::steady_clock::time_point editTime)
+{
+  return Submit({ EvaluationPlan(), std::move(tree), output, width, height, 0, editTime, nullptr });
+}
+
+uint64_t PreviewRenderer::Submit(Job job)
+{
+  job.Cancellation = std::make_shared<CancellationToken>();
+  uint64_t generation;
+  {
+    std::lock_guard lock(m_Mutex);
+    if (m_Running) m_Running->Cancel();
+    generation = job.Generation = ++m_Generation;
+    job.Profile = m_Profiler;
+    m_Pending = std::move(job);
+  }
+  m_Changed.notify_all();
+  return generation;
+}
+
+void PreviewRenderer::Cancel()
+{
+  std::lock_guard lock(m_Mutex);
+  if (m_Running) m_Running->Cancel();
+  m_Generation++;
+  m_Pending.reset();
+}
+
+void PreviewRenderer::SetProfiler(Profiler* profiler)
+{
+  std::lock_guard lock(m_Mutex);
+  m_Profiler = profiler;
+}
+
+const PreviewLevel* PreviewRenderer::Poll()
+{
+  if (!m_Levels.Update()) return nullptr;
+  const PreviewLevel& level = m_Levels.GetReadSlot();
+  return level.Generation == m_Generation ? &level : nullptr;
+}
+
+void PreviewRenderer::Wait()
+{
+  std::unique_lock lock(m_Mutex);
+  m_Changed.wait(lock, [this] { return !m_Pending && !m_Busy; });
+}
+
+void PreviewRenderer::Run()
+{
+  std::unique_lock lock(m_Mutex);
+  while (true) {
+    m_Changed.wait(lock, [this] { return m_Stop || m_Pending; });
+    if (m_Stop) return;
+
+    Job job = std::move(*m_Pending);
+    m_Pending.reset();
+    m_Running = job.Cancellation;
+    m_Busy = true;
+    lock.unlock();
+    if (job.Tree) {
+      ProfileScope scope(job.Profile, "Build plan", "plan");
+      job.Plan = EvaluationPlan::Build(*job.Tree, job.Output);
+      job.Tree.reset();
+    }
+    if (job.Plan.IsValid()) Refine(job);
+    lock.lock();
+    m_Running.reset();
+    m_Busy = false;
+    m_Changed.notify_all();
+  }
+}
+
+void PreviewRenderer::Refine(const Job& job)
+{
+  uint32_t previousWidth = 0, previousHeight = 0;
+  for (uint32_t divisor : Divisors) {
+    EvaluationSettings settings;
+    settings.Width = (job.Width + divisor - 1) / divisor;
+    settings.Height = (job.Height + divisor - 1) / divisor;
+    settings.TileSize = m_TileSize;
+    settings.Cancellation = job.Cancellation.get();
+    settings.Profile = job.Profile;
+    // Small previews round several levels to the same size
+    if (settings.Width == previousWidth && settings.Height == previousHeight) continue;
+    previousWidth = settings.Width;
+    previousHeight = settings.Height;
+
+    // The slot still holds an older level, whose pixels are reused
+    PreviewLevel& level = m_Levels.GetWriteSlot();
+    level.Divisor = divisor;
+    level.Width = settings.Width;
+    level.Height = settings.Height;
+    level.Generation = job.Generation;
+    level.Pixels.resize((size_t)level.Width * level.Height * Image::Channels);
+    // Chunks are converted as they come in, so a level never exists as floats as a whole
+    auto store = [&](const Image& chunk) {
+      const Rect& region = chunk.GetRegion();
+      for (int32_t y = region.Y; y < region.Bottom(); y++) {
+        uint8_t* row = level.Pixels.data() + ((size_t)y * level.Width + region.X) * Image::Channels;
+        for (uint32_t channel = 0; channel < Image::Channels; channel++) {
+          const float* source = chunk.GetPointer(channel, region.X, y);
+          for (int32_t x = 0; x < region.Width; x++) {
+            row[x * Image::Channels + channel] = (uint8_t)std::lround(std::clamp(source[x], 0.0f, 1.0f) * 255.0f);
+          }
+        }
+      }
+      return true;
+    };
+    if (!EvaluateStreaming(job.Plan, settings, m_Pool, m_Images, m_TileSize, store)) return;
+
+    level.Latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.EditTime).count();
+    m_Levels.Publish();
+  }
+}
+
+} // namespace Texturia
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Evaluator.hpp"
+#include "Engine/ImagePool.hpp"
+#include "Engine/ThreadPool.hpp"
+#include "Engine/TripleBuffer.hpp"
+
+#include <chrono>
+#include <optional>
+
+namespace Texturia {
+
+// One finished level of a preview, ready to be uploaded as a texture
+struct PreviewLevel {
+  // The level has the requested resolution divided by Divisor, rounded up
+  uint32_t Divisor = 1;
+  uint32_t Width = 0, Height = 0;
+  // 8 bit RGBA with values clamped to [0, 1], rows from top to bottom
+  std::vector<uint8_t> Pixels;
+  // Generation of the request the level belongs to
+  uint64_t Generation = 0;
+  // Seconds from the edit (see PreviewRenderer::Request) until the level was done
+  double Latency = 0.0;
+};
+
+// Evaluates a plan on background threads, first at 1/8 of the requested resolution and then refined to 1/4, 1/2 and
+// full resolution, so that an 8K preview shows something right away. Every request cancels the one before it, which
+// stops before its next tile. Finished levels come back through a TripleBuffer, so the thread polling them never
+// waits for the evaluation. Nothing here needs a window or GL context, the caller uploads the levels.
+class PreviewRenderer {
+public:
+  static constexpr uint32_t Divisors[] = { 8, 4, 2, 1 };
+
+  // threadCount 0 uses every hardware thread but one, which is left to the caller
+  explicit PreviewRenderer(uint32_t threadCount = 0, uint32_t tileSize = 64);
+  ~PreviewRenderer();
+
+  PreviewRenderer(const PreviewRenderer&) = delete;
+  PreviewRenderer& operator=(const PreviewRenderer&) = delete;
+
+  // Starts refining plan at width x height, the plan is a snapshot and the tree it was built from may change
+  // right away. editTime is when the edit that led to the request happened, the latency of the levels is measured
+  // from it. Returns the generation of the request.
+  uint64_t Request(EvaluationPlan plan, uint32_t width, uint32_t height,
+                   std::chrono::steady_clock::time_point editTime = std::chrono::steady_clock::now());
+  // Same as above, but the plan for output is built from the snapshot on the background thread, so the caller only
+  // pays for taking the snapshot. Plans that fail to build are dropped like cancelled requests.
+  uint64_t Request(Frameio::Ref<const NodesTree> tree, const Frameio::UUID& output, uint32_t width, uint32_t height,
+                   std::chrono::steady_clock::time_point editTime = std::chrono::steady_clock::now());
+  // Stops the running request, levels it already finished are dropped
+  void Cancel();
+  // Records the evaluations of the following requests into profiler, which has to outlive them. nullptr stops that.
+  void SetProfiler(Profiler* profiler);
+
+  // Finest level finished since the last call or nullptr, levels of requests that were replaced are never returned.
+  // The level stays valid until the next call. Never blocks, but only one thread may poll.
+  const PreviewLevel* Poll();
+  // Blocks until the last request is fully refined or cancelled
+  void Wait();
+
+private:
+  struct Job {
+    EvaluationPlan Plan;
+    // Set if the plan still has to be built
+    Frameio::Ref<const NodesTree> Tree;
+    Frameio::UUID Output = 0;
+    uint32_t Width, Height;
+    uint64_t Generation;
+    std::chrono::steady_clock::time_point EditTime;
+    Frameio::Ref<CancellationToken> Cancellation;
+    Profiler* Profile = nullptr;
+  };
+
+  uint64_t Submit(Job job);
+  void Run();
+  void Refine(const Job& job);
+
+  uint32_t m_TileSize;
+  ThreadPool m_Pool;
+  // Only used by the driver thread, so levels and requests reuse each others intermediate images
+  ImagePool m_Images;
+
+  std::mutex m_Mutex;
+  std::condition_variable m_Changed;
+  std::optional<Job> m_Pending;
+  // Of the job the driver is working on
+  Frameio::Ref<CancellationToken> m_Running;
+  bool m_Busy = false, m_Stop = false;
+  Profiler* m_Profiler = nullptr;
+
+  TripleBuffer<PreviewLevel> m_Levels;
+  // Bumped by every request and cancel, older levels are dropped by Poll
+  std::atomic<uint64_t> m_Generation = 0;
+
+  // Takes jobs from m_Pending and runs them on m_Pool, started last so that everything above already exists
+  std::thread m_Thread;
+};
+
+} // namespace Texturia
@@ -0,0 +1,184 @@
+#include "Engine/Profiler.hpp"
+
+#include "Engine/Json.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace Texturia {
+
+namespace {
+
+std::atomic<uint64_t> s_NextProfilerId = 1;
+
+// Microseconds with nanosecond precision, the unit of the trace format
+void AppendMicroseconds(std::string& out, uint64_t nanoseconds)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%llu.%03llu", (unsigned long long)(nanoseconds / 1000),
+                (unsigned long long)(nanoseconds % 1000));
+  out += buffer;
+}
+
+} // namespace
+
+Profiler::Profiler(bool recording)
+    : m_Id(s_NextProfilerId++), m_Recording(recording), m_Start(std::chrono::steady_clock::now())
+{
+}
+
+Profiler::~Profiler() = default;
+
+Profiler::ThreadBuffer& Profiler::GetThreadBuffer()
+{
+  // Threads mostly record into one profiler, the last buffer is remembered so that only a change needs the lock
+  thread_local uint64_t t_ProfilerId = 0;
+  thread_local ThreadBuffer* t_Buffer = nullptr;
+  if (t_ProfilerId == m_Id) return *t_Buffer;
+
+  std::lock_guard lock(m_Mutex);
+  const std::thread::id thread = std::this_thread::get_id();
+  auto found = std::find_if(m_Buffers.begin(), m_Buffers.end(), [&](const auto& buffer) {
+    return buffer->Thread == thread;
+  });
+  if (found == m_Buffers.end()) {
+    found = m_Buffers.insert(m_Buffers.end(), std::make_unique<ThreadBuffer>());
+    (*found)->Thread = thread;
+    (*found)->Index = (uint32_t)m_Buffers.size() - 1;
+  }
+  t_ProfilerId = m_Id;
+  t_Buffer = found->get();
+  return *t_Buffer;
+}
+
+NodeProfile& Profiler::GetNode(ThreadBuffer& buffer, const Frameio::UUID& node, const char* type)
+{
+  NodeProfile& profile = buffer.Nodes[node];
+  profile.Node = node;
+  profile.Type = type;
+  return profile;
+}
+
+void Profiler::Record(const ProfileEvent& event)
+{
+  ThreadBuffer& buffer = GetThreadBuffer();
+  std::lock_guard lock(buffer.Mutex);
+  if (buffer.Events.size() < MaxEventsPerThread) buffer.Events.push_back(event);
+  else buffer.Dropped++;
+}
+
+void Profiler::AddNodeTime(const Frameio::UUID& node, const char* type, uint64_t nanoseconds, uint64_t pixels,
+                           uint64_t bytesRead)
+{
+  ThreadBuffer& buffer = GetThreadBuffer();
+  std::lock_guard lock(buffer.Mutex);
+  NodeProfile& profile = GetNode(buffer, node, type);
+  profile.Nanoseconds += nanoseconds;
+  profile.Pixels += pixels;
+  profile.BytesRead += bytesRead;
+}
+
+void Profiler::AddNodeAllocation(const Frameio::UUID& node, const char* type, uint64_t bytes)
+{
+  ThreadBuffer& buffer = GetThreadBuffer();
+  std::lock_guard lock(buffer.Mutex);
+  GetNode(buffer, node, type).BytesAllocated += bytes;
+}
+
+std::vector<NodeProfile> Profiler::GetNodeProfiles() const
+{
+  std::unordered_map<Frameio::UUID, NodeProfile> merged;
+  {
+    std::lock_guard lock(m_Mutex);
+    for (const auto& buffer : m_Buffers) {
+      std::lock_guard bufferLock(buffer->Mutex);
+      for (const auto& [uuid, profile] : buffer->Nodes) {
+        NodeProfile& total = merged[uuid];
+        total.Node = uuid;
+        total.Type = profile.Type;
+        total.Nanoseconds += profile.Nanoseconds;
+        total.Pixels += profile.Pixels;
+        total.BytesAllocated += profile.BytesAllocated;
+        total.BytesRead += profile.BytesRead;
+      }
+    }
+  }
+
+  std::vector<NodeProfile> profiles;
+  profiles.reserve(merged.size());
+  for (const auto& [uuid, profile] : merged) profiles.push_back(profile);
+  std::sort(profiles.begin(), profiles.end(), [](const NodeProfile& a, const NodeProfile& b) {
+    return a.Nanoseconds != b.Nanoseconds ? a.Nanoseconds > b.Nanoseconds : a.Node < b.Node;
+  });
+  return profiles;
+}
+
+uint64_t Profiler::GetDroppedEventCount() const
+{
+  std::lock_guard lock(m_Mutex);
+  uint64_t dropped = 0;
+  for (const auto& buffer : m_Buffers) {
+    std::lock_guard bufferLock(buffer->Mutex);
+    dropped += buffer->Dropped;
+  }
+  return dropped;
+}
+
+std::string Profiler::ToChromeTrace() const
+{
+  std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto separate = [&]() {
+    out += first ? "\n" : ",\n";
+    first = false;
+  };
+
+  std::lock_guard lock(m_Mutex);
+  for (const auto& buffer : m_Buffers) {
+    std::lock_guard bufferLock(buffer->Mutex);
+    const std::string thread = std::to_string(buffer->Index);
+    separate();
+    out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + thread + ",\"args\":{\"name\":\"Thread " +
+           thread + "\"}}";
+
+    for (const ProfileEvent& event : buffer->Events) {
+      separate();
+      out += "{\"name\":";
+      WriteJsonString(out, event.Name ? event.Name : "");
+      out += ",\"cat\":";
+      WriteJsonString(out, event.Category ? event.Category : "");
+      out += ",\"ph\":\"X\",\"pid\":1,\"tid\":" + thread + ",\"ts\":";
+      AppendMicroseconds(out, event.Start);
+      out += ",\"dur\":";
+      AppendMicroseconds(out, event.Duration);
+      out += ",\"args\":{";
+      // UUIDs are strings, JavaScript numbers would round them
+      if (event.Node != 0) out += "\"node\":\"" + std::to_string(event.Node) + "\",";
+      out += "\"pixels\":" + std::to_string(event.Pixels) + ",\"bytes\":" + std::to_string(event.Bytes) + "}}";
+    }
+  }
+  out += "\n]}\n";
+  return out;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) const
+{
+  const std::string trace = ToChromeTrace();
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(trace.data(), (std::streamsize)trace.size());
+  return (bool)file;
+}
+
+void Profiler::Clear()
+{
+  std::lock_guard lock(m_Mutex);
+  for (const auto& buffer : m_Buffers) {
+    std::lock_guard bufferLock(buffer->Mutex);
+    buffer->Events.clear();
+    buffer->Nodes.clear();
+    buffer->Dropped = 0;
+  }
+}
+
+} // namespace Texturia
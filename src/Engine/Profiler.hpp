@@ -0,0 +1,132 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace Texturia {
+
+// Span of time on one thread, exported as a complete event of the Chrome trace format
+struct ProfileEvent {
+  // Only string literals and kernel types, events never own their names
+  const char* Name = nullptr;
+  const char* Category = nullptr;
+  // Nanoseconds since the profiler was created
+  uint64_t Start = 0, Duration = 0;
+  // Node the event belongs to, 0 for events of the whole evaluation
+  Frameio::UUID Node = 0;
+  uint64_t Pixels = 0, Bytes = 0;
+};
+
+// What one node cost over everything the profiler recorded
+struct NodeProfile {
+  Frameio::UUID Node = 0;
+  const char* Type = nullptr;
+  // Wall time of its kernel summed over every thread
+  uint64_t Nanoseconds = 0;
+  uint64_t Pixels = 0;
+  // Intermediate images the node was evaluated into, and images its kernel read
+  uint64_t BytesAllocated = 0, BytesRead = 0;
+};
+
+// Collects events and per node costs from any number of threads. Every thread writes into a buffer of its own, which
+// only the readers below lock as well, so recording threads never wait for each other. Hooks in the engine take a
+// Profiler pointer that is null unless the profiler is recording, which is all they cost otherwise.
+class Profiler {
+public:
+  // Events past this many per thread are counted but dropped, per node costs are still added up
+  static constexpr size_t MaxEventsPerThread = 1 << 18;
+
+  explicit Profiler(bool recording = true);
+  ~Profiler();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  inline void SetRecording(bool recording) { m_Recording.store(recording, std::memory_order_relaxed); }
+  inline bool IsRecording() const { return m_Recording.load(std::memory_order_relaxed); }
+
+  // Nanoseconds since the start
+  inline uint64_t Now() const
+  {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_Start)
+        .count();
+  }
+
+  void Record(const ProfileEvent& event);
+  // Adds to the per node costs without an event, for work that is too fine grained to trace
+  void AddNodeTime(const Frameio::UUID& node, const char* type, uint64_t nanoseconds, uint64_t pixels,
+                   uint64_t bytesRead);
+  void AddNodeAllocation(const Frameio::UUID& node, const char* type, uint64_t bytes);
+
+  // Merged over every thread, the most expensive node first
+  std::vector<NodeProfile> GetNodeProfiles() const;
+  uint64_t GetDroppedEventCount() const;
+
+  // Chrome trace event JSON, loads in chrome://tracing and ui.perfetto.dev
+  std::string ToChromeTrace() const;
+  bool WriteChromeTrace(const std::string& path) const;
+
+  // Forgets every event and cost, threads may keep recording while it runs
+  void Clear();
+
+private:
+  struct ThreadBuffer {
+    std::mutex Mutex;
+    std::thread::id Thread;
+    uint32_t Index;
+    std::vector<ProfileEvent> Events;
+    std::unordered_map<Frameio::UUID, NodeProfile> Nodes;
+    uint64_t Dropped = 0;
+  };
+
+  ThreadBuffer& GetThreadBuffer();
+  static NodeProfile& GetNode(ThreadBuffer& buffer, const Frameio::UUID& node, const char* type);
+
+  // Tells apart profilers that reuse the address of a destroyed one, see GetThreadBuffer
+  const uint64_t m_Id;
+  std::atomic<bool> m_Recording;
+  const std::chrono::steady_clock::time_point m_Start;
+
+  mutable std::mutex m_Mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_Buffers;
+};
+
+// Records the time from construction to destruction as an event. Does nothing if profiler is null or not recording.
+class ProfileScope {
+public:
+  inline ProfileScope(Profiler* profiler, const char* name, const char* category, Frameio::UUID node = 0)
+      : m_Profiler(profiler && profiler->IsRecording() ? profiler : nullptr)
+  {
+    if (!m_Profiler) return;
+    m_Event.Name = name;
+    m_Event.Category = category;
+    m_Event.Node = node;
+    m_Event.Start = m_Profiler->Now();
+  }
+  inline ~ProfileScope()
+  {
+    if (!m_Profiler) return;
+    m_Event.Duration = m_Profiler->Now() - m_Event.Start;
+    m_Profiler->Record(m_Event);
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+  inline void SetPixels(uint64_t pixels) { m_Event.Pixels = pixels; }
+  inline void SetBytes(uint64_t bytes) { m_Event.Bytes = bytes; }
+
+private:
+  Profiler* m_Profiler;
+  ProfileEvent m_Event;
+};
+
+} // namespace Texturia
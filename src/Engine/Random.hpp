@@ -0,0 +1,76 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Hash.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace Texturia {
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"). A counter based generator: the output
+// is a bijection of the counter under the key, so the n-th number of a stream is computed directly from n and any
+// number of threads can draw from the same stream in any order and get the same numbers.
+constexpr std::array<uint32_t, 4> Philox4x32(std::array<uint32_t, 4> counter, uint64_t key)
+{
+  uint32_t key0 = (uint32_t)key, key1 = (uint32_t)(key >> 32);
+  for (int round = 0; round < 10; round++) {
+    const uint64_t product0 = (uint64_t)0xD2511F53u * counter[0];
+    const uint64_t product1 = (uint64_t)0xCD9E8D57u * counter[2];
+    counter = { (uint32_t)(product1 >> 32) ^ counter[1] ^ key0,
+                (uint32_t)product1,
+                (uint32_t)(product0 >> 32) ^ counter[3] ^ key1,
+                (uint32_t)product0 };
+    key0 += 0x9E3779B9u;
+    key1 += 0xBB67AE85u;
+  }
+  return counter;
+}
+
+// lowbias32 by Chris Wellons, a cheap 32 bit integer hash for values that do not need the quality of Philox
+constexpr uint32_t HashInt(uint32_t value)
+{
+  value ^= value >> 16;
+  value *= 0x7FEB352Du;
+  value ^= value >> 15;
+  value *= 0x846CA68Bu;
+  return value ^ (value >> 16);
+}
+
+// Maps the upper 24 bits to [0, 1), every result is exactly representable
+constexpr float ToUnitFloat(uint32_t value)
+{
+  return (float)(value >> 8) * (1.0f / 16777216.0f);
+}
+
+// Key of the random numbers of a node, see KernelContext::NodeKey. Two nodes with the same seed still get
+// independent numbers.
+constexpr uint64_t GetRandomKey(uint64_t nodeKey, int32_t seed)
+{
+  return HashCombine(nodeKey, (uint32_t)seed);
+}
+
+// Random numbers of the pixels of a bake. The numbers of a pixel only depend on the key, the pixel coordinates in the
+// whole bake and the index of the number, so tiles, threads and the order they run in never change the result.
+class PixelRandom {
+public:
+  constexpr explicit PixelRandom(uint64_t key) : m_Key(key) {}
+
+  // Four independent numbers of the pixel, every block gives another four
+  constexpr std::array<uint32_t, 4> Generate(int32_t x, int32_t y, uint32_t block = 0) const
+  {
+    return Philox4x32({ (uint32_t)x, (uint32_t)y, block, 0 }, m_Key);
+  }
+  // One number of the pixel, cheaper than Generate but only meant for a few numbers per pixel
+  constexpr uint32_t Hash(int32_t x, int32_t y, uint32_t index = 0) const
+  {
+    const uint32_t key = (uint32_t)m_Key ^ HashInt((uint32_t)(m_Key >> 32) + index);
+    return HashInt(HashInt(key ^ (uint32_t)x) ^ (uint32_t)y);
+  }
+
+private:
+  uint64_t m_Key;
+};
+
+} // namespace Texturia
@@ -0,0 +1,88 @@
+#include "Engine/ResultCache.hpp"
+
+namespace Texturia {
+
+Frameio::Ref<const Image> ResultCache::Find(uint64_t key)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  auto it = m_Index.find(key);
+  if (it == m_Index.end()) {
+    m_Statistics.Misses++;
+    return nullptr;
+  }
+
+  m_Statistics.Hits++;
+  m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+  return it->second->Result;
+}
+
+void ResultCache::Insert(uint64_t key, Frameio::Ref<const Image> image)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  const uint64_t size = image->GetSizeInBytes();
+  if (size > m_Budget) return;
+
+  auto it = m_Index.find(key);
+  if (it != m_Index.end()) {
+    m_Statistics.ResidentBytes -= it->second->Result->GetSizeInBytes();
+    it->second->Result = std::move(image);
+    m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+  } else {
+    m_Entries.push_front({ key, std::move(image) });
+    m_Index[key] = m_Entries.begin();
+    m_Statistics.Entries++;
+  }
+  m_Statistics.ResidentBytes += size;
+  Evict(m_Budget);
+}
+
+void ResultCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Entries.clear();
+  m_Index.clear();
+  m_Statistics.Entries = 0;
+  m_Statistics.ResidentBytes = 0;
+}
+
+void ResultCache::SetBudget(uint64_t budget)
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Budget = budget;
+  Evict(budget);
+}
+
+uint64_t ResultCache::GetBudget() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Budget;
+}
+
+CacheStatistics ResultCache::GetStatistics() const
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  return m_Statistics;
+}
+
+void ResultCache::ResetCounters()
+{
+  std::lock_guard<std::mutex> lock(m_Mutex);
+  m_Statistics.Hits = m_Statistics.Misses = 0;
+  m_Statistics.Evictions = m_Statistics.EvictedBytes = 0;
+}
+
+void ResultCache::Evict(uint64_t budget)
+{
+  while (m_Statistics.ResidentBytes > budget) {
+    const Entry& entry = m_Entries.back();
+    const uint64_t size = entry.Result->GetSizeInBytes();
+    m_Statistics.ResidentBytes -= size;
+    m_Statistics.EvictedBytes += size;
+    m_Statistics.Evictions++;
+    m_Statistics.Entries--;
+    m_Index.erase(entry.Key);
+    m_Entries.pop_back();
+  }
+}
+
+} // namespace Texturia
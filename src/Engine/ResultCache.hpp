@@ -0,0 +1,60 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Image.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <list>
+#include <mutex>
+
+namespace Texturia {
+
+struct CacheStatistics {
+  uint64_t Hits = 0, Misses = 0;
+  uint64_t Evictions = 0, EvictedBytes = 0;
+  // Current contents
+  uint64_t Entries = 0, ResidentBytes = 0;
+};
+
+// Evaluated node results keyed by content hash (see NodesTree::GetContentHash), the least recently used results are
+// evicted once the images take up more than the memory budget. Images are shared, so evicting one that is still in
+// use somewhere else only drops the reference of the cache.
+class ResultCache {
+public:
+  static constexpr uint64_t DefaultBudget = 1ull << 30;
+
+  explicit ResultCache(uint64_t budget = DefaultBudget) : m_Budget(budget) {}
+
+  // Returns nullptr and counts a miss if there is no result for key
+  Frameio::Ref<const Image> Find(uint64_t key);
+  // Replaces an existing result for key, images larger than the whole budget are not stored
+  void Insert(uint64_t key, Frameio::Ref<const Image> image);
+  void Clear();
+
+  // Evicts right away when the new budget is smaller
+  void SetBudget(uint64_t budget);
+  uint64_t GetBudget() const;
+
+  CacheStatistics GetStatistics() const;
+  // Resets hits, misses and evictions but keeps the contents
+  void ResetCounters();
+
+private:
+  void Evict(uint64_t budget);
+
+  struct Entry {
+    uint64_t Key;
+    Frameio::Ref<const Image> Result;
+  };
+
+  mutable std::mutex m_Mutex;
+  uint64_t m_Budget;
+  // Most recently used first
+  std::list<Entry> m_Entries;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> m_Index;
+  CacheStatistics m_Statistics;
+};
+
+} // namespace Texturia
@@ -0,0 +1,267 @@
+#include "Engine/Scheduler.hpp"
+
+#include "Hash.hpp"
+
+namespace Texturia {
+
+TileScheduler::TileScheduler(const EvaluationPlan& plan, const CompiledPlan& compiled,
+                             const EvaluationSettings& settings, const Rect& region, std::span<Image* const> outputs,
+                             std::span<const Image* const> results, ImagePool& images)
+    : m_Plan(plan), m_Compiled(compiled), m_Settings(settings), m_Images(images)
+{
+  ProfileScope scope(settings.GetProfiler(), "Schedule", "scheduler");
+  const std::vector<EvaluationStep>& steps = plan.GetSteps();
+  const std::vector<CompiledPass>& passes = compiled.GetPasses();
+  const Rect bounds = { 0, 0, (int32_t)settings.Width, (int32_t)settings.Height };
+
+  m_StepRegions = compiled.GetStepRegions(plan, region, bounds);
+  Rect grid;
+  for (const CompiledPass& pass : passes) {
+    m_PassRegions.push_back(m_StepRegions[pass.Steps.back().Step]);
+    grid = grid.Union(m_PassRegions.back());
+  }
+  if (!grid.IsEmpty()) {
+    const uint32_t size = settings.TileSize;
+    m_TileX = grid.X / size;
+    m_TileY = grid.Y / size;
+    m_TilesX = (grid.Right() - 1) / size + 1 - m_TileX;
+    m_TilesY = (grid.Bottom() - 1) / size + 1 - m_TileY;
+  }
+  const uint32_t tileCount = m_TilesX * m_TilesY;
+
+  m_Outputs.assign(outputs.begin(), outputs.end());
+  m_Inputs.resize(steps.size());
+  m_RegisterInputs.resize(steps.size());
+  m_Temporaries.resize(steps.size());
+  m_Readers = std::make_unique<std::atomic<uint32_t>[]>(steps.size());
+  m_Allocated = std::make_unique<std::once_flag[]>(passes.size());
+  m_PassTemporaries.resize(passes.size());
+  m_PassReleases.resize(passes.size());
+  m_Consumers.resize(passes.size());
+  m_Waiting = std::make_unique<std::atomic<uint32_t>[]>(passes.size() * tileCount);
+
+  // Temporaries first, their readers need to know where the image will be
+  std::vector<const Image*> stepResults(results.begin(), results.end());
+  for (uint32_t p = 0; p < passes.size(); p++) {
+    for (const PassStep& passStep : passes[p].Steps) {
+      const uint32_t step = passStep.Step;
+      if (passStep.Register >= 0 || outputs[step]) continue;
+      FR_ASSERT(compiled.IsMaterialized(step),
+                "Step " + std::to_string(step) + " has neither a register nor an output!");
+      m_Outputs[step] = &m_Temporaries[step];
+      stepResults[step] = &m_Temporaries[step];
+      m_PassTemporaries[p].push_back(step);
+    }
+  }
+
+  std::vector<int32_t> registers(steps.size(), -1);
+  for (uint32_t p = 0; p < passes.size(); p++) {
+    const CompiledPass& pass = passes[p];
+    std::vector<uint32_t> sources;
+    for (const PassStep& passStep : pass.Steps) {
+      const EvaluationStep& step = steps[passStep.Step];
+      registers[passStep.Step] = passStep.Register;
+
+      for (uint32_t socket = 0; socket < step.InputSteps.size(); socket++) {
+        const int32_t source = step.InputSteps[socket];
+        if (source >= 0 && compiled.GetPass(source) == (int32_t)p && registers[source] >= 0) {
+          m_RegisterInputs[passStep.Step].push_back({ socket, registers[source] });
+          m_Inputs[passStep.Step].push_back({ nullptr, step.Constants[socket] });
+          continue;
+        }
+        FR_ASSERT(source < 0 || stepResults[source],
+                  "Step " + std::to_string(passStep.Step) + " reads a step without a result!");
+        m_Inputs[passStep.Step].push_back({ source >= 0 ? stepResults[source] : nullptr, step.Constants[socket] });
+
+        // Only evaluated steps of other passes have to be waited for
+        const int32_t sourcePass = source >= 0 ? compiled.GetPass(source) : -1;
+        if (sourcePass < 0 || sourcePass == (int32_t)p) continue;
+        if (std::find(sources.begin(), sources.end(), (uint32_t)sourcePass) == sources.end()) {
+          sources.push_back(sourcePass);
+          m_Consumers[sourcePass].push_back(p);
+        }
+        if (stepResults[source] == &m_Temporaries[source] &&
+            std::find(m_PassReleases[p].begin(), m_PassReleases[p].end(), (uint32_t)source) ==
+                m_PassReleases[p].end()) {
+          m_PassReleases[p].push_back(source);
+        }
+      }
+    }
+
+    uint32_t taskCount = 0;
+    for (uint32_t tile = 0; tile < tileCount; tile++) {
+      const Rect rect = GetTileRect(tile).Intersect(m_PassRegions[p]);
+      if (rect.IsEmpty()) continue;
+      taskCount++;
+      uint32_t waiting = 0;
+      for (uint32_t source : sources) {
+        waiting += GetOverlappingTiles(rect.Expand(pass.Radius).Intersect(m_PassRegions[source])).Count();
+      }
+      m_Waiting[(size_t)p * tileCount + tile] = waiting;
+    }
+    m_Remaining += taskCount;
+    for (uint32_t source : m_PassReleases[p]) m_Readers[source] += taskCount;
+  }
+}
+
+Rect TileScheduler::GetTileRect(uint32_t tile) const
+{
+  const int32_t size = (int32_t)m_Settings.TileSize;
+  const Rect bounds = { 0, 0, (int32_t)m_Settings.Width, (int32_t)m_Settings.Height };
+  const int32_t x = (int32_t)(m_TileX + tile % m_TilesX), y = (int32_t)(m_TileY + tile / m_TilesX);
+  return Rect{ x * size, y * size, size, size }.Intersect(bounds);
+}
+
+TileScheduler::TileRange TileScheduler::GetOverlappingTiles(const Rect& rect) const
+{
+  const uint32_t size = m_Settings.TileSize;
+  const Rect grid = { (int32_t)(m_TileX * size), (int32_t)(m_TileY * size), (int32_t)(m_TilesX * size),
+                      (int32_t)(m_TilesY * size) };
+  Rect clipped = rect.Intersect(grid).Intersect({ 0, 0, (int32_t)m_Settings.Width, (int32_t)m_Settings.Height });
+  if (clipped.IsEmpty()) return { 0, 0, 0, 0 };
+
+  return { clipped.X / size - m_TileX, clipped.Y / size - m_TileY, (clipped.Right() - 1) / size + 1 - m_TileX,
+           (clipped.Bottom() - 1) / size + 1 - m_TileY };
+}
+
+void TileScheduler::Run(ThreadPool& pool)
+{
+  if (m_Remaining == 0) return;
+  m_Pool = &pool;
+
+  // Collect the ready tasks first, once the first one runs it starts releasing others which must not be submitted twice
+  const uint32_t tileCount = m_TilesX * m_TilesY;
+  std::vector<uint64_t> ready;
+  for (uint32_t pass = 0; pass < m_PassRegions.size(); pass++) {
+    for (uint32_t tile = 0; tile < tileCount; tile++) {
+      const uint64_t task = (uint64_t)pass * tileCount + tile;
+      if (m_Waiting[task] == 0 && !GetTileRect(tile).Intersect(m_PassRegions[pass]).IsEmpty()) ready.push_back(task);
+    }
+  }
+  for (uint64_t task : ready) pool.Submit({ RunTask, this, task });
+
+  ProfileScope scope(m_Settings.GetProfiler(), "Wait", "scheduler");
+  std::unique_lock<std::mutex> lock(m_DoneMutex);
+  m_Done.wait(lock, [this]() { return m_Finished; });
+}
+
+void TileScheduler::RunTask(void* scheduler, uint64_t task)
+{
+  TileScheduler& self = *(TileScheduler*)scheduler;
+  const uint32_t tileCount = self.m_TilesX * self.m_TilesY;
+  self.Execute((uint32_t)(task / tileCount), (uint32_t)(task % tileCount));
+}
+
+void TileScheduler::Execute(uint32_t passIndex, uint32_t tile)
+{
+  const CompiledPass& pass = m_Compiled.GetPasses()[passIndex];
+  const Rect rect = GetTileRect(tile).Intersect(m_PassRegions[passIndex]);
+
+  // Cancelled tasks skip the kernels but still release the tasks and temporaries below, so that Run returns. Once a
+  // tile sees the cancellation every tile downstream of it does as well, none of them reads what was skipped.
+  if (!m_Settings.IsCancelled()) {
+    // Tiles are named after the last step of their pass, the steps themselves are timed by RunKernel
+    Profiler* profiler = m_Settings.GetProfiler();
+    const EvaluationStep& last = m_Plan.GetSteps()[pass.Steps.back().Step];
+    ProfileScope scope(profiler, last.Kernel->Type, "tile", last.UUID);
+    scope.SetPixels((uint64_t)rect.Width * rect.Height);
+
+    std::call_once(m_Allocated[passIndex], [&]() {
+      for (uint32_t step : m_PassTemporaries[passIndex]) {
+        const EvaluationStep& evaluationStep = m_Plan.GetSteps()[step];
+        ProfileScope allocation(profiler, "Allocate", "memory", evaluationStep.UUID);
+        m_Temporaries[step] = m_Images.Acquire(m_StepRegions[step]);
+        if (!profiler) continue;
+        const uint64_t bytes = Image::GetFloatCount(m_StepRegions[step]) * sizeof(float);
+        allocation.SetBytes(bytes);
+        profiler->AddNodeAllocation(evaluationStep.UUID, evaluationStep.Kernel->Type, bytes);
+      }
+    });
+
+    if (pass.Steps.size() == 1) {
+      const uint32_t step = pass.Steps[0].Step;
+      RunKernel(step, { rect, m_Settings.Width, m_Settings.Height, m_Inputs[step], m_Outputs[step], GetNodeKey(step) },
+                profiler);
+    } else {
+      const int32_t rows = std::max(1, s_BlockPixels / rect.Width);
+      for (int32_t y = rect.Y; y < rect.Bottom(); y += rows) {
+        ExecuteBlock(pass, Rect{ rect.X, y, rect.Width, rows }.Intersect(rect), profiler);
+      }
+    }
+  }
+
+  // Temporaries go back to the pool once the last tile reading them is done
+  for (uint32_t source : m_PassReleases[passIndex]) {
+    if (--m_Readers[source] == 0) m_Images.Recycle(std::move(m_Temporaries[source]));
+  }
+
+  // Release the downstream tiles that read from this one, they land in the deque of this worker and therefore
+  // usually run next on the same core while this tile is still in its cache
+  const uint32_t tileCount = m_TilesX * m_TilesY;
+  for (uint32_t consumer : m_Consumers[passIndex]) {
+    const Rect read = rect.Expand(m_Compiled.GetPasses()[consumer].Radius).Intersect(m_PassRegions[consumer]);
+    TileRange range = GetOverlappingTiles(read);
+    for (uint32_t y = range.Y0; y < range.Y1; y++) {
+      for (uint32_t x = range.X0; x < range.X1; x++) {
+        uint64_t task = (uint64_t)consumer * tileCount + y * m_TilesX + x;
+        if (--m_Waiting[task] == 0) m_Pool->Submit({ RunTask, this, task });
+      }
+    }
+  }
+
+  if (--m_Remaining == 0) {
+    std::lock_guard<std::mutex> lock(m_DoneMutex);
+    m_Finished = true;
+    m_Done.notify_all();
+  }
+}
+
+void TileScheduler::ExecuteBlock(const CompiledPass& pass, const Rect& block, Profiler* profiler)
+{
+  // Scratch images of the worker, they only grow, so a warm worker never allocates here
+  static thread_local std::vector<Image> s_Registers;
+  static thread_local std::vector<KernelInput> s_Inputs;
+  if (s_Registers.size() < pass.RegisterCount) s_Registers.resize(pass.RegisterCount);
+  for (uint32_t i = 0; i < pass.RegisterCount; i++) s_Registers[i].Reset(block);
+
+  for (const PassStep& passStep : pass.Steps) {
+    const uint32_t step = passStep.Step;
+    s_Inputs.assign(m_Inputs[step].begin(), m_Inputs[step].end());
+    for (const RegisterInput& input : m_RegisterInputs[step]) {
+      s_Inputs[input.Socket].Source = &s_Registers[input.Register];
+    }
+
+    Image* output = passStep.Register >= 0 ? &s_Registers[passStep.Register] : m_Outputs[step];
+    RunKernel(step, { block, m_Settings.Width, m_Settings.Height, s_Inputs, output, GetNodeKey(step) }, profiler);
+  }
+}
+
+uint64_t TileScheduler::GetNodeKey(uint32_t step) const
+{
+  return HashMix(m_Plan.GetSteps()[step].UUID);
+}
+
+void TileScheduler::RunKernel(uint32_t step, const KernelContext& context, Profiler* profiler) const
+{
+  const EvaluationStep& evaluationStep = m_Plan.GetSteps()[step];
+  if (!profiler) {
+    evaluationStep.Kernel->Run(context);
+    return;
+  }
+
+  const uint64_t start = profiler->Now();
+  evaluationStep.Kernel->Run(context);
+  const uint64_t duration = profiler->Now() - start;
+
+  // Every linked input is read over the tile and the halo of the kernel, scratch images of the pass included
+  const int32_t radius = evaluationStep.GetRadius(m_Settings.Width, m_Settings.Height);
+  const uint64_t inputBytes = Image::GetFloatCount(context.Tile.Expand(radius)) * sizeof(float);
+  uint64_t bytesRead = 0;
+  for (const KernelInput& input : context.Inputs) {
+    if (input.Source) bytesRead += inputBytes;
+  }
+  profiler->AddNodeTime(evaluationStep.UUID, evaluationStep.Kernel->Type, duration,
+                        (uint64_t)context.Tile.Width * context.Tile.Height, bytesRead);
+}
+
+} // namespace Texturia
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Compiler.hpp"
+#include "Engine/Evaluator.hpp"
+#include "Engine/ImagePool.hpp"
+#include "Engine/ThreadPool.hpp"
+
+namespace Texturia {
+
+// Runs the passes of a compiled plan as (pass, tile) tasks on a thread pool. There is no barrier between passes: a
+// tile becomes ready as soon as every tile of its inputs it reads from is done, which for point-wise passes is just
+// the same tile upstream and for neighbourhood kernels the tiles covered by the kernel radius.
+class TileScheduler {
+public:
+  // Evaluates region of the steps nobody reads and of every other step what its consumers need of it (see
+  // CompiledPlan::GetStepRegions). outputs[i] receives the result of step i and has to be set for every materialized
+  // step the compiler marked Kept. Materialized Temporary steps get an image of their region from images, which is
+  // recycled as soon as the last tile reading it is done. Consumers of steps that are not evaluated read results[i]
+  // instead, which has to be complete already (e.g. taken from a ResultCache). Steps with an output need
+  // results[i] == outputs[i].
+  TileScheduler(const EvaluationPlan& plan, const CompiledPlan& compiled, const EvaluationSettings& settings,
+                const Rect& region, std::span<Image* const> outputs, std::span<const Image* const> results,
+                ImagePool& images);
+
+  // Blocks until every tile of every pass has been evaluated
+  void Run(ThreadPool& pool);
+
+private:
+  // Point-wise passes evaluate a tile in blocks of about this many pixels, 8 KiB per scratch image. Registers are
+  // reused along a chain, so a pass only needs a few of them at once and they stay in L1.
+  static constexpr int32_t s_BlockPixels = 512;
+
+  static void RunTask(void* scheduler, uint64_t task);
+  void Execute(uint32_t pass, uint32_t tile);
+  void ExecuteBlock(const CompiledPass& pass, const Rect& block, Profiler* profiler);
+  // Adds the time, pixels and bytes read of the kernel to the step in profiler, if there is one
+  void RunKernel(uint32_t step, const KernelContext& context, Profiler* profiler) const;
+
+  // KernelContext::NodeKey of the step
+  uint64_t GetNodeKey(uint32_t step) const;
+
+  // Tile of the grid clipped to the bake
+  Rect GetTileRect(uint32_t tile) const;
+
+  // Range of tile indices along each axis that intersect rect
+  struct TileRange {
+    uint32_t X0, Y0, X1, Y1;
+
+    inline uint32_t Count() const { return (X1 - X0) * (Y1 - Y0); }
+  };
+  TileRange GetOverlappingTiles(const Rect& rect) const;
+
+  // Input of a step that is read from a scratch image of its pass
+  struct RegisterInput {
+    uint32_t Socket;
+    int32_t Register;
+  };
+
+  const EvaluationPlan& m_Plan;
+  const CompiledPlan& m_Compiled;
+  const EvaluationSettings& m_Settings;
+  ThreadPool* m_Pool = nullptr;
+  ImagePool& m_Images;
+
+  // The tile grid covers the union of the pass regions, its first tile is (m_TileX, m_TileY) of the whole bake
+  uint32_t m_TileX = 0, m_TileY = 0, m_TilesX = 0, m_TilesY = 0;
+  std::vector<Rect> m_StepRegions;
+  std::vector<Rect> m_PassRegions;
+
+  // Indexed by step, where the result goes and the inputs read from full size images, constants or scratch images
+  std::vector<Image*> m_Outputs;
+  std::vector<std::vector<KernelInput>> m_Inputs;
+  std::vector<std::vector<RegisterInput>> m_RegisterInputs;
+
+  // Images of the Temporary steps, allocated by the first tile of their pass. Readers counts the tiles of other passes
+  // that still read the step, indexed by step as well.
+  std::vector<Image> m_Temporaries;
+  std::unique_ptr<std::atomic<uint32_t>[]> m_Readers;
+  std::unique_ptr<std::once_flag[]> m_Allocated;
+  // Indexed by pass, the Temporary steps the pass writes and the ones it reads from other passes
+  std::vector<std::vector<uint32_t>> m_PassTemporaries;
+  std::vector<std::vector<uint32_t>> m_PassReleases;
+
+  // Unique downstream passes of every pass
+  std::vector<std::vector<uint32_t>> m_Consumers;
+  // Number of input tiles each (pass, tile) still waits for, indexed by pass * tileCount + tile
+  std::unique_ptr<std::atomic<uint32_t>[]> m_Waiting;
+
+  std::atomic<uint64_t> m_Remaining = 0;
+  std::mutex m_DoneMutex;
+  std::condition_variable m_Done;
+  // Set by the last tile under m_DoneMutex. Run waits for it rather than for m_Remaining, which reaches 0 before the
+  // last tile is done with the scheduler.
+  bool m_Finished = false;
+};
+
+} // namespace Texturia
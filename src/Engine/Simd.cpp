@@ -0,0 +1,92 @@
+#include "Engine/Simd.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(TX_SIMD_X86) && defined(_MSC_VER)
+  #include <intrin.h>
+#endif
+
+namespace Texturia {
+
+const char* GetSimdLevelName(SimdLevel level)
+{
+  switch (level) {
+    case SimdLevel::Generic:
+      return "generic";
+    case SimdLevel::SSE42:
+      return "sse4.2";
+    case SimdLevel::AVX2:
+      return "avx2";
+    case SimdLevel::AVX512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+bool IsSimdLevelSupported(SimdLevel level)
+{
+#if defined(TX_SIMD_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+  __cpuidex(info, 1, 0);
+  const bool sse42 = info[2] & (1 << 20);
+  const bool fma = info[2] & (1 << 12);
+  const bool osxsave = info[2] & (1 << 27);
+  bool avx2 = false, avx512 = false;
+  if (maxLeaf >= 7 && osxsave) {
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    avx2 = fma && (info[1] & (1 << 5)) && (xcr0 & 0x6) == 0x6;
+    avx512 = avx2 && (info[1] & (1 << 16)) && (info[1] & (1 << 17)) && (xcr0 & 0xE6) == 0xE6;
+  }
+
+  switch (level) {
+    case SimdLevel::Generic:
+      return true;
+    case SimdLevel::SSE42:
+      return sse42;
+    case SimdLevel::AVX2:
+      return avx2;
+    case SimdLevel::AVX512:
+      return avx512;
+  }
+  return false;
+#elif defined(TX_SIMD_X86)
+  switch (level) {
+    case SimdLevel::Generic:
+      return true;
+    case SimdLevel::SSE42:
+      return __builtin_cpu_supports("sse4.2");
+    case SimdLevel::AVX2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case SimdLevel::AVX512:
+      return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+  }
+  return false;
+#else
+  return level == SimdLevel::Generic;
+#endif
+}
+
+SimdLevel GetSimdLevel()
+{
+  static const SimdLevel level = []() {
+    SimdLevel limit = SimdLevel::AVX512;
+    if (const char* variable = std::getenv("TEXTURIA_SIMD")) {
+      for (SimdLevel candidate : { SimdLevel::Generic, SimdLevel::SSE42, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+        if (std::strcmp(variable, GetSimdLevelName(candidate)) == 0) limit = candidate;
+      }
+    }
+
+    SimdLevel best = SimdLevel::Generic;
+    for (SimdLevel candidate : { SimdLevel::SSE42, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+      if (candidate <= limit && IsSimdLevelSupported(candidate)) best = candidate;
+    }
+    return best;
+  }();
+  return level;
+}
+
+} // namespace Texturia
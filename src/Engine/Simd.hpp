@@ -0,0 +1,26 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include <cstdint>
+
+namespace Texturia {
+
+// Instruction sets that hot kernels are compiled for. Each of them is built into its own translation unit with the
+// matching compiler flags and picked at runtime, so one binary runs everywhere and still uses the widest vectors.
+enum class SimdLevel : uint8_t {
+  // Whatever the baseline of the target architecture is, e.g. SSE2 on x86-64 and NEON on AArch64
+  Generic,
+  SSE42,
+  AVX2,
+  AVX512
+};
+
+const char* GetSimdLevelName(SimdLevel level);
+
+// Best level the CPU and this build support, can be lowered with the TEXTURIA_SIMD environment variable
+// (generic, sse4.2, avx2, avx512) to compare code paths
+SimdLevel GetSimdLevel();
+bool IsSimdLevelSupported(SimdLevel level);
+
+} // namespace Texturia
@@ -0,0 +1,97 @@
+#include "Engine/ThreadPool.hpp"
+
+namespace Texturia {
+
+namespace {
+
+thread_local const ThreadPool* s_CurrentPool = nullptr;
+thread_local uint32_t s_CurrentWorker = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+  if (threadCount == 0) threadCount = GetHardwareThreadCount();
+
+  for (uint32_t i = 0; i < threadCount; i++) m_Workers.push_back(std::make_unique<Worker>());
+  for (uint32_t i = 0; i < threadCount; i++) m_Threads.emplace_back([this, i]() { WorkerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_SleepMutex);
+    m_Stop = true;
+  }
+  m_WakeUp.notify_all();
+  for (std::thread& thread : m_Threads) thread.join();
+}
+
+uint32_t ThreadPool::GetHardwareThreadCount()
+{
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::Submit(const Task& task)
+{
+  uint32_t index = s_CurrentPool == this ? s_CurrentWorker : m_NextWorker++ % GetThreadCount();
+  {
+    Worker& worker = *m_Workers[index];
+    std::lock_guard<std::mutex> lock(worker.Mutex);
+    worker.Tasks.push_back(task);
+  }
+
+  // Sequentially consistent together with the sleeping check in WorkerLoop, so a wake up can not get lost
+  m_Queued++;
+  if (m_Sleeping > 0) {
+    { std::lock_guard<std::mutex> lock(m_SleepMutex); }
+    m_WakeUp.notify_one();
+  }
+}
+
+bool ThreadPool::PopTask(uint32_t index, Task& task)
+{
+  {
+    Worker& worker = *m_Workers[index];
+    std::lock_guard<std::mutex> lock(worker.Mutex);
+    if (!worker.Tasks.empty()) {
+      task = worker.Tasks.back();
+      worker.Tasks.pop_back();
+      return true;
+    }
+  }
+
+  for (uint32_t offset = 1; offset < GetThreadCount(); offset++) {
+    Worker& victim = *m_Workers[(index + offset) % GetThreadCount()];
+    std::lock_guard<std::mutex> lock(victim.Mutex);
+    if (!victim.Tasks.empty()) {
+      task = victim.Tasks.front();
+      victim.Tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::WorkerLoop(uint32_t index)
+{
+  s_CurrentPool = this;
+  s_CurrentWorker = index;
+
+  Task task;
+  while (true) {
+    if (m_Queued > 0 && PopTask(index, task)) {
+      m_Queued--;
+      task.Function(task.Data, task.Argument);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_SleepMutex);
+    m_Sleeping++;
+    m_WakeUp.wait(lock, [this]() { return m_Stop || m_Queued > 0; });
+    m_Sleeping--;
+    if (m_Stop) return;
+  }
+}
+
+} // namespace Texturia
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace Texturia {
+
+// Work stealing thread pool. Every worker owns a deque: it pushes and pops its own tasks at the back, so work spawned
+// by a task stays on the same core while its inputs are still in cache, and idle workers steal from the front of the
+// other deques. Tasks are plain function pointers so that scheduling millions of tiles never allocates per task.
+class ThreadPool {
+public:
+  using TaskFunction = void (*)(void* data, uint64_t argument);
+
+  struct Task {
+    TaskFunction Function;
+    void* Data;
+    uint64_t Argument;
+  };
+
+  // threadCount 0 uses every hardware thread
+  explicit ThreadPool(uint32_t threadCount = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Called from a worker of this pool the task goes to the back of its own deque, otherwise the deques are filled
+  // round robin
+  void Submit(const Task& task);
+
+  inline uint32_t GetThreadCount() const { return (uint32_t)m_Workers.size(); }
+  static uint32_t GetHardwareThreadCount();
+
+private:
+  struct Worker {
+    std::mutex Mutex;
+    std::deque<Task> Tasks;
+  };
+
+  void WorkerLoop(uint32_t index);
+  bool PopTask(uint32_t index, Task& task);
+
+  std::vector<std::unique_ptr<Worker>> m_Workers;
+  std::vector<std::thread> m_Threads;
+  std::atomic<uint32_t> m_NextWorker = 0;
+
+  std::atomic<uint64_t> m_Queued = 0;
+  std::atomic<uint32_t> m_Sleeping = 0;
+  std::atomic<bool> m_Stop = false;
+  std::mutex m_SleepMutex;
+  std::condition_variable m_WakeUp;
+};
+
+} // namespace Texturia
@@ -0,0 +1,199 @@
+#include "Engine/TiffWriter.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <bit>
+#include <numeric>
+
+namespace Texturia {
+
+namespace {
+
+static_assert(std::endian::native == std::endian::little, "Tile data is written in the byte order of the host");
+
+enum TiffType : uint16_t { Short = 3, Long = 4, Long8 = 16 };
+
+// Appends value in little endian, TIFF files start with "II"
+template <typename T>
+void Append(std::vector<uint8_t>& bytes, T value)
+{
+  for (size_t i = 0; i < sizeof(T); i++) bytes.push_back((uint8_t)((uint64_t)value >> (i * 8)));
+}
+
+} // namespace
+
+TiffWriter::~TiffWriter()
+{
+  if (m_File.is_open()) Close();
+}
+
+uint32_t TiffWriter::GetTileSize(uint32_t schedulerTile, uint32_t minimum)
+{
+  uint32_t size = std::lcm(schedulerTile, 16u);
+  return size * std::max(1u, (minimum + size - 1) / size);
+}
+
+bool TiffWriter::Fail(std::string error)
+{
+  if (m_Error.empty()) m_Error = std::move(error);
+  m_File.close();
+  return false;
+}
+
+bool TiffWriter::Open(const std::string& path, uint32_t width, uint32_t height, uint32_t tileSize)
+{
+  FR_ASSERT(tileSize > 0 && tileSize % 16 == 0, "TIFF tiles have to be a multiple of 16 pixels!");
+  m_Error.clear();
+  m_Path = path;
+  m_Width = width;
+  m_Height = height;
+  m_TileSize = tileSize;
+  m_TilesX = (width + tileSize - 1) / tileSize;
+  const uint32_t tilesY = (height + tileSize - 1) / tileSize;
+  m_TileOffsets.assign((size_t)m_TilesX * tilesY, 0);
+  m_Buffer.resize((size_t)tileSize * tileSize * Image::Channels);
+
+  // Every tile plus one for missing tiles, with plenty of room for the directory
+  const uint64_t tileBytes = m_Buffer.size() * sizeof(float);
+  m_BigTiff = (m_TileOffsets.size() + 1) * tileBytes + m_TileOffsets.size() * 8 + 4096 > UINT32_MAX;
+
+  m_File.open(path, std::ios::binary | std::ios::trunc);
+  if (!m_File) return Fail("Could not open " + path);
+
+  // The offset of the directory is patched in by Close
+  std::vector<uint8_t> header = { 'I', 'I' };
+  if (m_BigTiff) {
+    Append<uint16_t>(header, 43);
+    Append<uint16_t>(header, 8);
+    Append<uint16_t>(header, 0);
+    Append<uint64_t>(header, 0);
+  } else {
+    Append<uint16_t>(header, 42);
+    Append<uint32_t>(header, 0);
+  }
+  m_File.write((const char*)header.data(), header.size());
+  m_End = header.size();
+  return m_File ? true : Fail("Failed to write " + path);
+}
+
+bool TiffWriter::Write(const Image& image)
+{
+  if (!m_File.is_open()) return Fail("Writing to a TIFF that is not open");
+  const Rect& region = image.GetRegion();
+  const Rect bounds = { 0, 0, (int32_t)m_Width, (int32_t)m_Height };
+  const int32_t size = (int32_t)m_TileSize;
+  FR_ASSERT(region.X % size == 0 && region.Y % size == 0 && bounds.Contains(region),
+            "Image region is not aligned to the tiles of the TIFF!");
+
+  for (int32_t tileY = region.Y; tileY < region.Bottom(); tileY += size) {
+    for (int32_t tileX = region.X; tileX < region.Right(); tileX += size) {
+      const Rect tile = Rect{ tileX, tileY, size, size }.Intersect(bounds);
+      FR_ASSERT(region.Contains(tile), "Image region does not cover whole tiles of the TIFF!");
+
+      // Edge tiles are still stored at full size, padded with zeros
+      if (tile.Width < size || tile.Height < size) std::fill(m_Buffer.begin(), m_Buffer.end(), 0.0f);
+      for (int32_t y = tile.Y; y < tile.Bottom(); y++) {
+        float* row = m_Buffer.data() + (size_t)(y - tile.Y) * size * Image::Channels;
+        for (uint32_t channel = 0; channel < Image::Channels; channel++) {
+          const float* source = image.GetPointer(channel, tile.X, y);
+          for (int32_t x = 0; x < tile.Width; x++) row[x * Image::Channels + channel] = source[x];
+        }
+      }
+
+      m_TileOffsets[(size_t)(tileY / size) * m_TilesX + tileX / size] = m_End;
+      m_File.write((const char*)m_Buffer.data(), m_Buffer.size() * sizeof(float));
+      m_End += m_Buffer.size() * sizeof(float);
+    }
+  }
+  return m_File ? true : Fail("Failed to write " + m_Path);
+}
+
+bool TiffWriter::Close()
+{
+  if (!m_File.is_open()) return false;
+
+  // Tiles that were never written share one black tile
+  const uint64_t tileBytes = m_Buffer.size() * sizeof(float);
+  if (std::find(m_TileOffsets.begin(), m_TileOffsets.end(), 0) != m_TileOffsets.end()) {
+    std::fill(m_Buffer.begin(), m_Buffer.end(), 0.0f);
+    m_File.write((const char*)m_Buffer.data(), tileBytes);
+    for (uint64_t& offset : m_TileOffsets) offset = offset ? offset : m_End;
+    m_End += tileBytes;
+  }
+  m_Buffer = {};
+
+  // Entries are sorted by tag. Values that do not fit into an entry go into data, which follows the directory.
+  struct Entry {
+    uint16_t Tag;
+    uint16_t Type;
+    std::vector<uint64_t> Values;
+  };
+  const uint16_t offsetType = m_BigTiff ? Long8 : Long;
+  const std::vector<uint64_t> byteCounts(m_TileOffsets.size(), tileBytes);
+  const std::vector<Entry> entries = {
+    { 256, Long, { m_Width } },            // ImageWidth
+    { 257, Long, { m_Height } },           // ImageLength
+    { 258, Short, { 32, 32, 32, 32 } },    // BitsPerSample
+    { 259, Short, { 1 } },                 // Compression, none
+    { 262, Short, { 2 } },                 // PhotometricInterpretation, RGB
+    { 277, Short, { 4 } },                 // SamplesPerPixel
+    { 284, Short, { 1 } },                 // PlanarConfiguration, interleaved
+    { 322, Long, { m_TileSize } },         // TileWidth
+    { 323, Long, { m_TileSize } },         // TileLength
+    { 324, offsetType, m_TileOffsets },    // TileOffsets
+    { 325, offsetType, byteCounts },       // TileByteCounts
+    { 338, Short, { 2 } },                 // ExtraSamples, unassociated alpha
+    { 339, Short, { 3, 3, 3, 3 } },        // SampleFormat, IEEE float
+  };
+
+  const uint64_t directory = (m_End + 7) / 8 * 8;
+  const size_t slot = m_BigTiff ? 8 : 4;
+  const size_t directorySize = m_BigTiff ? 8 + entries.size() * 20 + 8 : 2 + entries.size() * 12 + 4;
+  std::vector<uint8_t> bytes(directory - m_End, 0);
+  std::vector<uint8_t> data;
+  auto appendValue = [](std::vector<uint8_t>& target, uint16_t type, uint64_t value) {
+    if (type == Short) Append<uint16_t>(target, (uint16_t)value);
+    else if (type == Long) Append<uint32_t>(target, (uint32_t)value);
+    else Append<uint64_t>(target, value);
+  };
+
+  if (m_BigTiff) Append<uint64_t>(bytes, entries.size());
+  else Append<uint16_t>(bytes, (uint16_t)entries.size());
+  for (const Entry& entry : entries) {
+    Append<uint16_t>(bytes, entry.Tag);
+    Append<uint16_t>(bytes, entry.Type);
+    if (m_BigTiff) Append<uint64_t>(bytes, entry.Values.size());
+    else Append<uint32_t>(bytes, (uint32_t)entry.Values.size());
+
+    const size_t valueSize = entry.Type == Short ? 2 : entry.Type == Long ? 4 : 8;
+    if (entry.Values.size() * valueSize <= slot) {
+      const size_t start = bytes.size();
+      for (uint64_t value : entry.Values) appendValue(bytes, entry.Type, value);
+      bytes.resize(start + slot, 0);
+    } else {
+      const uint64_t offset = directory + directorySize + data.size();
+      if (m_BigTiff) Append<uint64_t>(bytes, offset);
+      else Append<uint32_t>(bytes, (uint32_t)offset);
+      for (uint64_t value : entry.Values) appendValue(data, entry.Type, value);
+      // Offsets have to be word aligned
+      if (data.size() % 2) data.push_back(0);
+    }
+  }
+  if (m_BigTiff) Append<uint64_t>(bytes, 0);
+  else Append<uint32_t>(bytes, 0);
+  bytes.insert(bytes.end(), data.begin(), data.end());
+  m_File.write((const char*)bytes.data(), bytes.size());
+
+  // Point the header at the directory
+  std::vector<uint8_t> offset;
+  if (m_BigTiff) Append<uint64_t>(offset, directory);
+  else Append<uint32_t>(offset, (uint32_t)directory);
+  m_File.seekp(m_BigTiff ? 8 : 4);
+  m_File.write((const char*)offset.data(), offset.size());
+
+  m_File.close();
+  if (!m_File) return Fail("Failed to write " + m_Path);
+  return IsValid();
+}
+
+} // namespace Texturia
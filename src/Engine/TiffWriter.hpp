@@ -0,0 +1,58 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Engine/Image.hpp"
+
+#include <fstream>
+
+namespace Texturia {
+
+// Writes a tiled, uncompressed 32 bit float RGBA TIFF piece by piece, so an image never has to be in memory as a
+// whole. Tiles are appended to the file as they arrive, in any order, and the directory pointing at them is written by
+// Close. Files that would not fit 32 bit offsets are written as BigTIFF.
+class TiffWriter {
+public:
+  TiffWriter() = default;
+  TiffWriter(const std::string& path, uint32_t width, uint32_t height, uint32_t tileSize)
+  {
+    Open(path, width, height, tileSize);
+  }
+  ~TiffWriter();
+
+  TiffWriter(const TiffWriter&) = delete;
+  TiffWriter& operator=(const TiffWriter&) = delete;
+
+  // tileSize has to be a multiple of 16
+  bool Open(const std::string& path, uint32_t width, uint32_t height, uint32_t tileSize);
+  // Writes every tile the region of image covers. The region has to start on the tile grid and cover whole tiles,
+  // except at the right and bottom edges of the image.
+  bool Write(const Image& image);
+  // Writes the directory, tiles that were never written are left black
+  bool Close();
+
+  inline bool IsValid() const { return m_Error.empty(); }
+  inline const std::string& GetError() const { return m_Error; }
+  inline uint32_t GetTileSize() const { return m_TileSize; }
+
+  // Smallest multiple of schedulerTile that is a valid TIFF tile size and at least minimum pixels wide, so that tiles
+  // of the file never split tiles of the scheduler
+  static uint32_t GetTileSize(uint32_t schedulerTile, uint32_t minimum = 256);
+
+private:
+  bool Fail(std::string error);
+
+  std::ofstream m_File;
+  std::string m_Path;
+  uint32_t m_Width = 0, m_Height = 0;
+  uint32_t m_TileSize = 0, m_TilesX = 0;
+  bool m_BigTiff = false;
+  // Where each tile starts in the file, 0 until it is written
+  std::vector<uint64_t> m_TileOffsets;
+  uint64_t m_End = 0;
+  // Interleaved RGBA of one tile
+  std::vector<float> m_Buffer;
+  std::string m_Error;
+};
+
+} // namespace Texturia
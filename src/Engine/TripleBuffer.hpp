@@ -0,0 +1,41 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace Texturia {
+
+// Hands the newest value from one writer thread to one reader thread without locks. The writer and the reader each own
+// one of three slots and swap it with the third one, so neither ever waits for the other. Values the reader did not
+// pick up before the next one was published are skipped. Slots are reused, so buffers inside of them keep their memory.
+template <typename T>
+class TripleBuffer {
+public:
+  // Only the writer may touch the slot, until it calls Publish
+  inline T& GetWriteSlot() { return m_Slots[m_Write]; }
+  inline void Publish() { m_Write = m_Shared.exchange(m_Write | s_Fresh, std::memory_order_acq_rel) & s_Index; }
+
+  // Makes the newest published value the read slot, returns false if nothing was published since the last call
+  inline bool Update()
+  {
+    if (!(m_Shared.load(std::memory_order_relaxed) & s_Fresh)) return false;
+    m_Read = m_Shared.exchange(m_Read, std::memory_order_acq_rel) & s_Index;
+    return true;
+  }
+  // Only the reader may touch the slot, until it calls Update again
+  inline T& GetReadSlot() { return m_Slots[m_Read]; }
+
+private:
+  // The shared index has this bit set while it holds a value the reader has not seen yet
+  static constexpr uint8_t s_Fresh = 4, s_Index = 3;
+
+  T m_Slots[3];
+  // Each on its own cache line, the writer and reader touch them all the time
+  alignas(64) uint8_t m_Write = 0;
+  alignas(64) uint8_t m_Read = 1;
+  alignas(64) std::atomic<uint8_t> m_Shared = 2;
+};
+
+} // namespace Texturia
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "PersistentVector.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <cstdint>
+
+namespace Texturia {
+
+// Generational handle into a HandlePool. It stays valid while the element lives, no matter how often other elements
+// move around, and never resolves to a different element once its own one got removed. The tag only keeps handles of
+// different pools from being mixed up.
+template <typename Tag>
+struct Handle {
+  static constexpr uint32_t NullIndex = ~0u;
+
+  uint32_t Index = NullIndex;
+  uint32_t Generation = 0;
+
+  inline bool IsNull() const { return Index == NullIndex; }
+  inline bool operator==(const Handle& other) const = default;
+};
+
+using NodeHandle = Handle<struct NodeTag>;
+using LinkHandle = Handle<struct LinkTag>;
+
+// Slot map bookkeeping: hands out handles and maps them to dense indices in [0, Size()). The owner keeps its data in
+// dense structure of arrays columns and mirrors every swap reported by Remove, so iterating stays a linear walk. Copies
+// share their storage, see PersistentVector.
+template <typename HandleType>
+class HandlePool {
+public:
+  static constexpr uint32_t NullIndex = HandleType::NullIndex;
+
+  // The new element always gets the dense index Size() - 1
+  inline HandleType Insert()
+  {
+    uint32_t dense = (uint32_t)m_DenseToSlot.size();
+    m_DenseToSlot.push_back(m_FreeSlot != NullIndex ? m_FreeSlot : m_Slots.size());
+    if (m_FreeSlot == NullIndex) {
+      m_Slots.push_back({ dense, 0 });
+      return { m_DenseToSlot.back(), 0 };
+    }
+
+    uint32_t slot = m_FreeSlot;
+    Slot& reused = m_Slots.Mutate(slot);
+    m_FreeSlot = reused.Dense;
+    reused.Dense = dense;
+    return { slot, reused.Generation };
+  }
+
+  // The last element moves into the dense index of the removed one, which is returned. The owner has to do the same
+  // swap and pop in all of its columns.
+  inline uint32_t Remove(HandleType handle)
+  {
+    FR_ASSERT(Contains(handle), "Handle is not part of this pool!");
+
+    uint32_t dense = m_Slots[handle.Index].Dense;
+    uint32_t last = (uint32_t)m_DenseToSlot.size() - 1;
+    m_DenseToSlot.Set(dense, m_DenseToSlot[last]);
+    m_Slots.Mutate(m_DenseToSlot[dense]).Dense = dense;
+    m_DenseToSlot.pop_back();
+
+    Slot& removed = m_Slots.Mutate(handle.Index);
+    removed.Generation++;
+    removed.Dense = m_FreeSlot;
+    m_FreeSlot = handle.Index;
+    return dense;
+  }
+
+  inline bool Contains(HandleType handle) const
+  {
+    // Removing or clearing bumps the generation of a slot, so stale handles never match
+    return handle.Index < m_Slots.size() && m_Slots[handle.Index].Generation == handle.Generation;
+  }
+
+  inline uint32_t GetIndex(HandleType handle) const
+  {
+    FR_ASSERT(handle.Index < m_Slots.size(), "Handle is not part of this pool!");
+    const Slot& slot = m_Slots[handle.Index];
+    FR_ASSERT(slot.Generation == handle.Generation, "Handle is not part of this pool!");
+    return slot.Dense;
+  }
+
+  inline HandleType GetHandle(uint32_t index) const
+  {
+    uint32_t slot = m_DenseToSlot[index];
+    return { slot, m_Slots[slot].Generation };
+  }
+
+  inline uint32_t Size() const { return (uint32_t)m_DenseToSlot.size(); }
+  // Upper bound of Handle::Index, slots are reused so this is the largest Size() the pool ever had
+  inline uint32_t GetSlotCount() const { return (uint32_t)m_Slots.size(); }
+
+  inline void Clear()
+  {
+    // Bump the generations so that handles from before the clear do not resolve to new elements
+    for (uint32_t dense = 0; dense < Size(); dense++) m_Slots.Mutate(m_DenseToSlot[dense]).Generation++;
+    m_FreeSlot = NullIndex;
+    for (uint32_t slot = m_Slots.size(); slot-- > 0;) {
+      m_Slots.Mutate(slot).Dense = m_FreeSlot;
+      m_FreeSlot = slot;
+    }
+    m_DenseToSlot.clear();
+  }
+
+private:
+  struct Slot {
+    // Dense index while the slot is alive, next free slot otherwise
+    uint32_t Dense;
+    uint32_t Generation;
+  };
+
+  PersistentVector<Slot> m_Slots;
+  PersistentVector<uint32_t> m_DenseToSlot;
+  uint32_t m_FreeSlot = NullIndex;
+};
+
+} // namespace Texturia
+
+template <typename Tag>
+struct std::hash<Texturia::Handle<Tag>> {
+  size_t operator()(const Texturia::Handle<Tag>& handle) const
+  {
+    return std::hash<uint64_t>()(((uint64_t)handle.Generation << 32) | handle.Index);
+  }
+};
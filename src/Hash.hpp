@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace Texturia {
+
+// Finalizer of splitmix64, every input bit affects every output bit
+constexpr uint64_t HashMix(uint64_t value)
+{
+  value ^= value >> 30;
+  value *= 0xBF58476D1CE4E5B9ull;
+  value ^= value >> 27;
+  value *= 0x94D049BB133111EBull;
+  return value ^ (value >> 31);
+}
+
+// Order dependent, HashCombine(a, b) != HashCombine(b, a)
+constexpr uint64_t HashCombine(uint64_t seed, uint64_t value)
+{
+  return HashMix(seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2)));
+}
+
+// 64 bit FNV-1a
+constexpr uint64_t HashBytes(const unsigned char* data, size_t size, uint64_t seed = 0xCBF29CE484222325ull)
+{
+  for (size_t i = 0; i < size; i++) seed = (seed ^ data[i]) * 0x100000001B3ull;
+  return seed;
+}
+
+inline uint64_t HashString(std::string_view string)
+{
+  return HashBytes((const unsigned char*)string.data(), string.size());
+}
+
+} // namespace Texturia
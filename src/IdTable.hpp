@@ -0,0 +1,70 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "PersistentVector.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <cstdint>
+
+namespace Texturia {
+
+// Hands out dense 32 bit IDs for APIs that can not take 64 bit UUIDs or handles, like ImNodes, and maps them back to
+// the value they were acquired for in O(1). Released IDs are reused first, so IDs stay below the largest number of
+// values that were alive at once and can never collide. Copies share their storage, see PersistentVector.
+template <typename Value>
+class IdTable {
+public:
+  static constexpr int32_t NullId = -1;
+
+  inline int32_t Acquire(const Value& value)
+  {
+    int32_t id;
+    m_Count++;
+    if (m_FreeId != NullId) {
+      id = m_FreeId;
+      m_FreeId = m_Entries[id].NextFree;
+      m_Entries.Set(id, { value, NullId, true });
+    } else {
+      FR_ASSERT(m_Entries.size() < (size_t)INT32_MAX, "Ran out of 32 bit IDs!");
+      id = (int32_t)m_Entries.size();
+      m_Entries.push_back({ value, NullId, true });
+    }
+    return id;
+  }
+
+  inline void Release(int32_t id)
+  {
+    FR_ASSERT(Contains(id), "ID " + std::to_string(id) + " is not in use!");
+    m_Entries.Set(id, { Value(), m_FreeId, false });
+    m_FreeId = id;
+    m_Count--;
+  }
+
+  inline bool Contains(int32_t id) const { return id >= 0 && (size_t)id < m_Entries.size() && m_Entries[id].Alive; }
+  // Returns a default constructed value for IDs that are not in use
+  inline Value Find(int32_t id) const { return Contains(id) ? m_Entries[id].Target : Value(); }
+
+  inline uint32_t Size() const { return m_Count; }
+  inline void Clear()
+  {
+    m_Entries.clear();
+    m_FreeId = NullId;
+    m_Count = 0;
+  }
+
+private:
+  struct Entry {
+    Value Target;
+    // Next entry of the free list while the entry is not alive
+    int32_t NextFree = NullId;
+    bool Alive = false;
+  };
+
+  PersistentVector<Entry> m_Entries;
+  int32_t m_FreeId = NullId;
+  uint32_t m_Count = 0;
+};
+
+} // namespace Texturia
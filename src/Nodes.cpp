@@ -1,67 +1,844 @@
 #include "Nodes.hpp"
 
+#include "Hash.hpp"
+
 #include <frameio/ImGui/Nodes.hpp>
 #include <frameio/frameio.hpp>
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <set>
+#include <utility>
+
 namespace Texturia {
 
-Node::Node(const std::string& label, Frameio::UUID uuid) : Label(label), UUID(uuid)
+namespace {
+
+// Scratch space of graph walks, nodes are visited when their mark equals the current epoch. Per thread, so that
+// readers of snapshots on different threads do not share it.
+thread_local std::vector<uint32_t> s_VisitMarks;
+thread_local uint32_t s_VisitEpoch = 0;
+thread_local std::vector<NodeHandle> s_VisitStack;
+
+// Size of nodes the editor has not measured yet: the title and the two outputs are a row each, like every input
+constexpr float s_EstimatedNodeWidth = 160.0f, s_EstimatedRowHeight = 20.0f;
+// Proxies and clipped links
+constexpr ImU32 s_ProxyColor = IM_COL32(60, 60, 70, 255), s_ProxyBorderColor = IM_COL32(100, 100, 110, 255);
+constexpr ImU32 s_ClippedLinkColor = IM_COL32(61, 133, 224, 200);
+
+} // namespace
+
+Node::Node(const std::string& label, Frameio::UUID uuid) : Label(label), UUID(uuid), Type("Default")
 {
   m_NodeSockets.push_back(NodeSocket("Bool", true));
   m_NodeSockets.push_back(NodeSocket("Int", 1));
   m_NodeSockets.push_back(NodeSocket("Float", 1.0f));
-  m_NodeSockets.push_back(NodeSocket("Char", 'c'));
-  m_NodeSockets.push_back(NodeSocket("String", "string"));
+  m_NodeSockets.push_back(NodeSocket("Vector", glm::vec3(0.0f, 0.0f, 1.0f)));
+  m_NodeSockets.push_back(NodeSocket("Color", SocketValue::Color(1.0f, 1.0f, 1.0f)));
 }
 
-void Node::OnImGuiRender()
+Node::Node(const std::string& label, const std::string& type, std::vector<NodeSocket> sockets, Frameio::UUID uuid)
+    : Label(label), UUID(uuid), Type(type), m_NodeSockets(std::move(sockets))
 {
-  ImNodes::BeginNode(UUID);
-  ImNodes::BeginNodeTitleBar();
-  ImGui::TextUnformatted(Label.c_str());
-  ImNodes::EndNodeTitleBar();
+}
 
-  ImNodes::BeginOutputAttribute(UUID + 1, ImNodesPinShape_TriangleFilled);
-  ImGui::Text("Output Socket");
-  ImNodes::EndOutputAttribute();
+Frameio::Ref<const NodesTree> NodesTree::Snapshot() const
+{
+  if (m_AnyHashDirty) UpdateContentHashes();
+  return std::make_shared<const NodesTree>(*this);
+}
 
-  ImNodes::BeginOutputAttribute(UUID + 2, ImNodesPinShape_QuadFilled);
-  ImGui::Text("Output Socket");
-  ImNodes::EndOutputAttribute();
+void NodesTree::DropContentHashes()
+{
+  m_ContentHashes.clear();
+  m_HashDirty.clear();
+  m_AnyHashDirty = true;
+}
 
-  for (auto nodeSocket : m_NodeSockets) {
-    ImNodes::BeginInputAttribute(nodeSocket.UUID, ImNodesPinShape_CircleFilled);
-    ImGui::Text("Input Socket");
-    ImNodes::EndInputAttribute();
+void NodesTree::RestoreContentHashes() const
+{
+  for (uint32_t i = m_HashDirty.size(); i < GetNodeCount(); i++) {
+    m_ContentHashes.push_back(0);
+    m_HashDirty.push_back(true);
   }
+}
+
+NodeHandle NodesTree::AddNode(const Node& node)
+{
+  FR_ASSERT(FindNode(node.UUID).IsNull(),
+            "Node { " + node.Label + ", " + std::to_string(node.UUID) + " } already exists!");
+  FR_ASSERT(node.GetSockets().size() <= MaxSocketCount,
+            "Node { " + node.Label + " } has more than " + std::to_string(MaxSocketCount) + " sockets!");
+  RestoreContentHashes();
 
-  ImNodes::EndNode();
+  NodeHandle handle = m_Handles.Insert();
+  m_NodeUUIDs.push_back(node.UUID);
+  m_NodeLabels.push_back(node.Label);
+  m_NodeTypes.push_back(InternString(node.Type));
+  m_NodeSockets.push_back({ PadSockets((uint32_t)node.GetSockets().size()), (uint32_t)node.GetSockets().size() });
+  m_NodeOutgoingLinks.push_back({});
+  m_NodeEditorIds.push_back(m_NodeIds.Acquire(handle));
+  std::array<int32_t, OutputPinCount> outputPins;
+  for (uint32_t pin = 0; pin < OutputPinCount; pin++) outputPins[pin] = m_PinIds.Acquire({ handle, pin, true });
+  m_NodeOutputPinIds.push_back(outputPins);
+  m_NodeRects.push_back({ 0.0f, 0.0f, s_EstimatedNodeWidth,
+                          s_EstimatedRowHeight * (OutputPinCount + 1 + (uint32_t)node.GetSockets().size()) });
+  m_NodeCellSlots.push_back(0);
+  InsertEditorEntry(handle);
+  InsertUUID(node.UUID, handle);
+  m_ContentHashes.push_back(0);
+  m_HashDirty.push_back(true);
+  m_AnyHashDirty = true;
+
+  for (uint32_t i = 0; i < node.GetSockets().size(); i++) {
+    const NodeSocket& socket = node.GetSockets()[i];
+    m_SocketLabels.push_back(InternString(socket.Label));
+    m_SocketTypes.push_back(socket.Value.Type);
+    m_SocketData.push_back(socket.Value.Data);
+    m_SocketUUIDs.push_back(socket.UUID);
+    m_SocketLinks.push_back(LinkHandle());
+    m_SocketPinIds.push_back(m_PinIds.Acquire({ handle, i, false }));
+  }
+  return handle;
 }
 
-void NodesTree::AddNode(const Node& node)
+void NodesTree::DeleteNode(const Frameio::UUID& uuid)
 {
-  auto result = m_Nodes.insert({ node.UUID, node });
-  FR_ASSERT(result.second, "Node { " + node.Label + ", " + std::to_string(node.UUID) + " } already exists!");
+  NodeHandle handle = FindNode(uuid);
+  if (!handle.IsNull()) DeleteNode(handle);
 }
 
-// Frameio::Ref<Node> NodesTree::GetNodeRef(const Frameio::UUID& uuid)
-// {
-//   return Frameio::Ref<Node>(m_Nodes);
-// }
+void NodesTree::DeleteNode(NodeHandle handle)
+{
+  InvalidateContentHash(handle);
+  for (uint32_t socket = 0; socket < GetSocketCount(handle); socket++) {
+    LinkHandle link = GetLink({ handle, socket });
+    if (!link.IsNull()) RemoveLink(link);
+  }
+  // Removing a link may copy the leaf holding the outgoing links, so they are looked up again every time
+  while (!GetOutgoingLinks(handle).empty()) RemoveLink(GetOutgoingLinks(handle).back());
 
-void NodesTree::DeleteNode(const Frameio::UUID& uuid)
+  const uint32_t index = GetIndex(handle);
+  const SocketRange range = m_NodeSockets[index];
+  for (uint32_t socket = range.First; socket < range.First + range.Count; socket++) {
+    m_PinIds.Release(m_SocketPinIds[socket]);
+  }
+  for (int32_t pin : m_NodeOutputPinIds[index]) m_PinIds.Release(pin);
+  m_NodeIds.Release(m_NodeEditorIds[index]);
+
+  m_SocketHoles += range.Count;
+  EraseUUID(GetUUID(handle));
+  EraseEditorEntry(handle);
+
+  // Mirror the swap and pop of the handle pool in every column, the last node moves into index
+  m_Handles.Remove(handle);
+  auto swapAndPop = [index](auto& column) {
+    if (index + 1 < column.size()) column.Set(index, column.back());
+    column.pop_back();
+  };
+  swapAndPop(m_NodeUUIDs);
+  swapAndPop(m_NodeLabels);
+  swapAndPop(m_NodeTypes);
+  swapAndPop(m_NodeSockets);
+  swapAndPop(m_NodeOutgoingLinks);
+  swapAndPop(m_NodeEditorIds);
+  swapAndPop(m_NodeOutputPinIds);
+  swapAndPop(m_NodeRects);
+  swapAndPop(m_NodeCellSlots);
+  swapAndPop(m_ContentHashes);
+  swapAndPop(m_HashDirty);
+
+  if (m_SocketHoles > m_SocketData.size() / 2) CompactSockets();
+}
+
+uint32_t NodesTree::PadSockets(uint32_t count)
+{
+  const uint32_t first = m_SocketData.size();
+  const uint32_t leafEnd = (first / SocketsPerLeaf + 1) * SocketsPerLeaf;
+  if (first + count <= leafEnd) return first;
+
+  for (uint32_t socket = first; socket < leafEnd; socket++) {
+    m_SocketLabels.push_back(0);
+    m_SocketTypes.push_back({});
+    m_SocketData.push_back({});
+    m_SocketUUIDs.push_back(Frameio::UUID(0));
+    m_SocketLinks.push_back(LinkHandle());
+    m_SocketPinIds.push_back(IdTable<EditorPin>::NullId);
+  }
+  m_SocketHoles += leafEnd - first;
+  return leafEnd;
+}
+
+void NodesTree::CompactSockets()
+{
+  // The columns are rebuilt from scratch, copies of the tree keep the old ones
+  const SocketColumn<uint32_t> labels = std::exchange(m_SocketLabels, {});
+  const SocketColumn<SocketType> types = std::exchange(m_SocketTypes, {});
+  const SocketColumn<SocketData> data = std::exchange(m_SocketData, {});
+  const SocketColumn<Frameio::UUID> uuids = std::exchange(m_SocketUUIDs, {});
+  const SocketColumn<LinkHandle> links = std::exchange(m_SocketLinks, {});
+  const SocketColumn<int32_t> pins = std::exchange(m_SocketPinIds, {});
+  m_SocketHoles = 0;
+
+  for (uint32_t i = 0; i < GetNodeCount(); i++) {
+    const SocketRange range = m_NodeSockets[i];
+    const uint32_t first = PadSockets(range.Count);
+    for (uint32_t socket = range.First; socket < range.First + range.Count; socket++) {
+      m_SocketLabels.push_back(labels[socket]);
+      m_SocketTypes.push_back(types[socket]);
+      m_SocketData.push_back(data[socket]);
+      m_SocketUUIDs.push_back(uuids[socket]);
+      m_SocketLinks.push_back(links[socket]);
+      m_SocketPinIds.push_back(pins[socket]);
+    }
+    m_NodeSockets.Set(i, { first, range.Count });
+  }
+}
+
+LinkHandle NodesTree::AddLink(const NodeLink& link)
+{
+  NodeHandle from = FindNode(link.From), to = FindNode(link.To);
+  FR_ASSERT(!from.IsNull() && !to.IsNull(), "Link endpoints must be part of the tree!");
+  return AddLink(from, { to, link.ToSocket });
+}
+
+LinkHandle NodesTree::AddLink(NodeHandle from, SocketHandle to)
+{
+  FR_ASSERT(Contains(from) && Contains(to.Node), "Link endpoints must be part of the tree!");
+  FR_ASSERT(to.Socket < GetSocketCount(to.Node),
+            "Node { " + GetLabel(to.Node) + " } has no socket " + std::to_string(to.Socket) + "!");
+  if (IsReachable(to.Node, from)) return LinkHandle();
+
+  LinkHandle existing = GetLink(to);
+  if (!existing.IsNull()) RemoveLink(existing);
+
+  std::vector<LinkHandle>& outgoing = m_NodeOutgoingLinks.Mutate(GetIndex(from));
+  LinkHandle handle = m_LinkHandles.Insert();
+  m_LinkSources.push_back(from);
+  m_LinkTargets.push_back(to);
+  m_LinkOutgoingSlots.push_back((uint32_t)outgoing.size());
+  m_LinkEditorIds.push_back(m_LinkIds.Acquire(handle));
+  outgoing.push_back(handle);
+  m_SocketLinks.Set(GetSocket(to.Node, to.Socket), handle);
+
+  InvalidateContentHash(to.Node);
+  return handle;
+}
+
+void NodesTree::RemoveLink(LinkHandle handle)
+{
+  const uint32_t index = m_LinkHandles.GetIndex(handle);
+  const SocketHandle target = m_LinkTargets[index];
+  InvalidateContentHash(target.Node);
+  m_SocketLinks.Set(GetSocket(target.Node, target.Socket), LinkHandle());
+
+  // Swap and pop out of the outgoing links of the source, the moved link has to learn its new position
+  std::vector<LinkHandle>& outgoing = m_NodeOutgoingLinks.Mutate(GetIndex(m_LinkSources[index]));
+  const uint32_t slot = m_LinkOutgoingSlots[index];
+  outgoing[slot] = outgoing.back();
+  m_LinkOutgoingSlots.Set(m_LinkHandles.GetIndex(outgoing[slot]), slot);
+  outgoing.pop_back();
+  m_LinkIds.Release(m_LinkEditorIds[index]);
+
+  uint32_t dense = m_LinkHandles.Remove(handle);
+  auto swapAndPop = [dense](auto& column) {
+    if (dense + 1 < column.size()) column.Set(dense, column.back());
+    column.pop_back();
+  };
+  swapAndPop(m_LinkSources);
+  swapAndPop(m_LinkTargets);
+  swapAndPop(m_LinkOutgoingSlots);
+  swapAndPop(m_LinkEditorIds);
+}
+
+bool NodesTree::IsReachable(NodeHandle from, NodeHandle to) const
+{
+  if (from == to) return true;
+
+  // Handle slots are stable, unlike dense indices, and bounded by the largest number of nodes the tree ever had
+  if (s_VisitMarks.size() < m_Handles.GetSlotCount()) s_VisitMarks.resize(m_Handles.GetSlotCount(), 0);
+  if (++s_VisitEpoch == 0) {
+    std::fill(s_VisitMarks.begin(), s_VisitMarks.end(), 0);
+    s_VisitEpoch = 1;
+  }
+
+  s_VisitStack.assign(1, from);
+  s_VisitMarks[from.Index] = s_VisitEpoch;
+  while (!s_VisitStack.empty()) {
+    NodeHandle current = s_VisitStack.back();
+    s_VisitStack.pop_back();
+    for (LinkHandle link : GetOutgoingLinks(current)) {
+      NodeHandle next = m_LinkTargets[m_LinkHandles.GetIndex(link)].Node;
+      if (next == to) return true;
+      if (s_VisitMarks[next.Index] == s_VisitEpoch) continue;
+      s_VisitMarks[next.Index] = s_VisitEpoch;
+      s_VisitStack.push_back(next);
+    }
+  }
+  return false;
+}
+
+std::vector<NodeHandle> NodesTree::GetTopologicalOrder() const
+{
+  // Kahn's algorithm, the order is a queue of nodes whose inputs are all placed
+  std::vector<NodeHandle> order;
+  order.reserve(GetNodeCount());
+  std::vector<uint32_t> waiting(GetNodeCount(), 0);
+  for (uint32_t i = 0; i < GetLinkCount(); i++) waiting[GetIndex(m_LinkTargets[i].Node)]++;
+  for (uint32_t i = 0; i < GetNodeCount(); i++) {
+    if (waiting[i] == 0) order.push_back(GetHandle(i));
+  }
+  for (size_t next = 0; next < order.size(); next++) {
+    for (LinkHandle link : GetOutgoingLinks(order[next])) {
+      NodeHandle target = GetLinkTarget(link).Node;
+      if (--waiting[GetIndex(target)] == 0) order.push_back(target);
+    }
+  }
+  // Links can not close cycles, so every node gets placed
+  FR_ASSERT(order.size() == GetNodeCount(), "Node tree contains a cycle!");
+  return order;
+}
+
+NodeHandle NodesTree::FindNode(const Frameio::UUID& uuid) const
+{
+  if (m_UUIDIndex.empty()) return NodeHandle();
+  const uint32_t mask = m_UUIDIndex.size() - 1;
+  for (uint32_t slot = (uint32_t)HashMix(uuid) & mask;; slot = (slot + 1) & mask) {
+    const UUIDSlot& entry = m_UUIDIndex[slot];
+    if (entry.Node.IsNull()) return NodeHandle();
+    if (entry.UUID == uuid) return entry.Node;
+  }
+}
+
+void NodesTree::InsertUUID(uint64_t uuid, NodeHandle handle)
+{
+  if ((GetNodeCount() + 1) * 2 > m_UUIDIndex.size()) ResizeUUIDIndex(std::max(16u, m_UUIDIndex.size() * 2));
+  const uint32_t mask = m_UUIDIndex.size() - 1;
+  uint32_t slot = (uint32_t)HashMix(uuid) & mask;
+  while (!m_UUIDIndex[slot].Node.IsNull()) slot = (slot + 1) & mask;
+  m_UUIDIndex.Set(slot, { uuid, handle });
+}
+
+void NodesTree::EraseUUID(uint64_t uuid)
+{
+  const uint32_t mask = m_UUIDIndex.size() - 1;
+  uint32_t hole = (uint32_t)HashMix(uuid) & mask;
+  while (m_UUIDIndex[hole].UUID != uuid || m_UUIDIndex[hole].Node.IsNull()) hole = (hole + 1) & mask;
+
+  // Backward shift: later entries of the probe sequence move into the hole unless that would put them in front of
+  // their home slot, so lookups never need tombstones
+  for (uint32_t slot = (hole + 1) & mask;; slot = (slot + 1) & mask) {
+    const UUIDSlot entry = m_UUIDIndex[slot];
+    if (entry.Node.IsNull()) break;
+    const uint32_t home = (uint32_t)HashMix(entry.UUID) & mask;
+    if (((slot - home) & mask) < ((slot - hole) & mask)) continue;
+    m_UUIDIndex.Set(hole, entry);
+    hole = slot;
+  }
+  m_UUIDIndex.Set(hole, { 0, NodeHandle() });
+}
+
+void NodesTree::ResizeUUIDIndex(uint32_t capacity)
+{
+  FR_ASSERT(std::has_single_bit(capacity), "Capacity of the UUID index has to be a power of two!");
+  PersistentVector<UUIDSlot> previous = std::move(m_UUIDIndex);
+  m_UUIDIndex.clear();
+  for (uint32_t slot = 0; slot < capacity; slot++) m_UUIDIndex.push_back({ 0, NodeHandle() });
+
+  const uint32_t mask = capacity - 1;
+  for (uint32_t i = 0; i < previous.size(); i++) {
+    const UUIDSlot& entry = previous[i];
+    if (entry.Node.IsNull()) continue;
+    uint32_t slot = (uint32_t)HashMix(entry.UUID) & mask;
+    while (!m_UUIDIndex[slot].Node.IsNull()) slot = (slot + 1) & mask;
+    m_UUIDIndex.Set(slot, entry);
+  }
+}
+
+void NodesTree::SetEditorPosition(NodeHandle handle, float x, float y)
+{
+  EditorRect rect = GetEditorRect(handle);
+  if (rect.X == x && rect.Y == y) return;
+  rect.X = x;
+  rect.Y = y;
+  SetEditorRect(handle, rect);
+}
+
+void NodesTree::SetEditorSize(NodeHandle handle, float width, float height)
+{
+  EditorRect rect = GetEditorRect(handle);
+  if (rect.Width == width && rect.Height == height) return;
+  rect.Width = width;
+  rect.Height = height;
+  SetEditorRect(handle, rect);
+}
+
+void NodesTree::FindEditorNodes(const EditorRect& area, std::vector<NodeHandle>& nodes) const
+{
+  if (m_EditorCells.empty()) return;
+  const std::array<int32_t, 2> first = GetEditorCell(area.X - m_MaxNodeWidth, area.Y - m_MaxNodeHeight);
+  const std::array<int32_t, 2> last = GetEditorCell(area.Right(), area.Bottom());
+  const uint64_t cellCount = (uint64_t)((int64_t)last[0] - first[0] + 1) * (uint64_t)((int64_t)last[1] - first[1] + 1);
+
+  // An area covering more cells than there are buckets visits every bucket once instead
+  if (cellCount >= m_EditorCells.size()) {
+    for (uint32_t bucket = 0; bucket < m_EditorCells.size(); bucket++) {
+      for (const EditorCellEntry& entry : m_EditorCells[bucket]) {
+        if (entry.Rect.Overlaps(area)) nodes.push_back(entry.Node);
+      }
+    }
+    return;
+  }
+  for (int32_t y = first[1]; y <= last[1]; y++) {
+    for (int32_t x = first[0]; x <= last[0]; x++) {
+      // Several cells share a bucket, their entries are left to their own cell so that none is found twice
+      for (const EditorCellEntry& entry : m_EditorCells[GetEditorBucket({ x, y })]) {
+        if (entry.Rect.Overlaps(area) && GetEditorCell(entry.Rect.X, entry.Rect.Y) == std::array{ x, y }) {
+          nodes.push_back(entry.Node);
+        }
+      }
+    }
+  }
+}
+
+std::array<int32_t, 2> NodesTree::GetEditorCell(float x, float y)
+{
+  // Clamped so that far away areas do not overflow
+  auto cell = [](float value) { return (int32_t)std::clamp(std::floor(value / EditorCellSize), -1e9f, 1e9f); };
+  return { cell(x), cell(y) };
+}
+
+uint32_t NodesTree::GetEditorBucket(std::array<int32_t, 2> cell) const
+{
+  return (uint32_t)HashMix((uint64_t)(uint32_t)cell[0] << 32 | (uint32_t)cell[1]) & (m_EditorCells.size() - 1);
+}
+
+void NodesTree::InsertEditorEntry(NodeHandle handle)
+{
+  const EditorRect& rect = GetEditorRect(handle);
+  m_MaxNodeWidth = std::max(m_MaxNodeWidth, rect.Width);
+  m_MaxNodeHeight = std::max(m_MaxNodeHeight, rect.Height);
+  // Rebuilding the grid inserts every node, this one included
+  if (GetNodeCount() > m_EditorCells.size() * 2) {
+    ResizeEditorGrid(std::max(64u, m_EditorCells.size() * 2));
+    return;
+  }
+  std::vector<EditorCellEntry>& bucket = m_EditorCells.Mutate(GetEditorBucket(GetEditorCell(rect.X, rect.Y)));
+  m_NodeCellSlots.Set(GetIndex(handle), (uint32_t)bucket.size());
+  bucket.push_back({ handle, rect });
+}
+
+void NodesTree::EraseEditorEntry(NodeHandle handle)
+{
+  const uint32_t index = GetIndex(handle), slot = m_NodeCellSlots[index];
+  const EditorRect& rect = m_NodeRects[index];
+  std::vector<EditorCellEntry>& bucket = m_EditorCells.Mutate(GetEditorBucket(GetEditorCell(rect.X, rect.Y)));
+  FR_ASSERT(slot < bucket.size() && bucket[slot].Node == handle, "Node is missing from the editor grid!");
+  if (slot + 1 < bucket.size()) {
+    bucket[slot] = bucket.back();
+    m_NodeCellSlots.Set(GetIndex(bucket[slot].Node), slot);
+  }
+  bucket.pop_back();
+}
+
+void NodesTree::SetEditorRect(NodeHandle handle, const EditorRect& rect)
+{
+  EraseEditorEntry(handle);
+  m_NodeRects.Set(GetIndex(handle), rect);
+  InsertEditorEntry(handle);
+}
+
+void NodesTree::ResizeEditorGrid(uint32_t bucketCount)
+{
+  FR_ASSERT(std::has_single_bit(bucketCount), "Bucket count of the editor grid has to be a power of two!");
+  m_EditorCells.clear();
+  for (uint32_t bucket = 0; bucket < bucketCount; bucket++) m_EditorCells.push_back({});
+  for (uint32_t i = 0; i < GetNodeCount(); i++) {
+    const EditorRect& rect = m_NodeRects[i];
+    std::vector<EditorCellEntry>& bucket = m_EditorCells.Mutate(GetEditorBucket(GetEditorCell(rect.X, rect.Y)));
+    m_NodeCellSlots.Set(i, (uint32_t)bucket.size());
+    bucket.push_back({ GetHandle(i), rect });
+  }
+}
+
+Node NodesTree::GetNode(NodeHandle handle) const
+{
+  uint32_t index = GetIndex(handle);
+  const SocketRange range = m_NodeSockets[index];
+
+  std::vector<NodeSocket> sockets;
+  sockets.reserve(range.Count);
+  for (uint32_t socket = range.First; socket < range.First + range.Count; socket++) {
+    sockets.push_back(
+        NodeSocket(m_Strings->Strings[m_SocketLabels[socket]], { m_SocketTypes[socket], m_SocketData[socket] }));
+    sockets.back().UUID = m_SocketUUIDs[socket];
+  }
+  return Node(m_NodeLabels[index], m_Strings->Strings[m_NodeTypes[index]], std::move(sockets), m_NodeUUIDs[index]);
+}
+
+void NodesTree::SetSocketValue(NodeHandle handle, uint32_t socket, const SocketValue& value)
+{
+  uint32_t index = GetSocket(handle, socket);
+  FR_ASSERT(value.Type == m_SocketTypes[index], "Socket " + std::to_string(socket) + " of node { " + GetLabel(handle) +
+                                                    " } does not hold a " + GetSocketTypeName(value.Type) + "!");
+  m_SocketData.Set(index, value.Data);
+  InvalidateContentHash(handle);
+}
+
+uint64_t NodesTree::GetContentHash(NodeHandle handle) const
+{
+  if (m_AnyHashDirty) UpdateContentHashes();
+  return m_ContentHashes[GetIndex(handle)];
+}
+
+void NodesTree::InvalidateContentHash(NodeHandle handle)
+{
+  RestoreContentHashes();
+  // Nodes that are already dirty have dirty downstream nodes as well, so the walk stops there
+  s_VisitStack.assign(1, handle);
+  while (!s_VisitStack.empty()) {
+    NodeHandle current = s_VisitStack.back();
+    s_VisitStack.pop_back();
+    if (m_HashDirty[GetIndex(current)]) continue;
+
+    m_HashDirty.Set(GetIndex(current), true);
+    for (LinkHandle link : GetOutgoingLinks(current)) s_VisitStack.push_back(GetLinkTarget(link).Node);
+  }
+  m_AnyHashDirty = true;
+}
+
+void NodesTree::UpdateContentHashes() const
+{
+  // Dense index of the node linked into a socket column entry, -1 for unlinked sockets
+  auto source = [this](uint32_t socket) {
+    LinkHandle link = m_SocketLinks[socket];
+    return link.IsNull() ? -1 : (int32_t)GetIndex(m_LinkSources[m_LinkHandles.GetIndex(link)]);
+  };
+
+  // Post order walk over the dirty nodes, clean nodes already hold their final hash. AddLink rejects cycles, so a
+  // node is never reached again while it is being visited.
+  enum : uint8_t { Clean, Dirty, Visiting };
+  RestoreContentHashes();
+  std::vector<uint32_t> stack;
+  for (uint32_t root = 0; root < GetNodeCount(); root++) {
+    if (m_HashDirty[root] != Dirty) continue;
+    stack.push_back(root);
+
+    while (!stack.empty()) {
+      const uint32_t index = stack.back();
+      const SocketRange range = m_NodeSockets[index];
+      if (m_HashDirty[index] == Dirty) {
+        m_HashDirty.Set(index, Visiting);
+        for (uint32_t socket = range.First; socket < range.First + range.Count; socket++) {
+          int32_t from = source(socket);
+          if (from >= 0 && m_HashDirty[from] == Dirty) stack.push_back(from);
+        }
+        continue;
+      }
+
+      stack.pop_back();
+      if (m_HashDirty[index] != Visiting) continue;
+
+      const std::string& type = m_Strings->Strings[m_NodeTypes[index]];
+      uint64_t hash = HashString(type);
+      if (!m_Groups->empty()) {
+        if (const NodeGroup* group = FindGroup(type)) hash = HashCombine(hash, group->GetHash());
+      }
+      for (uint32_t socket = range.First; socket < range.First + range.Count; socket++) {
+        if (int32_t from = source(socket); from >= 0) {
+          hash = HashCombine(hash, m_ContentHashes[from]);
+          continue;
+        }
+
+        const SocketData& data = m_SocketData[socket];
+        hash = HashCombine(hash, (uint64_t)m_SocketTypes[socket] + 1);
+        hash = HashCombine(hash, HashBytes((const unsigned char*)&data, sizeof(SocketData)));
+      }
+      m_ContentHashes.Set(index, hash);
+      m_HashDirty.Set(index, Clean);
+    }
+  }
+  m_AnyHashDirty = false;
+}
+
+void NodesTree::SetGroup(Frameio::Ref<const NodeGroup> group)
+{
+  FR_ASSERT(group, "Group must not be null!");
+  if (m_Groups.use_count() > 1) m_Groups = std::make_shared<GroupTable>(*m_Groups);
+  const std::string name = group->GetName();
+  m_Groups->insert_or_assign(name, std::move(group));
+
+  // Types are interned, so the nodes of the group are the ones with its string
+  auto type = m_Strings->Index.find(name);
+  if (type == m_Strings->Index.end()) return;
+  for (uint32_t i = 0; i < GetNodeCount(); i++) {
+    if (m_NodeTypes[i] == type->second) InvalidateContentHash(GetHandle(i));
+  }
+}
+
+void NodesTree::RemoveGroup(std::string_view name)
+{
+  if (!FindGroup(name)) return;
+  if (m_Groups.use_count() > 1) m_Groups = std::make_shared<GroupTable>(*m_Groups);
+  m_Groups->erase(m_Groups->find(name));
+}
+
+const NodeGroup* NodesTree::FindGroup(std::string_view name) const
+{
+  auto found = m_Groups->find(name);
+  return found == m_Groups->end() ? nullptr : found->second.get();
+}
+
+std::vector<Frameio::Ref<const NodeGroup>> NodesTree::GetGroups() const
+{
+  std::vector<Frameio::Ref<const NodeGroup>> groups;
+  groups.reserve(m_Groups->size());
+  for (const auto& [name, group] : *m_Groups) groups.push_back(group);
+  return groups;
+}
+
+uint32_t NodesTree::InternString(const std::string& string)
 {
-  m_Nodes.erase(uuid);
+  if (auto it = m_Strings->Index.find(string); it != m_Strings->Index.end()) return it->second;
+  if (m_Strings.use_count() > 1) m_Strings = std::make_shared<StringTable>(*m_Strings);
+
+  const uint32_t index = (uint32_t)m_Strings->Strings.size();
+  m_Strings->Strings.push_back(string);
+  m_Strings->Index.emplace(string, index);
+  return index;
 }
 
 void NodesTree::Clear()
 {
-  m_Nodes.clear();
+  m_Handles.Clear();
+  m_NodeUUIDs.clear();
+  m_NodeLabels.clear();
+  m_NodeTypes.clear();
+  m_NodeSockets.clear();
+  m_UUIDIndex.clear();
+  m_ContentHashes.clear();
+  m_HashDirty.clear();
+  m_AnyHashDirty = false;
+  m_SocketLabels.clear();
+  m_SocketTypes.clear();
+  m_SocketData.clear();
+  m_SocketUUIDs.clear();
+  m_SocketLinks.clear();
+  m_SocketPinIds.clear();
+  m_SocketHoles = 0;
+  m_NodeOutgoingLinks.clear();
+  m_NodeEditorIds.clear();
+  m_NodeOutputPinIds.clear();
+  m_NodeRects.clear();
+  m_EditorCells.clear();
+  m_NodeCellSlots.clear();
+  m_MaxNodeWidth = m_MaxNodeHeight = 0.0f;
+  m_LinkHandles.Clear();
+  m_LinkSources.clear();
+  m_LinkTargets.clear();
+  m_LinkOutgoingSlots.clear();
+  m_LinkEditorIds.clear();
+  m_NodeIds.Clear();
+  m_PinIds.Clear();
+  m_LinkIds.Clear();
+  m_Groups = std::make_shared<GroupTable>();
 }
 
-void NodesTree::OnImGuiRender()
+void NodesTree::Reserve(uint32_t nodeCount, uint32_t /*socketCount*/, uint32_t /*linkCount*/)
 {
-  for (auto node : m_Nodes) { node.second.OnImGuiRender(); }
+  const uint32_t capacity = std::bit_ceil(std::max(16u, nodeCount * 2));
+  if (capacity > m_UUIDIndex.size()) ResizeUUIDIndex(capacity);
+}
+
+Frameio::Ref<const NodeGroup> NodeGroup::Create(std::string name, NodesTree body, Frameio::UUID output,
+                                                std::vector<GroupParameter> parameters, std::string& error)
+{
+  auto fail = [&](std::string message) {
+    error = "Group " + name + ": " + message;
+    return nullptr;
+  };
+  if (body.FindNode(output).IsNull()) return fail("Output " + std::to_string(output) + " is not part of the body");
+  if (!body.GetGroups().empty()) return fail("Groups do not nest");
+
+  std::set<std::pair<uint64_t, uint32_t>> targeted;
+  for (const GroupParameter& parameter : parameters) {
+    for (const GroupTarget& target : parameter.Targets) {
+      const NodeHandle node = body.FindNode(target.Node);
+      const std::string targetName = "Target " + std::to_string(target.Node) + "." +
+                                     std::to_string(target.Socket) + " of " + parameter.Label;
+      if (node.IsNull() || target.Socket >= body.GetSocketCount(node)) {
+        return fail(targetName + " is not part of the body");
+      }
+      if (body.GetSocketValue(node, target.Socket).Type != parameter.Default.Type) {
+        return fail(targetName + " does not hold a " + GetSocketTypeName(parameter.Default.Type));
+      }
+      if (!targeted.insert({ target.Node, target.Socket }).second) {
+        return fail(targetName + " is the target of another parameter");
+      }
+    }
+  }
+
+  Frameio::Ref<NodeGroup> group(new NodeGroup());
+  group->m_Name = std::move(name);
+  group->m_Body = std::move(body);
+  group->m_Output = output;
+  group->m_Parameters = std::move(parameters);
+
+  // Also brings every content hash of the body up to date
+  const NodesTree& stored = group->m_Body;
+  uint64_t hash = HashCombine(HashString(group->m_Name), stored.GetContentHash(stored.FindNode(output)));
+  for (uint32_t i = 0; i < stored.GetNodeCount(); i++) hash = HashCombine(hash, stored.GetUUID(stored.GetHandle(i)));
+  for (const GroupParameter& parameter : group->m_Parameters) {
+    hash = HashCombine(hash, (uint64_t)parameter.Default.Type + 1);
+    for (const GroupTarget& target : parameter.Targets) {
+      hash = HashCombine(HashCombine(hash, target.Node), target.Socket);
+    }
+  }
+  group->m_Hash = hash;
+  return group;
+}
+
+Node NodeGroup::CreateNode(const std::string& label, Frameio::UUID uuid) const
+{
+  std::vector<NodeSocket> sockets;
+  for (const GroupParameter& parameter : m_Parameters) {
+    sockets.push_back(NodeSocket(parameter.Label, parameter.Default));
+  }
+  return Node(label.empty() ? m_Name : label, m_Name, std::move(sockets), uuid);
+}
+
+void NodesTree::OnImGuiRender(EditorFrame& frame)
+{
+  // Right after BeginNodeEditor the cursor is still at the origin of the canvas
+  const ImVec2 canvas = ImGui::GetCursorScreenPos(), panning = ImNodes::EditorContextGetPanning();
+  const ImVec2 windowPosition = ImGui::GetWindowPos(), windowSize = ImGui::GetWindowSize();
+  frame.OriginX = canvas.x + panning.x;
+  frame.OriginY = canvas.y + panning.y;
+  frame.Visible = { windowPosition.x - frame.OriginX, windowPosition.y - frame.OriginY, windowSize.x, windowSize.y };
+  frame.Detailed.clear();
+  frame.Proxies.clear();
+  FindEditorNodes(frame.Visible, frame.Detailed);
+
+  if (frame.Detailed.size() > EditorDetailBudget) {
+    const float centerX = frame.Visible.X + frame.Visible.Width * 0.5f;
+    const float centerY = frame.Visible.Y + frame.Visible.Height * 0.5f;
+    auto distance = [&](NodeHandle node) {
+      const EditorRect& rect = GetEditorRect(node);
+      const float x = rect.X + rect.Width * 0.5f - centerX, y = rect.Y + rect.Height * 0.5f - centerY;
+      return x * x + y * y;
+    };
+    auto budget = frame.Detailed.begin() + EditorDetailBudget;
+    std::nth_element(frame.Detailed.begin(), budget, frame.Detailed.end(),
+                     [&](NodeHandle a, NodeHandle b) { return distance(a) < distance(b); });
+    frame.Proxies.assign(budget, frame.Detailed.end());
+    frame.Detailed.erase(budget, frame.Detailed.end());
+  }
+
+  // Marks by handle slot, nodes that are not marked are outside of the window
+  enum : uint8_t { Hidden, Detailed, Proxy };
+  thread_local std::vector<uint8_t> s_EditorMarks;
+  if (s_EditorMarks.size() < m_Handles.GetSlotCount()) s_EditorMarks.resize(m_Handles.GetSlotCount(), Hidden);
+  for (NodeHandle node : frame.Detailed) s_EditorMarks[node.Index] = Detailed;
+  for (NodeHandle node : frame.Proxies) s_EditorMarks[node.Index] = Proxy;
+
+  // Drawn before the first node, so that everything lands on the background channel of ImNodes below the nodes
+  ImDrawList* drawList = ImGui::GetWindowDrawList();
+  auto toScreen = [&](float x, float y) { return ImVec2(frame.OriginX + x, frame.OriginY + y); };
+  // Pins are placed from the rectangle of the node, the title, the outputs and every input are a row of equal height
+  auto getRowHeight = [&](NodeHandle node) {
+    return GetEditorRect(node).Height / (float)(OutputPinCount + 1 + GetSocketCount(node));
+  };
+  auto getOutputPin = [&](NodeHandle node) {
+    const EditorRect& rect = GetEditorRect(node);
+    return toScreen(rect.Right(), rect.Y + getRowHeight(node) * 1.5f);
+  };
+  auto getInputPin = [&](SocketHandle input) {
+    const EditorRect& rect = GetEditorRect(input.Node);
+    return toScreen(rect.X, rect.Y + getRowHeight(input.Node) * (OutputPinCount + 1.5f + input.Socket));
+  };
+
+  for (NodeHandle node : frame.Proxies) {
+    const EditorRect& rect = GetEditorRect(node);
+    drawList->AddRectFilled(toScreen(rect.X, rect.Y), toScreen(rect.Right(), rect.Bottom()), s_ProxyColor, 4.0f);
+    drawList->AddRect(toScreen(rect.X, rect.Y), toScreen(rect.Right(), rect.Bottom()), s_ProxyBorderColor, 4.0f);
+  }
+  // Only links with a visible end are drawn, links between two detailed nodes are left to ImNodes
+  for (const std::vector<NodeHandle>* nodes : { &frame.Detailed, &frame.Proxies }) {
+    for (NodeHandle node : *nodes) {
+      for (uint32_t socket = 0; socket < GetSocketCount(node); socket++) {
+        const NodeHandle source = GetLinkedNode({ node, socket });
+        if (source.IsNull() || (s_EditorMarks[node.Index] == Detailed && s_EditorMarks[source.Index] == Detailed)) {
+          continue;
+        }
+        drawList->AddLine(getOutputPin(source), getInputPin({ node, socket }), s_ClippedLinkColor, 2.0f);
+      }
+      // Links into visible nodes were drawn with their inputs
+      for (LinkHandle link : GetOutgoingLinks(node)) {
+        const SocketHandle target = GetLinkTarget(link);
+        if (s_EditorMarks[target.Node.Index] != Hidden) continue;
+        drawList->AddLine(getOutputPin(node), getInputPin(target), s_ClippedLinkColor, 2.0f);
+      }
+    }
+  }
+
+  for (NodeHandle node : frame.Detailed) {
+    const uint32_t i = GetIndex(node);
+    // ImNodes forgets the nodes that are not submitted in a frame, the tree owns their positions
+    const EditorRect& rect = m_NodeRects[i];
+    ImNodes::SetNodeGridSpacePos(m_NodeEditorIds[i], ImVec2(rect.X, rect.Y));
+    ImNodes::BeginNode(m_NodeEditorIds[i]);
+    ImNodes::BeginNodeTitleBar();
+    ImGui::TextUnformatted(m_NodeLabels[i].c_str());
+    ImNodes::EndNodeTitleBar();
+
+    ImNodes::BeginOutputAttribute(m_NodeOutputPinIds[i][0], ImNodesPinShape_TriangleFilled);
+    ImGui::Text("Output Socket");
+    ImNodes::EndOutputAttribute();
+
+    ImNodes::BeginOutputAttribute(m_NodeOutputPinIds[i][1], ImNodesPinShape_QuadFilled);
+    ImGui::Text("Output Socket");
+    ImNodes::EndOutputAttribute();
+
+    const SocketRange range = m_NodeSockets[i];
+    for (uint32_t socket = range.First; socket < range.First + range.Count; socket++) {
+      ImNodes::BeginInputAttribute(m_SocketPinIds[socket], ImNodesPinShape_CircleFilled);
+      ImGui::Text("Input Socket");
+      ImNodes::EndInputAttribute();
+    }
+
+    ImNodes::EndNode();
+  }
+
+  // Links start at the first output pin of their source
+  for (NodeHandle node : frame.Detailed) {
+    for (uint32_t socket = 0; socket < GetSocketCount(node); socket++) {
+      const LinkHandle link = GetLink({ node, socket });
+      if (link.IsNull() || s_EditorMarks[GetLinkSource(link).Index] != Detailed) continue;
+      ImNodes::Link(GetEditorId(link), GetEditorOutputPinId(GetLinkSource(link), 0), GetEditorPinId({ node, socket }));
+    }
+  }
+
+  for (NodeHandle node : frame.Detailed) s_EditorMarks[node.Index] = Hidden;
+  for (NodeHandle node : frame.Proxies) s_EditorMarks[node.Index] = Hidden;
+}
+
+bool NodesTree::UpdateEditorLayout(const EditorFrame& frame)
+{
+  bool moved = false;
+  for (NodeHandle node : frame.Detailed) {
+    // Nodes deleted since the frame was drawn
+    if (!Contains(node)) continue;
+    const int32_t id = GetEditorId(node);
+    const ImVec2 position = ImNodes::GetNodeGridSpacePos(id), size = ImNodes::GetNodeDimensions(id);
+    const EditorRect rect = GetEditorRect(node);
+    if (position.x != rect.X || position.y != rect.Y) {
+      SetEditorPosition(node, position.x, position.y);
+      moved = true;
+    }
+    if (size.x > 0.0f && size.y > 0.0f) SetEditorSize(node, size.x, size.y);
+  }
+  return moved;
 }
 
 } // namespace Texturia
@@ -2,37 +2,34 @@
 
 #include "txpch.hpp"
 
+#include "HandlePool.hpp"
+#include "IdTable.hpp"
+#include "PersistentVector.hpp"
+#include "SocketValue.hpp"
+
 #include <frameio/frameio.hpp>
 
+#include <array>
 #include <cstdint>
 #include <iterator>
-#include <variant>
+#include <map>
+#include <span>
+#include <string_view>
 
 namespace Texturia {
 
-struct VariantToString {
-  std::string operator()(bool value) { return value ? "true" : "false"; }
-  std::string operator()(char value) { return std::string(1, value); }
-  std::string operator()(int value) { return std::to_string(value); }
-  std::string operator()(float value) { return std::to_string(value); }
-  std::string operator()(double value) { return std::to_string(value); }
-  std::string operator()(const std::string& value) { return value; }
-};
-
-using NodeSocketType = std::variant<bool, int, float, char, std::string>;
-
 struct NodeSocket {
   Frameio::UUID UUID;
   std::string Label;
-  NodeSocketType Value;
+  SocketValue Value;
 
-  NodeSocket(std::string label, const NodeSocketType& initialValue) : Label(label), Value(initialValue) {}
+  NodeSocket(std::string label, const SocketValue& initialValue) : Label(std::move(label)), Value(initialValue) {}
   ~NodeSocket() = default;
 
   inline std::string ToString() const
   {
     std::ostringstream os;
-    os << Label << ": " << std::visit(VariantToString(), Value);
+    os << Label << ": " << VariantToString()(Value);
     return os.str();
   }
 };
@@ -40,20 +37,22 @@ struct NodeSocket {
 struct Node {
   std::string Label;
   Frameio::UUID UUID;
+  // Name of the kernel that evaluates this node, see Engine/Kernels.hpp
+  std::string Type;
 
   Node(const std::string& label = "Default Node", Frameio::UUID uuid = Frameio::UUID());
+  Node(const std::string& label, const std::string& type, std::vector<NodeSocket> sockets, Frameio::UUID uuid);
   ~Node() = default;
 
-  virtual void OnImGuiRender();
-
   inline std::string ToString() const
   {
     std::ostringstream os;
     os << "{\n  Label: " << Label << ","
        << "\n  UUID: " << UUID << ","
+       << "\n  Type: " << Type << ","
        << "\n  Sockets: {";
     if (!m_NodeSockets.empty()) {
-      for (NodeSocket nodeSocket : m_NodeSockets) { os << "\n    " << nodeSocket.ToString() << ", "; }
+      for (const NodeSocket& nodeSocket : m_NodeSockets) { os << "\n    " << nodeSocket.ToString() << ", "; }
       os.seekp(-2, os.cur);
     } else {
       os << "!EMPTY!";
@@ -62,6 +61,9 @@ struct Node {
     return os.str();
   }
 
+  inline std::vector<NodeSocket>& GetSockets() { return m_NodeSockets; }
+  inline const std::vector<NodeSocket>& GetSockets() const { return m_NodeSockets; }
+
 private:
   std::vector<Texturia::NodeSocket> m_NodeSockets;
 };
@@ -71,23 +73,210 @@ inline std::ostream& operator<<(std::ostream& os, const Node& node)
   return os << node.ToString();
 }
 
+// Connects the output of the node From to the input socket with index ToSocket of the node To
+struct NodeLink {
+  Frameio::UUID From;
+  Frameio::UUID To;
+  uint32_t ToSocket;
+};
+
+// Input socket with index Socket of the node Node
+struct SocketHandle {
+  NodeHandle Node;
+  uint32_t Socket = 0;
+
+  inline bool operator==(const SocketHandle& other) const = default;
+};
+
+// What an ImNodes pin ID stands for, either input socket Socket or output pin Socket of Node
+struct EditorPin {
+  NodeHandle Node;
+  uint32_t Socket = 0;
+  bool IsOutput = false;
+};
+
+// Rectangle in the grid space of the nodes editor, y points down like in ImGui
+struct EditorRect {
+  float X = 0.0f, Y = 0.0f, Width = 0.0f, Height = 0.0f;
+
+  inline float Right() const { return X + Width; }
+  inline float Bottom() const { return Y + Height; }
+  inline bool Overlaps(const EditorRect& other) const
+  {
+    return X < other.Right() && other.X < Right() && Y < other.Bottom() && other.Y < Bottom();
+  }
+};
+
+// What NodesTree::OnImGuiRender drew in one frame of the editor
+struct EditorFrame {
+  // Part of the grid space inside the editor window
+  EditorRect Visible;
+  // Screen position of the origin of the grid space
+  float OriginX = 0.0f, OriginY = 0.0f;
+  // Nodes submitted to ImNodes and nodes only drawn as rectangles, because more were visible than the detail budget
+  std::vector<NodeHandle> Detailed, Proxies;
+};
+
+class NodeGroup;
+
+// Nodes and their sockets live in dense structure of arrays columns, so passes over every node walk linear memory.
+// Nodes are addressed by generational NodeHandles, the UUID of a node is only used for a side index.
+// The columns are PersistentVectors, so copying a tree is O(1) and an edit afterwards only copies the leaves it writes
+// to. Const member functions never write to shared memory, which lets other threads read copies while this one edits.
 class NodesTree {
 public:
   NodesTree(std::string label = "Default Node Tree") : m_Label(label) {}
   ~NodesTree() = default;
 
-  void AddNode(const Node& node);
-  // Frameio::Ref<Node> GetNodeRef(const Frameio::UUID& uuid);
+  // Copy of the current version with every content hash up to date, it can be read from any thread
+  Frameio::Ref<const NodesTree> Snapshot() const;
+  // Forgets the content hashes, for copies that are kept around for undo and should not hold on to them. They are
+  // recomputed on the next call of GetContentHash or edit.
+  void DropContentHashes();
+
+  NodeHandle AddNode(const Node& node);
+  // Also removes every link from and to the node
   void DeleteNode(const Frameio::UUID& uuid);
+  void DeleteNode(NodeHandle handle);
+  // An input socket is driven by at most one output, so a link replaces the one already going into its socket.
+  // Returns a null handle and leaves the tree untouched if the link would close a cycle.
+  LinkHandle AddLink(const NodeLink& link);
+  LinkHandle AddLink(NodeHandle from, SocketHandle to);
+  void RemoveLink(LinkHandle handle);
   void Clear();
-  void OnImGuiRender();
+  // Grows the UUID index up front, for loaders that know how much is coming. The other columns grow a leaf at a time.
+  void Reserve(uint32_t nodeCount, uint32_t socketCount, uint32_t linkCount);
+
+  // Only the visible nodes of the editor are submitted to ImNodes, found through a spatial hash grid over the
+  // rectangles of the nodes. Past DetailBudget visible nodes the ones furthest from the center of the window are
+  // drawn as plain rectangles, ImNodes has no zoom so that is what a pile of nodes or a huge window gets. Links
+  // between two submitted nodes go through ImNodes, links with an end outside of the window are drawn as lines that
+  // the window clips. Has to be called between ImNodes::BeginNodeEditor and EndNodeEditor.
+  static constexpr uint32_t EditorDetailBudget = 512;
+  void OnImGuiRender(EditorFrame& frame);
+  // Reads the positions and sizes of the detailed nodes of frame back from ImNodes, has to be called after
+  // ImNodes::EndNodeEditor. Returns true if a node was moved.
+  bool UpdateEditorLayout(const EditorFrame& frame);
+
+  // Returns a null handle if there is no node with this UUID
+  NodeHandle FindNode(const Frameio::UUID& uuid) const;
+  inline bool Contains(NodeHandle handle) const { return m_Handles.Contains(handle); }
+  // Copies the node out of the columns
+  Node GetNode(NodeHandle handle) const;
+
+  // Nodes are densely indexed by [0, GetNodeCount()), deleting a node moves the last node into its index
+  inline uint32_t GetNodeCount() const { return m_Handles.Size(); }
+  inline NodeHandle GetHandle(uint32_t index) const { return m_Handles.GetHandle(index); }
+  inline uint32_t GetIndex(NodeHandle handle) const { return m_Handles.GetIndex(handle); }
+
+  inline const Frameio::UUID& GetUUID(NodeHandle handle) const { return m_NodeUUIDs[GetIndex(handle)]; }
+  inline const std::string& GetLabel(NodeHandle handle) const { return m_NodeLabels[GetIndex(handle)]; }
+  inline const std::string& GetType(NodeHandle handle) const
+  {
+    return m_Strings->Strings[m_NodeTypes[GetIndex(handle)]];
+  }
+  inline uint32_t GetSocketCount(NodeHandle handle) const { return m_NodeSockets[GetIndex(handle)].Count; }
+  inline const std::string& GetSocketLabel(NodeHandle handle, uint32_t socket) const
+  {
+    return m_Strings->Strings[m_SocketLabels[GetSocket(handle, socket)]];
+  }
+  inline SocketValue GetSocketValue(NodeHandle handle, uint32_t socket) const
+  {
+    uint32_t index = GetSocket(handle, socket);
+    return SocketValue(m_SocketTypes[index], m_SocketData[index]);
+  }
+  // The sockets of a node are stored next to each other, types and payloads in separate arrays
+  inline std::span<const SocketType> GetSocketTypes(NodeHandle handle) const
+  {
+    const SocketRange& range = m_NodeSockets[GetIndex(handle)];
+    return m_SocketTypes.GetSpan(range.First, range.Count);
+  }
+  inline std::span<const SocketData> GetSocketData(NodeHandle handle) const
+  {
+    const SocketRange& range = m_NodeSockets[GetIndex(handle)];
+    return m_SocketData.GetSpan(range.First, range.Count);
+  }
+  void SetSocketValue(NodeHandle handle, uint32_t socket, const SocketValue& value);
+
+  // Hash of the type and socket values of the node and of the content hashes of the nodes linked into it, so two
+  // nodes with equal hashes compute the same result. Nodes of a group add NodeGroup::GetHash. Labels and UUIDs are not
+  // part of it. Edits only mark the node and everything downstream of it dirty, the hashes of dirty nodes are
+  // recomputed on the next call.
+  uint64_t GetContentHash(NodeHandle handle) const;
+
+  // Definitions of the groups used by the tree, nodes whose type is the name of a group are nodes of it (see
+  // NodeGroup). They are shared by every copy of the tree, so undo steps and snapshots do not copy the bodies.
+  // SetGroup replaces the group with the same name and marks its nodes dirty. Removing a group leaves its nodes in
+  // the tree, they fail to evaluate until it is set again.
+  void SetGroup(Frameio::Ref<const NodeGroup> group);
+  void RemoveGroup(std::string_view name);
+  // nullptr if there is no group with the name
+  const NodeGroup* FindGroup(std::string_view name) const;
+  // In the order of their names
+  std::vector<Frameio::Ref<const NodeGroup>> GetGroups() const;
+
+  inline const Frameio::UUID& GetSocketUUID(NodeHandle handle, uint32_t socket) const
+  {
+    return m_SocketUUIDs[GetSocket(handle, socket)];
+  }
+
+  // Links are densely indexed by [0, GetLinkCount()) like nodes. Every input socket knows the link going into it and
+  // every node the links going out of it, so upstream and downstream queries only touch the neighbours of a node.
+  inline uint32_t GetLinkCount() const { return m_LinkHandles.Size(); }
+  inline LinkHandle GetLinkHandle(uint32_t index) const { return m_LinkHandles.GetHandle(index); }
+  inline bool Contains(LinkHandle handle) const { return m_LinkHandles.Contains(handle); }
+  inline NodeHandle GetLinkSource(LinkHandle handle) const { return m_LinkSources[m_LinkHandles.GetIndex(handle)]; }
+  inline SocketHandle GetLinkTarget(LinkHandle handle) const { return m_LinkTargets[m_LinkHandles.GetIndex(handle)]; }
+  // Null handles for sockets that are not linked
+  inline LinkHandle GetLink(SocketHandle input) const { return m_SocketLinks[GetSocket(input.Node, input.Socket)]; }
+  inline NodeHandle GetLinkedNode(SocketHandle input) const
+  {
+    LinkHandle link = GetLink(input);
+    return link.IsNull() ? NodeHandle() : GetLinkSource(link);
+  }
+  inline std::span<const LinkHandle> GetOutgoingLinks(NodeHandle handle) const
+  {
+    return m_NodeOutgoingLinks[GetIndex(handle)];
+  }
+  // Whether there is a path of links from the output of from into to, a node reaches itself
+  bool IsReachable(NodeHandle from, NodeHandle to) const;
+  // Every node comes after the nodes linked into it
+  std::vector<NodeHandle> GetTopologicalOrder() const;
+
+  // ImNodes only takes int IDs, which 64 bit UUIDs do not fit into. Nodes, pins and links get dense IDs from their own
+  // tables instead, every kind has its own ID space in ImNodes as well. Lookups of unused IDs return null handles.
+  static constexpr uint32_t OutputPinCount = 2;
+  static constexpr uint32_t MaxSocketCount = 64;
+  inline int32_t GetEditorId(NodeHandle handle) const { return m_NodeEditorIds[GetIndex(handle)]; }
+  inline int32_t GetEditorId(LinkHandle handle) const { return m_LinkEditorIds[m_LinkHandles.GetIndex(handle)]; }
+  inline int32_t GetEditorPinId(SocketHandle input) const
+  {
+    return m_SocketPinIds[GetSocket(input.Node, input.Socket)];
+  }
+  inline int32_t GetEditorOutputPinId(NodeHandle handle, uint32_t pin) const
+  {
+    return m_NodeOutputPinIds[GetIndex(handle)][pin];
+  }
+  // New nodes start at the origin with a size estimated from their sockets, until the editor measured them
+  inline const EditorRect& GetEditorRect(NodeHandle handle) const { return m_NodeRects[GetIndex(handle)]; }
+  void SetEditorPosition(NodeHandle handle, float x, float y);
+  void SetEditorSize(NodeHandle handle, float width, float height);
+  // Appends every node whose rectangle overlaps area, in no particular order
+  void FindEditorNodes(const EditorRect& area, std::vector<NodeHandle>& nodes) const;
+
+  inline NodeHandle FindEditorNode(int32_t id) const { return m_NodeIds.Find(id); }
+  inline LinkHandle FindEditorLink(int32_t id) const { return m_LinkIds.Find(id); }
+  inline EditorPin FindEditorPin(int32_t id) const { return m_PinIds.Find(id); }
+
+  inline const std::string& GetLabel() const { return m_Label; }
+  inline void SetLabel(std::string label) { m_Label = std::move(label); }
 
   inline std::string ToString() const
   {
     std::ostringstream os;
     os << m_Label << ":";
-    if (!m_Nodes.empty()) {
-      for (auto node : m_Nodes) os << "\n" + node.second.ToString();
+    if (GetNodeCount() > 0) {
+      for (uint32_t i = 0; i < GetNodeCount(); i++) os << "\n" << GetNode(GetHandle(i)).ToString();
     } else {
       os << " !EMPTY!";
     }
@@ -95,8 +284,113 @@ public:
   }
 
 private:
+  struct SocketRange {
+    uint32_t First, Count;
+  };
+  // Open addressing with linear probing, empty slots hold a null handle
+  struct UUIDSlot {
+    uint64_t UUID;
+    NodeHandle Node;
+  };
+  // The rectangle is kept next to the handle, so queries do not look up every node they come across
+  struct EditorCellEntry {
+    NodeHandle Node;
+    EditorRect Rect;
+  };
+  struct StringTable {
+    std::vector<std::string> Strings;
+    std::unordered_map<std::string, uint32_t> Index;
+  };
+  using GroupTable = std::map<std::string, Frameio::Ref<const NodeGroup>, std::less<>>;
+  // The sockets of a node are padded so that they never cross a leaf
+  static constexpr uint32_t SocketsPerLeaf = 256;
+  template <typename T>
+  using SocketColumn = PersistentVector<T, SocketsPerLeaf>;
+
+  inline uint32_t GetSocket(NodeHandle handle, uint32_t socket) const
+  {
+    const SocketRange& range = m_NodeSockets[GetIndex(handle)];
+    FR_ASSERT(socket < range.Count, "Node has no socket " + std::to_string(socket) + "!");
+    return range.First + socket;
+  }
+
+  uint32_t InternString(const std::string& string);
+  // First socket of a node with count sockets that are appended, holes pad the columns up to the next leaf if the
+  // sockets would not fit into the last one
+  uint32_t PadSockets(uint32_t count);
+  void CompactSockets();
+  void InsertUUID(uint64_t uuid, NodeHandle handle);
+  void EraseUUID(uint64_t uuid);
+  void ResizeUUIDIndex(uint32_t capacity);
+  // Cells of the grid are EditorCellSize wide and hashed into a power of two buckets, a node is in the cell of its top
+  // left corner
+  static constexpr float EditorCellSize = 512.0f;
+  static std::array<int32_t, 2> GetEditorCell(float x, float y);
+  uint32_t GetEditorBucket(std::array<int32_t, 2> cell) const;
+  // The rectangle of the node in m_NodeRects has to be set before it is inserted
+  void InsertEditorEntry(NodeHandle handle);
+  void EraseEditorEntry(NodeHandle handle);
+  void SetEditorRect(NodeHandle handle, const EditorRect& rect);
+  void ResizeEditorGrid(uint32_t bucketCount);
+  // Marks the node and every node downstream of it as dirty
+  void InvalidateContentHash(NodeHandle handle);
+  void UpdateContentHashes() const;
+  // Refills the hash columns after DropContentHashes
+  void RestoreContentHashes() const;
+
   std::string m_Label;
-  std::unordered_map<Frameio::UUID, Node> m_Nodes;
+
+  // Node columns, indexed by the dense index of m_Handles
+  HandlePool<NodeHandle> m_Handles;
+  PersistentVector<Frameio::UUID> m_NodeUUIDs;
+  PersistentVector<std::string> m_NodeLabels;
+  PersistentVector<uint32_t> m_NodeTypes;
+  PersistentVector<SocketRange> m_NodeSockets;
+  PersistentVector<std::vector<LinkHandle>> m_NodeOutgoingLinks;
+  PersistentVector<int32_t> m_NodeEditorIds;
+  PersistentVector<std::array<int32_t, OutputPinCount>> m_NodeOutputPinIds;
+  PersistentVector<EditorRect> m_NodeRects;
+  // Spatial hash grid over m_NodeRects, at most two nodes per bucket on average. Queries reach this far into the cells
+  // left and above of their area, for the nodes that start there.
+  PersistentVector<std::vector<EditorCellEntry>> m_EditorCells;
+  // Position of the node in its bucket, for swap and pop removal. Nodes without a layout all share one.
+  PersistentVector<uint32_t> m_NodeCellSlots;
+  float m_MaxNodeWidth = 0.0f, m_MaxNodeHeight = 0.0f;
+  // Power of two capacity, at most half full
+  PersistentVector<UUIDSlot> m_UUIDIndex;
+  // Recomputed lazily by GetContentHash, which makes it unsafe to call from several threads at once. Snapshots are
+  // taken with every hash up to date, so their GetContentHash only reads.
+  mutable PersistentVector<uint64_t> m_ContentHashes;
+  mutable PersistentVector<uint8_t> m_HashDirty;
+  mutable bool m_AnyHashDirty = false;
+
+  // Socket columns, the sockets of one node are stored next to each other. Deleted nodes and padding leave holes
+  // behind which get compacted once they take up more space than the live sockets.
+  SocketColumn<uint32_t> m_SocketLabels;
+  SocketColumn<SocketType> m_SocketTypes;
+  SocketColumn<SocketData> m_SocketData;
+  SocketColumn<Frameio::UUID> m_SocketUUIDs;
+  SocketColumn<LinkHandle> m_SocketLinks;
+  SocketColumn<int32_t> m_SocketPinIds;
+  uint32_t m_SocketHoles = 0;
+
+  // Type names and socket labels repeat a lot, so they are only stored once. Only new strings copy the table, and
+  // only if a copy of the tree still shares it.
+  Frameio::Ref<StringTable> m_Strings = std::make_shared<StringTable>();
+  // Copied like the string table, only by the first change of a copy
+  Frameio::Ref<GroupTable> m_Groups = std::make_shared<GroupTable>();
+
+  // Link columns, indexed by the dense index of m_LinkHandles
+  HandlePool<LinkHandle> m_LinkHandles;
+  PersistentVector<NodeHandle> m_LinkSources;
+  PersistentVector<SocketHandle> m_LinkTargets;
+  // Position of the link in m_NodeOutgoingLinks of its source, for swap and pop removal
+  PersistentVector<uint32_t> m_LinkOutgoingSlots;
+  PersistentVector<int32_t> m_LinkEditorIds;
+
+  IdTable<NodeHandle> m_NodeIds;
+  IdTable<EditorPin> m_PinIds;
+  IdTable<LinkHandle> m_LinkIds;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const NodesTree& nodesTree)
@@ -104,4 +398,51 @@ inline std::ostream& operator<<(std::ostream& os, const NodesTree& nodesTree)
   return os << nodesTree.ToString();
 }
 
+// Input socket Socket of the node Node in the body of a group
+struct GroupTarget {
+  Frameio::UUID Node;
+  uint32_t Socket = 0;
+};
+
+// Socket of the nodes of a group. Its value, or the node linked into it, replaces the value and link of every target.
+struct GroupParameter {
+  std::string Label;
+  // Also defines the type, which every target has to hold
+  SocketValue Default;
+  std::vector<GroupTarget> Targets;
+};
+
+// Subgraph that many nodes share, e.g. a brick pattern used all over a material. Its nodes are a single node each, with
+// the name of the group as their type and one socket per parameter, so a tree stores and the editor draws the body only
+// once per group. The engine compiles the body once and evaluates what the nodes of a group compute alike only once
+// (see EvaluationPlan::Build). Groups are immutable once created and do not nest.
+class NodeGroup {
+public:
+  // Returns nullptr and sets error if output or a target is not part of body, a target does not hold the type of its
+  // parameter, a socket is the target of two parameters or body has groups itself
+  static Frameio::Ref<const NodeGroup> Create(std::string name, NodesTree body, Frameio::UUID output,
+                                              std::vector<GroupParameter> parameters, std::string& error);
+
+  // Node of the group with the defaults of the parameters, an empty label uses the name
+  Node CreateNode(const std::string& label = "", Frameio::UUID uuid = Frameio::UUID()) const;
+
+  inline const std::string& GetName() const { return m_Name; }
+  inline const NodesTree& GetBody() const { return m_Body; }
+  inline const Frameio::UUID& GetOutput() const { return m_Output; }
+  inline const std::vector<GroupParameter>& GetParameters() const { return m_Parameters; }
+  // Content hash of the output of the body combined with the targets of the parameters and the UUIDs of the body,
+  // which key its random numbers. Groups with equal hashes compute the same for the same parameters.
+  inline uint64_t GetHash() const { return m_Hash; }
+
+private:
+  NodeGroup() = default;
+
+  std::string m_Name;
+  // Every content hash of the body is up to date, so it can be read from any thread
+  NodesTree m_Body;
+  Frameio::UUID m_Output = Frameio::UUID(0);
+  std::vector<GroupParameter> m_Parameters;
+  uint64_t m_Hash = 0;
+};
+
 } // namespace Texturia
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include <frameio/frameio.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+
+namespace Texturia {
+
+// Vector with structural sharing: elements live in leaves of LeafSize elements below a tree of 32 way branches.
+// Copying only copies the root pointer, writes copy the leaf and the branches above it if another copy still shares
+// them. Nodes are never changed once they are shared, so copies can be read from other threads while this one keeps
+// writing. LeafSize 0 picks about 4 KiB per leaf.
+template <typename T, uint32_t LeafSizeParam = 0>
+class PersistentVector {
+public:
+  static constexpr uint32_t LeafSize =
+      LeafSizeParam ? LeafSizeParam : std::bit_floor((uint32_t)std::clamp<size_t>(4096 / sizeof(T), 8, 4096));
+  static_assert(std::has_single_bit(LeafSize), "Leaves have to hold a power of two elements!");
+
+  inline uint32_t size() const { return m_Size; }
+  inline bool empty() const { return m_Size == 0; }
+
+  inline const T& operator[](uint32_t index) const { return GetLeaf(index)->Items()[index % LeafSize]; }
+  inline const T& back() const { return (*this)[m_Size - 1]; }
+
+  // Elements [first, first + count) are contiguous as long as they do not cross a multiple of LeafSize
+  inline std::span<const T> GetSpan(uint32_t first, uint32_t count) const
+  {
+    if (count == 0) return {};
+    FR_ASSERT(first / LeafSize == (first + count - 1) / LeafSize, "Span crosses a leaf of the vector!");
+    return { &(*this)[first], count };
+  }
+
+  // Copies the path to the element first if it is shared. The reference stays valid until the vector is copied.
+  inline T& Mutate(uint32_t index)
+  {
+    FR_ASSERT(index < m_Size, "Index " + std::to_string(index) + " is out of range!");
+    return MutateLeaf(index)->Items()[index % LeafSize];
+  }
+  inline void Set(uint32_t index, T value) { Mutate(index) = std::move(value); }
+
+  inline void push_back(T value)
+  {
+    if (m_Size == GetCapacity()) {
+      // The old root becomes the first child of a new one
+      if (m_Root) {
+        auto root = std::make_shared<Branch>();
+        root->Children[0] = std::move(m_Root);
+        m_Root = std::move(root);
+        m_Depth++;
+      }
+    }
+    m_Size++;
+    MutateLeaf(m_Size - 1)->Push(std::move(value));
+  }
+
+  inline void pop_back()
+  {
+    FR_ASSERT(m_Size > 0, "Vector is empty!");
+    MutateLeaf(m_Size - 1)->Pop();
+    if (--m_Size == 0) clear();
+  }
+
+  inline void clear()
+  {
+    m_Root.reset();
+    m_Size = 0;
+    m_Depth = 0;
+  }
+
+private:
+  static constexpr uint32_t BranchBits = 5, BranchSize = 1 << BranchBits;
+
+  // Elements are stored inline and only constructed once they are pushed, reads do not go through another pointer
+  struct Leaf {
+    uint32_t Count = 0;
+    alignas(T) unsigned char Storage[LeafSize * sizeof(T)];
+
+    Leaf() = default;
+    Leaf(const Leaf& other) : Count(other.Count) { std::uninitialized_copy_n(other.Items(), Count, Items()); }
+    Leaf& operator=(const Leaf&) = delete;
+    ~Leaf() { std::destroy_n(Items(), Count); }
+
+    inline T* Items() { return std::launder(reinterpret_cast<T*>(Storage)); }
+    inline const T* Items() const { return std::launder(reinterpret_cast<const T*>(Storage)); }
+    inline void Push(T value) { std::construct_at(Items() + Count++, std::move(value)); }
+    inline void Pop() { std::destroy_at(Items() + --Count); }
+  };
+  struct Branch {
+    // Leaves if this is the lowest level of branches
+    std::array<std::shared_ptr<void>, BranchSize> Children;
+  };
+
+  inline uint64_t GetCapacity() const { return m_Root ? (uint64_t)LeafSize << (m_Depth * BranchBits) : 0; }
+
+  inline const Leaf* GetLeaf(uint32_t index) const
+  {
+    const uint32_t leaf = index / LeafSize;
+    const void* node = m_Root.get();
+    // Reads are what the tree is walked for most, the depths of all but huge vectors get a path without a loop
+    auto child = [](const void* branch, uint32_t slot) {
+      return static_cast<const Branch*>(branch)->Children[slot % BranchSize].get();
+    };
+    if (m_Depth == 1) return static_cast<const Leaf*>(child(node, leaf));
+    if (m_Depth == 2) return static_cast<const Leaf*>(child(child(node, leaf >> BranchBits), leaf));
+    for (uint32_t level = m_Depth; level > 0; level--) {
+      node = static_cast<const Branch*>(node)->Children[(leaf >> ((level - 1) * BranchBits)) % BranchSize].get();
+    }
+    return static_cast<const Leaf*>(node);
+  }
+
+  // Returns the node as one only this vector points to, copying it if another vector shares it
+  template <typename Node>
+  static inline Node* MakeUnique(std::shared_ptr<void>& node)
+  {
+    if (!node) {
+      node = std::make_shared<Node>();
+    } else if (node.use_count() > 1) {
+      node = std::make_shared<Node>(*static_cast<const Node*>(node.get()));
+    } else {
+      // Pairs with the release of the last other owner, its reads happen before the writes that follow
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return static_cast<Node*>(node.get());
+  }
+
+  inline Leaf* MutateLeaf(uint32_t index)
+  {
+    const uint32_t leaf = index / LeafSize;
+    std::shared_ptr<void>* node = &m_Root;
+    for (uint32_t level = m_Depth; level > 0; level--) {
+      node = &MakeUnique<Branch>(*node)->Children[(leaf >> ((level - 1) * BranchBits)) % BranchSize];
+    }
+    return MakeUnique<Leaf>(*node);
+  }
+
+  std::shared_ptr<void> m_Root;
+  uint32_t m_Size = 0;
+  // Levels of branches above the leaves
+  uint32_t m_Depth = 0;
+};
+
+} // namespace Texturia
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+namespace Texturia {
+
+enum class SocketType : uint8_t {
+  Bool,
+  Int,
+  Float,
+  Vec2,
+  Vec3,
+  Vec4,
+  Color,
+  // Per pixel data, only available through a link. Float and color sockets accept links to images too.
+  Image
+};
+
+inline const char* GetSocketTypeName(SocketType type)
+{
+  switch (type) {
+    case SocketType::Bool:
+      return "Bool";
+    case SocketType::Int:
+      return "Int";
+    case SocketType::Float:
+      return "Float";
+    case SocketType::Vec2:
+      return "Vec2";
+    case SocketType::Vec3:
+      return "Vec3";
+    case SocketType::Vec4:
+      return "Vec4";
+    case SocketType::Color:
+      return "Color";
+    case SocketType::Image:
+      return "Image";
+  }
+  return "Unknown";
+}
+
+// Payload of a socket value, exactly one 16 byte SSE/NEON register
+struct alignas(16) SocketData {
+  union {
+    float Floats[4];
+    int32_t Ints[4];
+  };
+};
+
+// Constant value of a socket. Unlike a std::variant every type shares the same fixed size payload, so values can be
+// stored in plain arrays (NodesTree keeps the types and payloads in separate columns) and broadcast into SIMD
+// registers without branching on the type.
+struct SocketValue {
+  SocketData Data = {};
+  SocketType Type = SocketType::Float;
+
+  SocketValue() = default;
+  SocketValue(bool value) : Type(SocketType::Bool) { Data.Ints[0] = value; }
+  SocketValue(int32_t value) : Type(SocketType::Int) { Data.Ints[0] = value; }
+  SocketValue(float value) : Type(SocketType::Float) { Data.Floats[0] = value; }
+  SocketValue(const glm::vec2& value) : SocketValue(SocketType::Vec2, value.x, value.y, 0.0f, 0.0f) {}
+  SocketValue(const glm::vec3& value) : SocketValue(SocketType::Vec3, value.x, value.y, value.z, 0.0f) {}
+  SocketValue(const glm::vec4& value) : SocketValue(SocketType::Vec4, value.x, value.y, value.z, value.w) {}
+  SocketValue(SocketType type, const SocketData& data) : Data(data), Type(type) {}
+  // Would silently turn into a bool otherwise
+  SocketValue(const char*) = delete;
+
+  static inline SocketValue Color(float r, float g, float b, float a = 1.0f)
+  {
+    return SocketValue(SocketType::Color, r, g, b, a);
+  }
+  static inline SocketValue Image() { return SocketValue(SocketType::Image, 0.0f, 0.0f, 0.0f, 0.0f); }
+
+  // Scalars convert to floats, vectors return their first component
+  inline float AsFloat() const
+  {
+    return Type == SocketType::Bool || Type == SocketType::Int ? (float)Data.Ints[0] : Data.Floats[0];
+  }
+  inline int32_t AsInt() const
+  {
+    return Type == SocketType::Bool || Type == SocketType::Int ? Data.Ints[0] : (int32_t)Data.Floats[0];
+  }
+
+  // Calls visitor with the value as bool, int32_t, float, glm::vec2, glm::vec3 or glm::vec4 (colors and images)
+  template <typename Visitor>
+  inline auto Visit(Visitor&& visitor) const
+  {
+    const float* f = Data.Floats;
+    switch (Type) {
+      case SocketType::Bool:
+        return visitor(Data.Ints[0] != 0);
+      case SocketType::Int:
+        return visitor(Data.Ints[0]);
+      case SocketType::Vec2:
+        return visitor(glm::vec2(f[0], f[1]));
+      case SocketType::Vec3:
+        return visitor(glm::vec3(f[0], f[1], f[2]));
+      case SocketType::Vec4:
+      case SocketType::Color:
+      case SocketType::Image:
+        return visitor(glm::vec4(f[0], f[1], f[2], f[3]));
+      case SocketType::Float:
+        break;
+    }
+    return visitor(f[0]);
+  }
+
+  inline bool operator==(const SocketValue& other) const
+  {
+    return Type == other.Type && std::memcmp(&Data, &other.Data, sizeof(Data)) == 0;
+  }
+
+private:
+  SocketValue(SocketType type, float x, float y, float z, float w) : Type(type)
+  {
+    Data.Floats[0] = x;
+    Data.Floats[1] = y;
+    Data.Floats[2] = z;
+    Data.Floats[3] = w;
+  }
+};
+
+struct VariantToString {
+  std::string operator()(bool value) { return value ? "true" : "false"; }
+  std::string operator()(int32_t value) { return std::to_string(value); }
+  std::string operator()(float value) { return std::to_string(value); }
+  std::string operator()(const glm::vec2& value) { return Join(&value.x, 2); }
+  std::string operator()(const glm::vec3& value) { return Join(&value.x, 3); }
+  std::string operator()(const glm::vec4& value) { return Join(&value.x, 4); }
+  std::string operator()(const SocketValue& value) { return value.Visit(*this); }
+
+private:
+  std::string Join(const float* values, int count)
+  {
+    std::string result = "(";
+    for (int i = 0; i < count; i++) result += (i > 0 ? ", " : "") + std::to_string(values[i]);
+    return result + ")";
+  }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const SocketValue& value)
+{
+  return os << VariantToString()(value);
+}
+
+} // namespace Texturia
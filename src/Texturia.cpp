@@ -10,54 +10,40 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtx/vector_angle.hpp>
 
-// #include "LookupNodes.hpp"
+#include "Engine/ImageIO.hpp"
+#include "Engine/ImageWriter.hpp"
+#include "Engine/NodeRegistry.hpp"
+#include "Engine/Preview.hpp"
+#include "Engine/Profiler.hpp"
+#include "Hash.hpp"
 #include "Nodes.hpp"
+#include "UndoHistory.hpp"
+
+#include <algorithm>
+#include <cctype>
 
 namespace Texturia {
 
 class ViewportLayer : public Frameio::Layer {
 public:
-  ViewportLayer()
+  // Shows the output of nodesTree, which the GuiLayer edits. Previews and texture uploads are recorded into profiler.
+  ViewportLayer(Frameio::Ref<NodesTree> nodesTree, Frameio::Ref<Profiler> profiler)
       : Layer("Texturia: Gui"),
+        m_NodesTree(std::move(nodesTree)),
+        m_Profiler(std::move(profiler)),
         m_Camera(-1.6f, 1.6f, -0.9f, 0.9f),
         m_CameraMoveDirection(0.0f),
         m_BackgroundPosition(0.0f),
-        m_BackgroundScale(1.5f),
-        m_TrianglePosition(-0.2f),
-        m_TriangleScale(1.0f)
+        m_BackgroundScale(1.5f)
   {
+    m_Preview.SetProfiler(m_Profiler.get());
+
     Frameio::BufferLayout bufferLayout = {
       {Frameio::ShaderDataType::Float3,     "a_Position"},
       {Frameio::ShaderDataType::Float2, "a_TextureCoord"},
       {Frameio::ShaderDataType::Float4,        "a_Color"}
     };
 
-    // TRIANGLE
-    m_TriangleVertexArray = Frameio::VertexArray::Create();
-
-    float triangleVertices[3 * 9] = {
-      // clang-format off
-      //    x,     y,    z,     u,     v,    r,    g,    b,    a
-         0.0f,  0.5f, 0.0f,  0.5f,  1.0f, 0.1f, 0.6f, 1.0f, 1.0f,
-         0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 0.2f, 0.3f, 0.9f, 1.0f,
-        -0.5f, -0.5f, 0.0f,  0.0f,  0.0f, 0.4f, 0.1f, 1.0f, 1.0f
-      // clang-format on
-    };
-
-    uint32_t triangleIndices[3] = { 0, 1, 2 };
-
-    Frameio::Ref<Frameio::VertexBuffer> triangleVertexBuffer;
-    triangleVertexBuffer = Frameio::VertexBuffer::Create(sizeof(triangleVertices), triangleVertices);
-
-    triangleVertexBuffer->SetLayout(bufferLayout);
-    m_TriangleVertexArray->AddVertexBuffer(triangleVertexBuffer);
-
-    Frameio::Ref<Frameio::IndexBuffer> triangleIndexBuffer;
-    triangleIndexBuffer = Frameio::IndexBuffer::Create(sizeof(triangleIndices) / sizeof(uint32_t), triangleIndices);
-
-    m_TriangleVertexArray->SetIndexBuffer(triangleIndexBuffer);
-    // END TRIANGLE
-
     // SQUARE
     m_BackgroundVertexArray = Frameio::VertexArray::Create();
 
@@ -165,8 +151,8 @@ public:
     m_DebugShader = Frameio::Shader::Create(vertexSource, fragSrcVertexColor);
     m_TextureShader = Frameio::Shader::Create(vertexSource, fragSrcTexture);
 
-    m_GridTexture = Frameio::Texture2D::Create("assets/textures/Grid.png");
-    m_GridWithDotTexture = Frameio::Texture2D::Create("assets/textures/GridWithDot.png");
+    // Decoded on the threads of m_ImageIO, the first frames are drawn without it
+    m_GridWithDotLoad = m_ImageIO.Load("assets/textures/GridWithDot.png", false);
 
     m_TextureShader->Bind();
     std::dynamic_pointer_cast<Frameio::OpenGLShader>(m_TextureShader)->UploadUniformInt("u_Texture", 2);
@@ -209,6 +195,9 @@ public:
 
     m_Camera.SetRotation(glm::sin(m_Time));
 
+    UpdatePreview();
+    UpdateGridTexture();
+
     Frameio::RenderCommand::SetClearColor({ 0.09f, 0.09f, 0.09f, 1.0f });
     Frameio::RenderCommand::Clear();
 
@@ -219,17 +208,21 @@ public:
     //     ->UploadUniformFloat4("u_FlatColor", { 0.8f, 0.1f, 0.2f, 1.0f });
     Frameio::Renderer::Submit(m_BackgroundVertexArray, m_DebugShader, glm::scale(glm::vec3(1.6f * 2, 0.9f * 2, 1.0f)));
 
-    // Square
-    m_GridWithDotTexture->Bind(2);
-    Frameio::Renderer::Submit(
-        m_BackgroundVertexArray, m_TextureShader, glm::scale(glm::translate(m_BackgroundPosition), m_BackgroundScale));
-
-    // Triangle
-    m_GridTexture->Bind(2);
-    // std::dynamic_pointer_cast<Frameio::OpenGLShader>(m_DebugShader)
-    //     ->UploadUniformFloat4("u_FlatColor", { 0.1f, 0.2f, 0.8f, 1.0f });
-    Frameio::Renderer::Submit(
-        m_TriangleVertexArray, m_TextureShader, glm::scale(glm::translate(m_TrianglePosition), m_TriangleScale));
+    // Output of the node tree, the grid until the first preview level is done and nothing until the grid is loaded.
+    // Rows of both go from top to bottom and those of textures from bottom to top.
+    glm::vec3 scale = m_BackgroundScale;
+    if (m_PreviewTexture) {
+      m_PreviewTexture->Bind(2);
+      // Keeps the aspect ratio
+      scale *= glm::vec3((float)m_PreviewTexture->GetWidth() / m_PreviewTexture->GetHeight(), -1.0f, 1.0f);
+    } else if (m_GridWithDotTexture) {
+      m_GridWithDotTexture->Bind(2);
+      scale *= glm::vec3(1.0f, -1.0f, 1.0f);
+    }
+    if (m_PreviewTexture || m_GridWithDotTexture) {
+      Frameio::Renderer::Submit(
+          m_BackgroundVertexArray, m_TextureShader, glm::scale(glm::translate(m_BackgroundPosition), scale));
+    }
 
     Frameio::Renderer::EndScene();
   }
@@ -237,12 +230,17 @@ public:
   void OnImGuiRender() override
   {
     ImGui::Begin("Renderer Debug");
-    ImGui::PushID("Triangle");
-    ImGui::Text("Triangle");
-    ImGui::DragFloat3("Position", m_TrianglePosition);
-    // TODO Implement rotation of objects
-    ImGui::DragFloat3("Rotation", m_TrianglePosition);
-    ImGui::DragFloat3("Scale", m_TriangleScale, 1.0f);
+    ImGui::PushID("Preview");
+    ImGui::Text("Preview");
+    static const int resolutions[] = { 512, 1024, 2048, 4096, 8192 };
+    static const char* const resolutionNames[] = { "512", "1024", "2048", "4096", "8192" };
+    int resolution = (int)(std::find(std::begin(resolutions), std::end(resolutions), (int)m_PreviewSize) - resolutions);
+    if (ImGui::Combo("Resolution", &resolution, resolutionNames, IM_ARRAYSIZE(resolutionNames))) {
+      m_PreviewSize = (uint32_t)resolutions[resolution];
+    }
+    if (m_PreviewHash == 0) ImGui::Text("No Output node");
+    else if (m_PreviewDivisor == 0) ImGui::Text("Evaluating...");
+    else ImGui::Text("Showing 1/%u resolution, %.1f ms after the edit", m_PreviewDivisor, m_PreviewLatency * 1000.0f);
     ImGui::PopID();
     ImGui::PushID("Background");
     ImGui::Text("Background");
@@ -256,41 +254,125 @@ public:
   }
 
 private:
+  // Requests a new preview whenever the output or anything upstream of it changed and uploads finished levels
+  void UpdatePreview()
+  {
+    NodeHandle output;
+    for (uint32_t i = 0; i < m_NodesTree->GetNodeCount() && output.IsNull(); i++) {
+      if (m_NodesTree->GetType(m_NodesTree->GetHandle(i)) == "Output") output = m_NodesTree->GetHandle(i);
+    }
+    if (output.IsNull()) {
+      if (m_PreviewHash != 0) m_Preview.Cancel();
+      m_PreviewTexture.reset();
+      m_PreviewHash = 0;
+      m_PreviewDivisor = 0;
+      return;
+    }
+
+    // The content hash covers every node upstream of the output, so it only changes on edits that change the image
+    const uint64_t hash = HashCombine(m_NodesTree->GetContentHash(output), m_PreviewSize);
+    if (hash != m_PreviewHash) {
+      // The plan is built from the snapshot on the threads of m_Preview, the tree can be edited again right away
+      m_Preview.Request(m_NodesTree->Snapshot(), m_NodesTree->GetUUID(output), m_PreviewSize, m_PreviewSize);
+      m_PreviewHash = hash;
+    }
+
+    // Never blocks, the evaluation runs on the threads of m_Preview
+    const PreviewLevel* level = m_Preview.Poll();
+    if (!level) return;
+    ProfileScope scope(m_Profiler.get(), "Upload texture", "gpu");
+    scope.SetPixels((uint64_t)level->Width * level->Height);
+    scope.SetBytes(level->Pixels.size());
+    if (!m_PreviewTexture || m_PreviewTexture->GetWidth() != level->Width ||
+        m_PreviewTexture->GetHeight() != level->Height) {
+      m_PreviewTexture = Frameio::Texture2D::Create(level->Width, level->Height);
+    }
+    m_PreviewTexture->SetData(level->Pixels.data(), (uint32_t)level->Pixels.size());
+    m_PreviewDivisor = level->Divisor;
+    m_PreviewLatency = (float)level->Latency;
+  }
+
+  // Uploads the grid once m_ImageIO has decoded it
+  void UpdateGridTexture()
+  {
+    if (!m_GridWithDotLoad || !m_GridWithDotLoad->IsDone()) return;
+    const Frameio::Ref<const DecodedImage> grid = m_GridWithDotLoad->GetImage();
+    if (!grid) FR_ERROR("{0}", m_GridWithDotLoad->GetError());
+    m_GridWithDotLoad.reset();
+    if (!grid) return;
+
+    const Image& image = grid->GetLevel(0);
+    ProfileScope scope(m_Profiler.get(), "Upload texture", "gpu");
+    std::vector<uint8_t> pixels((size_t)image.GetWidth() * image.GetHeight() * 4);
+    for (uint32_t y = 0; y < image.GetHeight(); y++) {
+      ConvertToRGBA8(image, y, &pixels[(size_t)y * image.GetWidth() * 4]);
+    }
+    m_GridWithDotTexture = Frameio::Texture2D::Create(image.GetWidth(), image.GetHeight());
+    m_GridWithDotTexture->SetData(pixels.data(), (uint32_t)pixels.size());
+  }
+
+  Frameio::Ref<NodesTree> m_NodesTree;
+  Frameio::Ref<Profiler> m_Profiler;
+  // Loads the assets of the viewport, two threads are plenty for them
+  ImageIO m_ImageIO{ 2 };
+  Frameio::Ref<ImageTask> m_GridWithDotLoad;
+  PreviewRenderer m_Preview;
+  Frameio::Ref<Frameio::Texture2D> m_PreviewTexture;
+  uint64_t m_PreviewHash = 0;
+  uint32_t m_PreviewSize = 1024;
+  // Divisor of the level m_PreviewTexture holds, 0 until the first one is done
+  uint32_t m_PreviewDivisor = 0;
+  // Seconds from the edit until that level was done
+  float m_PreviewLatency = 0.0f;
+
   float m_Time = 0.0f;
 
   Frameio::OrthographicCamera m_Camera;
   float m_CameraMoveSpeed = 1.5f;
 
   glm::vec3 m_CameraMoveDirection;
-  Frameio::Ref<Frameio::Texture2D> m_GridTexture, m_GridWithDotTexture;
+  Frameio::Ref<Frameio::Texture2D> m_GridWithDotTexture;
   Frameio::Ref<Frameio::Shader> m_DebugShader, m_TextureShader;
-  Frameio::Ref<Frameio::VertexArray> m_TriangleVertexArray;
-  glm::vec3 m_TrianglePosition;
-  glm::vec3 m_TriangleScale;
   Frameio::Ref<Frameio::VertexArray> m_BackgroundVertexArray;
   glm::vec3 m_BackgroundPosition;
   glm::vec3 m_BackgroundScale;
 };
 
-// TODO find out how to use m_NodesTree in here
-// TODO display more information about the Node by getting its data from m_NodesTree
-//! The displayed ID might not be the same as the one saved in our Node object because we use uint64_t and not int
-void MiniMapNodeHoverCallback(int nodeUUID, void* userData)
+// userData is the NodesTree drawn by the editor, nodeId one of its editor IDs
+void MiniMapNodeHoverCallback(int nodeId, void* userData)
 {
-  ImGui::SetTooltip("Node UUID: %d", nodeUUID);
+  const NodesTree& tree = *(const NodesTree*)userData;
+  NodeHandle node = tree.FindEditorNode(nodeId);
+  if (node.IsNull()) return;
+
+  ImGui::SetTooltip("%s\nType: %s\nUUID: %llu", tree.GetLabel(node).c_str(), tree.GetType(node).c_str(),
+                    (unsigned long long)tree.GetUUID(node));
 }
 
 class GuiLayer : public Frameio::Layer {
 public:
-  GuiLayer() : Layer("Texturia: Gui")
+  GuiLayer(Frameio::Ref<NodesTree> nodesTree, Frameio::Ref<Profiler> profiler)
+      : Layer("Texturia: Gui"), m_NodesTree(std::move(nodesTree)), m_Profiler(std::move(profiler))
   {
-    m_NodesTree = std::make_shared<NodesTree>("Main Nodes Tree");
     m_NodesTree->AddNode(Node("Old Node 1", 2147483647));
-    //! This UUID causes ImNodes to use -2147483648 because of integer overflow
+    // ImNodes never sees UUIDs, so ones beyond the int range are fine
     m_NodesTree->AddNode(Node("Old Node 2", 2147483648));
 
     m_NodesTree->AddNode(Node("New Node 1", Frameio::UUID(Frameio::Int32Range)));
     m_NodesTree->AddNode(Node("New Node 2", Frameio::UUID(Frameio::Int32Range)));
+
+    // Something for the viewport to show
+    Node gradient = CreateNode("Gradient");
+    Node checker = CreateNode("Checker");
+    Node output = CreateNode("Output");
+    float x = 0.0f;
+    for (const Node* node : { &gradient, &checker, &output }) {
+      m_NodesTree->SetEditorPosition(m_NodesTree->AddNode(*node), x, 200.0f);
+      x += 220.0f;
+    }
+    m_NodesTree->AddLink({ gradient.UUID, checker.UUID, 2 });
+    m_NodesTree->AddLink({ checker.UUID, output.UUID, 0 });
+    m_History.Commit(*m_NodesTree);
   }
 
   void OnImGuiRender() override
@@ -298,11 +380,19 @@ public:
     static bool showDemoWindow = false;
     static bool showMetricsWindow = true;
     static bool showNodesEditorWindow = false;
+    static bool showProfilerWindow = false;
 
     if (ImGui::BeginMainMenuBar()) {
+      if (ImGui::BeginMenu("Edit")) {
+        if (ImGui::MenuItem("Undo", "Ctrl+Z", false, m_History.CanUndo())) m_History.Undo(*m_NodesTree);
+        if (ImGui::MenuItem("Redo", "Ctrl+Y", false, m_History.CanRedo())) m_History.Redo(*m_NodesTree);
+        ImGui::EndMenu();
+      }
+
       if (ImGui::BeginMenu("View")) {
         if (ImGui::MenuItem("ImGui Demo")) showDemoWindow = showDemoWindow ? false : true;
         if (ImGui::MenuItem("Metrics")) showMetricsWindow = showMetricsWindow ? false : true;
+        if (ImGui::MenuItem("Profiler")) showProfilerWindow = showProfilerWindow ? false : true;
         if (ImGui::MenuItem("Nodes Editor")) showMetricsWindow = showNodesEditorWindow ? false : true;
         ImGui::EndMenu();
       }
@@ -327,6 +417,10 @@ public:
 
     if (showMetricsWindow) ImGui::ShowMetricsWindow(&showMetricsWindow);
 
+    // Read once per frame, the panel and the heat overlay show the same numbers
+    if (m_Profiler->IsRecording() || m_NodeProfiles.empty()) m_NodeProfiles = m_Profiler->GetNodeProfiles();
+    if (showProfilerWindow) DrawProfiler(&showProfilerWindow);
+
     // // Note that since many nodes can be selected at once, we first need to query the number of
     // // selected nodes before getting them.
     // static std::vector<int> selectedNodes;
@@ -339,28 +433,45 @@ public:
     // }
 
     if (showNodesEditorWindow) {
-      static std::vector<std::pair<int, int>> links;
-
       ImGui::Begin("Nodes Editor");
       ImNodes::BeginNodeEditor();
 
-      m_NodesTree->OnImGuiRender();
+      // Also draws the links, only the visible part of the tree is submitted
+      m_NodesTree->OnImGuiRender(m_EditorFrame);
 
-      ImNodes::MiniMap(0.2f, ImNodesMiniMapLocation_BottomLeft, MiniMapNodeHoverCallback);
-
-      for (int i = 0; i < links.size(); ++i) {
-        const std::pair<int, int> link = links[i];
-        ImNodes::Link(i, link.first, link.second);
-      }
+      // Only knows the submitted nodes, so it shows the surroundings of the visible part
+      ImNodes::MiniMap(0.2f, ImNodesMiniMapLocation_BottomLeft, MiniMapNodeHoverCallback, m_NodesTree.get());
 
       ImNodes::EndNodeEditor();
+      // A drag becomes one version once the mouse is released
+      m_NodesMoved |= m_NodesTree->UpdateEditorLayout(m_EditorFrame);
+      if (m_NodesMoved && !ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+        m_History.Commit(*m_NodesTree);
+        m_NodesMoved = false;
+      }
+      if (m_ShowHeat) DrawHeatOverlay();
+      DrawAddNodePopup();
+
+      int linkId;
+      if (ImNodes::IsLinkDestroyed(&linkId)) {
+        LinkHandle link = m_NodesTree->FindEditorLink(linkId);
+        if (!link.IsNull()) {
+          m_NodesTree->RemoveLink(link);
+          m_History.Commit(*m_NodesTree);
+        }
+      }
 
-      // TODO Integrate linking in own Nodes API with own UUIDs
-      int start_attr, end_attr;
-      if (ImNodes::IsLinkCreated(&start_attr, &end_attr)) { links.push_back(std::make_pair(start_attr, end_attr)); }
-
-      int linkID;
-      if (ImNodes::IsLinkDestroyed(&linkID)) { links.erase(links.begin() + linkID); }
+      int startPin, endPin;
+      if (ImNodes::IsLinkCreated(&startPin, &endPin)) {
+        // The link can be dragged out of either end
+        EditorPin start = m_NodesTree->FindEditorPin(startPin), end = m_NodesTree->FindEditorPin(endPin);
+        if (!start.IsOutput) std::swap(start, end);
+        // AddLink rejects links that would close a cycle
+        if (!start.Node.IsNull() && !end.Node.IsNull() && start.IsOutput && !end.IsOutput &&
+            !m_NodesTree->AddLink(start.Node, { end.Node, end.Socket }).IsNull()) {
+          m_History.Commit(*m_NodesTree);
+        }
+      }
 
       ImGui::End();
     }
@@ -372,18 +483,170 @@ public:
       Frameio::KeyTypedEvent& e = (Frameio::KeyTypedEvent&)event;
       FR_TRACE((char)e.GetKeyCode());
     }
+
+    if (event.GetEventType() == Frameio::EventType::KeyPressed && ImGui::GetIO().KeyCtrl) {
+      Frameio::KeyPressedEvent& e = (Frameio::KeyPressedEvent&)event;
+      if (e.GetKeyCode() == FR_KEY_Z) m_History.Undo(*m_NodesTree);
+      if (e.GetKeyCode() == FR_KEY_Y) m_History.Redo(*m_NodesTree);
+    }
   }
 
 private:
+  // Nodes sorted by the time they took, with buttons to record, clear and save a trace
+  void DrawProfiler(bool* open)
+  {
+    ImGui::Begin("Profiler", open);
+    bool recording = m_Profiler->IsRecording();
+    if (ImGui::Checkbox("Record", &recording)) m_Profiler->SetRecording(recording);
+    ImGui::SameLine();
+    if (ImGui::Button("Clear")) {
+      m_Profiler->Clear();
+      m_NodeProfiles.clear();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Save trace")) {
+      m_TraceStatus = m_Profiler->WriteChromeTrace(s_TracePath) ? std::string("Saved ") + s_TracePath
+                                                                 : std::string("Failed to write ") + s_TracePath;
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Heat overlay", &m_ShowHeat);
+    if (!m_TraceStatus.empty()) ImGui::TextUnformatted(m_TraceStatus.c_str());
+    if (uint64_t dropped = m_Profiler->GetDroppedEventCount()) {
+      ImGui::Text("%llu events did not fit into the trace", (unsigned long long)dropped);
+    }
+
+    if (ImGui::BeginTable("Nodes", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+      ImGui::TableSetupColumn("Node");
+      ImGui::TableSetupColumn("Type");
+      ImGui::TableSetupColumn("Time (ms)");
+      ImGui::TableSetupColumn("Mpix");
+      ImGui::TableSetupColumn("Read (MiB)");
+      ImGui::TableSetupColumn("Allocated (MiB)");
+      ImGui::TableHeadersRow();
+      for (const NodeProfile& profile : m_NodeProfiles) {
+        // Nodes that were deleted since are still listed by their UUID
+        const NodeHandle node = m_NodesTree->FindNode(profile.Node);
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        if (node.IsNull()) ImGui::Text("%llu", (unsigned long long)profile.Node);
+        else ImGui::TextUnformatted(m_NodesTree->GetLabel(node).c_str());
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(profile.Type);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", profile.Nanoseconds * 1e-6);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", profile.Pixels * 1e-6);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", profile.BytesRead / 1048576.0);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", profile.BytesAllocated / 1048576.0);
+      }
+      ImGui::EndTable();
+    }
+    ImGui::End();
+  }
+
+  // Tints every profiled node in the editor from blue to red by its share of the time of the slowest node, has to be
+  // called in the window of the editor after ImNodes::EndNodeEditor
+  void DrawHeatOverlay()
+  {
+    if (m_NodeProfiles.empty() || m_NodeProfiles.front().Nanoseconds == 0) return;
+    const double slowest = (double)m_NodeProfiles.front().Nanoseconds;
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    for (const NodeProfile& profile : m_NodeProfiles) {
+      const NodeHandle node = m_NodesTree->FindNode(profile.Node);
+      if (node.IsNull() || !m_NodesTree->GetEditorRect(node).Overlaps(m_EditorFrame.Visible)) continue;
+      const EditorRect& rect = m_NodesTree->GetEditorRect(node);
+      const ImVec2 min(m_EditorFrame.OriginX + rect.X, m_EditorFrame.OriginY + rect.Y);
+      const float heat = (float)(profile.Nanoseconds / slowest);
+      const ImU32 color = ImGui::ColorConvertFloat4ToU32(ImVec4(heat, 0.2f, 1.0f - heat, 0.25f + 0.35f * heat));
+      drawList->AddRectFilled(min, ImVec2(min.x + rect.Width, min.y + rect.Height), color, 4.0f);
+    }
+  }
+
+  // Right clicking the editor opens a popup that searches the groups of the tree and the NodeRegistry as one types,
+  // the picked type is added where the popup was opened. Enter picks the best match. Has to be called after
+  // ImNodes::EndNodeEditor.
+  void DrawAddNodePopup()
+  {
+    if (ImNodes::IsEditorHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Right)) {
+      m_AddNodeFilter[0] = '\0';
+      m_AddNodePosition = ImGui::GetMousePos();
+      ImGui::OpenPopup("Add Node");
+    }
+    if (!ImGui::BeginPopup("Add Node")) return;
+
+    if (ImGui::IsWindowAppearing()) ImGui::SetKeyboardFocusHere();
+    const bool entered = ImGui::InputText("##Filter", m_AddNodeFilter, sizeof(m_AddNodeFilter),
+                                          ImGuiInputTextFlags_EnterReturnsTrue);
+    const std::vector<const NodeType*> types = GetNodeRegistry().Search(m_AddNodeFilter);
+
+    // A tree only has a few groups, they come first and match by a case insensitive substring
+    std::vector<Frameio::Ref<const NodeGroup>> groups = m_NodesTree->GetGroups();
+    const std::string_view filter = m_AddNodeFilter;
+    auto matches = [&](const std::string& name) {
+      auto equal = [](char a, char b) { return std::tolower((unsigned char)a) == std::tolower((unsigned char)b); };
+      return std::search(name.begin(), name.end(), filter.begin(), filter.end(), equal) != name.end();
+    };
+    std::erase_if(groups, [&](const Frameio::Ref<const NodeGroup>& group) { return !matches(group->GetName()); });
+
+    const NodeGroup* pickedGroup = entered && !groups.empty() ? groups.front().get() : nullptr;
+    const NodeType* picked = entered && groups.empty() && !types.empty() ? types.front() : nullptr;
+    for (const Frameio::Ref<const NodeGroup>& group : groups) {
+      ImGui::PushID(group.get());
+      if (ImGui::Selectable(group->GetName().c_str())) pickedGroup = group.get();
+      ImGui::SameLine(ImGui::GetWindowContentRegionMax().x - ImGui::CalcTextSize("Groups").x);
+      ImGui::TextDisabled("Groups");
+      ImGui::PopID();
+    }
+    for (const NodeType* type : types) {
+      if (ImGui::Selectable(type->Name.c_str())) picked = type;
+      ImGui::SameLine(ImGui::GetWindowContentRegionMax().x - ImGui::CalcTextSize(type->Category.c_str()).x);
+      ImGui::TextDisabled("%s", type->Category.c_str());
+    }
+    if (types.empty() && groups.empty()) ImGui::TextDisabled("No node types match");
+
+    if (picked || pickedGroup) {
+      const NodeHandle node = m_NodesTree->AddNode(pickedGroup ? pickedGroup->CreateNode() : picked->Create());
+      m_NodesTree->SetEditorPosition(node, m_AddNodePosition.x - m_EditorFrame.OriginX,
+                                     m_AddNodePosition.y - m_EditorFrame.OriginY);
+      m_History.Commit(*m_NodesTree);
+      ImGui::CloseCurrentPopup();
+    }
+    ImGui::EndPopup();
+  }
+
+  // Relative to the working directory, there is no file dialog yet
+  static constexpr const char* s_TracePath = "texturia-trace.json";
+
   Frameio::Ref<NodesTree> m_NodesTree;
+  // Every edit made in the nodes editor is a version, undo swaps an older one into m_NodesTree
+  UndoHistory m_History;
+
+  // Shared with the ViewportLayer, which records the previews into it
+  Frameio::Ref<Profiler> m_Profiler;
+  std::vector<NodeProfile> m_NodeProfiles;
+  std::string m_TraceStatus;
+  bool m_ShowHeat = true;
+
+  // What the nodes editor drew last frame
+  EditorFrame m_EditorFrame;
+  bool m_NodesMoved = false;
+
+  char m_AddNodeFilter[64] = {};
+  ImVec2 m_AddNodePosition;
 };
 
 class TexturiaApp : public Frameio::App {
 public:
   TexturiaApp()
   {
-    PushLayer(new ViewportLayer());
-    PushOverlay(new GuiLayer());
+    // Edited by the GuiLayer, previewed by the ViewportLayer
+    Frameio::Ref<NodesTree> nodesTree = std::make_shared<NodesTree>("Main Nodes Tree");
+    // Off until it is switched on in the profiler panel of the GuiLayer
+    Frameio::Ref<Profiler> profiler = std::make_shared<Profiler>(false);
+    PushLayer(new ViewportLayer(nodesTree, profiler));
+    PushOverlay(new GuiLayer(nodesTree, profiler));
   }
 
   ~TexturiaApp() = default;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "txpch.hpp"
+
+#include "Nodes.hpp"
+
+#include <deque>
+
+namespace Texturia {
+
+// Versions of a NodesTree to step back and forth between. Copies of a tree share everything but what was edited in
+// between, so a version costs about as much memory as its edit wrote to, not a copy of the whole tree.
+class UndoHistory {
+public:
+  // Only the newest limit versions are kept
+  explicit UndoHistory(size_t limit = 256) : m_Limit(std::max<size_t>(limit, 1)) {}
+
+  // Records the tree after an edit as the newest version, versions that could have been redone are dropped
+  inline void Commit(const NodesTree& tree)
+  {
+    if (!m_Versions.empty()) m_Versions.resize(m_Current + 1);
+    m_Versions.push_back(tree);
+    m_Versions.back().DropContentHashes();
+    if (m_Versions.size() > m_Limit) m_Versions.pop_front();
+    m_Current = m_Versions.size() - 1;
+  }
+
+  inline bool CanUndo() const { return m_Current > 0; }
+  inline bool CanRedo() const { return m_Current + 1 < m_Versions.size(); }
+
+  // Replace tree with the version before or after the current one, return false if there is none
+  inline bool Undo(NodesTree& tree)
+  {
+    if (!CanUndo()) return false;
+    tree = m_Versions[--m_Current];
+    return true;
+  }
+  inline bool Redo(NodesTree& tree)
+  {
+    if (!CanRedo()) return false;
+    tree = m_Versions[++m_Current];
+    return true;
+  }
+
+  inline size_t GetVersionCount() const { return m_Versions.size(); }
+  inline void Clear()
+  {
+    m_Versions.clear();
+    m_Current = 0;
+  }
+
+private:
+  std::deque<NodesTree> m_Versions;
+  // Version the tree was at after the last Commit, Undo or Redo
+  size_t m_Current = 0;
+  size_t m_Limit;
+};
+
+} // namespace Texturia
@@ -0,0 +1,742 @@
+// texturia-bake: evaluates a node tree without a window, GL context or ImGui and writes the result to disk.
+
+#include "Engine/Batch.hpp"
+#include "Engine/Evaluator.hpp"
+#include "Engine/GraphFile.hpp"
+#include "Engine/GraphJson.hpp"
+#include "Engine/ImageIO.hpp"
+#include "Engine/ImagePool.hpp"
+#include "Engine/ImageWriter.hpp"
+#include "Engine/Kernels.hpp"
+#include "Engine/NodeRegistry.hpp"
+#include "Engine/Profiler.hpp"
+#include "Engine/Simd.hpp"
+#include "Engine/ThreadPool.hpp"
+#include "Engine/TiffWriter.hpp"
+#include "Hash.hpp"
+#include "Nodes.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <thread>
+
+#ifdef TX_PLATFORM_WINDOWS
+  #define WIN32_LEAN_AND_MEAN
+  #define NOMINMAX
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+using namespace Texturia;
+
+namespace {
+
+// Built in sample graphs, each returns the UUID of its output node
+using GraphBuilder = std::function<Frameio::UUID(NodesTree& tree)>;
+
+Frameio::UUID BuildCheckerGraph(NodesTree& tree)
+{
+  Node gradient = CreateNode("Gradient");
+  Node checker = CreateNode("Checker");
+  Node output = CreateNode("Output");
+  tree.AddNode(gradient);
+  tree.AddNode(checker);
+  tree.AddNode(output);
+  tree.AddLink({ gradient.UUID, checker.UUID, 2 });
+  tree.AddLink({ checker.UUID, output.UUID, 0 });
+  return output.UUID;
+}
+
+Frameio::UUID BuildGradientGraph(NodesTree& tree)
+{
+  Node horizontal = CreateNode("Gradient");
+  Node vertical = CreateNode("Gradient");
+  vertical.GetSockets()[0].Value = true;
+  Node color = CreateNode("Constant");
+  color.GetSockets()[0].Value = SocketValue::Color(1.0f, 0.4f, 0.1f);
+  Node mix = CreateNode("Mix");
+  Node output = CreateNode("Output");
+  for (const Node* node : { &horizontal, &vertical, &color, &mix, &output }) tree.AddNode(*node);
+  tree.AddLink({ color.UUID, mix.UUID, 0 });
+  tree.AddLink({ horizontal.UUID, mix.UUID, 1 });
+  tree.AddLink({ vertical.UUID, mix.UUID, 2 });
+  tree.AddLink({ mix.UUID, output.UUID, 0 });
+  return output.UUID;
+}
+
+// Ridged fractal noise tinted by a Worley pattern
+Frameio::UUID BuildNoiseGraph(NodesTree& tree)
+{
+  Node fractal = CreateNode("Fractal Noise");
+  fractal.GetSockets()[6].Value = true;
+  Node worley = CreateNode("Worley Noise");
+  Node color = CreateNode("Constant");
+  color.GetSockets()[0].Value = SocketValue::Color(0.2f, 0.5f, 0.9f);
+  Node multiply = CreateNode("Multiply");
+  Node mix = CreateNode("Mix");
+  Node output = CreateNode("Output");
+  for (const Node* node : { &fractal, &worley, &color, &multiply, &mix, &output }) tree.AddNode(*node);
+  tree.AddLink({ worley.UUID, multiply.UUID, 0 });
+  tree.AddLink({ color.UUID, multiply.UUID, 1 });
+  tree.AddLink({ fractal.UUID, mix.UUID, 0 });
+  tree.AddLink({ multiply.UUID, mix.UUID, 1 });
+  tree.AddLink({ mix.UUID, output.UUID, 0 });
+  return output.UUID;
+}
+
+// Normal map of a fractal height field, darkened by its ambient occlusion
+Frameio::UUID BuildTerrainGraph(NodesTree& tree)
+{
+  Node height = CreateNode("Fractal Noise");
+  Node normal = CreateNode("Height To Normal");
+  normal.GetSockets()[1].Value = 4.0f;
+  Node occlusion = CreateNode("Ambient Occlusion");
+  Node multiply = CreateNode("Multiply");
+  Node output = CreateNode("Output");
+  for (const Node* node : { &height, &normal, &occlusion, &multiply, &output }) tree.AddNode(*node);
+  tree.AddLink({ height.UUID, normal.UUID, 0 });
+  tree.AddLink({ height.UUID, occlusion.UUID, 0 });
+  tree.AddLink({ normal.UUID, multiply.UUID, 0 });
+  tree.AddLink({ occlusion.UUID, multiply.UUID, 1 });
+  tree.AddLink({ multiply.UUID, output.UUID, 0 });
+  return output.UUID;
+}
+
+// Eight nodes of a group of tiles darkened by the ambient occlusion of a dirt layer, mixed together. The dirt does not
+// depend on the parameters and the nodes only use four distinct ones, so the plan shares the dirt between all of them
+// and has four copies of the rest.
+Frameio::UUID BuildTilesGraph(NodesTree& tree)
+{
+  NodesTree body("Tiles");
+  Node dirt = CreateNode("Fractal Noise", "Dirt");
+  Node occlusion = CreateNode("Ambient Occlusion");
+  Node tiles = CreateNode("Checker");
+  Node multiply = CreateNode("Multiply");
+  for (const Node* node : { &dirt, &occlusion, &tiles, &multiply }) body.AddNode(*node);
+  body.AddLink({ dirt.UUID, occlusion.UUID, 0 });
+  body.AddLink({ tiles.UUID, multiply.UUID, 0 });
+  body.AddLink({ occlusion.UUID, multiply.UUID, 1 });
+
+  std::string error;
+  std::vector<GroupParameter> parameters = { { "Scale", 8, { { tiles.UUID, 0 } } },
+                                              { "Color", SocketValue::Color(1.0f, 1.0f, 1.0f), { { tiles.UUID, 2 } } } };
+  const Frameio::Ref<const NodeGroup> group =
+      NodeGroup::Create("Tiles", std::move(body), multiply.UUID, std::move(parameters), error);
+  FR_ASSERT(group, error);
+  tree.SetGroup(group);
+
+  const SocketValue colors[] = { SocketValue::Color(0.8f, 0.4f, 0.3f), SocketValue::Color(0.6f, 0.6f, 0.7f) };
+  Node output = CreateNode("Output");
+  tree.AddNode(output);
+  Frameio::UUID previous(0);
+  for (int32_t i = 0; i < 8; i++) {
+    Node instance = group->CreateNode("Tiles " + std::to_string(i + 1));
+    instance.GetSockets()[0].Value = 4 + 4 * (i % 2);
+    instance.GetSockets()[1].Value = colors[i / 2 % 2];
+    tree.AddNode(instance);
+    if (i == 0) {
+      previous = instance.UUID;
+      continue;
+    }
+    Node mix = CreateNode("Mix");
+    mix.GetSockets()[2].Value = 1.0f / (float)(i + 1);
+    tree.AddNode(mix);
+    tree.AddLink({ previous, mix.UUID, 0 });
+    tree.AddLink({ instance.UUID, mix.UUID, 1 });
+    previous = mix.UUID;
+  }
+  tree.AddLink({ previous, output.UUID, 0 });
+  return output.UUID;
+}
+
+// The first --bitmap, sharpened
+Frameio::UUID BuildBitmapGraph(NodesTree& tree)
+{
+  Node bitmap = CreateNode("Bitmap");
+  bitmap.GetSockets()[0].Value = 1;
+  Node sharpen = CreateNode("Sharpen");
+  Node output = CreateNode("Output");
+  for (const Node* node : { &bitmap, &sharpen, &output }) tree.AddNode(*node);
+  tree.AddLink({ bitmap.UUID, sharpen.UUID, 0 });
+  tree.AddLink({ sharpen.UUID, output.UUID, 0 });
+  return output.UUID;
+}
+
+// Albedo, normal, roughness and height maps of one fractal height field, for batches. Returns the height output.
+Frameio::UUID BuildMaterialGraph(NodesTree& tree)
+{
+  Node height = CreateNode("Fractal Noise", "Height Noise");
+  Node dark = CreateNode("Constant", "Dark");
+  dark.GetSockets()[0].Value = SocketValue::Color(0.25f, 0.15f, 0.08f);
+  Node light = CreateNode("Constant", "Light");
+  light.GetSockets()[0].Value = SocketValue::Color(0.8f, 0.7f, 0.5f);
+  Node albedo = CreateNode("Mix");
+  Node normal = CreateNode("Height To Normal");
+  normal.GetSockets()[1].Value = 4.0f;
+  Node roughness = CreateNode("Invert");
+  Node albedoOutput = CreateNode("Output", "Albedo");
+  Node normalOutput = CreateNode("Output", "Normal");
+  Node roughnessOutput = CreateNode("Output", "Roughness");
+  Node heightOutput = CreateNode("Output", "Height");
+  for (const Node* node : { &height, &dark, &light, &albedo, &normal, &roughness, &albedoOutput, &normalOutput,
+                            &roughnessOutput, &heightOutput }) {
+    tree.AddNode(*node);
+  }
+  tree.AddLink({ dark.UUID, albedo.UUID, 0 });
+  tree.AddLink({ light.UUID, albedo.UUID, 1 });
+  tree.AddLink({ height.UUID, albedo.UUID, 2 });
+  tree.AddLink({ height.UUID, normal.UUID, 0 });
+  tree.AddLink({ height.UUID, roughness.UUID, 0 });
+  tree.AddLink({ albedo.UUID, albedoOutput.UUID, 0 });
+  tree.AddLink({ normal.UUID, normalOutput.UUID, 0 });
+  tree.AddLink({ roughness.UUID, roughnessOutput.UUID, 0 });
+  tree.AddLink({ height.UUID, heightOutput.UUID, 0 });
+  return heightOutput.UUID;
+}
+
+const std::map<std::string, GraphBuilder> s_Graphs = {
+  {"bitmap",   BuildBitmapGraph},
+  {"checker",  BuildCheckerGraph},
+  {"gradient", BuildGradientGraph},
+  {"material", BuildMaterialGraph},
+  {"noise",    BuildNoiseGraph},
+  {"terrain",  BuildTerrainGraph},
+  {"tiles",    BuildTilesGraph},
+};
+
+// Graph files are .txg or their .json form, the output is the first node of type Output
+bool LoadGraph(const std::string& path, NodesTree& tree, Frameio::UUID& output)
+{
+  std::string error;
+  if (path.ends_with(".json")) {
+    std::ifstream file(path);
+    std::ostringstream json;
+    json << file.rdbuf();
+    if (!file || !ImportGraphJson(json.str(), tree, error)) error = file ? error : "Could not open " + path;
+  } else {
+    GraphFile file(path);
+    if (!file.IsValid() || !file.Load(tree)) error = file.GetError();
+  }
+  if (!error.empty()) {
+    std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+    return false;
+  }
+
+  for (uint32_t i = 0; i < tree.GetNodeCount(); i++) {
+    if (tree.GetType(tree.GetHandle(i)) == "Output") {
+      output = tree.GetUUID(tree.GetHandle(i));
+      return true;
+    }
+  }
+  std::fprintf(stderr, "%s has no Output node\n", path.c_str());
+  return false;
+}
+
+bool SaveGraph(const NodesTree& tree, const std::string& path)
+{
+  if (!path.ends_with(".json")) return WriteGraphFile(tree, path);
+  std::ofstream file(path);
+  file << ExportGraphJson(tree);
+  return (bool)file;
+}
+
+// First node with the label, null if there is none
+NodeHandle FindNodeByLabel(const NodesTree& tree, const std::string& label)
+{
+  for (uint32_t i = 0; i < tree.GetNodeCount(); i++) {
+    if (tree.GetLabel(tree.GetHandle(i)) == label) return tree.GetHandle(i);
+  }
+  return NodeHandle();
+}
+
+// Space separated components of a value of type, colors may leave out alpha
+bool ParseSocketValue(const std::string& text, SocketType type, SocketValue& value)
+{
+  std::istringstream stream(text);
+  value = SocketValue(type, SocketData{});
+  if (type == SocketType::Bool) {
+    std::string word;
+    stream >> word;
+    if (word != "true" && word != "false" && word != "1" && word != "0") return false;
+    value.Data.Ints[0] = word == "true" || word == "1";
+  } else if (type == SocketType::Int) {
+    if (!(stream >> value.Data.Ints[0])) return false;
+  } else {
+    const uint32_t count = type == SocketType::Float  ? 1
+                           : type == SocketType::Vec2 ? 2
+                           : type == SocketType::Vec3 ? 3
+                                                      : 4;
+    if (type == SocketType::Color) value.Data.Floats[3] = 1.0f;
+    for (uint32_t i = 0; i < count; i++) {
+      if (stream >> value.Data.Floats[i]) continue;
+      if (type != SocketType::Color || i != 3) return false;
+      stream.clear();
+    }
+  }
+  std::string rest;
+  return !(stream >> rest);
+}
+
+// --vary "<node label>.<socket label>=<value>,<value>,..."
+bool ParseParameter(const NodesTree& tree, const std::string& text, BatchParameter& parameter,
+                    std::vector<SocketValue>& values)
+{
+  const size_t equals = text.find('=');
+  const size_t dot = text.rfind('.', equals);
+  if (equals == std::string::npos || dot == std::string::npos) {
+    std::fprintf(stderr, "--vary %s is not <node>.<socket>=<values>\n", text.c_str());
+    return false;
+  }
+
+  const std::string nodeLabel = text.substr(0, dot), socketLabel = text.substr(dot + 1, equals - dot - 1);
+  const NodeHandle node = FindNodeByLabel(tree, nodeLabel);
+  if (node.IsNull()) {
+    std::fprintf(stderr, "There is no node labeled %s\n", nodeLabel.c_str());
+    return false;
+  }
+  parameter.Node = tree.GetUUID(node);
+  for (parameter.Socket = 0; parameter.Socket < tree.GetSocketCount(node); parameter.Socket++) {
+    if (tree.GetSocketLabel(node, parameter.Socket) == socketLabel) break;
+  }
+  if (parameter.Socket == tree.GetSocketCount(node)) {
+    std::fprintf(stderr, "Node %s has no socket %s\n", nodeLabel.c_str(), socketLabel.c_str());
+    return false;
+  }
+
+  const SocketType type = tree.GetSocketValue(node, parameter.Socket).Type;
+  std::istringstream list(text.substr(equals + 1));
+  for (std::string item; std::getline(list, item, ',');) {
+    if (!ParseSocketValue(item, type, values.emplace_back())) {
+      std::fprintf(stderr, "%s is not a valid %s\n", item.c_str(), GetSocketTypeName(type));
+      return false;
+    }
+  }
+  return !values.empty();
+}
+
+// Replaces every {name} in path with value
+std::string ReplaceAll(std::string path, const std::string& name, const std::string& value)
+{
+  for (size_t at = path.find(name); at != std::string::npos; at = path.find(name, at + value.size())) {
+    path.replace(at, name.size(), value);
+  }
+  return path;
+}
+
+// Peak resident set size of the process in bytes, 0 if it is not known
+uint64_t GetPeakResidentBytes()
+{
+#ifdef TX_PLATFORM_WINDOWS
+  PROCESS_MEMORY_COUNTERS counters;
+  return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  #ifdef TX_PLATFORM_MACOS
+  return (uint64_t)usage.ru_maxrss;
+  #else
+  return (uint64_t)usage.ru_maxrss * 1024;
+  #endif
+#endif
+}
+
+// The nodes that took the most time, their time is summed over every thread and can exceed the wall time of the bake
+void PrintProfile(const Profiler& profiler, const NodesTree& tree)
+{
+  const std::vector<NodeProfile> profiles = profiler.GetNodeProfiles();
+  uint64_t total = 0;
+  for (const NodeProfile& profile : profiles) total += profile.Nanoseconds;
+
+  std::printf("\n%-32s %-16s %10s %6s %10s %10s %10s\n", "Node", "Type", "Time", "Share", "Mpix", "Read", "Allocated");
+  for (size_t i = 0; i < std::min<size_t>(profiles.size(), 16); i++) {
+    const NodeProfile& profile = profiles[i];
+    const NodeHandle node = tree.FindNode(profile.Node);
+    std::printf("%-32.32s %-16.16s %7.2f ms %5.1f%% %10.2f %6.1f MiB %6.1f MiB\n",
+                node.IsNull() ? std::to_string(profile.Node).c_str() : tree.GetLabel(node).c_str(),
+                profile.Type,
+                profile.Nanoseconds * 1e-6,
+                total ? profile.Nanoseconds * 100.0 / total : 0.0,
+                profile.Pixels * 1e-6,
+                profile.BytesRead / 1048576.0,
+                profile.BytesAllocated / 1048576.0);
+  }
+  if (profiles.size() > 16) std::printf("... and %zu more nodes\n", profiles.size() - 16);
+  if (uint64_t dropped = profiler.GetDroppedEventCount()) {
+    std::printf("%llu events did not fit into the trace\n", (unsigned long long)dropped);
+  }
+}
+
+// Writes the trace of --profile and prints its summary, true without a profiler
+bool WriteProfile(const Profiler* profiler, const std::string& path, const NodesTree& tree)
+{
+  if (!profiler) return true;
+  if (!profiler->WriteChromeTrace(path)) {
+    std::fprintf(stderr, "Failed to write %s\n", path.c_str());
+    return false;
+  }
+  PrintProfile(*profiler, tree);
+  return true;
+}
+
+// Bakes every combination of the --vary values for every output, outputPath names the files
+bool RunBatch(const NodesTree& tree, const std::string& graphName, std::span<const Frameio::UUID> outputs,
+              const std::vector<std::string>& varies, const std::string& outputPath, const BatchSettings& settings)
+{
+  std::vector<BatchParameter> parameters(varies.size());
+  std::vector<std::vector<SocketValue>> values(varies.size());
+  for (size_t i = 0; i < varies.size(); i++) {
+    if (!ParseParameter(tree, varies[i], parameters[i], values[i])) return false;
+  }
+  const std::vector<BatchVariant> variants = ExpandParameterMatrix(values);
+  if (variants.size() > 1 && outputPath.find("{variant}") == std::string::npos) {
+    std::fprintf(stderr, "The output path needs {variant} to bake %zu variants\n", variants.size());
+    return false;
+  }
+  if (outputs.size() > 1 && outputPath.find("{output}") == std::string::npos) {
+    std::fprintf(stderr, "The output path needs {output} to bake %zu outputs\n", outputs.size());
+    return false;
+  }
+
+  auto path = [&](uint32_t variant, uint32_t output) {
+    std::string label = tree.GetLabel(tree.FindNode(outputs[output]));
+    std::replace(label.begin(), label.end(), ' ', '_');
+    return ReplaceAll(ReplaceAll(outputPath, "{variant}", std::to_string(variant)), "{output}", label);
+  };
+
+  const EvaluationSettings& evaluation = settings.Evaluation;
+  ThreadPool pool(evaluation.ThreadCount);
+  // Encoding is single threaded per file, so the files of a pass are written in parallel
+  ImageIO io(evaluation.ThreadCount);
+  BatchStatistics statistics;
+  std::string error;
+  auto start = std::chrono::steady_clock::now();
+  if (!BakeBatch(tree, outputs, parameters, variants, settings, pool, io, path, error, &statistics)) {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return false;
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::printf("Baked %u variants x %zu outputs of %s in %u passes at %ux%u on %u threads in %.2f s (%.0f variants/h)\n",
+              statistics.Variants,
+              outputs.size(),
+              graphName.c_str(),
+              statistics.Passes,
+              evaluation.Width,
+              evaluation.Height,
+              pool.GetThreadCount(),
+              seconds,
+              seconds > 0.0 ? statistics.Variants * 3600.0 / seconds : 0.0);
+  std::printf("Evaluated %llu of %llu planned steps\n",
+              (unsigned long long)statistics.EvaluatedSteps,
+              (unsigned long long)statistics.PlannedSteps);
+  std::printf("Peak resident memory: %.1f MiB\n", GetPeakResidentBytes() / 1048576.0);
+  return true;
+}
+
+// Hash of the pixels of the image, independent of its row alignment
+uint64_t HashImage(const Image& image)
+{
+  uint64_t hash = 0;
+  for (uint32_t c = 0; c < Image::Channels; c++) {
+    for (uint32_t y = 0; y < image.GetHeight(); y++) {
+      const float* row = image.GetPointer(c, image.GetRegion().X, image.GetRegion().Y + (int32_t)y);
+      hash = HashCombine(hash, HashBytes((const unsigned char*)row, image.GetWidth() * sizeof(float)));
+    }
+  }
+  return hash;
+}
+
+// Pixels with any channel that differs bitwise, and the first of them in row order
+uint64_t CountDifferences(const Image& a, const Image& b, int32_t& firstX, int32_t& firstY)
+{
+  uint64_t count = 0;
+  const Rect& region = a.GetRegion();
+  for (int32_t y = region.Y; y < region.Bottom(); y++) {
+    for (int32_t x = region.X; x < region.Right(); x++) {
+      bool differs = false;
+      for (uint32_t c = 0; c < Image::Channels; c++) {
+        differs |= std::memcmp(a.GetPointer(c, x, y), b.GetPointer(c, x, y), sizeof(float)) != 0;
+      }
+      if (differs && count++ == 0) {
+        firstX = x;
+        firstY = y;
+      }
+    }
+  }
+  return count;
+}
+
+// Bakes the plan with 1, 4 and every hardware thread and several tile sizes, which all have to give the same pixels
+bool VerifyDeterminism(const EvaluationPlan& plan, const std::string& graphName, EvaluationSettings settings)
+{
+  std::vector<uint32_t> threadCounts = { 1, 4 };
+  if (uint32_t cores = std::thread::hardware_concurrency(); cores != 1 && cores != 4) threadCounts.push_back(cores);
+  std::vector<uint32_t> tileSizes = { 16, 48, 64, 256 };
+  if (std::find(tileSizes.begin(), tileSizes.end(), settings.TileSize) == tileSizes.end()) {
+    tileSizes.push_back(settings.TileSize);
+  }
+
+  std::printf("Verifying %s at %ux%u with %s kernels\n\n%8s %6s %18s %12s\n",
+              graphName.c_str(),
+              settings.Width,
+              settings.Height,
+              GetSimdLevelName(GetSimdLevel()),
+              "Threads",
+              "Tile",
+              "Hash",
+              "Time");
+  uint64_t expected = 0;
+  uint32_t mismatches = 0, bakes = 0;
+  Image reference;
+  for (uint32_t threads : threadCounts) {
+    ThreadPool pool(threads);
+    for (uint32_t tile : tileSizes) {
+      settings.TileSize = tile;
+      auto start = std::chrono::steady_clock::now();
+      Image image = Evaluate(plan, settings, pool);
+      auto end = std::chrono::steady_clock::now();
+      const uint64_t hash = HashImage(image);
+      if (bakes++ == 0) {
+        expected = hash;
+        reference = std::move(image);
+      }
+      std::printf("%8u %6u   %016llx %9.2f ms",
+                  threads,
+                  tile,
+                  (unsigned long long)hash,
+                  std::chrono::duration<double, std::milli>(end - start).count());
+      if (hash != expected) {
+        int32_t x = 0, y = 0;
+        const uint64_t pixels = CountDifferences(reference, image, x, y);
+        std::printf("  differs in %llu pixels, first at %d, %d", (unsigned long long)pixels, x, y);
+        mismatches++;
+      }
+      std::printf("\n");
+    }
+  }
+
+  if (mismatches) std::printf("\n%u of %u bakes differ from the first one\n", mismatches, bakes);
+  else std::printf("\nAll %u bakes are identical\n", bakes);
+  return mismatches == 0;
+}
+
+void PrintUsage()
+{
+  std::printf("Usage: texturia-bake [options] <output.png|output.pfm|output.tga|output.exr|output.tif>\n"
+              "\n"
+              "TIFF outputs are streamed: the bake runs chunk by chunk and every finished chunk goes straight to the\n"
+              "file, so the whole image is never in memory and bakes of any resolution need about the same memory.\n"
+              "Bitmaps can be PNG, TGA, EXR (scanline, uncompressed, RLE or ZIP) or PFM files.\n"
+              "\n"
+              "Batches bake every combination of the --vary values for one or more outputs. Nodes that do not depend\n"
+              "on a varied value are evaluated once for all variants, files are written while the next variants bake.\n"
+              "{variant} in the output path becomes the number of the variant and {output} the label of the output\n"
+              "node, with {output} every Output node is baked.\n"
+              "\n"
+              "Options:\n"
+              "  --graph <name>   Built in graph or .txg/.json graph file to bake (default: checker)\n"
+              "  --save <path>    Also write the graph to a .txg or .json file\n"
+              "  --bitmap <path>  Load an image for the Bitmap nodes, the first one is asset 1, the next one asset 2\n"
+              "                   and so on. May be repeated, the files are decoded in parallel.\n"
+              "  --vary <node>.<socket>=<value>,<value>,...\n"
+              "                   Bake a variant for each value of the socket of the node with that label. Components\n"
+              "                   are separated by spaces: \"Dark.Color=0.2 0.1 0,0.1 0.1 0.1\". May be repeated.\n"
+              "  --output <label> Output node to bake, may be repeated (default: every Output node with {output})\n"
+              "  --pass <n>       Variants evaluated together in one pass of a batch, 0 for all (default: 4)\n"
+              "  --size <pixels>  Width and height of the output (default: 1024)\n"
+              "  --width <pixels>\n"
+              "  --height <pixels>\n"
+              "  --tile <pixels>  Edge length of the tiles the kernels run on (default: 64)\n"
+              "  --threads <n>    Maximum number of worker threads, 0 uses all cores (default: 0)\n"
+              "  --budget <MiB>   Memory limit of intermediate images, larger bakes run in bands (default: none)\n"
+              "  --no-fuse        Evaluate every node into its own image instead of fusing point-wise chains\n"
+              "  --profile <path> Write a Chrome trace of the bake (chrome://tracing, ui.perfetto.dev) and print the\n"
+              "                   nodes that took the most time\n"
+              "  --verify         Bake with 1, 4 and all threads and several tile sizes instead of writing a file and\n"
+              "                   fail unless every bake gives the same pixels\n"
+              "  --list           List the built in graphs and node types\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::string graphName = "checker";
+  std::string outputPath, savePath, profilePath;
+  std::vector<std::string> bitmapPaths, varies, outputLabels;
+  bool verify = false;
+  BatchSettings batchSettings;
+  EvaluationSettings& settings = batchSettings.Evaluation;
+
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+    auto next = [&]() -> const char* {
+      if (i + 1 >= argc) {
+        std::fprintf(stderr, "Missing value for %s\n", argument.c_str());
+        std::exit(1);
+      }
+      return argv[++i];
+    };
+
+    if (argument == "--graph") graphName = next();
+    else if (argument == "--save") savePath = next();
+    else if (argument == "--bitmap") bitmapPaths.push_back(next());
+    else if (argument == "--vary") varies.push_back(next());
+    else if (argument == "--output") outputLabels.push_back(next());
+    else if (argument == "--pass") batchSettings.VariantsPerPass = (uint32_t)std::stoul(next());
+    else if (argument == "--size") settings.Width = settings.Height = (uint32_t)std::stoul(next());
+    else if (argument == "--width") settings.Width = (uint32_t)std::stoul(next());
+    else if (argument == "--height") settings.Height = (uint32_t)std::stoul(next());
+    else if (argument == "--tile") settings.TileSize = (uint32_t)std::stoul(next());
+    else if (argument == "--threads") settings.ThreadCount = (uint32_t)std::stoul(next());
+    else if (argument == "--no-fuse") settings.Fuse = false;
+    else if (argument == "--budget") settings.MemoryBudget = std::stoull(next()) << 20;
+    else if (argument == "--profile") profilePath = next();
+    else if (argument == "--verify") verify = true;
+    else if (argument == "--list") {
+      std::printf("Graphs:\n");
+      for (const auto& [name, builder] : s_Graphs) std::printf("  %s\n", name.c_str());
+      std::printf("Node types:\n");
+      const NodeRegistry& registry = GetNodeRegistry();
+      for (uint32_t i = 0; i < registry.GetTypeCount(); i++) {
+        const NodeType& type = registry.GetType(i);
+        std::printf("  %-24s %s\n", type.Name.c_str(), type.Category.c_str());
+      }
+      return 0;
+    } else if (argument == "--help" || argument == "-h") {
+      PrintUsage();
+      return 0;
+    } else if (!argument.starts_with("--") && outputPath.empty()) {
+      outputPath = argument;
+    } else {
+      std::fprintf(stderr, "Unknown argument %s\n", argument.c_str());
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  if ((outputPath.empty() && !verify) || settings.Width == 0 || settings.Height == 0 || settings.TileSize == 0) {
+    PrintUsage();
+    return 1;
+  }
+
+  NodesTree tree(graphName);
+  Frameio::UUID output;
+  if (graphName.ends_with(".txg") || graphName.ends_with(".json")) {
+    if (!LoadGraph(graphName, tree, output)) return 1;
+  } else {
+    auto graph = s_Graphs.find(graphName);
+    if (graph == s_Graphs.end()) {
+      std::fprintf(stderr, "Unknown graph %s, see --list\n", graphName.c_str());
+      return 1;
+    }
+    output = graph->second(tree);
+  }
+  if (!savePath.empty() && !SaveGraph(tree, savePath)) {
+    const bool groups = !tree.GetGroups().empty() && !savePath.ends_with(".json");
+    std::fprintf(stderr, "Failed to write %s%s\n", savePath.c_str(),
+                 groups ? ", graphs with groups only save as .json" : "");
+    return 1;
+  }
+
+  // Only exists for --profile, the engine skips every hook without it
+  std::unique_ptr<Profiler> profiler;
+  if (!profilePath.empty()) profiler = std::make_unique<Profiler>();
+  settings.Profile = profiler.get();
+
+  if (!bitmapPaths.empty()) {
+    ProfileScope scope(profiler.get(), "Load bitmaps", "io");
+    ImageIO io(settings.ThreadCount);
+    std::vector<Frameio::Ref<ImageTask>> loads;
+    for (const std::string& path : bitmapPaths) loads.push_back(io.Load(path));
+    for (const Frameio::Ref<ImageTask>& load : loads) {
+      load->Wait();
+      if (!load->GetImage()) {
+        std::fprintf(stderr, "%s\n", load->GetError().c_str());
+        return 1;
+      }
+      AddBitmap(load->GetImage());
+    }
+  }
+
+  const bool everyOutput = outputPath.find("{output}") != std::string::npos;
+  if (!varies.empty() || !outputLabels.empty() || everyOutput || outputPath.find("{variant}") != std::string::npos) {
+    std::vector<Frameio::UUID> outputs;
+    for (const std::string& label : outputLabels) {
+      const NodeHandle node = FindNodeByLabel(tree, label);
+      if (node.IsNull()) {
+        std::fprintf(stderr, "There is no node labeled %s\n", label.c_str());
+        return 1;
+      }
+      outputs.push_back(tree.GetUUID(node));
+    }
+    for (uint32_t i = 0; i < tree.GetNodeCount() && outputLabels.empty() && everyOutput; i++) {
+      if (tree.GetType(tree.GetHandle(i)) == "Output") outputs.push_back(tree.GetUUID(tree.GetHandle(i)));
+    }
+    if (outputs.empty()) outputs.push_back(output);
+    const bool baked = RunBatch(tree, graphName, outputs, varies, outputPath, batchSettings);
+    return baked && WriteProfile(profiler.get(), profilePath, tree) ? 0 : 1;
+  }
+
+  EvaluationPlan plan;
+  {
+    ProfileScope scope(profiler.get(), "Build plan", "plan");
+    plan = EvaluationPlan::Build(tree, output);
+  }
+  if (!plan.IsValid()) {
+    std::fprintf(stderr, "%s\n", plan.GetError().c_str());
+    return 1;
+  }
+
+  if (verify) return VerifyDeterminism(plan, graphName, settings) ? 0 : 1;
+
+  ThreadPool pool(settings.ThreadCount);
+  ImagePool images;
+  const bool streamed = outputPath.ends_with(".tif") || outputPath.ends_with(".tiff");
+  Image image;
+  auto start = std::chrono::steady_clock::now();
+  if (streamed) {
+    TiffWriter writer(outputPath, settings.Width, settings.Height, TiffWriter::GetTileSize(settings.TileSize));
+    auto write = [&](const Image& chunk) { return writer.Write(chunk); };
+    if (!writer.IsValid() || !EvaluateStreaming(plan, settings, pool, images, writer.GetTileSize(), write) ||
+        !writer.Close()) {
+      std::fprintf(stderr, "Failed to write %s: %s\n", outputPath.c_str(), writer.GetError().c_str());
+      return 1;
+    }
+  } else {
+    image = Evaluate(plan, settings, pool, images);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  std::printf("Baked %s (%zu nodes) at %ux%u on %u threads in %.2f ms\n",
+              graphName.c_str(),
+              plan.GetSteps().size(),
+              settings.Width,
+              settings.Height,
+              pool.GetThreadCount(),
+              std::chrono::duration<double, std::milli>(end - start).count());
+  const ImagePoolStatistics statistics = images.GetStatistics();
+  std::printf("Intermediate images: peak %.1f MiB in use, %.1f MiB resident, %llu allocations, %llu reuses\n",
+              statistics.PeakInUseBytes / 1048576.0,
+              statistics.PeakResidentBytes / 1048576.0,
+              (unsigned long long)statistics.Allocations,
+              (unsigned long long)statistics.Reuses);
+  std::printf("Peak resident memory: %.1f MiB\n", GetPeakResidentBytes() / 1048576.0);
+
+  if (!streamed) {
+    ProfileScope scope(profiler.get(), "Write", "io");
+    if (!WriteImage(image, outputPath)) {
+      std::fprintf(stderr, "Failed to write %s\n", outputPath.c_str());
+      return 1;
+    }
+  }
+
+  return WriteProfile(profiler.get(), profilePath, tree) ? 0 : 1;
+}